@@ -49,8 +49,14 @@ bool CCmdLineParser::parse(int argc,
                            std::string& persistFileName,
                            bool& isPersistFileNamedPipe,
                            bool& isPersistInForeground,
+                           bool& isPersistInBinary,
                            std::size_t& maxAnomalyRecords,
+                           std::size_t& forecastThreads,
+                           std::size_t& categorizationThreads,
+                           std::size_t& restoreThreads,
+                           bool& isRestoreLazily,
                            bool& memoryUsage,
+                           bool& stageTimings,
                            bool& validElasticLicenseKeyConfirmed) {
     try {
         boost::program_options::options_description desc(DESCRIPTION);
@@ -95,12 +101,22 @@ bool CCmdLineParser::parse(int argc,
                     "Optional file to persist state to - not present means no state persistence")
             ("persistIsPipe", "Specified persist file is a named pipe")
             ("persistInForeground", "Persistence occurs in the foreground. Defaults to background persistence.")
+            ("persistInBinary", "Model state is persisted in a compact binary format. Defaults to JSON. State in either format can be restored.")
             ("bucketPersistInterval", boost::program_options::value<std::size_t>(),
                     "Optional number of buckets after which to periodically persist model state.")
             ("maxAnomalyRecords", boost::program_options::value<std::size_t>(),
                     "The maximum number of records to be outputted for each bucket. Defaults to 100, a value 0 removes the limit.")
+            ("forecastThreads", boost::program_options::value<std::size_t>(),
+                    "The number of threads to use to run forecasts. These are separate from the thread which processes input. Defaults to 1.")
+            ("categorizationThreads", boost::program_options::value<std::size_t>(),
+                    "The number of threads to use to categorize input when per-partition categorization is used. Defaults to 1.")
+            ("restoreThreads", boost::program_options::value<std::size_t>(),
+                    "The number of threads to use to restore detectors' models from saved state. Defaults to 1.")
+            ("lazyRestore", "Detectors' models are kept compressed after restoration until they are first needed. Defaults to restoring all models up front.")
             ("memoryUsage",
                     "Log the model memory usage at the end of the job")
+            ("stageTimings",
+                    "Time the main stages of processing and log the timings at the end of the job. Defaults to off.")
             ("validElasticLicenseKeyConfirmed", boost::program_options::value<bool>(),
                     "Confirmation that a valid Elastic license key is in use.")
             ;
@@ -191,12 +207,30 @@ bool CCmdLineParser::parse(int argc,
         if (vm.count("persistInForeground") > 0) {
             isPersistInForeground = true;
         }
+        if (vm.count("persistInBinary") > 0) {
+            isPersistInBinary = true;
+        }
         if (vm.count("maxAnomalyRecords") > 0) {
             maxAnomalyRecords = vm["maxAnomalyRecords"].as<std::size_t>();
         }
+        if (vm.count("forecastThreads") > 0) {
+            forecastThreads = vm["forecastThreads"].as<std::size_t>();
+        }
+        if (vm.count("categorizationThreads") > 0) {
+            categorizationThreads = vm["categorizationThreads"].as<std::size_t>();
+        }
+        if (vm.count("restoreThreads") > 0) {
+            restoreThreads = vm["restoreThreads"].as<std::size_t>();
+        }
+        if (vm.count("lazyRestore") > 0) {
+            isRestoreLazily = true;
+        }
         if (vm.count("memoryUsage") > 0) {
             memoryUsage = true;
         }
+        if (vm.count("stageTimings") > 0) {
+            stageTimings = true;
+        }
         if (vm.count("validElasticLicenseKeyConfirmed") > 0) {
             validElasticLicenseKeyConfirmed =
                 vm["validElasticLicenseKeyConfirmed"].as<bool>();
@@ -61,8 +61,14 @@ public:
                       std::string& persistFileName,
                       bool& isPersistFileNamedPipe,
                       bool& isPersistInForeground,
+                      bool& isPersistInBinary,
                       std::size_t& maxAnomalyRecords,
+                      std::size_t& forecastThreads,
+                      std::size_t& categorizationThreads,
+                      std::size_t& restoreThreads,
+                      bool& isRestoreLazily,
                       bool& memoryUsage,
+                      bool& stageTimings,
                       bool& validElasticLicenseKeyConfirmed);
 
 private:
@@ -25,7 +25,9 @@
 #include <core/CLogger.h>
 #include <core/CProcessPriority.h>
 #include <core/CProgramCounters.h>
+#include <core/CProgramStageTimers.h>
 #include <core/CStringUtils.h>
+#include <core/Concurrency.h>
 #include <core/CoreTypes.h>
 
 #include <ver/CBuildInfo.h>
@@ -52,6 +54,7 @@
 
 #include "CCmdLineParser.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
@@ -82,7 +85,9 @@ int main(int argc, char** argv) {
         ml::counter_t::E_TSADNumberSamplesOutsideLatencyWindow,
         ml::counter_t::E_TSADNumberMemoryLimitModelCreationFailures,
         ml::counter_t::E_TSADNumberPrunedItems,
-        ml::counter_t::E_TSADAssignmentMemoryBasis};
+        ml::counter_t::E_TSADAssignmentMemoryBasis,
+        ml::counter_t::E_TSADPersistPauseTime,
+        ml::counter_t::E_TSADNumberResultNodeAllocations};
 
     ml::core::CProgramCounters::registerProgramCounterTypes(counters);
 
@@ -112,8 +117,14 @@ int main(int argc, char** argv) {
     std::string persistFileName;
     bool isPersistFileNamedPipe{false};
     bool isPersistInForeground{false};
+    bool isPersistInBinary{false};
     std::size_t maxAnomalyRecords{100};
+    std::size_t forecastThreads{1};
+    std::size_t categorizationThreads{1};
+    std::size_t restoreThreads{1};
+    bool isRestoreLazily{false};
     bool memoryUsage{false};
+    bool stageTimings{false};
     bool validElasticLicenseKeyConfirmed{false};
     if (ml::autodetect::CCmdLineParser::parse(
             argc, argv, configFile, filtersConfigFile, eventsConfigFile,
@@ -122,10 +133,24 @@ int main(int argc, char** argv) {
             namedPipeConnectTimeout, inputFileName, isInputFileNamedPipe, outputFileName,
             isOutputFileNamedPipe, restoreFileName, isRestoreFileNamedPipe,
             persistFileName, isPersistFileNamedPipe, isPersistInForeground,
-            maxAnomalyRecords, memoryUsage, validElasticLicenseKeyConfirmed) == false) {
+            isPersistInBinary, maxAnomalyRecords, forecastThreads, categorizationThreads,
+            restoreThreads, isRestoreLazily, memoryUsage, stageTimings,
+            validElasticLicenseKeyConfirmed) == false) {
         return EXIT_FAILURE;
     }
 
+    // Only record the latencies of the main stages of processing if asked to,
+    // since this reads the clocks for every record
+    ml::core::CProgramStageTimers::enable(stageTimings);
+
+    // The default async executor is used to categorize per-partition and to
+    // restore detectors so is sized for whichever needs more threads. Forecasts
+    // run on a thread pool of their own.
+    std::size_t asyncThreads{std::max(categorizationThreads, restoreThreads)};
+    if (asyncThreads > 1) {
+        ml::core::startDefaultAsyncExecutor(asyncThreads);
+    }
+
     ml::core::CBlockingCallCancellingTimer cancellerThread{
         ml::core::CThread::currentThreadId(), std::chrono::seconds{namedPipeConnectTimeout}};
 
@@ -281,7 +306,10 @@ int main(int argc, char** argv) {
                              jobConfig.quantilePersistInterval(),
                              jobConfig.dataDescription().timeField(),
                              timeFormat,
-                             maxAnomalyRecords};
+                             maxAnomalyRecords,
+                             isPersistInBinary,
+                             isRestoreLazily,
+                             forecastThreads};
 
     if (!quantilesStateFile.empty()) {
         if (job.initNormalizer(quantilesStateFile) == false) {
@@ -303,7 +331,8 @@ int main(int argc, char** argv) {
         &job,
         wrappedOutputStream,
         persistenceManager.get(),
-        analysisConfig.perPartitionCategorizationStopOnWarn()};
+        analysisConfig.perPartitionCategorizationStopOnWarn(),
+        categorizationThreads};
 
     ml::api::CDataProcessor* firstProcessor{nullptr};
     if (doingCategorization) {
@@ -335,6 +364,9 @@ int main(int argc, char** argv) {
 
     // Print out the runtime counters generated during this execution context
     LOG_DEBUG(<< ml::core::CProgramCounters::instance());
+    if (stageTimings) {
+        LOG_INFO(<< "Stage timings:" << ml::core::CProgramStageTimers::instance());
+    }
 
     // This message makes it easier to spot process crashes in a log file - if
     // this isn't present in the log for a given PID and there's no other log
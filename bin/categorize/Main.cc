@@ -225,7 +225,8 @@ int main(int argc, char** argv) {
                                                nullptr,
                                                wrappedOutputStream,
                                                persistenceManager.get(),
-                                               stopCategorizationOnWarnStatus};
+                                               stopCategorizationOnWarnStatus,
+                                               1};
 
     if (persistenceManager != nullptr) {
         persistenceManager->firstProcessorBackgroundPeriodicPersistFunc(std::bind(
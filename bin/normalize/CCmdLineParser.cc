@@ -37,6 +37,7 @@ bool CCmdLineParser::parse(int argc,
                            std::string& quantilesState,
                            bool& deleteStateFiles,
                            bool& writeCsv,
+                           std::size_t& numberThreads,
                            bool& validElasticLicenseKeyConfirmed) {
     try {
         boost::program_options::options_description desc(DESCRIPTION);
@@ -68,6 +69,8 @@ bool CCmdLineParser::parse(int argc,
                     "If this flag is set then delete the normalizer state files once they have been read")
             ("writeCsv",
                     "Write the results in CSV format (default is ND-JSON)")
+            ("numberThreads", boost::program_options::value<std::size_t>(),
+                    "The number of threads to use to normalize batches of records. Defaults to 1, which normalizes records one at a time.")
             ("validElasticLicenseKeyConfirmed", boost::program_options::value<bool>(),
              "Confirmation that a valid Elastic license key is in use.")
         ;
@@ -125,6 +128,9 @@ bool CCmdLineParser::parse(int argc,
         if (vm.count("writeCsv") > 0) {
             writeCsv = true;
         }
+        if (vm.count("numberThreads") > 0) {
+            numberThreads = vm["numberThreads"].as<std::size_t>();
+        }
         if (vm.count("validElasticLicenseKeyConfirmed") > 0) {
             validElasticLicenseKeyConfirmed =
                 vm["validElasticLicenseKeyConfirmed"].as<bool>();
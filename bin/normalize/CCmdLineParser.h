@@ -50,6 +50,7 @@ public:
                       std::string& quantilesState,
                       bool& deleteStateFiles,
                       bool& writeCsv,
+                      std::size_t& numberThreads,
                       bool& validElasticLicenseKeyConfirmed);
 
 private:
@@ -21,6 +21,8 @@
 #include <core/CBlockingCallCancellingTimer.h>
 #include <core/CLogger.h>
 #include <core/CProcessPriority.h>
+#include <core/CStopWatch.h>
+#include <core/Concurrency.h>
 #include <core/CoreTypes.h>
 
 #include <ver/CBuildInfo.h>
@@ -38,7 +40,9 @@
 
 #include "CCmdLineParser.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <functional>
@@ -61,15 +65,20 @@ int main(int argc, char** argv) {
     std::string quantilesStateFile;
     bool deleteStateFiles{false};
     bool writeCsv{false};
+    std::size_t numberThreads{1};
     bool validElasticLicenseKeyConfirmed{false};
     if (ml::normalize::CCmdLineParser::parse(
             argc, argv, modelConfigFile, logProperties, logPipe, bucketSpan,
             lengthEncodedInput, namedPipeConnectTimeout, inputFileName,
             isInputFileNamedPipe, outputFileName, isOutputFileNamedPipe, quantilesStateFile,
-            deleteStateFiles, writeCsv, validElasticLicenseKeyConfirmed) == false) {
+            deleteStateFiles, writeCsv, numberThreads, validElasticLicenseKeyConfirmed) == false) {
         return EXIT_FAILURE;
     }
 
+    if (numberThreads > 1) {
+        ml::core::startDefaultAsyncExecutor(numberThreads);
+    }
+
     ml::core::CBlockingCallCancellingTimer cancellerThread{
         ml::core::CThread::currentThreadId(), std::chrono::seconds{namedPipeConnectTimeout}};
 
@@ -158,13 +167,27 @@ int main(int argc, char** argv) {
         }
     }
 
-    // Now handle the numbers to be normalised from stdin
-    if (inputParser->readStreamIntoMaps(
-            std::bind(&ml::api::CResultNormalizer::handleRecord, &normalizer,
-                      std::placeholders::_1)) == false) {
+    // Now handle the numbers to be normalised from stdin. With more than
+    // one thread the records are read positionally and normalized in
+    // batches in parallel.
+    ml::core::CStopWatch timer{true};
+    bool handledInput{
+        numberThreads > 1
+            ? inputParser->readStreamIntoVecs(std::bind(
+                  &ml::api::CResultNormalizer::handlePositionalRecord,
+                  &normalizer, std::placeholders::_1, std::placeholders::_2)) &&
+                  normalizer.flushPositionalRecords()
+            : inputParser->readStreamIntoMaps(
+                  std::bind(&ml::api::CResultNormalizer::handleRecord,
+                            &normalizer, std::placeholders::_1))};
+    if (handledInput == false) {
         LOG_FATAL(<< "Failed to handle input to be normalized");
         return EXIT_FAILURE;
     }
+    std::uint64_t elapsedTime{std::max(timer.stop(), std::uint64_t{1})};
+    LOG_INFO(<< "Normalized " << normalizer.numberRecords() << " records in "
+             << elapsedTime << "ms ("
+             << 1000 * normalizer.numberRecords() / elapsedTime << " records per second)");
 
     // This message makes it easier to spot process crashes in a log file - if
     // this isn't present in the log for a given PID and there's no other log
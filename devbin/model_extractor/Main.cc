@@ -140,7 +140,8 @@ int main(int argc, char** argv) {
         -1,
         ml::api::CAnomalyJob::DEFAULT_TIME_FIELD_NAME,
         ml::api::CAnomalyJob::EMPTY_STRING,
-        0};
+        0,
+        false};
 
     ml::core_t::TTime completeToTime{0};
     ml::core_t::TTime prevCompleteToTime{0};
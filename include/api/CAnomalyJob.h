@@ -11,8 +11,10 @@
 #ifndef INCLUDED_ml_api_CAnomalyJob_h
 #define INCLUDED_ml_api_CAnomalyJob_h
 
+#include <core/CFastMutex.h>
 #include <core/CJsonOutputStreamWrapper.h>
 #include <core/CStopWatch.h>
+#include <core/CompressUtils.h>
 #include <core/CoreTypes.h>
 
 #include <model/CAnomalyDetector.h>
@@ -34,6 +36,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <map>
 #include <memory>
 #include <string>
@@ -124,7 +127,27 @@ public:
         boost::optional<std::string> s_Extra;
     };
 
+    //! \brief The state to persist in the background.
+    //!
+    //! DESCRIPTION:\n
+    //! Detectors are copied lazily: s_Detectors initially refers to the live
+    //! detectors which have changed since they were last copied. These are
+    //! copied by the persistence thread before it starts writing, or by the
+    //! main thread if it needs to modify one before then, whichever happens
+    //! first. A live detector is only ever copied while holding the mutex so
+    //! the main thread never modifies a detector while it is being copied.
+    //!
+    //! The main thread copies every live detector before it outputs final
+    //! or interim results, skips or advances time (skipSampling and
+    //! timeNow), resets buckets, prunes models, forecasts, refreshes memory
+    //! usage for a foreground persist or starts another background persist.
+    //! addRecord only copies the detector it adds to.
+    //! Anything else which modifies a detector on the main thread must do
+    //! the same.
     struct SBackgroundPersistArgs {
+        using TAnomalyDetectorCPtrSizeUMap =
+            boost::unordered_map<const model::CAnomalyDetector*, std::size_t>;
+
         SBackgroundPersistArgs(core_t::TTime time,
                                const model::CResourceMonitor::SModelSizeStats& modelSizeStats,
                                const model::CInterimBucketCorrector& interimBucketCorrector,
@@ -132,6 +155,14 @@ public:
                                core_t::TTime latestRecordTime,
                                core_t::TTime lastResultsTime);
 
+        //! Copy \p detector if it is still shared with the main thread.
+        //!
+        //! \return True if any detectors are still shared.
+        bool copyLiveDetector(const model::CAnomalyDetector& detector);
+
+        //! Copy every detector which is still shared with the main thread.
+        void copyLiveDetectors();
+
         core_t::TTime s_Time;
         model::CResourceMonitor::SModelSizeStats s_ModelSizeStats;
         model::CInterimBucketCorrector s_InterimBucketCorrector;
@@ -140,6 +171,13 @@ public:
         core_t::TTime s_LatestRecordTime;
         core_t::TTime s_LastResultsTime;
         TKeyCRefAnomalyDetectorPtrPrVec s_Detectors;
+
+        //! The positions in s_Detectors of the detectors still shared with
+        //! the main thread.
+        TAnomalyDetectorCPtrSizeUMap s_LiveDetectors;
+
+        //! Held while copying a live detector.
+        core::CFastMutex s_LiveDetectorsMutex;
     };
 
     using TBackgroundPersistArgsPtr = std::shared_ptr<SBackgroundPersistArgs>;
@@ -155,7 +193,10 @@ public:
                 core_t::TTime maxQuantileInterval,
                 const std::string& timeFieldName,
                 const std::string& timeFieldFormat,
-                std::size_t maxAnomalyRecords);
+                std::size_t maxAnomalyRecords,
+                bool persistInBinary,
+                bool restoreLazily,
+                std::size_t forecastThreads);
 
     ~CAnomalyJob() override;
 
@@ -212,6 +253,17 @@ public:
     //! here.
     const SRestoredStateDetail& restoreStateStatus() const;
 
+    //! How many copies of unchanged detectors have background persists
+    //! reused rather than copying the detectors again?
+    std::size_t numberPersistenceCopiesReused() const;
+
+private:
+    using TBoolFutureVec = std::vector<std::future<bool>>;
+    using TKeyCompressedStateUMap =
+        boost::unordered_map<model::CSearchKey::TStrKeyPr, core::CCompressUtil::TByteVec,
+                             model::CStrKeyPrHash, model::CStrKeyPrEqual>;
+    using TKeyCompressedStateUMapItrVec = std::vector<TKeyCompressedStateUMap::iterator>;
+
 private:
     //! NULL pointer that we can take a long-lived const reference to
     static const TAnomalyDetectorPtr NULL_DETECTOR;
@@ -224,8 +276,13 @@ private:
     //! 'f' => Echo a flush ID so that the attached process knows that data
     //!        sent previously has all been processed
     //! 'i' => Generate interim results
+    //! 'd' => Dump the program stage timings
     bool handleControlMessage(const std::string& controlMessage);
 
+    //! Log the latencies and CPU time of the program stages if stage
+    //! timing is enabled.
+    void dumpStageTimings();
+
     //! Write out the results for the bucket starting at \p bucketStartTime.
     void outputResults(core_t::TTime bucketStartTime);
 
@@ -248,7 +305,12 @@ private:
                       std::size_t& numDetectors);
 
     //! Attempt to restore one detector from an already-created traverser.
-    bool restoreSingleDetector(core::CStateRestoreTraverser& traverser);
+    //!
+    //! If the default async executor has more than one thread the detector's
+    //! models are restored in the background, and the task is added to
+    //! \p pendingRestores.
+    bool restoreSingleDetector(core::CStateRestoreTraverser& traverser,
+                               TBoolFutureVec& pendingRestores);
 
     //! Restore the detector identified by \p key and \p partitionFieldValue
     //! from \p traverser.
@@ -256,9 +318,81 @@ private:
                               const std::string& partitionFieldValue,
                               core::CStateRestoreTraverser& traverser);
 
+    //! Keep the compressed state of the detector identified by \p key and
+    //! \p partitionFieldValue from \p traverser to restore when it's first
+    //! needed.
+    bool restoreDetectorStateLazily(const model::CSearchKey& key,
+                                    const std::string& partitionFieldValue,
+                                    core::CStateRestoreTraverser& traverser);
+
+    //! Restore every detector whose state is being kept to restore lazily.
+    //! This is needed wherever every detector's full state is used.
+    //!
+    //! \note A detector which fails to restore is dropped.
+    void materialiseDormantDetectors();
+
+    //! Restore the dormant detectors which have results for buckets without
+    //! data, if allocations are allowed.
+    void materialiseDormantDetectorsWithResults();
+
+    //! Restore the dormant detectors in \p dormant.
+    void materialiseDormantDetectors(const TKeyCompressedStateUMapItrVec& dormant);
+
+    //! Restore the detector whose state is being kept in \p dormant.
+    //!
+    //! \return The detector or NULL_DETECTOR if allocations aren't allowed
+    //! or it failed to restore.
+    const TAnomalyDetectorPtr&
+    materialiseDormantDetector(TKeyCompressedStateUMap::iterator dormant);
+
+    //! Create an empty detector for the dormant detector keyed by \p key.
+    TAnomalyDetectorPtr& createDormantDetector(const model::CSearchKey::TStrKeyPr& key);
+
+    //! Drop the dormant detector \p dormant.
+    void eraseDormantDetector(TKeyCompressedStateUMap::iterator dormant);
+
+    //! Check if the detector keyed by \p key has results for buckets
+    //! without data, so can't stay dormant while buckets are finalised.
+    bool dormantDetectorHasResults(const model::CSearchKey& key) const;
+
+    //! Sample the buckets finalised while \p detector was dormant.
+    void sampleDormantBuckets(model::CAnomalyDetector& detector);
+
+    //! Create the detector identified by \p key and \p partitionFieldValue
+    //! and restore it from a copy of the state of \p traverser on the default
+    //! async executor.
+    bool restoreDetectorStateInBackground(const model::CSearchKey& key,
+                                          const std::string& partitionFieldValue,
+                                          core::CStateRestoreTraverser& traverser,
+                                          TBoolFutureVec& pendingRestores);
+
     //! Persist current state in the background
     bool backgroundPersistState();
 
+    //! Release any persistence copies of detectors whose state has changed
+    //! since they were copied.
+    void releaseStalePersistenceCopies();
+
+    //! Make sure \p detector isn't shared with a background persist before
+    //! it's modified.
+    void copyDetectorForPersistBeforeUpdate(const model::CAnomalyDetector& detector);
+
+    //! Make sure no detector is shared with a background persist before
+    //! they're modified.
+    void copyDetectorsForPersistBeforeUpdate();
+
+    //! Keep the copies made for the last background persist once it no
+    //! longer shares any live detectors.
+    void retainPersistenceCopies();
+
+    //! Update the memory the resource monitor counts towards the limit for
+    //! the persistence copies of detectors.
+    void refreshPersistenceCopiesMemoryUsage();
+
+    //! Tell the resource monitor the memory used by the persistence copies
+    //! and the state of dormant detectors.
+    void refreshRetainedMemoryUsage();
+
     //! This is the function that is called in a different thread to the
     //! main processing when background persistence is triggered.
     bool runBackgroundPersist(TBackgroundPersistArgsPtr args, core::CDataAdder& persister);
@@ -457,6 +591,26 @@ private:
     //! Map of objects to provide the inner workings
     TKeyAnomalyDetectorPtrUMap m_Detectors;
 
+    //! The copies of the detectors made for the last background persist.
+    //! A copy is reused by the next background persist if its detector's
+    //! state epoch hasn't changed in the meantime, and is released as soon
+    //! as its detector has changed after a bucket is processed.
+    TKeyAnomalyDetectorPtrUMap m_PersistenceCopies;
+
+    //! The number of persistence copies reused by background persists.
+    std::size_t m_NumberPersistenceCopiesReused{0};
+
+    //! The memory used by the persistence copies.
+    std::size_t m_PersistenceCopiesMemoryUsage{0};
+
+    //! The state of the last background persist while it may still share
+    //! live detectors with this thread.
+    TBackgroundPersistArgsPtr m_PendingPersistArgs;
+
+    //! The time in ms spent copying detectors for background persistence
+    //! since it was last added to the program counters.
+    std::uint64_t m_PersistPauseTime{0};
+
     //! The end time of the last bucket out of latency window we've seen
     core_t::TTime m_LastFinalisedBucketEndTime;
 
@@ -474,6 +628,24 @@ private:
     //! we'll output them to reflect decay.  Non-positive values mean never.
     core_t::TTime m_MaxQuantileInterval;
 
+    //! Should model state be persisted in binary rather than JSON format?
+    //! State in either format can be restored.
+    bool m_PersistInBinary;
+
+    //! Should detectors' models only be restored when they're first needed?
+    bool m_RestoreLazily;
+
+    //! The compressed binary state of detectors which have been restored
+    //! lazily and not yet needed.
+    TKeyCompressedStateUMap m_DormantDetectors;
+
+    //! The memory used by the state of dormant detectors.
+    std::size_t m_DormantDetectorsMemoryUsage{0};
+
+    //! The end time of the last bucket to set on dormant detectors when
+    //! they're restored.
+    core_t::TTime m_DormantDetectorsLastBucketEndTime{0};
+
     //! What was the wall clock time when we last persisted the
     //! normalizer? The normalizer is persisted for two reasons:
     //! either there was a significant change or more than a
@@ -490,6 +662,10 @@ private:
     //! Extra information about any errors that may have occurred
     SRestoredStateDetail m_RestoredStateDetail;
 
+    //! The bucket results. These are cleared rather than destroyed after
+    //! each bucket is output so their nodes are reused.
+    model::CHierarchicalResults m_Results;
+
     //! The hierarchical results aggregator.
     model::CHierarchicalResultsAggregator m_Aggregator;
 
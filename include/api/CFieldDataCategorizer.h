@@ -74,6 +74,16 @@ class CPersistenceManager;
 //! lower level model library categorizer.  This is keyed on
 //! the empty string in the map of lower level categorizers.
 //!
+//! When per-partition categorization is used and more than one
+//! thread is requested, records are buffered in batches.  Each
+//! batch is categorized on the default async executor, with each
+//! partition's categorizer only ever touched by one thread, and
+//! then local category IDs are mapped to global category IDs and
+//! records passed down the chain in input order.  This means the
+//! global category IDs are the same as when a single thread is
+//! used.  However, memory limit and stop-on-warn checks are made
+//! per batch rather than per record.
+//!
 class API_EXPORT CFieldDataCategorizer : public CDataProcessor {
 public:
     //! The name of the field where the category is going to be written
@@ -87,6 +97,10 @@ public:
     //! The current state version
     static const std::string STATE_VERSION;
 
+    //! The number of records categorized together when using more than one
+    //! thread
+    static const std::size_t RECORD_BATCH_SIZE;
+
 public:
     // A type of token list data categorizer that DOESN'T exclude fields from
     // its analysis
@@ -114,7 +128,8 @@ public:
                           CDataProcessor* chainedProcessor,
                           core::CJsonOutputStreamWrapper& outputStream,
                           CPersistenceManager* persistenceManager,
-                          bool stopCategorizationOnWarnStatus);
+                          bool stopCategorizationOnWarnStatus,
+                          std::size_t numberThreads);
 
     ~CFieldDataCategorizer() override;
 
@@ -164,7 +179,41 @@ private:
     using TStrSingleFieldDataCategorizerUPtrMap =
         std::map<std::string, TSingleFieldDataCategorizerUPtr>;
 
+    //! A record buffered for categorization in a batch.
+    struct SBufferedRecord {
+        SBufferedRecord(const TStrStrUMap& fields, const TOptionalTime& time)
+            : s_Fields{fields}, s_Time{time} {}
+
+        //! A copy of the record's fields.
+        TStrStrUMap s_Fields;
+
+        //! The record's time.
+        TOptionalTime s_Time;
+
+        //! The categorizer for the record's partition.  This is nullptr if
+        //! the record won't be categorized.
+        CSingleFieldDataCategorizer* s_DataCategorizer = nullptr;
+
+        //! The result of categorizing the record in its partition.
+        CSingleFieldDataCategorizer::SLocalCategorization s_Categorization;
+
+        //! The record's global category ID.
+        CGlobalCategoryId s_GlobalCategoryId;
+    };
+    using TBufferedRecordVec = std::vector<SBufferedRecord>;
+
 private:
+    //! Check the given input record can be categorized and get the
+    //! categorizer for its partition.  If it cannot be categorized this
+    //! returns nullptr and sets \p globalCategoryId to the appropriate
+    //! failure.
+    CSingleFieldDataCategorizer* checkedCategorizerForRecord(const TStrStrUMap& dataRowFields,
+                                                             CGlobalCategoryId& globalCategoryId);
+
+    //! Categorize all buffered records and pass them down the chain in input
+    //! order.
+    bool handleBufferedRecords();
+
     //! Get the appropriate categorizer key from the given input record
     const std::string& categorizerKeyForRecord(const TStrStrUMap& dataRowFields);
 
@@ -236,6 +285,13 @@ private:
     //! Keep count of how many records we've handled
     std::uint64_t m_NumRecordsHandled = 0;
 
+    //! The number of threads to use to categorize records.  Only per-partition
+    //! categorization can use more than one.
+    std::size_t m_NumberThreads = 1;
+
+    //! Records waiting to be categorized in the next batch.
+    TBufferedRecordVec m_BufferedRecords;
+
     //! Pointer to the mutable entry in the data row fields map that
     //! needs to be updated with the computed global category ID before
     //! chaining to the next processor.
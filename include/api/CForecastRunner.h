@@ -56,6 +56,9 @@ struct testSufficientDiskSpace;
 }
 
 namespace ml {
+namespace core {
+class CExecutor;
+}
 namespace api {
 
 //! \brief
@@ -65,7 +68,11 @@ namespace api {
 //! Executes forecast jobs async to the main thread
 //!
 //! IMPLEMENTATION DECISIONS:\n
-//! Uses only 1 thread as worker.
+//! Uses only 1 thread as worker to manage the queue of forecast jobs. Within
+//! a job the models are forecast in batches on a thread pool which belongs to
+//! the runner, so the forecast concurrency is set by its own thread count and
+//! forecasting doesn't tie up the default async executor which other stages
+//! use. The results are written in a fixed order per batch.
 //!
 //! The forecast runs in parallel to the main thread, this has
 //! various consequences:
@@ -106,6 +113,9 @@ public:
     //! minimum time between stat updates to prevent to many updates in a short time
     static const std::uint64_t MINIMUM_TIME_ELAPSED_FOR_STATS_UPDATE = 3000ul; // 3s
 
+    //! the number of models per forecast thread to forecast in each batch
+    static const std::size_t FORECAST_BATCH_SIZE_PER_THREAD = 32;
+
 private:
     static const std::string ERROR_FORECAST_REQUEST_FAILED_TO_PARSE;
     static const std::string ERROR_NO_FORECAST_ID;
@@ -142,9 +152,11 @@ public:
     //! Initialize and start the forecast runner thread
     //! \p jobId The job ID
     //! \p strmOut The output stream to write forecast results to
+    //! \p numberThreads The number of threads to use to forecast models
     CForecastRunner(const std::string& jobId,
                     core::CJsonOutputStreamWrapper& strmOut,
-                    model::CResourceMonitor& resourceMonitor);
+                    model::CResourceMonitor& resourceMonitor,
+                    std::size_t numberThreads = 1);
 
     //! Destructor, cancels all queued forecast requests, finishes a running forecast.
     //! To finish all remaining forecasts call finishForecasts() first.
@@ -285,6 +297,12 @@ private:
     //! note: we use the resource monitor only for checks at the moment
     model::CResourceMonitor& m_ResourceMonitor;
 
+    //! The number of threads used to forecast models
+    std::size_t m_NumberThreads;
+
+    //! The thread pool on which models are forecast
+    std::unique_ptr<core::CExecutor> m_Executor;
+
     //! thread for the worker
     std::thread m_Worker;
 
@@ -13,6 +13,7 @@
 
 #include <core/CJsonOutputStreamWrapper.h>
 #include <core/CRapidJsonConcurrentLineWriter.h>
+#include <core/CRapidJsonWriterBase.h>
 #include <core/CSmallVector.h>
 #include <core/CoreTypes.h>
 
@@ -25,6 +26,7 @@
 #include <api/ImportExport.h>
 
 #include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
 
 #include <boost/optional.hpp>
 
@@ -73,15 +75,23 @@ namespace api {
 //!
 //! Empty string fields are not written to the output.
 //!
-//! Memory for values added to the output documents is allocated from a pool (to
-//! reduce allocation cost and memory fragmentation).  This pool is cleared
-//! between buckets to avoid excessive accumulation of memory over long periods.
-//! It is crucial that the pool is only cleared when no documents reference
-//! memory within it.  This is achieved by only clearing the pool
-//! (m_JsonPoolAllocator) when the m_BucketDataByTime vector is empty.  Care
-//! must be taken if the memory pool is used to allocate memory for long-lived
-//! documents that are not stored within m_BucketDataByTime.  (It might be
-//! better to have a separate pool if this situation ever arises in the future.)
+//! Records can be very numerous for noisy jobs so they aren't built as
+//! documents. Instead, the fields of each record are serialised as soon as
+//! the record is accepted, straight from the hierarchical results, and the
+//! record is completed with the fields which are only known when the bucket
+//! is written using pre-encoded field name tokens. The buffers holding
+//! serialised records are reused from one batch to the next.
+//!
+//! Memory for values added to the influencer output documents is allocated
+//! from a pool (to reduce allocation cost and memory fragmentation).  This
+//! pool is cleared between buckets to avoid excessive accumulation of memory
+//! over long periods. It is crucial that the pool is only cleared when no
+//! documents reference memory within it.  This is achieved by only clearing
+//! the pool (m_JsonPoolAllocator) when the m_BucketDataByTime vector is empty.
+//! Care must be taken if the memory pool is used to allocate memory for
+//! long-lived documents that are not stored within m_BucketDataByTime.  (It
+//! might be better to have a separate pool if this situation ever arises in
+//! the future.)
 //!
 //! Population anomalies consist of overall results and breakdown results.
 //! There is an assumption that the overall result for a population anomaly
@@ -107,9 +117,6 @@ public:
     using TDocumentWeakPtrVecItr = TDocumentWeakPtrVec::iterator;
     using TDocumentWeakPtrVecCItr = TDocumentWeakPtrVec::const_iterator;
 
-    using TDocumentWeakPtrIntPr = std::pair<TDocumentWeakPtr, int>;
-    using TDocumentWeakPtrIntPrVec = std::vector<TDocumentWeakPtrIntPr>;
-    using TDocumentWeakPtrIntPrVecItr = TDocumentWeakPtrIntPrVec::iterator;
     using TStrDocumentPtrVecMap = std::map<std::string, TDocumentWeakPtrVec>;
 
     using TStrVec = std::vector<std::string>;
@@ -126,6 +133,21 @@ public:
 
     using TValuePtr = std::shared_ptr<rapidjson::Value>;
 
+    //! A result record which has been serialised, apart from the fields
+    //! which are added when its bucket is written.
+    struct SRecord {
+        //! The record probability, used to order and limit the records.
+        double s_Probability;
+
+        //! The index of the record's detector.
+        int s_DetectorIndex;
+
+        //! The index of the record's JSON in the serialised records.
+        std::size_t s_Json;
+    };
+
+    using TRecordVec = std::vector<SRecord>;
+
     //! Structure to buffer up information about each bucket that we have
     //! unwritten results for
     struct SBucketData {
@@ -144,9 +166,8 @@ public:
         //! The bucketspan of this bucket
         core_t::TTime s_BucketSpan;
 
-        //! The result record documents to be written, in a vector keyed on
-        //! detector index
-        TDocumentWeakPtrIntPrVec s_DocumentsToWrite;
+        //! The result records to be written
+        TRecordVec s_RecordsToWrite;
 
         //! Bucket Influencer documents
         TDocumentWeakPtrVec s_BucketInfluencerDocuments;
@@ -155,7 +176,7 @@ public:
         TDocumentWeakPtrVec s_InfluencerDocuments;
 
         // The highest probability of all the records stored
-        // in the s_DocumentsToWrite array. Used for filtering
+        // in the s_RecordsToWrite array. Used for filtering
         // new records with a higher probability
         double s_HighestProbability;
 
@@ -269,6 +290,9 @@ private:
     //! revert to using the previous allocator for JSON output processing
     void popAllocator();
 
+private:
+    using TStringBufferWriter = core::CRapidJsonWriterBase<rapidjson::StringBuffer>;
+
 private:
     //! Write out all the JSON documents that have been built up for
     //! a particular bucket
@@ -277,21 +301,30 @@ private:
                      SBucketData& bucketData,
                      std::uint64_t bucketProcessingTime);
 
-    //! Add the fields for a metric detector
-    void addMetricFields(const CHierarchicalResultsWriter::TResults& results,
-                         TDocumentWeakPtr weakDoc);
+    //! Write a record which was serialised when it was accepted, adding
+    //! the fields which depend on the bucket.
+    void writeRecord(const SRecord& record,
+                     bool isInterim,
+                     core_t::TTime bucketTime,
+                     core_t::TTime bucketSpan);
+
+    //! Get the index of a buffer for a new serialised record.
+    std::size_t newRecordJson();
+
+    //! Start serialising a record or cause.
+    void startRecordJson();
+
+    //! Write the fields for a metric detector
+    void writeMetricFields(const CHierarchicalResultsWriter::TResults& results);
 
     //! Write the fields for a population detector
-    void addPopulationFields(const CHierarchicalResultsWriter::TResults& results,
-                             TDocumentWeakPtr weakDoc);
+    void writePopulationFields(const CHierarchicalResultsWriter::TResults& results);
 
     //! Write the fields for a population detector cause
-    void addPopulationCauseFields(const CHierarchicalResultsWriter::TResults& results,
-                                  TDocumentWeakPtr weakDoc);
+    void writePopulationCauseFields(const CHierarchicalResultsWriter::TResults& results);
 
     //! Write the fields for an event rate detector
-    void addEventRateFields(const CHierarchicalResultsWriter::TResults& results,
-                            TDocumentWeakPtr weakDoc);
+    void writeEventRateFields(const CHierarchicalResultsWriter::TResults& results);
 
     //! Add the influencer fields to the doc
     void addInfluencerFields(bool isBucketInfluencer,
@@ -299,8 +332,7 @@ private:
                              TDocumentWeakPtr weakDoc);
 
     //! Write the influence results.
-    void addInfluences(const CHierarchicalResultsWriter::TStoredStringPtrStoredStringPtrPrDoublePrVec& influenceResults,
-                       TDocumentWeakPtr weakDoc);
+    void writeInfluences(const CHierarchicalResultsWriter::TStoredStringPtrStoredStringPtrPrDoublePrVec& influenceResults);
 
 private:
     //! The job ID
@@ -318,11 +350,24 @@ private:
     //! Max number of records to write for each bucket/detector
     std::size_t m_RecordOutputLimit;
 
-    //! Vector for building up documents representing nested sub-results.
-    //! The documents in this vector will reference memory owned by
-    //! m_JsonPoolAllocator.  (Hence this is declared after the memory pool
-    //! so that it's destroyed first when the destructor runs.)
-    TDocumentWeakPtrVec m_NestedDocs;
+    //! The job ID encoded as a JSON string.
+    std::string m_EncodedJobId;
+
+    //! The buffer into which records and causes are serialised.
+    rapidjson::StringBuffer m_RecordBuffer;
+
+    //! Writes records and causes into m_RecordBuffer.
+    TStringBufferWriter m_RecordWriter;
+
+    //! The serialised records. Only the first m_NumberRecordsJson are in
+    //! use: the rest are kept so their memory can be reused.
+    TStrVec m_RecordsJson;
+
+    //! The number of serialised records in use.
+    std::size_t m_NumberRecordsJson;
+
+    //! A JSON array of the serialised causes of the next population record.
+    std::string m_CausesJson;
 
     //! Bucket data waiting to be written.  The map is keyed on bucket time.
     //! The documents in this map will reference memory owned by
@@ -133,6 +133,16 @@ public:
     //! Concurrent calls to this method are not threadsafe.
     bool startPersistIfAppropriate();
 
+    //! Don't start periodic persistence until resumePersistence is called.
+    //! This is for callers which must finish a unit of work, which would
+    //! be inconsistent if persisted part way through, before persisting.
+    void deferPersistence();
+
+    //! Stop deferring periodic persistence and start a persist if one fell
+    //! due while it was deferred.
+    //! \return true if a persist was started.
+    bool resumePersistence();
+
     //! Start a persist if a background one is not running.
     //! Calls the first processor periodic persist function first.
     //! Concurrent calls to this method are not threadsafe.
@@ -189,6 +199,12 @@ private:
     //! How many buckets left to process before attempting the next background persist?
     std::size_t m_NumberBucketsUntilNextPersist;
 
+    //! Is periodic persistence being deferred?
+    bool m_IsPersistDeferred{false};
+
+    //! Did a periodic persist fall due while persistence was deferred?
+    bool m_IsPersistDue{false};
+
     //! The function that will be called to start the chain of
     //! persistence.
     TFirstProcessorPeriodicPersistFunc m_FirstProcessorBackgroundPeriodicPersistFunc;
@@ -45,6 +45,12 @@ namespace api {
 //! The state required to initialize the normalizers is a JSON document
 //! as created by model::CHierarchicalResultsNormalizer::toJson().
 //!
+//! Records can also be supplied positionally, in which case they are
+//! buffered and normalized in batches in parallel using the default async
+//! executor. The normalizers are only read once they are restored so the
+//! batches share them without locking. The records are written in the
+//! order they are received.
+//!
 //! IMPLEMENTATION DECISIONS:\n
 //! Does not support processor chaining functionality as it is unlikely
 //! that this class would ever be chained to another data processor.
@@ -72,9 +78,12 @@ public:
     static const std::string ZERO;
 
 public:
+    using TSizeVec = std::vector<std::size_t>;
     using TStrVec = std::vector<std::string>;
     using TStrVecItr = TStrVec::iterator;
     using TStrVecCItr = TStrVec::const_iterator;
+    using TStrVecVec = std::vector<TStrVec>;
+    using TStrPtrVec = std::vector<std::string*>;
 
     using TStrStrUMap = boost::unordered_map<std::string, std::string>;
     using TStrStrUMapItr = TStrStrUMap::iterator;
@@ -90,7 +99,33 @@ public:
     //! Handle a record to be normalized
     bool handleRecord(const TStrStrUMap& dataRowFields);
 
+    //! Handle a record to be normalized whose \p fieldValues are in the
+    //! same order as \p fieldNames.
+    //!
+    //! \note The record is buffered and only normalized and written when
+    //! a batch is complete or flushPositionalRecords is called.
+    bool handlePositionalRecord(const TStrVec& fieldNames, const TStrVec& fieldValues);
+
+    //! Normalize and write any buffered positional records.
+    bool flushPositionalRecords();
+
+    //! Get the number of records handled.
+    std::size_t numberRecords() const;
+
 private:
+    //! Get the normalized score output for a record.
+    std::string normalizedScore(const std::string& level,
+                                const std::string& partitionName,
+                                const std::string& partitionValue,
+                                const std::string& personName,
+                                const std::string& personValue,
+                                const std::string& function,
+                                const std::string& valueFieldName,
+                                double probability) const;
+
+    //! Get the normalized score output for a positional record.
+    std::string normalizedScore(const TStrVec& fieldValues) const;
+
     bool parseDataFields(const TStrStrUMap& dataRowFields,
                          std::string& level,
                          std::string& partitionName,
@@ -134,6 +169,31 @@ private:
 
     //! The hierarchical results normalizer
     model::CHierarchicalResultsNormalizer m_Normalizer;
+
+    //! The number of records handled.
+    std::size_t m_NumberRecords;
+
+    //! \name Positional Records
+    //@{
+    //! The positions of the fields needed to normalize a record.
+    TSizeVec m_FieldPositions;
+
+    //! The values of the output row in field order.
+    TStrPtrVec m_RowFieldValues;
+
+    //! Map holding the output row.
+    TStrStrUMap m_RowFields;
+
+    //! The buffered records. Only the first m_NumberBufferedRecords are
+    //! in use, the remainder are retained to reuse their memory.
+    TStrVecVec m_BufferedRecords;
+
+    //! The number of buffered records.
+    std::size_t m_NumberBufferedRecords;
+
+    //! The normalized scores of the buffered records.
+    TStrVec m_BufferedScores;
+    //@}
 };
 }
 }
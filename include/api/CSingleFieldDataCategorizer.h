@@ -57,6 +57,16 @@ public:
 
     using TOptionalTime = boost::optional<core_t::TTime>;
 
+    //! The outcome of categorizing a message with the wrapped categorizer,
+    //! before its local category ID is mapped to a global one.
+    struct SLocalCategorization {
+        //! The local category ID chosen.
+        model::CLocalCategoryId s_LocalCategoryId;
+
+        //! Did the chosen category's definition change?
+        bool s_Changed = false;
+    };
+
 public:
     CSingleFieldDataCategorizer(std::string partitionFieldName,
                                 model::CDataCategorizer::TDataCategorizerUPtr dataCategorizer,
@@ -78,6 +88,28 @@ public:
                              model::CResourceMonitor& resourceMonitor,
                              CJsonOutputWriter& jsonOutputWriter);
 
+    //! Compute and update a local category from a string without mapping it
+    //! to a global category ID or writing any output.
+    //!
+    //! \note This only touches the state of this object, so different objects
+    //! can categorize concurrently.  Mapping to global category IDs must then
+    //! be done on one thread in input order by calling mapCategory().
+    SLocalCategorization computeLocalCategory(bool isDryRun,
+                                              const model::CDataCategorizer::TStrStrUMap& fields,
+                                              const std::string& messageToCategorize,
+                                              const std::string& rawMessage);
+
+    //! Map a local category ID computed by computeLocalCategory() to its
+    //! global category ID, allocating a new one if necessary.
+    CGlobalCategoryId mapCategory(model::CLocalCategoryId localCategoryId,
+                                  const TOptionalTime& messageTime);
+
+    //! Write the definition of the supplied category if it has changed since
+    //! it was last written and update the resource monitor.
+    void writeCategoryIfChanged(model::CLocalCategoryId localCategoryId,
+                                model::CResourceMonitor& resourceMonitor,
+                                CJsonOutputWriter& jsonOutputWriter);
+
     //! Make a function that can be called later to persist state in the
     //! foreground, i.e. in the knowledge that no other thread will be
     //! accessing the data structures this method accesses.
@@ -0,0 +1,111 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+#ifndef INCLUDED_ml_core_CBinaryStatePersistInserter_h
+#define INCLUDED_ml_core_CBinaryStatePersistInserter_h
+
+#include <core/CStatePersistInserter.h>
+#include <core/ImportExport.h>
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace ml {
+namespace core {
+
+//! \brief
+//! For persisting state in a compact binary format.
+//!
+//! DESCRIPTION:\n
+//! Concrete implementation of the CStatePersistInserter interface
+//! that persists state as a sequence of tagged records.  The short
+//! persistence tags are kept, so the structure of the state is
+//! identical to that written by CJsonStatePersistInserter.
+//!
+//! Each record starts with a single byte giving its type.  Names and
+//! string values are written as a varint length followed by the raw
+//! bytes, so there is no quoting or escaping.  Floating point values
+//! persisted with a precision are written as the raw IEEE754 bits of
+//! the value rounded to that precision, avoiding the conversion to
+//! decimal.
+//!
+//! IMPLEMENTATION DECISIONS:\n
+//! Output is streaming and buffered internally.  The buffer is flushed
+//! to the output stream when it fills and on destruction, so, as with
+//! the JSON inserter, the inserter must be destroyed before the stream
+//! is completed.
+//!
+//! The state starts with a two byte header: a marker byte that cannot
+//! start a JSON document and a format version.  This lets restore code
+//! detect the format, see CBinaryStateRestoreTraverser::isBinaryState.
+//!
+//! Doubles are written in the byte order of the machine persisting
+//! them.  All supported platforms are little endian.
+//!
+class CORE_EXPORT CBinaryStatePersistInserter : public CStatePersistInserter {
+public:
+    //! The byte which starts binary state.
+    static const char MARKER;
+
+    //! The version of the binary format.
+    static const char FORMAT_VERSION;
+
+    //! The record types.
+    enum ERecordType : std::uint8_t {
+        E_String = 1,
+        E_Double = 2,
+        E_NewLevel = 3,
+        E_EndLevel = 4
+    };
+
+public:
+    explicit CBinaryStatePersistInserter(std::ostream& outputStream);
+
+    //! Destructor ends the state and flushes
+    ~CBinaryStatePersistInserter() override;
+
+    //! Store a name/value
+    void insertValue(const std::string& name, const std::string& value) override;
+
+    //! Store a floating point number with a given level of precision
+    void insertValue(const std::string& name, double value, CIEEE754::EPrecision precision) override;
+
+    // Bring extra base class overloads into scope
+    using CStatePersistInserter::insertValue;
+
+    //! Flush the underlying output stream
+    void flush();
+
+protected:
+    //! Start a new level with the given name
+    void newLevel(const std::string& name) override;
+
+    //! End the current level
+    void endLevel() override;
+
+private:
+    void writeType(ERecordType type);
+    void writeVarint(std::size_t value);
+    void writeString(const std::string& value);
+    void flushIfFull();
+    void writeBuffer();
+
+private:
+    //! The stream to which state is written
+    std::ostream& m_OutputStream;
+
+    //! Buffer for state not yet written to the stream
+    std::string m_Buffer;
+};
+}
+}
+
+#endif // INCLUDED_ml_core_CBinaryStatePersistInserter_h
@@ -0,0 +1,141 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+#ifndef INCLUDED_ml_core_CBinaryStateRestoreTraverser_h
+#define INCLUDED_ml_core_CBinaryStateRestoreTraverser_h
+
+#include <core/CStateRestoreTraverser.h>
+#include <core/ImportExport.h>
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace ml {
+namespace core {
+
+//! \brief
+//! For restoring state in the binary format written by
+//! CBinaryStatePersistInserter.
+//!
+//! DESCRIPTION:\n
+//! Concrete implementation of the CStateRestoreTraverser interface
+//! that restores state in binary format.  It behaves in the same way
+//! as CJsonStateRestoreTraverser, so code restoring state need not
+//! know which format was used.
+//!
+//! IMPLEMENTATION DECISIONS:\n
+//! Input is streaming and buffered internally.  Only the current
+//! element is held in memory and sub-levels which are not traversed
+//! are skipped without decoding their values.
+//!
+//! Doubles are converted to strings on restore because the traverser
+//! interface returns all values as strings.
+//!
+class CORE_EXPORT CBinaryStateRestoreTraverser : public CStateRestoreTraverser {
+public:
+    explicit CBinaryStateRestoreTraverser(std::istream& inputStream);
+
+    //! Check if the next character in \p inputStream starts binary state.
+    //! This does not consume any input so the stream can be passed to
+    //! either this or a JSON traverser afterwards.
+    static bool isBinaryState(std::istream& inputStream);
+
+    //! Navigate to the next element at the current level, or return false
+    //! if there isn't one
+    bool next() override;
+
+    //! Does the current element have a sub-level?
+    bool hasSubLevel() const override;
+
+    //! Get the name of the current element - the returned reference is only
+    //! valid for as long as the traverser is pointing at the same element
+    const std::string& name() const override;
+
+    //! Get the value of the current element - the returned reference is
+    //! only valid for as long as the traverser is pointing at the same
+    //! element
+    const std::string& value() const override;
+
+    //! Is the traverser at the end of the inputstream?
+    bool isEof() const override;
+
+protected:
+    //! Navigate to the start of the sub-level of the current element, or
+    //! return false if there isn't one
+    bool descend() override;
+
+    //! Navigate to the element of the level above from which descend() was
+    //! called, or return false if there isn't a level above
+    bool ascend() override;
+
+private:
+    using TStrVec = std::vector<std::string>;
+
+private:
+    //! Read the header and the first element
+    bool start();
+
+    //! Read the next element at the current level.  Returns false if the
+    //! end of the level is reached instead.
+    bool advance();
+
+    //! Skip the remainder of a level whose start has been read.
+    bool skipLevel();
+
+    //! Make at least one unread byte available if possible.
+    bool fillBuffer();
+
+    //! Read primitives.  Values are discarded if the output pointer is null.
+    bool readByte(std::uint8_t& value);
+    bool readVarint(std::size_t& length);
+    bool readString(std::string* value);
+    bool readDouble(double& value);
+    bool readRaw(std::size_t length, std::string* value);
+
+    //! Log an error and mark the state as bad
+    bool fail(const std::string& reason);
+
+private:
+    //! The stream from which state is read
+    std::istream& m_InputStream;
+
+    //! Buffered input and the position of the next unread byte in it
+    std::string m_Buffer;
+    std::size_t m_BufferPos = 0;
+
+    //! Flag to indicate whether we've started reading
+    bool m_Started = false;
+
+    //! Has the end of the root level been read?
+    bool m_Eof = false;
+
+    //! The depth of the level currently being traversed
+    std::size_t m_Level = 0;
+
+    //! Has the end of the level currently being traversed been read?
+    bool m_LevelEnded = false;
+
+    //! Is the current element the start of a level whose contents have not
+    //! been read?
+    bool m_CurrentIsLevel = false;
+
+    //! The name and value of the current element
+    std::string m_Name;
+    std::string m_Value;
+
+    //! The names of the elements whose levels have been descended into
+    TStrVec m_LevelNames;
+};
+}
+}
+
+#endif // INCLUDED_ml_core_CBinaryStateRestoreTraverser_h
@@ -33,10 +33,16 @@ namespace core {
 //! manages the buffering of data between the client thread and
 //! the upload thread.
 //!
+//! When compressing in parallel the upload thread splits the data
+//! into fixed size blocks, compresses each block as a separate gzip
+//! member on the default async executor and writes the compressed
+//! blocks in order.  The number of blocks in flight is limited to
+//! bound memory.
+//!
 class CORE_EXPORT CCompressOStream : public std::ostream {
 public:
     //! Constructor
-    CCompressOStream(CStateCompressor::CChunkFilter& filter);
+    CCompressOStream(CStateCompressor::CChunkFilter& filter, bool compressInParallel = false);
 
     //! Destructor will close the stream
     ~CCompressOStream() override;
@@ -49,13 +55,18 @@ private:
     public:
         CCompressThread(CCompressOStream& stream,
                         CDualThreadStreamBuf& streamBuf,
-                        CStateCompressor::CChunkFilter& filter);
+                        CStateCompressor::CChunkFilter& filter,
+                        bool compressInParallel);
 
     protected:
         //! Implementation of inherited interface
         void run() override;
         void shutdown() override;
 
+    private:
+        //! Compress blocks of the data in parallel.
+        void runInParallel();
+
     public:
         //! Reference to the owning stream
         CCompressOStream& m_Stream;
@@ -68,6 +79,9 @@ private:
         //! downstream writing to datastore
         CStateCompressor::CChunkFilter& m_FilterSink;
 
+        //! True if blocks of the data are compressed in parallel.
+        bool m_CompressInParallel;
+
         //! The gzip filter to live within the new thread
         CStateCompressor::TFilteredOutput m_OutFilter;
     };
@@ -0,0 +1,104 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+#ifndef INCLUDED_ml_core_CLatencyHistogram_h
+#define INCLUDED_ml_core_CLatencyHistogram_h
+
+#include <core/ImportExport.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ml {
+namespace core {
+
+//! \brief A histogram of durations with bounded relative error.
+//!
+//! DESCRIPTION:\n
+//! Records durations, typically in nanoseconds, so that their count, total,
+//! maximum and quantiles can be reported. Any quantile is accurate to within
+//! 1 / 2^SUB_BUCKET_BITS of the true value, for all values up to 2^64 - 1.
+//!
+//! IMPLEMENTATION DECISIONS:\n
+//! This uses the log-linear bucketing of an HDR histogram: values less than
+//! 2^SUB_BUCKET_BITS get a bucket each and every subsequent power of two is
+//! split into 2^SUB_BUCKET_BITS equal width buckets. This means recording a
+//! value is a couple of shifts and an increment, and the memory is fixed.
+//!
+//! The counts are atomics incremented with relaxed ordering so values can
+//! be recorded from any thread without locking. Reading the histogram while
+//! it's being updated gives a consistent enough view for reporting but the
+//! count, total and buckets may be momentarily out of step.
+class CORE_EXPORT CLatencyHistogram {
+public:
+    //! The number of bits of each value which are used to choose its bucket
+    //! within a power of two.
+    static constexpr std::size_t SUB_BUCKET_BITS{5};
+    //! The number of buckets within each power of two.
+    static constexpr std::size_t SUB_BUCKET_COUNT{std::size_t{1} << SUB_BUCKET_BITS};
+    //! The total number of buckets needed to represent any 64 bit value.
+    static constexpr std::size_t NUMBER_BUCKETS{(64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT};
+
+public:
+    CLatencyHistogram();
+
+    CLatencyHistogram(const CLatencyHistogram&) = delete;
+    CLatencyHistogram& operator=(const CLatencyHistogram&) = delete;
+
+    //! Add \p value to the histogram.
+    void record(std::uint64_t value);
+
+    //! Get the number of values recorded.
+    std::uint64_t count() const;
+
+    //! Get the sum of the values recorded.
+    std::uint64_t total() const;
+
+    //! Get the largest value recorded.
+    std::uint64_t max() const;
+
+    //! Get the \p q'th quantile of the values recorded.
+    //!
+    //! \note This is the largest value in the bucket which contains the
+    //! quantile, capped at the maximum value recorded, and is zero if no
+    //! values have been recorded.
+    std::uint64_t quantile(double q) const;
+
+    //! Remove all recorded values.
+    void clear();
+
+    //! Get the bucket which contains \p value.
+    static std::size_t bucket(std::uint64_t value);
+
+    //! Get the largest value in \p bucket.
+    static std::uint64_t bucketUpperBound(std::size_t bucket);
+
+private:
+    using TAtomicUInt64Array = std::array<std::atomic_uint_fast64_t, NUMBER_BUCKETS>;
+
+private:
+    //! The bucket counts.
+    TAtomicUInt64Array m_Counts;
+
+    //! The number of values recorded.
+    std::atomic_uint_fast64_t m_Count;
+
+    //! The sum of the values recorded.
+    std::atomic_uint_fast64_t m_Total;
+
+    //! The largest value recorded.
+    std::atomic_uint_fast64_t m_Max;
+};
+}
+}
+
+#endif // INCLUDED_ml_core_CLatencyHistogram_h
@@ -109,6 +109,14 @@ enum ECounterTypes {
     //! Which option is being used to get model memory for node assignment?
     E_TSADAssignmentMemoryBasis = 29,
 
+    //! The total time in ms processing was paused to snapshot model state
+    //! for background persistence
+    E_TSADPersistPauseTime = 30,
+
+    //! The number of result nodes which had to be allocated because the
+    //! pooled nodes were exhausted
+    E_TSADNumberResultNodeAllocations = 31,
+
     // Data Frame Outlier Detection
 
     //! The estimated peak memory usage for outlier detection in bytes
@@ -143,7 +151,7 @@ enum ECounterTypes {
     // Add any new values here
 
     //! This MUST be last, increment the value for every new enum added
-    E_LastEnumCounter = 30
+    E_LastEnumCounter = 32
 };
 
 static constexpr std::size_t NUM_COUNTERS = static_cast<std::size_t>(E_LastEnumCounter);
@@ -350,6 +358,10 @@ private:
           "The number of old people or attributes pruned from the models"},
          {counter_t::E_TSADAssignmentMemoryBasis, "E_TSADAssignmentMemoryBasis",
           "Which option is being used to get model memory for node assignment?"},
+         {counter_t::E_TSADPersistPauseTime, "E_TSADPersistPauseTime",
+          "The total time processing was paused to snapshot model state for background persistence"},
+         {counter_t::E_TSADNumberResultNodeAllocations, "E_TSADNumberResultNodeAllocations",
+          "The number of result nodes allocated because the pooled nodes were exhausted"},
          {counter_t::E_DFOEstimatedPeakMemoryUsage, "E_DFOEstimatedPeakMemoryUsage",
           "The upfront estimate of the peak memory outlier detection would use"},
          {counter_t::E_DFOPeakMemoryUsage, "E_DFOPeakMemoryUsage", "The peak memory outlier detection used"},
@@ -0,0 +1,206 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+#ifndef INCLUDED_ml_core_CProgramStageTimers_h
+#define INCLUDED_ml_core_CProgramStageTimers_h
+
+#include <core/CLatencyHistogram.h>
+#include <core/CMonotonicTime.h>
+#include <core/ImportExport.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace ml {
+namespace stage_t {
+
+//! The enum values must be explicitly assigned & names should have a meaningful prefix to effectively namespace stages
+//! New stages may be added anywhere before E_LastEnumStage and must be grouped by namespace prefix.
+//! The E_LastEnumStage value must be bumped for every new enum added.
+//! Don't forget to also add a definition of the new enum value to m_StageDefinitions.
+enum EStageTypes {
+    // Time Series Anomaly Detection
+
+    //! Handling an input record, including adding it to the data gatherers
+    //! and outputting any buckets it completes
+    E_TSADHandleRecord = 0,
+
+    //! Updating a detector's models with a bucket's data
+    E_TSADSampleModels = 1,
+
+    //! Computing a detector's results for a bucket
+    E_TSADComputeResults = 2,
+
+    //! Normalizing a bucket's results
+    E_TSADNormalizeResults = 3,
+
+    //! Producing and writing a bucket's final results end-to-end
+    E_TSADOutputResults = 4,
+
+    //! Persisting model state
+    E_TSADPersistState = 5,
+
+    // Add any new values here
+
+    //! This MUST be last, increment the value for every new enum added
+    E_LastEnumStage = 6
+};
+
+static constexpr std::size_t NUM_STAGES = static_cast<std::size_t>(E_LastEnumStage);
+}
+
+namespace core {
+
+struct SStageDefinition {
+    stage_t::EStageTypes s_Type;
+    std::string s_Name;
+    std::string s_Description;
+    //! False for stages which are so short and frequent that reading the
+    //! thread CPU clock would add significantly to their cost.
+    bool s_MeasureCpu;
+};
+
+//! \brief
+//! Latency histograms and cumulative CPU time for the stages of a program
+//!
+//! DESCRIPTION:\n
+//! The program counters tell us how much work a program has done but not
+//! where its time goes. This records the elapsed time of every execution
+//! of each stage of a program in a latency histogram together with the
+//! total CPU time the stage used. Programs time a stage by creating a
+//! CScopedTimer for the scope which implements it.
+//!
+//! To add a new stage, add it to the stage_t::EStageTypes enum in the
+//! penultimate position and add its details to the m_StageDefinitions
+//! array.
+//!
+//! IMPLEMENTATION DECISIONS:\n
+//! A singleton class: there should only be one collection of stage timers.
+//!
+//! Timing is disabled by default and a disabled timer doesn't read any
+//! clocks, so it costs nothing in programs and tests which don't want it.
+//! Stages can nest, for example sampling happens while outputting results,
+//! and are recorded independently. Stages may be timed concurrently from
+//! different threads.
+//!
+class CORE_EXPORT CProgramStageTimers {
+public:
+    //! \brief
+    //! The timings of one stage
+    class CORE_EXPORT CStage {
+    public:
+        CStage();
+
+        //! Record one execution which took \p elapsedTime and used \p cpuTime
+        //! nanoseconds.
+        void record(std::uint64_t elapsedTime, std::uint64_t cpuTime);
+
+        //! Get the histogram of elapsed times in nanoseconds.
+        const CLatencyHistogram& latencies() const;
+
+        //! Get the total CPU time used in nanoseconds.
+        std::uint64_t cpuTime() const;
+
+        //! Remove all timings.
+        void clear();
+
+    private:
+        CLatencyHistogram m_Latencies;
+        std::atomic_uint_fast64_t m_CpuTime;
+    };
+
+    //! \brief
+    //! Times the enclosing scope as an execution of a stage
+    class CORE_EXPORT CScopedTimer {
+    public:
+        explicit CScopedTimer(stage_t::EStageTypes stage);
+        ~CScopedTimer();
+
+        CScopedTimer(const CScopedTimer&) = delete;
+        CScopedTimer& operator=(const CScopedTimer&) = delete;
+
+    private:
+        //! The stage being timed or null if timing is disabled.
+        CStage* m_Stage;
+        bool m_MeasureCpu;
+        std::uint64_t m_StartTime;
+        std::uint64_t m_StartCpuTime;
+    };
+
+    using TStageDefinitionArray = std::array<SStageDefinition, stage_t::NUM_STAGES>;
+
+public:
+    //! Singleton pattern
+    static CProgramStageTimers& instance();
+
+    //! Enable or disable timing.
+    static void enable(bool enabled);
+
+    //! Check if timing is enabled.
+    static bool enabled();
+
+    //! Provide access to the timings of \p stage.
+    static CStage& stage(stage_t::EStageTypes stage);
+
+    //! Get the definitions of all the stages in enum order.
+    static const TStageDefinitionArray& definitions();
+
+    //! Remove all timings.
+    static void clear();
+
+    //! Get a monotonic time in nanoseconds to measure elapsed times.
+    static std::uint64_t now();
+
+private:
+    using TStageArray = std::array<CStage, stage_t::NUM_STAGES>;
+
+private:
+    CProgramStageTimers();
+
+private:
+    //! The unique instance.
+    static CProgramStageTimers ms_Instance;
+
+    //! Is timing enabled?
+    std::atomic_bool m_Enabled;
+
+    //! The clock used to measure elapsed times.
+    CMonotonicTime m_Clock;
+
+    //! The timings of each stage.
+    TStageArray m_Stages;
+
+    //! The definitions of the stages.
+    TStageDefinitionArray m_StageDefinitions{
+        {{stage_t::E_TSADHandleRecord, "handle_record",
+          "Handling an input record, including outputting any buckets it completes", false},
+         {stage_t::E_TSADSampleModels, "sample_models",
+          "Updating a detector's models with a bucket's data", true},
+         {stage_t::E_TSADComputeResults, "compute_results",
+          "Computing a detector's results for a bucket", true},
+         {stage_t::E_TSADNormalizeResults, "normalize_results",
+          "Normalizing a bucket's results", true},
+         {stage_t::E_TSADOutputResults, "output_results",
+          "Producing and writing a bucket's final results", true},
+         {stage_t::E_TSADPersistState, "persist_state", "Persisting model state", true}}};
+
+    //! Enabling printing out the current timings.
+    friend CORE_EXPORT std::ostream& operator<<(std::ostream& o,
+                                                const CProgramStageTimers& timers);
+};
+
+} // core
+} // ml
+
+#endif // INCLUDED_ml_core_CProgramStageTimers_h
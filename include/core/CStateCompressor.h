@@ -45,6 +45,12 @@ class CCompressOStream;
 //! that downstream CDataAdder/CDataSearcher store will
 //! support strings of Base64 encoded data
 //!
+//! Optionally, blocks of the data can be compressed in parallel
+//! on the default async executor, in the same way as pigz. Each
+//! block is a separate gzip member and a concatenation of gzip
+//! members is itself a valid gzip stream, so CStateDecompressor
+//! reads both formats.
+//!
 class CORE_EXPORT CStateCompressor : public CDataAdder {
 public:
     static const std::string COMPRESSED_ATTRIBUTE;
@@ -117,7 +123,10 @@ public:
 
 public:
     //! Constructor: take a reference to the underlying downstream datastore
-    CStateCompressor(CDataAdder& compressedAdder);
+    //!
+    //! \param[in] compressInParallel If true and the default async executor
+    //! has more than one thread blocks of the data are compressed in parallel.
+    explicit CStateCompressor(CDataAdder& compressedAdder, bool compressInParallel = false);
 
     //! Add streamed data - return of NULL stream indicates failure.
     //! Since the data to be written isn't known at the time this function
@@ -143,7 +143,7 @@ public:
     }
 
     //! Store a floating point number with a given level of precision
-    void insertValue(const std::string& name, double value, CIEEE754::EPrecision precision);
+    virtual void insertValue(const std::string& name, double value, CIEEE754::EPrecision precision);
 
     //! Store a floating point number with a given level of precision
     //! with choice of tag format
@@ -58,8 +58,8 @@ public:
     //! Check if the thread pool has been marked as busy.
     bool busy() const;
 
-    //! Check if the thread pool has been marked as busy.
-    void busy(bool busy);
+    //! Mark the thread pool as busy or not and return whether it was busy.
+    bool busy(bool busy);
 
 private:
     using TOptionalSize = boost::optional<std::size_t>;
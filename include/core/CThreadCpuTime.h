@@ -0,0 +1,44 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+#ifndef INCLUDED_ml_core_CThreadCpuTime_h
+#define INCLUDED_ml_core_CThreadCpuTime_h
+
+#include <core/ImportExport.h>
+
+#include <cstdint>
+
+namespace ml {
+namespace core {
+
+//! \brief
+//! Get the CPU time used by the calling thread
+//!
+//! DESCRIPTION:\n
+//! Encapsulates the OS specific methods that obtain the CPU time, user
+//! plus system, which the calling thread has used so far. Like the
+//! monotonic time the only meaningful thing to do with the values is to
+//! subtract two obtained on the same thread.
+//!
+//! IMPLEMENTATION DECISIONS:\n
+//! On platforms using clock_gettime() this reads CLOCK_THREAD_CPUTIME_ID
+//! and on Windows it uses GetThreadTimes(). Neither is as cheap as reading
+//! the monotonic clock, typically they need a system call, so they aren't
+//! suitable for timing very short operations which are run very often.
+//!
+class CORE_EXPORT CThreadCpuTime {
+public:
+    //! Get the number of nanoseconds of CPU time the calling thread has used
+    static std::uint64_t nanoseconds();
+};
+}
+}
+
+#endif // INCLUDED_ml_core_CThreadCpuTime_h
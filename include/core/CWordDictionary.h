@@ -17,6 +17,7 @@
 #include <boost/unordered_map.hpp>
 
 #include <string>
+#include <string_view>
 
 namespace ml {
 namespace core {
@@ -167,14 +168,14 @@ public:
     //! partOfSpeech().  Instead simply call partOfSpeech(), noting that
     //! it will return E_NotInDictionary in cases where this method will
     //! return false.
-    bool isInDictionary(const std::string& str) const;
+    bool isInDictionary(std::string_view str) const;
 
     //! Check what part of speech a word is primarily used for.  Note that
     //! many words can be used in different parts of speech and this method
     //! only returns what Grady Ward thought was the primary use when he
     //! created Moby.  This method returns E_NotInDictionary for words that
     //! aren't in the dictionary.
-    EPartOfSpeech partOfSpeech(const std::string& str) const;
+    EPartOfSpeech partOfSpeech(std::string_view str) const;
 
 private:
     //! Constructor for a singleton is private
@@ -182,14 +183,15 @@ private:
     ~CWordDictionary();
 
 private:
+    //! These take string views so that lookups needn't construct a string.
     class CStrHashIgnoreCase {
     public:
-        std::size_t operator()(const std::string& str) const;
+        std::size_t operator()(std::string_view str) const;
     };
 
     class CStrEqualIgnoreCase {
     public:
-        bool operator()(const std::string& lhs, const std::string& rhs) const;
+        bool operator()(std::string_view lhs, std::string_view rhs) const;
     };
 
 private:
@@ -209,8 +211,16 @@ private:
         boost::unordered_map<std::string, EPartOfSpeech, CStrHashIgnoreCase, CStrEqualIgnoreCase>;
     using TStrUMapCItr = TStrUMap::const_iterator;
 
+private:
+    //! Find \p str in the dictionary ignoring case.
+    TStrUMapCItr find(std::string_view str) const;
+
     //! Our dictionary of words
     TStrUMap m_DictionaryWords;
+
+    //! The length of the longest word in the dictionary.  Longer strings
+    //! are rejected without being hashed.
+    std::size_t m_MaxWordLength = 0;
 };
 }
 }
@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <functional>
 #include <future>
+#include <memory>
 #include <thread>
 #include <type_traits>
 #include <vector>
@@ -78,7 +79,11 @@ public:
     virtual ~CExecutor() = default;
     virtual void schedule(std::function<void()>&& f) = 0;
     virtual bool busy() const = 0;
-    virtual void busy(bool value) = 0;
+    //! Mark the executor busy or not and return whether it was busy.
+    //!
+    //! \note This is atomic so only one caller can see the executor go from
+    //! not busy to busy.
+    virtual bool busy(bool value) = 0;
 };
 
 //! Setup the global default executor for async.
@@ -108,6 +113,15 @@ CExecutor& defaultAsyncExecutor();
 CORE_EXPORT
 std::size_t defaultAsyncThreadPoolSize();
 
+//! Make an executor with its own thread pool.
+//!
+//! This is for work whose concurrency is set independently of the default async
+//! executor. Tasks scheduled on it don't affect whether the default executor is
+//! busy and vice versa. If \p threadPoolSize is less than two, or the pool can't
+//! be created, tasks execute in the thread which schedules them.
+CORE_EXPORT
+std::unique_ptr<CExecutor> makeThreadPoolExecutor(std::size_t threadPoolSize);
+
 namespace concurrency_detail {
 template<typename F, typename P>
 void invokeAndWriteResultToPromise(F& f, P& promise, const std::false_type&) {
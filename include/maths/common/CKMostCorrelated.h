@@ -12,6 +12,7 @@
 #ifndef INCLUDED_ml_maths_common_CKMostCorrelated_h
 #define INCLUDED_ml_maths_common_CKMostCorrelated_h
 
+#include <core/CAlignment.h>
 #include <core/CPackedBitVector.h>
 
 #include <maths/common/CBasicStatistics.h>
@@ -55,6 +56,21 @@ namespace common {
 //! components are the projected normalised residuals, finding the
 //! most correlated variables amounts to a collection neighbourhood
 //! searches around each point.
+//!
+//! IMPLEMENTATION:\n
+//! The projections of the values added between captures are accumulated
+//! in a single contiguous, 16 byte aligned, buffer with one block of
+//! NUMBER_PROJECTIONS doubles per variable which has received a value.
+//! Variables are mapped to their block by a dense index so add is a
+//! constant time vectorised update and capture only touches the blocks
+//! of variables which actually received values.
+//!
+//! The initial candidate pairs for the neighbourhood search are found
+//! by locality sensitive hashing. Each component of a projected point
+//! is itself a random projection of the residuals so its sign is a
+//! random hyperplane hash of the point. Points are bucketed on subsets
+//! of these signs and only points sharing a bucket with a point, or
+//! with its reflection for negative correlation, are compared.
 class MATHS_COMMON_EXPORT CKMostCorrelated {
 public:
     //! The number of projections of the data to maintain
@@ -130,6 +146,7 @@ protected:
 protected:
     using TMeanVarAccumulator = CBasicStatistics::SSampleMeanVar<double>::TAccumulator;
     using TMeanVarAccumulatorVec = std::vector<TMeanVarAccumulator>;
+    using TAlignedDoubleVec = std::vector<double, core::CAlignedAllocator<double>>;
     using TSizeVectorUMapCItr = TSizeVectorUMap::const_iterator;
     using TSizeVectorPackedBitVectorPrUMapItr = TSizeVectorPackedBitVectorPrUMap::iterator;
     using TSizeVectorPackedBitVectorPrUMapCItr = TSizeVectorPackedBitVectorPrUMap::const_iterator;
@@ -214,6 +231,15 @@ protected:
     //! Generate the next projection and reinitialize related state.
     void nextProjection();
 
+    //! Copy the current projection into the aligned buffer used by add.
+    void initializeCurrentProjection();
+
+    //! Get the values to add in the next capture keyed by variable.
+    TSizeVectorUMap currentProjected() const;
+
+    //! Set the values to add in the next capture from \p currentProjected.
+    void currentProjected(const TSizeVectorUMap& currentProjected);
+
     //! Get the projections.
     const TVectorVec& projections() const;
 
@@ -239,8 +265,19 @@ private:
     //! The random projections.
     TVectorVec m_Projections;
 
-    //! The values to add in the next capture.
-    TSizeVectorUMap m_CurrentProjected;
+    //! The current projection stored as doubles in an aligned block.
+    TAlignedDoubleVec m_CurrentProjection;
+
+    //! The block of m_CurrentProjected for each variable or npos if
+    //! the variable hasn't received a value since the last capture.
+    TSizeVec m_CurrentBlocks;
+
+    //! The variable owning each block of m_CurrentProjected.
+    TSizeVec m_CurrentVariables;
+
+    //! The values to add in the next capture stored in contiguous
+    //! aligned blocks of NUMBER_PROJECTIONS doubles.
+    TAlignedDoubleVec m_CurrentProjected;
 
     //! The projected variables' "normalised" residuals.
     TSizeVectorPackedBitVectorPrUMap m_Projected;
@@ -36,6 +36,8 @@ class CTimeSeriesCorrelations;
 namespace common {
 class CMultivariatePrior;
 class CPrior;
+struct SDistributionRestoreParams;
+struct STimeSeriesDecompositionRestoreParams;
 
 //! \brief Data describing a prediction error bar.
 struct MATHS_COMMON_EXPORT SErrorBar {
@@ -465,6 +467,20 @@ public:
     //! Returns true
     virtual bool shouldPersist() const;
 
+    //! Store the model state in a compact form if possible. This is intended
+    //! for models of time series which haven't received values for some time.
+    //!
+    //! \param[in] decompositionParams The parameters needed to restore the
+    //! time series decomposition.
+    //! \param[in] distributionParams The parameters needed to restore the
+    //! residual distribution models.
+    //! \note The default implementation is a no-op.
+    virtual void compact(const STimeSeriesDecompositionRestoreParams& decompositionParams,
+                         const SDistributionRestoreParams& distributionParams);
+
+    //! Check if the model state is stored in compact form.
+    virtual bool isCompact() const;
+
 protected:
     CModel(const CModel&) = default;
 
@@ -16,8 +16,7 @@
 
 #include <maths/common/ImportExport.h>
 
-#include <functional>
-#include <list>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -79,7 +78,9 @@ namespace common {
 //!
 //! This uses the fact the maximum length of the q-digest is \f$3k\f$
 //! to ensure constant complexity of all operations at various points
-//! and to reserve sufficient memory up front for our node allocator.
+//! and to reserve sufficient memory up front for the nodes. These are
+//! stored contiguously in a single array and link to one another by
+//! index. Nodes removed by compression are recycled via a free list.
 class MATHS_COMMON_EXPORT CQDigest : private core::CNonCopyable {
 public:
     using TUInt32UInt64Pr = std::pair<uint32_t, uint64_t>;
@@ -207,34 +208,27 @@ public:
     //@}
 
 private:
-    using TSizeVec = std::vector<std::size_t>;
-    using TSizeVecCItr = TSizeVec::const_iterator;
-    using TSizeGreater = std::greater<std::size_t>;
+    using TUInt32Vec = std::vector<uint32_t>;
 
-    class CNode;
-    class CNodeAllocator;
+    //! The index used for a missing node.
+    static constexpr uint32_t NO_NODE{std::numeric_limits<uint32_t>::max()};
 
-    using TNodePtrVec = std::vector<CNode*>;
-    using TNodePtrVecItr = TNodePtrVec::iterator;
-    using TNodePtrVecCItr = TNodePtrVec::const_iterator;
-    using TNodePtrVecCRItr = TNodePtrVec::const_reverse_iterator;
+    class CNode;
+    using TNodeVec = std::vector<CNode>;
 
-    //! Orders node pointers by level order.
+    //! Orders nodes by level order.
     struct MATHS_COMMON_EXPORT SLevelLess {
-        bool operator()(const CNode* lhs, const CNode* rhs) const;
+        bool operator()(const CNode& lhs, const CNode& rhs) const;
     };
 
-    //! Order node pointers by post order in completed tree.
+    //! Order nodes by post order in completed tree.
     struct MATHS_COMMON_EXPORT SPostLess {
-        bool operator()(const CNode* lhs, const CNode* rhs) const;
+        bool operator()(const CNode& lhs, const CNode& rhs) const;
     };
 
-    //! Check the state invariants after restoration
-    //! Abort on failure.
-    void checkRestoredInvariants() const;
-
-    //! Represents a node of the q-digest with convenience
-    //! operations for compression.
+    //! Represents a node of the q-digest.
+    //!
+    //! The tree links are indices into the digest's node array.
     class MATHS_COMMON_EXPORT CNode {
     public:
         //! \name XML Tag Names
@@ -250,47 +244,6 @@ private:
         CNode();
         CNode(uint32_t min, uint32_t max, uint64_t count, uint64_t subtreeCount);
 
-        //! Get the size of the q-digest rooted at this node.
-        std::size_t size() const;
-
-        //! Get the approximate quantile \p n.
-        uint32_t quantile(uint64_t leftCount, uint64_t n) const;
-
-        //! Get the largest value of x for which the upper count
-        //! i.e. count of values definitely to the right of x, is
-        //! less than \p n.
-        bool quantileSublevelSetSupremum(uint64_t n, uint64_t leftCount, uint32_t& result) const;
-
-        //! Get the lower bound for the c.d.f. at \p x.
-        void cdfLowerBound(uint32_t x, uint64_t& result) const;
-
-        //! Get the upper bound for the c.d.f. at \p x.
-        void cdfUpperBound(uint32_t x, uint64_t& result) const;
-
-        //! Get the maximum knot point less than \p x.
-        void sublevelSetSupremum(const int64_t x, uint32_t& result) const;
-
-        //! Get the minimum knot point greater than \p x.
-        void superlevelSetInfimum(uint32_t x, uint32_t& result) const;
-
-        //! Fill in \p nodes with q-digest nodes in post-order.
-        void postOrder(TNodePtrVec& nodes) const;
-
-        //! Expand the node to fit \p value.
-        CNode* expand(CNodeAllocator& allocator, const uint32_t& value);
-
-        //! Insert the specified node at its lowest ancestor
-        //! in the q-digest.
-        CNode& insert(CNodeAllocator& allocator, const CNode& node);
-
-        //! Compress the digest at the triple comprising this node,
-        //! its sibling and parent in the complete tree if they are
-        //! in the q-digest.
-        CNode* compress(CNodeAllocator& allocator, uint64_t compressionFactor);
-
-        //! Age the counts by the specified factor.
-        uint64_t age(double factor);
-
         //! Get the span of universe values covered by the node.
         uint32_t span() const;
         //! Get the minimum value covered by the node.
@@ -302,39 +255,9 @@ private:
         //! Get the count in the subtree rooted at this node.
         const uint64_t& subtreeCount() const;
 
-        //! Persist this node and descendents
-        void persistRecursive(const std::string& nodeTag,
-                              core::CStatePersistInserter& inserter) const;
-
-        //! Create from an XML node tree.
-        bool acceptRestoreTraverser(core::CStateRestoreTraverser& traverser);
-
-        //! Check the node invariants in the q-digest rooted at this node.
-        bool checkInvariants(uint64_t compressionFactor) const;
-
-        //! Print for debug.
-        std::string print() const;
-
-    private:
-        //! Persist state by passing information to the supplied
-        //! inserter - this should only be called by persistRecursive()
-        //! to ensure the whole tree gets persisted
-        void acceptPersistInserter(core::CStatePersistInserter& inserter) const;
-
         //! Test for equality.
         bool operator==(const CNode& node) const;
 
-        //! Get the index of the immediate ancestor in the q-digest.
-        CNode* ancestor() const;
-        //! Get the number of descendants.
-        std::size_t numberDescendants() const;
-        //! Get an iterator over the descendants.
-        TNodePtrVecCItr beginDescendants() const;
-        //! Get the end of the descendants.
-        TNodePtrVecCItr endDescendants() const;
-        //! Get the sibling of \p node if it exists in the q-digest.
-        CNode* sibling(const CNode& node) const;
-
         //! Is this a sibling of \p node?
         bool isSibling(const CNode& node) const;
         //! Is this a parent of \p node?
@@ -348,19 +271,22 @@ private:
         //! Is this the left child of a node in the complete tree.
         bool isLeftChild() const;
 
-        //! Detach this node from the q-digest.
-        void detach(CNodeAllocator& allocator);
-        //! Remove \p node from the descendants.
-        void removeDescendant(CNode& node);
-        //! Take the descendants of \p node.
-        bool takeDescendants(CNode& node);
+        //! Persist state by passing information to the supplied inserter.
+        void acceptPersistInserter(core::CStatePersistInserter& inserter) const;
+
+        //! Create from an XML node tree.
+        bool acceptRestoreTraverser(core::CStateRestoreTraverser& traverser);
+
+        //! Print for debug.
+        std::string print() const;
 
     private:
-        //! The immediate ancestor of this node in the q-digest.
-        CNode* m_Ancestor;
+        //! The index of the immediate ancestor of this node in the q-digest.
+        uint32_t m_Ancestor;
 
-        //! The immediate descendants of this node in the q-digest.
-        TNodePtrVec m_Descendants;
+        //! The indices of the immediate descendants of this node in the
+        //! q-digest in post-order.
+        TUInt32Vec m_Descendants;
 
         //! The minimum value covered by the node.
         uint32_t m_Min;
@@ -373,44 +299,103 @@ private:
 
         //! The count in the subtree root at this node.
         uint64_t m_SubtreeCount;
-    };
 
-    //! Manages the creation and recycling of nodes.
-    class MATHS_COMMON_EXPORT CNodeAllocator {
-    public:
-        CNodeAllocator(std::size_t size);
-
-        //! Create a new node.
-        CNode& create(const CNode& node);
-
-        //! Recycle \p node.
-        void release(CNode& node);
-
-    private:
-        using TNodePtrVecVec = std::vector<TNodePtrVec>;
-        using TNodeVec = std::vector<CNode>;
-        using TNodeVecCItr = std::vector<CNode>::const_iterator;
-        using TNodeVecList = std::list<TNodeVec>;
-        using TNodeVecListItr = TNodeVecList::iterator;
-        using TNodeVecListCItr = TNodeVecList::const_iterator;
-
-    private:
-        //! Find the block to which \p node belongs.
-        std::size_t findBlock(const CNode& node) const;
-
-    private:
-        TNodeVecList m_Nodes;
-        TNodePtrVecVec m_FreeNodes;
+        friend class CQDigest;
     };
 
 private:
+    //! Check the state invariants after restoration
+    //! Abort on failure.
+    void checkRestoredInvariants() const;
+
     //! Compress the q-digest bottom up in level order.
     void compress();
 
     //! Starting at the lowest nodes in \p compress in level order
     //! compress all q-digest paths bottom up in level order to the
     //! root.
-    bool compress(TNodePtrVec& compress);
+    bool compress(TUInt32Vec& compress);
+
+    //! \name Tree Operations
+    //!
+    //! These operate on the subtree of the q-digest rooted at the
+    //! node with index \p node.
+    //@{
+    //! Get the size of the q-digest rooted at \p node.
+    std::size_t subtreeSize(uint32_t node) const;
+
+    //! Get the approximate quantile \p n.
+    uint32_t subtreeQuantile(uint32_t node, uint64_t leftCount, uint64_t n) const;
+
+    //! Get the largest value of x for which the upper count
+    //! i.e. count of values definitely to the right of x, is
+    //! less than \p n.
+    bool subtreeQuantileSublevelSetSupremum(uint32_t node,
+                                            uint64_t n,
+                                            uint64_t leftCount,
+                                            uint32_t& result) const;
+
+    //! Get the lower bound for the c.d.f. at \p x.
+    void subtreeCdfLowerBound(uint32_t node, uint32_t x, uint64_t& result) const;
+
+    //! Get the upper bound for the c.d.f. at \p x.
+    void subtreeCdfUpperBound(uint32_t node, uint32_t x, uint64_t& result) const;
+
+    //! Get the maximum knot point less than \p x.
+    void subtreeSublevelSetSupremum(uint32_t node, const int64_t x, uint32_t& result) const;
+
+    //! Get the minimum knot point greater than \p x.
+    void subtreeSuperlevelSetInfimum(uint32_t node, uint32_t x, uint32_t& result) const;
+
+    //! Fill in \p nodes with q-digest nodes in post-order.
+    void postOrder(uint32_t node, TUInt32Vec& nodes) const;
+
+    //! Age the counts by the specified factor.
+    uint64_t age(uint32_t node, double factor);
+
+    //! Persist \p node and descendents.
+    void persistRecursive(uint32_t node, core::CStatePersistInserter& inserter) const;
+
+    //! Check the node invariants in the q-digest rooted at \p node.
+    bool checkSubtreeInvariants(uint32_t node, uint64_t compressionFactor) const;
+    //@}
+
+    //! Expand the root to fit \p value.
+    //!
+    //! \return True if the root was expanded.
+    bool expand(uint32_t value);
+
+    //! Insert a copy of \p value at its lowest ancestor in the
+    //! q-digest rooted at \p node.
+    //!
+    //! \return The index of the node which holds \p value.
+    uint32_t insert(uint32_t node, const CNode& value);
+
+    //! Compress the digest at the triple comprising \p node, its
+    //! sibling and parent in the complete tree if they are in the
+    //! q-digest.
+    //!
+    //! \return The index of the compressed node's parent or NO_NODE
+    //! if nothing was compressed.
+    uint32_t compress(uint32_t node, uint64_t compressionFactor);
+
+    //! Get the sibling of \p node among the descendants of \p ancestor
+    //! if it exists in the q-digest or NO_NODE otherwise.
+    uint32_t sibling(uint32_t ancestor, uint32_t node) const;
+
+    //! Detach \p node from the q-digest and recycle it.
+    void detach(uint32_t node);
+
+    //! Remove \p node from the descendants of \p ancestor.
+    void removeDescendant(uint32_t ancestor, uint32_t node);
+
+    //! Make the descendants of \p node which \p taker covers the
+    //! descendants of \p taker.
+    bool takeDescendants(uint32_t taker, uint32_t node);
+
+    //! Get a node with the same range and counts as \p node, reusing
+    //! a recycled node if there is one.
+    uint32_t createNode(const CNode& node);
 
 private:
     //! Controls the maximum number of values stored. In particular,
@@ -418,10 +403,14 @@ private:
     uint64_t m_K;
     //! The number of values added to the q-digest.
     uint64_t m_N;
-    //! The root node.
-    CNode* m_Root;
-    //! The node allocator.
-    CNodeAllocator m_NodeAllocator;
+    //! The index of the root node.
+    uint32_t m_Root;
+    //! The nodes of the q-digest, including recycled ones.
+    TNodeVec m_Nodes;
+    //! The indices of the recycled nodes.
+    TUInt32Vec m_FreeNodes;
+    //! Scratch space for the nodes to compress.
+    TUInt32Vec m_CompressionQueue;
     //! The rate at which information is lost by the digest.
     double m_DecayRate;
 };
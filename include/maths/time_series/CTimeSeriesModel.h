@@ -77,6 +77,11 @@ public:
     std::size_t identifier() const override;
 
     //! Create a copy of this model passing ownership to the caller.
+    //!
+    //! \note The copy shares the trend and residual models with this
+    //! model until either is first updated, at which point they are
+    //! copied. This makes creating models for new series from a common
+    //! prototype cheap.
     CUnivariateTimeSeriesModel* clone(std::size_t id) const override;
 
     //! Create a copy of the state we need to persist passing ownership
@@ -195,19 +200,41 @@ public:
     //! Get the type of data being modeled.
     maths_t::EDataType dataType() const override;
 
+    //! Store the trend and residual models in compressed persisted form.
+    //!
+    //! \note Const queries of a compact model are answered by a temporary
+    //! copy with the models restored, so they never modify this object or
+    //! change its memory usage. The models restored for the last compact
+    //! model queried on each thread are kept so a run of queries of one
+    //! model only restores them once. The models are restored permanently
+    //! the next time the model is updated.
+    void compact(const common::STimeSeriesDecompositionRestoreParams& decompositionParams,
+                 const common::SDistributionRestoreParams& distributionParams) override;
+
+    //! Check if the trend and residual models are stored in compact form.
+    bool isCompact() const override;
+
     //! Unpack the weights in \p weights.
     static TDoubleWeightsAry unpack(const TDouble2VecWeightsAry& weights);
 
     //! \name Test Functions
     //@{
     //! Get the trend.
+    //!
+    //! \warning The model must not be compact.
     const CTimeSeriesDecompositionInterface& trendModel() const;
 
     //! Get the residual model.
+    //!
+    //! \warning The model must not be compact.
     const common::CPrior& residualModel() const;
 
     //! Get the decay rate controllers.
     const TDecayRateController2Ary* decayRateControllers() const;
+
+    //! Get the number of times the models of a compact model have been
+    //! restored to answer const queries.
+    static std::size_t numberCompactStateRestores();
     //@}
 
 private:
@@ -226,10 +253,51 @@ private:
         core::CSmallVector<TMultivariatePriorCPtrSizePr, 1>;
     using TModelCPtr1Vec = core::CSmallVector<const CUnivariateTimeSeriesModel*, 1>;
 
+    //! \brief The compressed state of the trend and residual models.
+    struct SCompactState;
+    using TCompactStatePtr = std::unique_ptr<SCompactState>;
+
+    using TUnivariateTimeSeriesModelPtr = std::unique_ptr<CUnivariateTimeSeriesModel>;
+
+    //! The different ways a model can be copied.
+    enum ECopyType {
+        E_DeepCopy,     //!< Copy all state.
+        E_SharedCopy,   //!< Share the trend and residual models until written.
+        E_InflatedCopy, //!< Copy all state restoring any compact models.
+        E_ForecastCopy  //!< Copy only the state needed for forecasting.
+    };
+
 private:
     CUnivariateTimeSeriesModel(const CUnivariateTimeSeriesModel& other,
                                std::size_t id,
-                               bool isForForecast = false);
+                               ECopyType type = E_DeepCopy);
+
+    //! Copy any of the trend and residual models which are shared with
+    //! other models. This must be called before they are modified.
+    void copyOnWrite();
+
+    //! Restore the trend and residual models from their compact state and
+    //! discard it.
+    void inflate();
+
+    //! Restore the trend and residual models from \p state.
+    void inflate(const SCompactState& state);
+
+    //! Share the trend and residual models restored from \p state by the
+    //! last inflated copy made on this thread or restore them if they were
+    //! restored from different state.
+    void inflateShared(const SCompactState& state);
+
+    //! Get a copy of this model with the trend and residual models restored.
+    //! This is used to answer const queries of a compact model.
+    TUnivariateTimeSeriesModelPtr inflatedCopy() const;
+
+    //! Persist the state which is compacted by passing information to \p inserter.
+    void persistCompactState(core::CStatePersistInserter& inserter) const;
+
+    //! Restore the state which is compacted reading from \p traverser.
+    bool restoreCompactState(const common::SModelRestoreParams& params,
+                             core::CStateRestoreTraverser& traverser);
 
     //! Update the trend with \p samples.
     EUpdateResult updateTrend(const common::CModelAddSamplesParams& params,
@@ -287,18 +355,25 @@ private:
 
     //! The time series trend decomposition.
     //!
-    //! \note This can be temporarily be shared with the change detector.
+    //! \note This can be temporarily be shared with the change detector
+    //! and is shared with the model from which this was cloned until it
+    //! is first updated.
     TDecompositionPtr m_TrendModel;
 
     //! The time series' residual model.
     //!
-    //! \note This can be temporarily be shared with the change detector.
+    //! \note This can be temporarily be shared with the change detector
+    //! and is shared with the model from which this was cloned until it
+    //! is first updated.
     TPriorPtr m_ResidualModel;
 
     //! The multi-bucket feature to use.
     TMultibucketFeaturePtr m_MultibucketFeature;
 
     //! A model of the multi-bucket feature.
+    //!
+    //! \note This is shared with the model from which this was cloned
+    //! until it is first updated.
     TPriorPtr m_MultibucketFeatureModel;
 
     //! A model for time periods when the basic model can't predict the
@@ -307,6 +382,10 @@ private:
 
     //! Models the correlations between time series.
     CTimeSeriesCorrelations* m_Correlations;
+
+    //! The compressed state of the trend and residual models if the model
+    //! has been compacted.
+    TCompactStatePtr m_CompactState;
 };
 
 //! \brief Manages the creation correlate models.
@@ -129,6 +129,9 @@ struct MODEL_EXPORT SAnnotatedProbability {
     //! Efficiently swap the contents of this and \p other.
     void swap(SAnnotatedProbability& other) noexcept;
 
+    //! Reset to the default state retaining the memory of the vectors.
+    void clear();
+
     //! Is the result type interim?
     bool isInterim() const;
 
@@ -24,6 +24,7 @@
 #include <model/ImportExport.h>
 #include <model/ModelTypes.h>
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -274,6 +275,9 @@ public:
     //! Get the static size of this object - used for virtual hierarchies
     std::size_t staticSize() const override;
 
+    //! Recompute the memory used by the model's feature models.
+    void auditMemoryUsage() override;
+
     //! Returns true, as anomaly detectors do support pruning.
     bool supportsPruning() const override;
 
@@ -315,6 +319,14 @@ public:
     const TModelPtr& model() const;
     TModelPtr& model();
 
+    //! Get a counter which is incremented by every operation which may
+    //! change the persisted state of this detector. Two reads which return
+    //! the same value mean the state was unchanged between them.
+    //!
+    //! \note This is not persisted and is copied by the persistence
+    //! constructor so a copy can be identified as current.
+    std::uint64_t stateEpoch() const;
+
 protected:
     //! This function is called before adding a record allowing
     //! for varied preprocessing.
@@ -366,6 +378,9 @@ private:
     //! in the model ensemble class.
     void legacyModelsAcceptPersistInserter(core::CStatePersistInserter& inserter) const;
 
+    //! Prune models which haven't seen activity for \p maximumAge buckets.
+    void pruneModelsOlderThan(std::size_t maximumAge);
+
 private:
     //! Configurable limits
     CLimits& m_Limits;
@@ -390,6 +405,9 @@ private:
     //! necessary to create a valid persisted state?
     bool m_IsForPersistence;
 
+    //! Incremented whenever the state may have changed.
+    std::uint64_t m_StateEpoch{1};
+
     friend MODEL_EXPORT std::ostream& operator<<(std::ostream&, const CAnomalyDetector&);
 };
 
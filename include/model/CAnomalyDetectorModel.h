@@ -31,6 +31,7 @@
 #include <boost/optional.hpp>
 #include <boost/unordered_map.hpp>
 
+#include <cstdint>
 #include <functional>
 #include <limits>
 #include <map>
@@ -134,6 +135,7 @@ class MODEL_EXPORT CAnomalyDetectorModel {
 
 public:
     using TSizeVec = std::vector<std::size_t>;
+    using TUInt32Vec = std::vector<std::uint32_t>;
     using TDoubleVec = std::vector<double>;
     using TDouble1Vec = core::CSmallVector<double, 1>;
     using TDouble10Vec = core::CSmallVector<double, 10>;
@@ -458,6 +460,10 @@ public:
     //! Get the memory used by this model
     virtual std::size_t memoryUsage() const = 0;
 
+    //! Recompute the memory used by the parts of this model whose memory
+    //! usage is maintained incrementally.
+    virtual void auditMemoryUsage();
+
     //! Estimate the memory usage of the model based on number of people,
     //! attributes and correlations. Returns empty when the estimator
     //! is unable to produce an estimate.
@@ -526,8 +532,26 @@ protected:
         //! Debug the memory used by this model.
         void debugMemoryUsage(const core::CMemoryUsage::TMemoryUsagePtr& mem) const;
         //! Get the memory used by this model.
+        //!
+        //! \note This uses the memory of each model when it was last
+        //! refreshed rather than walking all the models.
         std::size_t memoryUsage() const;
 
+        //! Update the memory used by the model \p id. This must be called
+        //! whenever the model is created, updated or replaced.
+        void refreshMemoryUsage(std::size_t id);
+
+        //! Update the memory used by the models \p ids.
+        void refreshMemoryUsage(TSizeVec ids);
+
+        //! Recompute the memory used by every model.
+        //!
+        //! \note Models which share state with the prototype, or with one
+        //! another, are charged for their share when they're refreshed so
+        //! the incremental total can drift as models are cloned. This
+        //! corrects it.
+        void auditMemoryUsage();
+
         //! Determine whether the model should be persisted or not.
         bool shouldPersist() const;
 
@@ -537,6 +561,10 @@ protected:
         TMathsModelSPtr s_NewModel;
         //! The person models.
         TMathsModelUPtrVec s_Models;
+        //! The memory used by each model when it was last refreshed.
+        TUInt32Vec s_ModelsMemoryUsage;
+        //! The sum of s_ModelsMemoryUsage.
+        std::size_t s_TotalModelsMemoryUsage{0};
     };
     using TFeatureModelsVec = std::vector<SFeatureModels>;
 
@@ -185,6 +185,10 @@ public:
     //! model.
     static const double DEFAULT_PRUNE_WINDOW_SCALE_MAXIMUM;
 
+    //! The default number of buckets a person must be inactive before its
+    //! models are compacted.
+    static const std::size_t DEFAULT_COMPACT_MODELS_WINDOW;
+
     //! The default factor increase in priors used to model correlations.
     static const double DEFAULT_CORRELATION_MODELS_OVERHEAD;
 
@@ -269,6 +273,8 @@ public:
     void interimBucketCorrector(const TInterimBucketCorrectorPtr& interimBucketCorrector);
     //! Set whether to model multibucket features.
     void useMultibucketFeatures(bool enabled);
+    //! Set the number of buckets of inactivity after which to compact models.
+    void compactModelsWindow(std::size_t window);
     //! Set whether multivariate analysis of correlated 'by' fields should
     //! be performed.
     void multivariateByFields(bool enabled);
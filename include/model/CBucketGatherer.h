@@ -336,8 +336,9 @@ public:
     //! reset or false otherwise.
     virtual bool resetBucket(core_t::TTime bucketStart) = 0;
 
-    //! Release memory that is no longer needed
-    virtual void releaseMemory(core_t::TTime samplingCutoffTime) = 0;
+    //! Release memory that is no longer needed and return true if
+    //! anything was released.
+    virtual bool releaseMemory(core_t::TTime samplingCutoffTime) = 0;
 
     //! Remove the values in queue for the people or attributes
     //! in \p toRemove.
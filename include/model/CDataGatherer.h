@@ -597,8 +597,9 @@ public:
     //! reset or false otherwise.
     bool resetBucket(core_t::TTime bucketStart);
 
-    //! Release memory that is no longer needed
-    void releaseMemory(core_t::TTime samplingCutoffTime);
+    //! Release memory that is no longer needed and return true if
+    //! anything was released.
+    bool releaseMemory(core_t::TTime samplingCutoffTime);
 
     //! Get the global configuration parameters.
     const SModelParams& params() const;
@@ -31,6 +31,7 @@
 #include <iosfwd>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <stdint.h>
 
@@ -45,6 +46,7 @@ namespace model {
 class MODEL_EXPORT CForecastDataSink final : private core::CNonCopyable {
 public:
     using TMathsModelPtr = std::shared_ptr<maths::common::CModel>;
+    using TErrorBarVec = std::vector<maths::common::SErrorBar>;
     using TStrUMap = boost::unordered_set<std::string>;
     struct SForecastResultSeries;
 
@@ -63,13 +65,21 @@ public:
         CForecastModelWrapper(const CForecastModelWrapper&) = delete;
         CForecastModelWrapper& operator=(const CForecastModelWrapper&) = delete;
 
-        bool forecast(const SForecastResultSeries& series,
-                      core_t::TTime startTime,
+        //! Forecast the model buffering the results in \p errorBars.
+        //!
+        //! \note This doesn't touch any shared state so distinct models can
+        //! be forecast concurrently.
+        bool forecast(core_t::TTime startTime,
                       core_t::TTime endTime,
                       double boundsPercentile,
-                      CForecastDataSink& sink,
+                      TErrorBarVec& errorBars,
                       std::string& message) const;
 
+        //! Write the buffered forecast \p errorBars of this model to \p sink.
+        void write(const SForecastResultSeries& series,
+                   const TErrorBarVec& errorBars,
+                   CForecastDataSink& sink) const;
+
     private:
         model_t::EFeature m_Feature;
         std::string m_ByFieldValue;
@@ -12,8 +12,7 @@
 #ifndef INCLUDED_ml_model_CForecastModelPersist_h
 #define INCLUDED_ml_model_CForecastModelPersist_h
 
-#include <core/CJsonStatePersistInserter.h>
-#include <core/CJsonStateRestoreTraverser.h>
+#include <core/CoreTypes.h>
 
 #include <maths/common/CModel.h>
 
@@ -23,13 +22,16 @@
 
 #include <boost/filesystem.hpp>
 
+#include <cstdint>
 #include <fstream>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace ml {
 namespace model {
 
-//! \brief Persist/Restore CModel sub-classes to/from text representations for
+//! \brief Persist/Restore CModel sub-classes to/from binary representations for
 //!  the purpose of forecasting.
 //!
 //! DESCRIPTION:\n
@@ -42,9 +44,16 @@ namespace model {
 //! Persist and Restore are only done to avoid heap memory usage using temporary disk space.
 //! No need for backwards compatibility and version'ing as code will only be used
 //! locally never leaving process/io boundaries.
+//!
+//! Each model is written as a length prefixed record of its deflated binary state
+//! so the file is compact and is read sequentially one record at a time. The binary
+//! format is much cheaper to write and read back than JSON. Reading a record is
+//! separated from restoring the model it holds so that models can be restored, and
+//! forecast, on multiple threads in bounded batches.
 class MODEL_EXPORT CForecastModelPersist final {
 public:
     using TMathsModelPtr = std::unique_ptr<maths::common::CModel>;
+    using TByteVec = std::vector<std::uint8_t>;
 
 public:
     class MODEL_EXPORT CPersist final {
@@ -85,6 +94,21 @@ public:
                        model_t::EFeature& feature,
                        std::string& byFieldValue);
 
+        //! Read the next persisted model record into \p record.
+        //!
+        //! \return False if there are no more records or reading failed.
+        bool nextRecord(TByteVec& record);
+
+        //! Restore the model persisted in \p record.
+        //!
+        //! \note This is thread safe.
+        bool restoreModel(const TByteVec& record,
+                          TMathsModelPtr& model,
+                          core_t::TTime& firstDataTime,
+                          core_t::TTime& lastDataTime,
+                          model_t::EFeature& feature,
+                          std::string& byFieldValue) const;
+
     private:
         //! model parameters required in order to restore the model
         const SModelParams m_ModelParams;
@@ -94,9 +118,6 @@ public:
 
         //! the actual file where the models are persisted
         std::ifstream m_InStream;
-
-        //! the model state restorer
-        core::CJsonStateRestoreTraverser m_RestoreTraverser;
     }; // class CRestore
 };     // class CForecastModelPersist
 }
@@ -150,6 +150,10 @@ struct MODEL_EXPORT SNode {
     //! Efficient swap
     void swap(SNode& other) noexcept;
 
+    //! Reset to the state of a default constructed node retaining the
+    //! memory the node's containers have allocated.
+    void clear();
+
     //! \name Connectivity
     //@{
     //! The node's parent.
@@ -219,7 +223,9 @@ class CHierarchicalResultsVisitor;
 //! An abstract visitor pattern is implemented, with the intention of
 //! factoring out logic to, for example, output hierarchical results and
 //! aggregate the probabilities up the tree. Both bottom up depth and
-//! breadth first visiting strategies have been implemented.
+//! breadth first visiting strategies have been implemented. The breadth
+//! first strategies visit the nodes of each level of the tree in parallel
+//! for visitors which support it.
 //!
 //! IMPLEMENTATION:\n
 //! This loosely implements a builder pattern: each simple search result
@@ -227,6 +233,12 @@ class CHierarchicalResultsVisitor;
 //! then the hierarchical object is built (although buildHierarchy can
 //! be called repeatedly).
 //!
+//! The nodes are pooled: clear resets them rather than freeing them so
+//! an object which is reused to build the results for each bucket only
+//! allocates nodes when it sees more results than it has done before.
+//! Leaves swap their annotated probability with the one supplied, which
+//! hands the previous occupant's vectors back to the caller for reuse.
+//!
 //! Most of the state of this class is held by reference and could become
 //! invalid if it is kept longer than to output a single result. This is
 //! to minimize the amount of state that needs to be copied when outputting
@@ -234,6 +246,7 @@ class CHierarchicalResultsVisitor;
 class MODEL_EXPORT CHierarchicalResults {
 public:
     using TDoubleVec = std::vector<double>;
+    using TSizeVec = std::vector<std::size_t>;
     using TAttributeProbabilityVec = std::vector<SAttributeProbability>;
     using TResultSpec = hierarchical_results_detail::SResultSpec;
     using TStoredStringPtr = core::CStoredStringPtr;
@@ -335,9 +348,17 @@ public:
                             const TStoredStringPtr& influencerValue) const;
 
     //! Bottom up first visit the tree.
+    //!
+    //! \note If \p visitor can visit a level in parallel then the nodes
+    //! of each level are visited in parallel, but all the nodes of a level
+    //! are visited before any node of the level above.
     void bottomUpBreadthFirst(CHierarchicalResultsVisitor& visitor) const;
 
     //! Top down first visit the tree.
+    //!
+    //! \note If \p visitor can visit a level in parallel then the nodes
+    //! of each level are visited in parallel, but all the nodes of a level
+    //! are visited before any node of the level below.
     void topDownBreadthFirst(CHierarchicalResultsVisitor& visitor) const;
 
     //! Post-order depth first visit the tree.
@@ -360,6 +381,11 @@ public:
     //! Sets the result to be interm
     void setInterim();
 
+    //! Remove all the results and reset the result type to final.
+    //!
+    //! \note The nodes are retained for reuse by subsequent results.
+    void clear();
+
     //! Get type of result
     model_t::CResultType resultType() const;
 
@@ -367,7 +393,7 @@ public:
     std::string print() const;
 
 private:
-    //! Create a new node.
+    //! Create a new node, reusing a pooled node if one is available.
     TNode& newNode();
 
     //! Create a new leaf node for the simple search \p simpleSearch.
@@ -382,10 +408,21 @@ private:
     //! Post-order depth first visit the tree.
     void postorderDepthFirst(const TNode* node, CHierarchicalResultsVisitor& visitor) const;
 
+    //! Get the boundaries of the levels of the tree in the node storage.
+    void levels(TSizeVec& result) const;
+
 private:
-    //! Storage for the nodes.
+    //! Storage for the nodes. Only the first m_NumberNodes are in use and
+    //! the rest are cleared nodes available for reuse.
     TNodeDeque m_Nodes;
 
+    //! The number of nodes in use.
+    std::size_t m_NumberNodes;
+
+    //! The end of each level of the tree in the node storage. The nodes
+    //! of a level are never ancestors of one another.
+    TSizeVec m_LevelEnds;
+
     //! Storage for the pivot nodes.
     TStoredStringPtrStoredStringPtrPrNodeMap m_PivotNodes;
 
@@ -409,6 +446,12 @@ public:
     //! Visit a node.
     virtual void visit(const CHierarchicalResults& results, const TNode& node, bool pivot) = 0;
 
+    //! Check if the nodes of a level of the tree can be visited in parallel.
+    //!
+    //! This is false by default. Visitors can opt in if visit only modifies
+    //! the node it is passed and only reads the visitor's own state.
+    virtual bool canVisitLevelInParallel() const;
+
 protected:
     //! Check if this node is the root node.
     static bool isRoot(const TNode& node);
@@ -120,6 +120,12 @@ public:
     //! Update the normalizer with the node's anomaly score.
     void visit(const CHierarchicalResults& results, const TNode& node, bool pivot) override;
 
+    //! Returns true when normalizing scores, which only reads the quantiles.
+    //!
+    //! \note This relies on the normalizers for every node already existing,
+    //! which is the case after a E_RefreshSettings pass over the same results.
+    bool canVisitLevelInParallel() const override;
+
     //! Age the maximum scores and quantile summaries.
     void propagateForwardByTime(double time);
 
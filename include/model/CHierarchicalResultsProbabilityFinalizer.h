@@ -33,6 +33,9 @@ class MODEL_EXPORT CHierarchicalResultsProbabilityFinalizer : public CHierarchic
 public:
     //! Finalize the probability of \p node.
     void visit(const CHierarchicalResults& results, const TNode& node, bool pivot) override;
+
+    //! Returns true since each node's probability is finalized independently.
+    bool canVisitLevelInParallel() const override;
 };
 }
 }
@@ -17,6 +17,7 @@
 #include <core/CoreTypes.h>
 
 #include <model/CAnomalyDetectorModel.h>
+#include <model/CLastBucketTimeIndex.h>
 #include <model/CMemoryUsageEstimator.h>
 #include <model/ImportExport.h>
 
@@ -155,6 +156,9 @@ public:
     //! Get the memory used by this model.
     std::size_t memoryUsage() const override = 0;
 
+    //! Recompute the memory used by the feature models.
+    void auditMemoryUsage() override;
+
     //! Get the static size of this object - used for virtual hierarchies.
     std::size_t staticSize() const override = 0;
 
@@ -250,6 +254,10 @@ protected:
     //! Get a writable model corresponding to \p feature of the person \p pid.
     maths::common::CModel* model(model_t::EFeature feature, std::size_t pid);
 
+    //! Update the memory used by the models of \p feature for \p people
+    //! after they've been updated.
+    void refreshMemoryUsage(model_t::EFeature feature, TSizeVec people);
+
     //! Sample the correlate models.
     void sampleCorrelateModels();
 
@@ -284,6 +292,14 @@ private:
     //! Perform derived class specific operations to accomplish skipping sampling
     void doSkipSampling(core_t::TTime startTime, core_t::TTime endTime) override;
 
+    //! Compact the models of people who have just become inactive at \p time.
+    //!
+    //! \note The models are expanded again when they're next updated.
+    void compactInactiveModels(core_t::TTime time);
+
+    //! Rebuild the index of people by their last bucket times.
+    void rebuildLastBucketTimeIndex();
+
     //! Get the model memory usage estimator
     CMemoryUsageEstimator* memoryUsageEstimator() const override;
 
@@ -294,6 +310,9 @@ private:
     //! The last time that each person was seen.
     TTimeVec m_LastBucketTimes;
 
+    //! The people indexed by the last time they were seen.
+    CLastBucketTimeIndex m_LastBucketTimeIndex;
+
     //! The models of all the correlates for each feature.
     //!
     //! IMPORTANT this must come before m_FeatureModels in the class declaration
@@ -0,0 +1,146 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+
+#ifndef INCLUDED_ml_model_CLastBucketTimeIndex_h
+#define INCLUDED_ml_model_CLastBucketTimeIndex_h
+
+#include <core/CMemoryUsage.h>
+#include <core/CoreTypes.h>
+
+#include <model/ImportExport.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace ml {
+namespace model {
+
+//! \brief Indexes identifiers by the start time of the last bucket in
+//! which they had data.
+//!
+//! DESCRIPTION:\n
+//! The models need to find the people, or attributes, which were last
+//! seen at a particular time, for example to compact their models once
+//! they've been inactive for a while, or which haven't been seen for a
+//! given number of buckets, for example to prune them. Scanning every
+//! identifier for this costs time proportional to the total number of
+//! series rather than the number which are found.
+//!
+//! IMPLEMENTATION DECISIONS:\n
+//! The identifiers last seen at each time are stored in an intrusive
+//! doubly linked list so that moving an identifier to a new time and
+//! visiting the identifiers last seen at a time are both constant time
+//! per identifier. The lists are ordered by time so the identifiers which
+//! were last seen before a given time can be visited oldest first. The
+//! state is derived from the models' last bucket times so it isn't
+//! persisted.
+class MODEL_EXPORT CLastBucketTimeIndex {
+public:
+    //! Set the number of identifiers to \p n.
+    //!
+    //! \note New identifiers are initially not indexed.
+    void resize(std::size_t n);
+
+    //! Record that \p id was last seen in the bucket starting at \p time.
+    void update(std::size_t id, core_t::TTime time);
+
+    //! Remove \p id from the index.
+    void remove(std::size_t id);
+
+    //! Remove all identifiers from the index.
+    void clear();
+
+    //! Get the number of identifiers which are indexed.
+    std::size_t size() const;
+
+    //! Apply \p f to each identifier last seen at \p time.
+    //!
+    //! \note \p f must not modify the index.
+    template<typename F>
+    void forEach(core_t::TTime time, F f) const {
+        auto head = m_Heads.find(time);
+        if (head == m_Heads.end()) {
+            return;
+        }
+        for (std::uint32_t id = head->second; id != NONE; id = m_Entries[id].s_Next) {
+            f(static_cast<std::size_t>(id));
+        }
+    }
+
+    //! Apply \p f to each identifier last seen more than \p maximumAge
+    //! buckets of length \p bucketLength before the bucket starting at
+    //! \p time.
+    //!
+    //! \note The identifiers are visited in order of the time they were
+    //! last seen and \p f must not modify the index.
+    template<typename F>
+    void forEachOlderThan(core_t::TTime time,
+                          core_t::TTime bucketLength,
+                          std::size_t maximumAge,
+                          F f) const {
+        core_t::TTime cutoff{ageCutoff(time, bucketLength, maximumAge)};
+        for (auto head = m_Heads.begin(); head != m_Heads.end() && head->first < cutoff; ++head) {
+            for (std::uint32_t id = head->second; id != NONE; id = m_Entries[id].s_Next) {
+                f(static_cast<std::size_t>(id));
+            }
+        }
+    }
+
+    //! Debug the memory used by this object.
+    void debugMemoryUsage(const core::CMemoryUsage::TMemoryUsagePtr& mem) const;
+
+    //! Get the memory used by this object.
+    std::size_t memoryUsage() const;
+
+private:
+    //! Marks the end of a list.
+    static constexpr std::uint32_t NONE{std::numeric_limits<std::uint32_t>::max()};
+    //! The time of identifiers which aren't indexed.
+    static constexpr core_t::TTime UNINDEXED{std::numeric_limits<core_t::TTime>::min()};
+
+    //! \brief The position of an identifier in the list for its time.
+    struct SEntry {
+        bool indexed() const { return s_Time != UNINDEXED; }
+
+        core_t::TTime s_Time{UNINDEXED};
+        std::uint32_t s_Previous{NONE};
+        std::uint32_t s_Next{NONE};
+    };
+
+    using TEntryVec = std::vector<SEntry>;
+    using TTimeUInt32Map = std::map<core_t::TTime, std::uint32_t>;
+
+private:
+    //! Get the time before which identifiers are more than \p maximumAge
+    //! buckets older than \p time.
+    static core_t::TTime
+    ageCutoff(core_t::TTime time, core_t::TTime bucketLength, std::size_t maximumAge);
+
+    //! Remove \p id from the list for its time.
+    void unlink(std::uint32_t id);
+
+private:
+    //! The list entries for each identifier.
+    TEntryVec m_Entries;
+
+    //! The heads of the lists of the identifiers last seen at each time.
+    TTimeUInt32Map m_Heads;
+
+    //! The number of identifiers which are indexed.
+    std::size_t m_Size{0};
+};
+}
+}
+
+#endif // INCLUDED_ml_model_CLastBucketTimeIndex_h
@@ -210,8 +210,9 @@ public:
     //! Reset bucket and return true if bucket was successfully reset or false otherwise.
     bool resetBucket(core_t::TTime bucketStart) override;
 
-    //! Release memory that is no longer needed
-    void releaseMemory(core_t::TTime samplingCutoffTime) override;
+    //! Release memory that is no longer needed and return true if
+    //! anything was released.
+    bool releaseMemory(core_t::TTime samplingCutoffTime) override;
 
     //! \name Features
     //@{
@@ -289,6 +289,9 @@ public:
     //! Get the memory used by this model.
     std::size_t memoryUsage() const override;
 
+    //! Recompute the memory used by the feature models.
+    void auditMemoryUsage() override;
+
     //! Get the static size of this object - used for virtual hierarchies
     std::size_t staticSize() const override;
 
@@ -344,6 +347,10 @@ private:
     //! by \p cid.
     maths::common::CModel* model(model_t::EFeature feature, std::size_t pid);
 
+    //! Update the memory used by the models of \p feature for \p attributes
+    //! after they've been updated.
+    void refreshMemoryUsage(model_t::EFeature feature, TSizeVec attributes);
+
     //! Check if there are correlates for \p feature and the person and
     //! attribute identified by \p pid and \p cid, respectively.
     bool correlates(model_t::EFeature feature, std::size_t pid, std::size_t cid, core_t::TTime time) const;
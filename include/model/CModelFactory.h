@@ -341,6 +341,12 @@ public:
     //! \note A length of zero disables modeling of multibucket features altogether.
     void multibucketFeaturesWindowLength(std::size_t length);
 
+    //! Set the number of buckets a person must be inactive before their
+    //! models are compacted.
+    //!
+    //! \note A window of zero disables compacting models altogether.
+    void compactModelsWindow(std::size_t window);
+
     //! Set whether multivariate analysis of correlated 'by' fields should
     //! be performed.
     void multivariateByFields(bool enabled);
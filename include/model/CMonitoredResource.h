@@ -45,6 +45,10 @@ public:
     //! Get the static size of the derived class
     virtual std::size_t staticSize() const = 0;
 
+    //! Recompute any memory usage which this monitored resource maintains
+    //! incrementally by walking all its state.
+    virtual void auditMemoryUsage();
+
     //! Does this monitored resource support pruning?
     virtual bool supportsPruning() const;
 
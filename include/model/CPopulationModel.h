@@ -25,6 +25,7 @@
 
 #include <model/CAnomalyDetectorModel.h>
 #include <model/CFeatureData.h>
+#include <model/CLastBucketTimeIndex.h>
 #include <model/ImportExport.h>
 #include <model/ModelTypes.h>
 
@@ -33,6 +34,10 @@
 #include <utility>
 #include <vector>
 
+namespace CEventRatePopulationModelTest {
+class CTestFixture;
+}
+
 namespace ml {
 namespace core {
 class CStatePersistInserter;
@@ -278,6 +283,10 @@ protected:
 private:
     using TOptionalCountMinSketch = boost::optional<maths::time_series::CCountMinSketch>;
 
+private:
+    //! Rebuild the indices of people and attributes by their last bucket times.
+    void rebuildLastBucketTimeIndices();
+
 private:
     //! The last time each person was seen.
     TTimeVec m_PersonLastBucketTimes;
@@ -288,6 +297,12 @@ private:
     //! The last time each attribute was seen.
     TTimeVec m_AttributeLastBucketTimes;
 
+    //! The people indexed by the last time they were seen.
+    CLastBucketTimeIndex m_PersonLastBucketTimeIndex;
+
+    //! The attributes indexed by the last time they were seen.
+    CLastBucketTimeIndex m_AttributeLastBucketTimeIndex;
+
     //! The initial sketch to use for estimating the number of distinct people.
     maths::common::CBjkstUniqueValues m_NewDistinctPersonCounts;
 
@@ -300,6 +315,9 @@ private:
     //! The bucket count of each (person, attribute) pair in the exponentially
     //! decaying window with decay rate equal to CAnomalyDetectorModel::m_DecayRate.
     TCountMinSketchVec m_PersonAttributeBucketCounts;
+
+    //! Test friends
+    friend class CEventRatePopulationModelTest::CTestFixture;
 };
 }
 }
@@ -124,6 +124,9 @@ public:
         double s_Cutoff;
         //! If true then add in influences greater than the cutoff.
         bool s_IncludeCutoff;
+        //! A cache of the probabilities of the influenced values of
+        //! s_Value if there is one.
+        CModelTools::CProbabilityCache* s_ProbabilityCache;
         //! Filled in with the influences of s_Value if any.
         TStoredStringPtrStoredStringPtrPrDoublePrVec s_Influences;
     };
@@ -353,6 +356,11 @@ private:
     //! The probability calculation cache if there is one.
     CModelTools::CProbabilityCache* m_ProbabilityCache;
 
+    //! The probabilities of the influenced values of the last value
+    //! added. These are shared by all influencer fields of that value
+    //! and many influencer field values have the same influenced value.
+    CModelTools::CProbabilityCache m_InfluenceProbabilityCache;
+
     //! The influence probability calculator.
     CModelTools::TStoredStringPtrStoredStringPtrPrProbabilityAggregatorUMap m_InfluencerProbabilities;
 
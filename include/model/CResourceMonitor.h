@@ -28,6 +28,7 @@ class CTestFixture;
 struct testMonitor;
 struct testPeakUsage;
 struct testPruning;
+struct testRetainedMemory;
 struct testUpdateMoments;
 }
 namespace CResourceLimitTest {
@@ -108,13 +109,21 @@ public:
     //! Register a callback to be used when the memory usage grows
     void memoryUsageReporter(const TMemoryUsageReporterFunc& reporter);
 
+    //! Get the memory usage of \p resource when it was last refreshed.
+    std::size_t lastMemoryUsage(const CMonitoredResource& resource) const;
+
     //! Recalculate the memory usage if there is a memory limit
+    //!
+    //! \note This uses the memory usage which \p resource maintains
+    //! incrementally, which is cheap to compute.
     void refresh(CMonitoredResource& resource);
 
-    //! Recalculate the memory usage regardless of whether there is a memory limit
+    //! Recalculate the memory usage regardless of whether there is a memory
+    //! limit, auditing the memory usage \p resource maintains incrementally.
     void forceRefresh(CMonitoredResource& resource);
 
-    //! Recalculate the memory usage for all monitored resources
+    //! Recalculate the memory usage for all monitored resources auditing
+    //! the memory usage they maintain incrementally.
     void forceRefreshAll();
 
     //! Set the internal memory limit, as specified in a limits config file
@@ -173,6 +182,12 @@ public:
     //! Clears all extra memory
     void clearExtraMemory();
 
+    //! Set the memory used by state which is kept in addition to the
+    //! monitored resources, such as copies of them made for background
+    //! persistence. This counts towards the memory limit but, since it
+    //! isn't model state, not towards the reported memory usage.
+    void retainedMemory(std::size_t memory);
+
     //! Decrease the margin on the memory limit.
     //!
     //! We start off applying a 'safety' margin to the memory limit because
@@ -210,6 +225,10 @@ private:
     //! shoule be allowed or not
     void updateAllowAllocations();
 
+    //! Check whether allocations should be allowed given \p total memory
+    //! used by monitored resources.
+    void updateAllowAllocations(std::size_t total);
+
     //! Get the high memory limit with margin applied.
     std::size_t highLimit() const;
 
@@ -250,6 +269,9 @@ private:
     //! Extra memory to enable accounting of soon to be allocated memory
     std::size_t m_ExtraMemory{0};
 
+    //! Memory retained in addition to the monitored resources.
+    std::size_t m_RetainedMemory{0};
+
     //! The total memory usage on the previous usage report
     std::size_t m_PreviousTotal;
 
@@ -310,6 +332,7 @@ private:
     friend struct CResourceMonitorTest::testMonitor;
     friend struct CResourceMonitorTest::testPeakUsage;
     friend struct CResourceMonitorTest::testPruning;
+    friend struct CResourceMonitorTest::testRetainedMemory;
     friend struct CResourceMonitorTest::testUpdateMoments;
     friend class CResourceLimitTest::CTestFixture;
     friend struct CAnomalyJobLimitTest::testAccuracy;
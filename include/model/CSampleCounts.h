@@ -79,8 +79,12 @@ public:
     //! Update the mean non-zero bucket counts and age the count data.
     void updateMeanNonZeroBucketCount(std::size_t id, double count, double alpha);
 
-    //! Refresh the sample count identified by \p id.
-    void refresh(const CDataGatherer& gatherer);
+    //! Refresh the sample counts identified by \p ids.
+    //!
+    //! \note Only the sample counts whose mean non-zero bucket counts have
+    //! been updated since they were last refreshed can change, so \p ids
+    //! need only include those.
+    void refresh(const CDataGatherer& gatherer, const TSizeVec& ids);
 
     //! Recycle the sample counts identified by \p idsToRemove.
     void recycle(const TSizeVec& idsToRemove);
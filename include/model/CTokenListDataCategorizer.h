@@ -20,8 +20,10 @@
 #include <model/CTokenListDataCategorizerBase.h>
 
 #include <algorithm>
-#include <cctype>
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace ml {
 namespace model {
@@ -101,36 +103,36 @@ protected:
         tokenUniqueIds.clear();
         totalWeight = 0;
 
-        std::string temp;
+        std::string_view remainder{str};
+        if (TRUNCATE_AT_NEWLINE) {
+            remainder = remainder.substr(0, remainder.find('\n'));
+        }
 
-        // TODO - make more efficient
+        // Basically tokenise into [a-zA-Z0-9/]+ strings, possibly allowing
+        // underscores, dots and dashes in the middle.  Tokens are found as
+        // spans of the string so that nothing is copied until a token gets
+        // past the cheap checks in considerToken().
+        std::string token;
+        std::size_t tokenStart{0};
+        std::size_t tokenLength{0};
         std::string::size_type nonHexPos(std::string::npos);
-        for (const char curChar : str) {
-
-            if (TRUNCATE_AT_NEWLINE && curChar == '\n') {
-                break;
-            }
-
-            // Basically tokenise into [a-zA-Z0-9/]+ strings, possibly
-            // allowing underscores, dots and dashes in the middle
-            if (std::isalnum(static_cast<unsigned char>(curChar)) ||
-                (!temp.empty() && ((ALLOW_UNDERSCORE && curChar == '_') ||
-                                   (ALLOW_DOT && curChar == '.') ||
-                                   (ALLOW_DASH && curChar == '-'))) ||
-                (ALLOW_FORWARD_SLASH && curChar == '/')) {
-                temp += curChar;
-                if (IGNORE_HEX) {
-                    // Count dots and dashes as numeric
-                    if (!std::isxdigit(static_cast<unsigned char>(curChar)) &&
-                        curChar != '.' && curChar != '-') {
-                        nonHexPos = temp.length() - 1;
-                    }
+        for (std::size_t i = 0; i < remainder.length(); ++i) {
+            std::uint8_t charClass{CHAR_CLASSES[static_cast<unsigned char>(remainder[i])]};
+            if ((charClass & E_TokenStart) != 0 ||
+                (tokenLength > 0 && (charClass & E_TokenContinue) != 0)) {
+                if (tokenLength == 0) {
+                    tokenStart = i;
+                }
+                ++tokenLength;
+                if (IGNORE_HEX && (charClass & E_NonHex) != 0) {
+                    nonHexPos = tokenLength - 1;
                 }
             } else {
-                if (!temp.empty()) {
-                    this->considerToken(fields, nonHexPos, temp, tokenIds,
-                                        tokenUniqueIds, totalWeight);
-                    temp.clear();
+                if (tokenLength > 0) {
+                    this->considerToken(fields, nonHexPos,
+                                        remainder.substr(tokenStart, tokenLength),
+                                        token, tokenIds, tokenUniqueIds, totalWeight);
+                    tokenLength = 0;
                 }
 
                 if (IGNORE_HEX) {
@@ -139,8 +141,9 @@ protected:
             }
         }
 
-        if (!temp.empty()) {
-            this->considerToken(fields, nonHexPos, temp, tokenIds, tokenUniqueIds, totalWeight);
+        if (tokenLength > 0) {
+            this->considerToken(fields, nonHexPos, remainder.substr(tokenStart, tokenLength),
+                                token, tokenIds, tokenUniqueIds, totalWeight);
         }
 
         LOG_TRACE(<< str << " tokenised to " << tokenIds.size() << " tokens with total weight "
@@ -218,15 +221,18 @@ private:
     }
 
     //! Consider adding a token to the data structures that will be used in
-    //! the comparison.  The \p token argument must not be empty when this
-    //! method is called.  This method may modify \p token.
+    //! the comparison.  The \p tokenSpan argument must not be empty when this
+    //! method is called.  \p token is used to hold a copy of the token if it
+    //! is needed.
     void considerToken(const TStrStrUMap& fields,
                        std::string::size_type nonHexPos,
+                       std::string_view tokenSpan,
                        std::string& token,
                        TSizeSizePrVec& tokenIds,
                        TSizeSizeMap& tokenUniqueIds,
                        std::size_t& totalWeight) {
-        if (IGNORE_LEADING_DIGIT && std::isdigit(static_cast<unsigned char>(token[0]))) {
+        if (IGNORE_LEADING_DIGIT &&
+            (CHAR_CLASSES[static_cast<unsigned char>(tokenSpan[0])] & E_Digit) != 0) {
             return;
         }
 
@@ -243,16 +249,21 @@ private:
             // check to be completely compiled away as IGNORE_LEADING_DIGIT
             // is a template argument
             if (!IGNORE_LEADING_DIGIT && nonHexPos == 1 &&
-                token.compare(0, 2, "0x") == 0 && token.length() != 2) {
+                tokenSpan.compare(0, 2, "0x") == 0 && tokenSpan.length() != 2) {
                 // Implies hex with 0x prefix.
                 return;
             }
         }
 
         // If the last character is not alphanumeric, strip it.
-        while (!std::isalnum(static_cast<unsigned char>(token[token.length() - 1]))) {
-            token.erase(token.length() - 1);
+        while (tokenSpan.empty() == false &&
+               (CHAR_CLASSES[static_cast<unsigned char>(tokenSpan.back())] & E_AlphaNumeric) == 0) {
+            tokenSpan.remove_suffix(1);
+        }
+        if (tokenSpan.empty()) {
+            return;
         }
+        token.assign(tokenSpan);
 
         if (IGNORE_DATE_WORDS && core::CTimeUtils::isDateWord(token)) {
             return;
@@ -265,6 +276,57 @@ private:
         this->tokenToIdAndWeight(token, tokenIds, tokenUniqueIds, totalWeight);
     }
 
+private:
+    //! Character classes used by the tokeniser.
+    enum ECharClass : std::uint8_t {
+        E_AlphaNumeric = 0x01,
+        E_Digit = 0x02,
+        //! Characters which can start a token.
+        E_TokenStart = 0x04,
+        //! Characters which can only continue a token.
+        E_TokenContinue = 0x08,
+        //! Token characters that aren't hex digits, dots or dashes.
+        E_NonHex = 0x10
+    };
+
+    using TUInt8Ary = std::array<std::uint8_t, 256>;
+
+    //! Classify every character up front so the tokeniser needs a single
+    //! table lookup per character rather than several locale dependent
+    //! calls.  The classification matches the "C" locale.
+    static constexpr TUInt8Ary makeCharClasses() {
+        TUInt8Ary result{};
+        for (int c = 0; c < 256; ++c) {
+            bool isDigit{c >= '0' && c <= '9'};
+            bool isAlpha{(c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')};
+            bool isXDigit{isDigit || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')};
+            bool isStart{isDigit || isAlpha || (ALLOW_FORWARD_SLASH && c == '/')};
+            bool isContinue{(ALLOW_UNDERSCORE && c == '_') ||
+                            (ALLOW_DOT && c == '.') || (ALLOW_DASH && c == '-')};
+            std::uint8_t charClass{0};
+            if (isDigit || isAlpha) {
+                charClass |= E_AlphaNumeric;
+            }
+            if (isDigit) {
+                charClass |= E_Digit;
+            }
+            if (isStart) {
+                charClass |= E_TokenStart;
+            }
+            if (isContinue) {
+                charClass |= E_TokenContinue;
+            }
+            // Count dots and dashes as numeric
+            if ((isStart || isContinue) && isXDigit == false && c != '.' && c != '-') {
+                charClass |= E_NonHex;
+            }
+            result[static_cast<std::size_t>(c)] = charClass;
+        }
+        return result;
+    }
+
+    static constexpr TUInt8Ary CHAR_CLASSES{makeCharClasses()};
+
 private:
     //! Reference to a part-of-speech dictionary.
     const core::CWordDictionary& m_Dict;
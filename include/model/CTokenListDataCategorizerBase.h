@@ -19,6 +19,7 @@
 #include <model/ImportExport.h>
 #include <model/ModelTypes.h>
 
+#include <cstdint>
 #include <iosfwd>
 #include <map>
 #include <memory>
@@ -69,6 +70,12 @@ public:
     //! if available
     static const std::string PRETOKENISED_TOKEN_FIELD;
 
+    //! The number of slots in the cache of recent tokenisations.
+    static const std::size_t TOKENISATION_CACHE_SIZE;
+
+    //! The longest string whose tokenisation will be cached.
+    static const std::size_t MAX_CACHED_STRING_LENGTH;
+
 public:
     //! Shared pointer to reverse search creator that we're will function
     //! after being shallow copied
@@ -88,6 +95,10 @@ public:
     //! Used for storing distinct token IDs
     using TSizeSizeMap = std::map<std::size_t, std::size_t>;
 
+    //! Used for indexing categories by token ID
+    using TSizeVec = std::vector<std::size_t>;
+    using TSizeVecVec = std::vector<TSizeVec>;
+
     //! Used for stream output of token IDs translated back to the original
     //! tokens
     struct MODEL_EXPORT SIdTranslater {
@@ -319,6 +330,24 @@ private:
     //! Tag for the token index
     struct SToken {};
 
+    //! A recent tokenisation of a string.
+    struct STokenisation {
+        //! Debug the memory used by this tokenisation.
+        void debugMemoryUsage(const core::CMemoryUsage::TMemoryUsagePtr& mem) const;
+
+        //! Get the memory used by this tokenisation.
+        std::size_t memoryUsage() const;
+
+        //! A hash of the names of the fields supplied with the string.
+        std::uint64_t s_FieldNamesHash = 0;
+        std::string s_String;
+        TSizeSizePrVec s_TokenIds;
+        TSizeSizeMap s_TokenUniqueIds;
+        std::size_t s_Weight = 0;
+    };
+
+    using TTokenisationVec = std::vector<STokenisation>;
+
     using TTokenMIndex = boost::multi_index::multi_index_container<
         CTokenInfoItem,
         boost::multi_index::indexed_by<boost::multi_index::random_access<>,
@@ -331,6 +360,13 @@ private:
                                       std::size_t memoryCategorizationFailures,
                                       core::CStatePersistInserter& inserter);
 
+    //! Tokenise \p str into the working data structures, reusing the result
+    //! of tokenising the same string with the same field names if it is
+    //! still in the tokenisation cache.  Strings longer than
+    //! MAX_CACHED_STRING_LENGTH are never cached.
+    //! \return The total weight of the tokens.
+    std::size_t tokeniseStringUsingCache(const TStrStrUMap& fields, const std::string& str);
+
     //! Given a string containing comma separated pre-tokenised input, add
     //! the tokens to the working data structures in the same way as if they
     //! had been determined by the tokeniseString() method.  The result of
@@ -348,6 +384,20 @@ private:
     //!             for which usurped categories are to be found.
     TLocalCategoryIdVec usurpedCategories(TSizeSizePrVecCItr iter) const;
 
+    //! Add the category at \p index in m_Categories to the index of categories
+    //! by common unique token.
+    void indexCategory(std::size_t index);
+
+    //! Get the positions in m_CategoriesByCount of the categories which could
+    //! possibly match a string with unique tokens \p tokenUniqueIds in
+    //! ascending order.
+    //!
+    //! Any category which isn't a candidate would be rejected by the checks in
+    //! computeCategory before its similarity is calculated. Because the lower
+    //! threshold is positive this includes every category with common unique
+    //! tokens none of which are in the string.
+    void candidateCategories(const TSizeSizeMap& tokenUniqueIds, TSizeVec& positions) const;
+
 private:
     //! Reference to the object we'll use to create reverse searches
     const TTokenListReverseSearchCreatorCPtr m_ReverseSearchCreator;
@@ -375,6 +425,19 @@ private:
     //! of m_CategoriesByCount.
     std::size_t m_TotalCount = 0;
 
+    //! The position of each category in m_CategoriesByCount indexed by the
+    //! category's index in m_Categories.
+    TSizeVec m_CategoryPositions;
+
+    //! The indices of the categories which have had each token, indexed by
+    //! token ID, in their common unique tokens. Since common unique tokens are
+    //! only ever removed from a category these may include some categories
+    //! which no longer have the token in common.
+    TSizeVecVec m_CategoriesByCommonToken;
+
+    //! The indices of the categories with no common unique tokens.
+    TSizeVec m_CategoriesWithoutCommonTokens;
+
     //! Number of rare categories, as defined by the isCategoryCountRare()
     //! method.
     std::size_t m_NumRareCategories = 0;
@@ -390,6 +453,20 @@ private:
     //! repeated reallocations for different strings.
     TSizeSizeMap m_WorkTokenUniqueIds;
 
+    //! Vector to use to build up the candidate categories for a string.  This
+    //! is a member to save repeated reallocations for different strings.
+    TSizeVec m_WorkCandidatePositions;
+
+    //! A direct mapped cache of recent tokenisations indexed by a hash of
+    //! the string.  Token IDs are never reassigned so the cached tokens
+    //! are exactly what tokeniseString() would produce.  This is sized on
+    //! first use.
+    TTokenisationVec m_TokenisationCache;
+
+    //! The number of strings whose tokenisation was found in the cache since
+    //! this object was created or restored.
+    std::size_t m_TokenisationCacheHits = 0;
+
     //! Used to parse pre-tokenised input supplied as CSV.
     core::CCsvLineParser m_CsvLineParser;
 
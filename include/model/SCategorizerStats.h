@@ -36,6 +36,10 @@ struct MODEL_EXPORT SCategorizerStats {
     std::size_t s_RareCategories = 0;
     std::size_t s_DeadCategories = 0;
     std::size_t s_MemoryCategorizationFailures = 0;
+    //! The number of messages whose tokens were found in a categorizer's
+    //! cache of recent tokenisations.  The hit rate is the ratio of this to
+    //! s_CategorizedMessages.
+    std::size_t s_TokenisationCacheHits = 0;
     model_t::ECategorizationStatus s_CategorizationStatus = model_t::E_CategorizationStatusOk;
 
     //! Equality comparison
@@ -46,6 +50,7 @@ struct MODEL_EXPORT SCategorizerStats {
                s_RareCategories == other.s_RareCategories &&
                s_DeadCategories == other.s_DeadCategories &&
                s_MemoryCategorizationFailures == other.s_MemoryCategorizationFailures &&
+               s_TokenisationCacheHits == other.s_TokenisationCacheHits &&
                s_CategorizationStatus == other.s_CategorizationStatus;
     }
 };
@@ -159,6 +159,10 @@ struct MODEL_EXPORT SModelParams {
     //! The scale factor of the decayRate that determines the maximum size
     //! of the sliding prune window for purging older entries from the model
     double s_PruneWindowScaleMaximum;
+
+    //! The number of buckets a person must be inactive before its models
+    //! are compacted. A value of zero disables compaction.
+    std::size_t s_CompactModelsWindow;
     //@}
 
     //! \name Rules
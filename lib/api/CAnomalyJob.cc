@@ -10,6 +10,8 @@
  */
 #include <api/CAnomalyJob.h>
 
+#include <core/CBinaryStatePersistInserter.h>
+#include <core/CBinaryStateRestoreTraverser.h>
 #include <core/CDataAdder.h>
 #include <core/CDataSearcher.h>
 #include <core/CFunctional.h>
@@ -18,12 +20,16 @@
 #include <core/CLogger.h>
 #include <core/CPersistUtils.h>
 #include <core/CProgramCounters.h>
+#include <core/CProgramStageTimers.h>
 #include <core/CRapidXmlStatePersistInserter.h>
+#include <core/CScopedFastLock.h>
 #include <core/CScopedRapidJsonPoolAllocator.h>
 #include <core/CStateCompressor.h>
 #include <core/CStateDecompressor.h>
+#include <core/CStopWatch.h>
 #include <core/CStringUtils.h>
 #include <core/CTimeUtils.h>
+#include <core/Concurrency.h>
 #include <core/Constants.h>
 #include <core/UnwrapRef.h>
 
@@ -40,6 +46,8 @@
 #include <model/CSearchKey.h>
 #include <model/CSimpleCountDetector.h>
 #include <model/CStringStore.h>
+#include <model/FunctionTypes.h>
+#include <model/ModelTypes.h>
 
 #include <api/CAnnotationJsonWriter.h>
 #include <api/CAnomalyJobConfig.h>
@@ -52,8 +60,10 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 
@@ -100,6 +110,55 @@ const std::string INTERIM_BUCKET_CORRECTOR_TAG("k");
 //! compatibility code.)
 const std::string MODEL_SNAPSHOT_MIN_VERSION("8.0.0");
 
+//! Make a copy of \p detector which has the same persisted state.
+CAnomalyJob::TAnomalyDetectorPtr copyForPersistence(const model::CAnomalyDetector& detector) {
+    if (detector.isSimpleCount()) {
+        return std::make_shared<model::CSimpleCountDetector>(true, detector);
+    }
+    return std::make_shared<model::CAnomalyDetector>(true, detector);
+}
+
+//! Copy the element \p traverser is pointing at, including any sub-level,
+//! to \p inserter.
+bool copyState(core::CStateRestoreTraverser& traverser, core::CStatePersistInserter& inserter) {
+    std::string name{traverser.name()};
+    if (traverser.hasSubLevel() == false) {
+        inserter.insertValue(name, traverser.value());
+        return true;
+    }
+    bool copied{true};
+    inserter.insertLevel(name, [&](core::CStatePersistInserter& subLevelInserter) {
+        copied = traverser.traverseSubLevel([&](core::CStateRestoreTraverser& subLevelTraverser) {
+            do {
+                if (copyState(subLevelTraverser, subLevelInserter) == false) {
+                    return false;
+                }
+            } while (subLevelTraverser.next());
+            return true;
+        });
+    });
+    return copied;
+}
+
+//! Restore \p detector from \p state which was compressed when it was
+//! restored lazily.
+bool restoreCompressedState(const core::CCompressUtil::TByteVec& state,
+                            const std::string& partitionFieldValue,
+                            model::CAnomalyDetector& detector) {
+    core::CInflator decompressor{false};
+    core::CCompressUtil::TByteVec decompressed;
+    if (decompressor.addVector(state) == false ||
+        decompressor.finishAndTakeData(decompressed) == false) {
+        return false;
+    }
+    std::istringstream strm{std::string(decompressed.begin(), decompressed.end())};
+    core::CBinaryStateRestoreTraverser traverser{strm};
+    return traverser.traverseSubLevel(std::bind(
+               &model::CAnomalyDetector::acceptRestoreTraverser, &detector,
+               std::cref(partitionFieldValue), std::placeholders::_1)) &&
+           traverser.haveBadState() == false;
+}
+
 //! Persist state as JSON with meaningful tag names.
 class CReadableJsonStatePersistInserter : public core::CJsonStatePersistInserter {
 public:
@@ -143,16 +202,22 @@ CAnomalyJob::CAnomalyJob(const std::string& jobId,
                          core_t::TTime maxQuantileInterval,
                          const std::string& timeFieldName,
                          const std::string& timeFieldFormat,
-                         size_t maxAnomalyRecords)
+                         size_t maxAnomalyRecords,
+                         bool persistInBinary,
+                         bool restoreLazily,
+                         std::size_t forecastThreads)
     : CDataProcessor{timeFieldName, timeFieldFormat}, m_JobId{jobId}, m_Limits{limits},
       m_OutputStream{outputStream}, m_ForecastRunner{m_JobId, m_OutputStream,
-                                                     limits.resourceMonitor()},
+                                                     limits.resourceMonitor(),
+                                                     forecastThreads},
       m_JsonOutputWriter{m_JobId, m_OutputStream}, m_JobConfig{jobConfig},
       m_ModelConfig{modelConfig}, m_NumRecordsHandled{0},
       m_LastFinalisedBucketEndTime{0}, m_PersistCompleteFunc{persistCompleteFunc},
       m_MaxDetectors{std::numeric_limits<size_t>::max()},
       m_PersistenceManager{persistenceManager}, m_MaxQuantileInterval{maxQuantileInterval},
-      m_LastNormalizerPersistTime{core::CTimeUtils::now()}, m_LatestRecordTime{0},
+      m_PersistInBinary{persistInBinary}, m_RestoreLazily{restoreLazily},
+      m_LastNormalizerPersistTime{core::CTimeUtils::now()},
+      m_LatestRecordTime{0},
       m_LastResultsTime{0}, m_Aggregator{modelConfig}, m_Normalizer{modelConfig} {
     m_JsonOutputWriter.limitNumberRecords(maxAnomalyRecords);
 
@@ -162,6 +227,7 @@ CAnomalyJob::CAnomalyJob(const std::string& jobId,
 
 CAnomalyJob::~CAnomalyJob() {
     m_ForecastRunner.finishForecasts();
+    m_Limits.resourceMonitor().retainedMemory(0);
 }
 
 bool CAnomalyJob::handleRecord(const TStrStrUMap& dataRowFields, TOptionalTime time) {
@@ -171,6 +237,8 @@ bool CAnomalyJob::handleRecord(const TStrStrUMap& dataRowFields, TOptionalTime t
         return this->handleControlMessage(iter->second);
     }
 
+    core::CProgramStageTimers::CScopedTimer stageTimer{stage_t::E_TSADHandleRecord};
+
     // Time may have been parsed already further back along the chain
     if (time == boost::none) {
         time = this->parseTime(dataRowFields);
@@ -320,6 +388,10 @@ const CAnomalyJob::SRestoredStateDetail& CAnomalyJob::restoreStateStatus() const
     return m_RestoredStateDetail;
 }
 
+std::size_t CAnomalyJob::numberPersistenceCopiesReused() const {
+    return m_NumberPersistenceCopiesReused;
+}
+
 bool CAnomalyJob::handleControlMessage(const std::string& controlMessage) {
     if (controlMessage.empty()) {
         LOG_ERROR(<< "Programmatic error - handleControlMessage should only be "
@@ -363,6 +435,9 @@ bool CAnomalyJob::handleControlMessage(const std::string& controlMessage) {
     case 'w':
         this->processPersistControlMessage(controlMessage.substr(1));
         break;
+    case 'd':
+        this->dumpStageTimings();
+        break;
     default:
         LOG_WARN(<< "Ignoring unknown control message of length "
                  << controlMessage.length() << " beginning with '"
@@ -375,6 +450,14 @@ bool CAnomalyJob::handleControlMessage(const std::string& controlMessage) {
     return true;
 }
 
+void CAnomalyJob::dumpStageTimings() {
+    if (core::CProgramStageTimers::enabled() == false) {
+        LOG_WARN(<< "Ignoring request to dump stage timings - stage timing is not enabled");
+        return;
+    }
+    LOG_INFO(<< "Stage timings:" << core::CProgramStageTimers::instance());
+}
+
 bool CAnomalyJob::parsePersistControlMessageArgs(const std::string& controlMessageArgs,
                                                  core_t::TTime& snapshotTimestamp,
                                                  std::string& snapshotId,
@@ -436,7 +519,9 @@ void CAnomalyJob::processPersistControlMessage(const std::string& controlMessage
                                                snapshotId, snapshotDescription)) {
                 // Since this is not going through the full persistence call
                 // chain, make sure model size stats are up to date before
-                // persisting
+                // persisting. Refreshing audits the detectors' memory so they
+                // mustn't be shared with a background persist.
+                this->copyDetectorsForPersistBeforeUpdate();
                 m_Limits.resourceMonitor().forceRefreshAll();
                 if (m_PersistenceManager->doForegroundPersist(
                         [this, &snapshotDescription, &snapshotId,
@@ -561,6 +646,9 @@ void CAnomalyJob::skipTime(const std::string& time_) {
 void CAnomalyJob::skipSampling(core_t::TTime endTime) {
     LOG_INFO(<< "Skipping time to: " << endTime);
 
+    this->copyDetectorsForPersistBeforeUpdate();
+    this->materialiseDormantDetectors();
+
     for (const auto& detector_ : m_Detectors) {
         model::CAnomalyDetector* detector(detector_.second.get());
         if (detector == nullptr) {
@@ -575,6 +663,9 @@ void CAnomalyJob::skipSampling(core_t::TTime endTime) {
 }
 
 void CAnomalyJob::timeNow(core_t::TTime time) {
+    this->copyDetectorsForPersistBeforeUpdate();
+    this->materialiseDormantDetectorsWithResults();
+
     for (const auto& detector_ : m_Detectors) {
         model::CAnomalyDetector* detector(detector_.second.get());
         if (detector == nullptr) {
@@ -634,6 +725,11 @@ bool CAnomalyJob::parseTimeRangeInControlMessage(const std::string& controlMessa
 }
 
 void CAnomalyJob::doForecast(const std::string& controlMessage) {
+    // Creating the forecast models expands compact models, so they mustn't
+    // be shared with a background persist.
+    this->copyDetectorsForPersistBeforeUpdate();
+    this->materialiseDormantDetectors();
+
     // make a copy of the detectors vector, note: this is a shallow, not a deep copy
     TAnomalyDetectorPtrVec detectorVector;
     this->detectors(detectorVector);
@@ -646,11 +742,16 @@ void CAnomalyJob::doForecast(const std::string& controlMessage) {
 }
 
 void CAnomalyJob::outputResults(core_t::TTime bucketStartTime) {
+    core::CProgramStageTimers::CScopedTimer stageTimer{stage_t::E_TSADOutputResults};
+
+    this->copyDetectorsForPersistBeforeUpdate();
+    this->materialiseDormantDetectorsWithResults();
+
     core::CStopWatch timer(true);
 
     core_t::TTime bucketLength = m_ModelConfig.bucketLength();
 
-    model::CHierarchicalResults results;
+    model::CHierarchicalResults& results{m_Results};
     TModelPlotDataVec modelPlotData;
     TAnnotationVec annotations;
 
@@ -696,6 +797,7 @@ void CAnomalyJob::outputResults(core_t::TTime bucketStartTime) {
     this->writeOutModelPlot(modelPlotData);
     this->writeOutAnnotations(annotations);
     this->writeOutResults(false, results, bucketStartTime, processingTime);
+    results.clear();
 
     if (m_ModelConfig.modelPruneWindow() > 0) {
         // Ensure that bucketPruneWindow is always rounded _up_
@@ -711,14 +813,23 @@ void CAnomalyJob::outputResults(core_t::TTime bucketStartTime) {
     // Prune models based on memory resource limits
     m_Limits.resourceMonitor().pruneIfRequired(bucketStartTime);
     model::CStringStore::tidyUpNotThreadSafe();
+
+    // Don't hold on to copies which can no longer be used for persistence
+    this->releaseStalePersistenceCopies();
+
+    core::CProgramCounters::counter(counter_t::E_TSADPersistPauseTime) += m_PersistPauseTime;
+    m_PersistPauseTime = 0;
 }
 
 void CAnomalyJob::outputInterimResults(core_t::TTime bucketStartTime) {
+    this->copyDetectorsForPersistBeforeUpdate();
+    this->materialiseDormantDetectorsWithResults();
+
     core::CStopWatch timer(true);
 
     core_t::TTime bucketLength = m_ModelConfig.bucketLength();
 
-    model::CHierarchicalResults results;
+    model::CHierarchicalResults& results{m_Results};
     results.setInterim();
 
     TKeyCRefAnomalyDetectorPtrPrVec detectors;
@@ -752,6 +863,7 @@ void CAnomalyJob::outputInterimResults(core_t::TTime bucketStartTime) {
 
     std::uint64_t processingTime = timer.stop();
     this->writeOutResults(true, results, bucketStartTime, processingTime);
+    results.clear();
 }
 
 void CAnomalyJob::writeOutResults(bool interim,
@@ -800,6 +912,8 @@ void CAnomalyJob::resetBuckets(const std::string& controlMessage) {
         core_t::TTime bucketLength = m_ModelConfig.bucketLength();
         core_t::TTime time = maths::common::CIntegerTools::floor(start, bucketLength);
         core_t::TTime bucketEnd = maths::common::CIntegerTools::ceil(end, bucketLength);
+        this->copyDetectorsForPersistBeforeUpdate();
+        this->materialiseDormantDetectors();
         while (time < bucketEnd) {
             for (const auto& detector_ : m_Detectors) {
                 model::CAnomalyDetector* detector = detector_.second.get();
@@ -842,16 +956,21 @@ bool CAnomalyJob::restoreState(core::CDataSearcher& restoreSearcher,
             return false;
         }
 
-        // We're dealing with streaming JSON state
-        core::CJsonStateRestoreTraverser traverser(*strm);
+        // We're dealing with streaming state, which may be JSON or binary
+        std::unique_ptr<core::CStateRestoreTraverser> traverser;
+        if (core::CBinaryStateRestoreTraverser::isBinaryState(*strm)) {
+            traverser = std::make_unique<core::CBinaryStateRestoreTraverser>(*strm);
+        } else {
+            traverser = std::make_unique<core::CJsonStateRestoreTraverser>(*strm);
+        }
 
-        if (this->restoreState(traverser, completeToTime, numDetectors) == false) {
+        if (this->restoreState(*traverser, completeToTime, numDetectors) == false) {
             LOG_ERROR(<< "Failed to restore detectors");
             return false;
         }
         LOG_DEBUG(<< "Finished restoration, with " << numDetectors << " detectors");
 
-        if (numDetectors == 1 && m_Detectors.empty()) {
+        if (numDetectors == 1 && m_Detectors.empty() && m_DormantDetectors.empty()) {
             // non fatal error
             m_RestoredStateDetail.s_RestoredStateStatus = E_NoDetectorsRecovered;
             return true;
@@ -860,6 +979,7 @@ bool CAnomalyJob::restoreState(core::CDataSearcher& restoreSearcher,
         if (completeToTime > 0) {
             core_t::TTime lastBucketEndTime(maths::common::CIntegerTools::ceil(
                 completeToTime, m_ModelConfig.bucketLength()));
+            m_DormantDetectorsLastBucketEndTime = lastBucketEndTime;
 
             for (const auto& detector_ : m_Detectors) {
                 model::CAnomalyDetector* detector(detector_.second.get());
@@ -874,8 +994,9 @@ bool CAnomalyJob::restoreState(core::CDataSearcher& restoreSearcher,
                 detector->lastBucketEndTime() = lastBucketEndTime;
             }
         } else {
-            if (!m_Detectors.empty()) {
-                LOG_ERROR(<< "Inconsistency - " << m_Detectors.size()
+            if (!m_Detectors.empty() || !m_DormantDetectors.empty()) {
+                LOG_ERROR(<< "Inconsistency - "
+                          << m_Detectors.size() + m_DormantDetectors.size()
                           << " detectors have been restored but completeToTime is "
                           << completeToTime);
             }
@@ -934,6 +1055,14 @@ bool CAnomalyJob::restoreState(core::CStateRestoreTraverser& traverser,
         return true;
     }
 
+    // Detectors may be restored in the background in which case we must
+    // wait for them to finish before returning.
+    TBoolFutureVec pendingRestores;
+    auto fail = [&pendingRestores] {
+        core::wait_for_all(pendingRestores);
+        return false;
+    };
+
     while (traverser.next()) {
         const std::string& name = traverser.name();
         if (name == INTERIM_BUCKET_CORRECTOR_TAG) {
@@ -944,14 +1073,15 @@ bool CAnomalyJob::restoreState(core::CStateRestoreTraverser& traverser,
                     &model::CInterimBucketCorrector::acceptRestoreTraverser,
                     interimBucketCorrector.get(), std::placeholders::_1)) == false) {
                 LOG_ERROR(<< "Cannot restore interim bucket corrector");
-                return false;
+                return fail();
             }
             m_ModelConfig.interimBucketCorrector(interimBucketCorrector);
         } else if (name == TOP_LEVEL_DETECTOR_TAG) {
-            if (traverser.traverseSubLevel(std::bind(&CAnomalyJob::restoreSingleDetector,
-                                                     this, std::placeholders::_1)) == false) {
+            if (traverser.traverseSubLevel(std::bind(
+                    &CAnomalyJob::restoreSingleDetector, this,
+                    std::placeholders::_1, std::ref(pendingRestores))) == false) {
                 LOG_ERROR(<< "Cannot restore anomaly detector");
-                return false;
+                return fail();
             }
             ++numDetectors;
         } else if (name == RESULTS_AGGREGATOR_TAG) {
@@ -959,7 +1089,7 @@ bool CAnomalyJob::restoreState(core::CStateRestoreTraverser& traverser,
                     &model::CHierarchicalResultsAggregator::acceptRestoreTraverser,
                     &m_Aggregator, std::placeholders::_1)) == false) {
                 LOG_ERROR(<< "Cannot restore results aggregator");
-                return false;
+                return fail();
             }
         } else if (name == LATEST_RECORD_TIME_TAG) {
             core::CPersistUtils::restore(LATEST_RECORD_TIME_TAG, m_LatestRecordTime, traverser);
@@ -968,12 +1098,18 @@ bool CAnomalyJob::restoreState(core::CStateRestoreTraverser& traverser,
         }
     }
 
+    if (core::get_conjunction_of_all(pendingRestores) == false) {
+        LOG_ERROR(<< "Cannot restore anomaly detector");
+        return false;
+    }
+
     m_RestoredStateDetail.s_RestoredStateStatus = E_Success;
 
     return true;
 }
 
-bool CAnomalyJob::restoreSingleDetector(core::CStateRestoreTraverser& traverser) {
+bool CAnomalyJob::restoreSingleDetector(core::CStateRestoreTraverser& traverser,
+                                        TBoolFutureVec& pendingRestores) {
     if (traverser.name() != KEY_TAG) {
         LOG_ERROR(<< "Cannot restore anomaly detector - " << KEY_TAG << " element expected but found "
                   << traverser.name() << '=' << traverser.value());
@@ -1035,8 +1171,18 @@ bool CAnomalyJob::restoreSingleDetector(core::CStateRestoreTraverser& traverser)
         return false;
     }
 
-    if (this->restoreDetectorState(key, partitionFieldValue, traverser) == false ||
-        traverser.haveBadState()) {
+    // The simple count detector restores the program counters and other
+    // statics so is always restored on this thread.
+    bool restored{false};
+    if (key.isSimpleCount() == false && m_RestoreLazily) {
+        restored = this->restoreDetectorStateLazily(key, partitionFieldValue, traverser);
+    } else if (key.isSimpleCount() || core::defaultAsyncThreadPoolSize() < 2) {
+        restored = this->restoreDetectorState(key, partitionFieldValue, traverser);
+    } else {
+        restored = this->restoreDetectorStateInBackground(
+            key, partitionFieldValue, traverser, pendingRestores);
+    }
+    if (restored == false || traverser.haveBadState()) {
         LOG_ERROR(<< "Delegated portion of anomaly detector restore failed");
         m_RestoredStateDetail.s_RestoredStateStatus = E_Failure;
         return false;
@@ -1076,9 +1222,263 @@ bool CAnomalyJob::restoreDetectorState(const model::CSearchKey& key,
     return true;
 }
 
+bool CAnomalyJob::restoreDetectorStateInBackground(const model::CSearchKey& key,
+                                                   const std::string& partitionFieldValue,
+                                                   core::CStateRestoreTraverser& traverser,
+                                                   TBoolFutureVec& pendingRestores) {
+    // The detector is created on this thread because creating it updates
+    // the resource monitor and populates caches in the model factory which
+    // are then only read when restoring its models.
+    const TAnomalyDetectorPtr& detector =
+        this->detectorForKey(true, // for restoring
+                             0,    // time reset later
+                             key, partitionFieldValue, m_Limits.resourceMonitor());
+    if (!detector) {
+        LOG_ERROR(<< "Detector with key '" << key.debug() << '/' << partitionFieldValue
+                  << "' was not recreated on restore - "
+                     "memory limit is too low to continue this job");
+
+        m_RestoredStateDetail.s_RestoredStateStatus = E_MemoryLimitReached;
+        return false;
+    }
+
+    LOG_DEBUG(<< "Restoring state for detector with key '" << key.debug() << '/'
+              << partitionFieldValue << "' in the background");
+
+    // The traverser can only be read on this thread so the detector's state
+    // is copied for the task which restores it. This uses the binary format
+    // since it is the cheapest to write and to read back.
+    std::ostringstream state;
+    {
+        core::CBinaryStatePersistInserter inserter{state};
+        if (copyState(traverser, inserter) == false) {
+            LOG_ERROR(<< "Error reading state for anomaly detector for key '"
+                      << key.debug() << '/' << partitionFieldValue << '\'');
+            return false;
+        }
+    }
+
+    // Limit the copied state held in memory if restoring models is slower
+    // than reading their state.
+    std::size_t maxPendingRestores{2 * core::defaultAsyncThreadPoolSize()};
+    if (pendingRestores.size() >= maxPendingRestores) {
+        pendingRestores[pendingRestores.size() - maxPendingRestores].wait();
+    }
+
+    pendingRestores.push_back(core::async(
+        core::defaultAsyncExecutor(),
+        [ key, partitionFieldValue, detector, state_ = state.str() ] {
+            std::istringstream strm{state_};
+            core::CBinaryStateRestoreTraverser traverser_{strm};
+            if (traverser_.traverseSubLevel(std::bind(
+                    &model::CAnomalyDetector::acceptRestoreTraverser, detector.get(),
+                    std::cref(partitionFieldValue), std::placeholders::_1)) == false ||
+                traverser_.haveBadState()) {
+                LOG_ERROR(<< "Error restoring anomaly detector for key '"
+                          << key.debug() << '/' << partitionFieldValue << '\'');
+                return false;
+            }
+            return true;
+        }));
+
+    return true;
+}
+
+bool CAnomalyJob::restoreDetectorStateLazily(const model::CSearchKey& key,
+                                             const std::string& partitionFieldValue,
+                                             core::CStateRestoreTraverser& traverser) {
+    // The detector is created when it's needed, but whether it may be is
+    // decided now as it would be if it were restored eagerly.
+    if (m_Limits.resourceMonitor().areAllocationsAllowed() == false) {
+        LOG_ERROR(<< "Detector with key '" << key.debug() << '/' << partitionFieldValue
+                  << "' was not recreated on restore - "
+                     "memory limit is too low to continue this job");
+
+        m_RestoredStateDetail.s_RestoredStateStatus = E_MemoryLimitReached;
+        return false;
+    }
+
+    LOG_DEBUG(<< "Keeping state for detector with key '" << key.debug() << '/'
+              << partitionFieldValue << "' to restore when it's needed");
+
+    std::ostringstream state;
+    {
+        core::CBinaryStatePersistInserter inserter{state};
+        if (copyState(traverser, inserter) == false) {
+            LOG_ERROR(<< "Error reading state for anomaly detector for key '"
+                      << key.debug() << '/' << partitionFieldValue << '\'');
+            return false;
+        }
+    }
+
+    core::CDeflator compressor{false};
+    core::CCompressUtil::TByteVec& compressed =
+        m_DormantDetectors[model::CSearchKey::TStrKeyPr{partitionFieldValue, key}];
+    if (compressor.addString(state.str()) == false ||
+        compressor.finishAndTakeData(compressed) == false) {
+        LOG_ERROR(<< "Error compressing state for anomaly detector for key '"
+                  << key.debug() << '/' << partitionFieldValue << '\'');
+        return false;
+    }
+    m_DormantDetectorsMemoryUsage += compressed.capacity();
+    this->refreshRetainedMemoryUsage();
+
+    return true;
+}
+
+void CAnomalyJob::materialiseDormantDetectors() {
+    if (m_DormantDetectors.empty()) {
+        return;
+    }
+
+    TKeyCompressedStateUMapItrVec dormant;
+    dormant.reserve(m_DormantDetectors.size());
+    for (auto i = m_DormantDetectors.begin(); i != m_DormantDetectors.end(); ++i) {
+        dormant.push_back(i);
+    }
+    this->materialiseDormantDetectors(dormant);
+}
+
+void CAnomalyJob::materialiseDormantDetectorsWithResults() {
+    if (m_DormantDetectors.empty() ||
+        m_Limits.resourceMonitor().areAllocationsAllowed() == false) {
+        return;
+    }
+
+    TKeyCompressedStateUMapItrVec dormant;
+    for (auto i = m_DormantDetectors.begin(); i != m_DormantDetectors.end(); ++i) {
+        if (this->dormantDetectorHasResults(i->first.second)) {
+            dormant.push_back(i);
+        }
+    }
+    this->materialiseDormantDetectors(dormant);
+}
+
+void CAnomalyJob::materialiseDormantDetectors(const TKeyCompressedStateUMapItrVec& dormant) {
+    if (dormant.empty()) {
+        return;
+    }
+
+    LOG_DEBUG(<< "Restoring " << dormant.size() << " dormant detectors");
+
+    // Detectors are created on this thread for the same reason as for
+    // restoreDetectorStateInBackground. Only restoring their models is
+    // done in parallel.
+    TAnomalyDetectorPtrVec detectors;
+    detectors.reserve(dormant.size());
+    for (const auto& state : dormant) {
+        detectors.push_back(this->createDormantDetector(state->first));
+    }
+
+    core::parallel_for_each(0, dormant.size(), [&](std::size_t i) {
+        if (restoreCompressedState(dormant[i]->second, dormant[i]->first.first,
+                                   *detectors[i]) == false) {
+            detectors[i].reset();
+        }
+    });
+
+    for (std::size_t i = 0; i < dormant.size(); ++i) {
+        if (detectors[i] != nullptr) {
+            this->sampleDormantBuckets(*detectors[i]);
+        } else {
+            LOG_ERROR(<< "Error restoring anomaly detector for key '"
+                      << dormant[i]->first.second.debug() << '/'
+                      << dormant[i]->first.first << '\'');
+            m_Detectors.erase(dormant[i]->first);
+        }
+        this->eraseDormantDetector(dormant[i]);
+    }
+}
+
+const CAnomalyJob::TAnomalyDetectorPtr&
+CAnomalyJob::materialiseDormantDetector(TKeyCompressedStateUMap::iterator dormant) {
+    const model::CSearchKey::TStrKeyPr& key = dormant->first;
+
+    if (m_Limits.resourceMonitor().areAllocationsAllowed() == false) {
+        LOG_TRACE(<< "No memory to restore dormant detector for key '"
+                  << key.second.debug() << '/' << key.first << '\'');
+        return NULL_DETECTOR;
+    }
+
+    LOG_DEBUG(<< "Restoring dormant detector with key '" << key.second.debug()
+              << '/' << key.first << '\'');
+
+    TAnomalyDetectorPtr& detector = this->createDormantDetector(key);
+    if (restoreCompressedState(dormant->second, key.first, *detector) == false) {
+        LOG_ERROR(<< "Error restoring anomaly detector for key '"
+                  << key.second.debug() << '/' << key.first << '\'');
+        m_Detectors.erase(key);
+        this->eraseDormantDetector(dormant);
+        return NULL_DETECTOR;
+    }
+    this->sampleDormantBuckets(*detector);
+    this->eraseDormantDetector(dormant);
+
+    return detector;
+}
+
+CAnomalyJob::TAnomalyDetectorPtr&
+CAnomalyJob::createDormantDetector(const model::CSearchKey::TStrKeyPr& key) {
+    // This mirrors detectorForKey when restoring. Whether allocations are
+    // allowed is checked by the caller since some callers, such as persist,
+    // need every detector's models.
+    TAnomalyDetectorPtr& detector =
+        m_Detectors.emplace(key, TAnomalyDetectorPtr()).first->second;
+    detector = this->makeDetector(m_ModelConfig, m_Limits, key.first, 0,
+                                  m_ModelConfig.factory(key.second));
+    if (detector == nullptr) {
+        LOG_ABORT(<< "Failed to create anomaly detector for key '"
+                  << key.second.debug() << '\'');
+    }
+    detector->zeroModelsToTime(-m_ModelConfig.latency());
+    detector->lastBucketEndTime() = m_DormantDetectorsLastBucketEndTime;
+    return detector;
+}
+
+void CAnomalyJob::eraseDormantDetector(TKeyCompressedStateUMap::iterator dormant) {
+    m_DormantDetectorsMemoryUsage -= dormant->second.capacity();
+    m_DormantDetectors.erase(dormant);
+    this->refreshRetainedMemoryUsage();
+}
+
+bool CAnomalyJob::dormantDetectorHasResults(const model::CSearchKey& key) const {
+    if (m_ModelConfig.modelPlotBoundsPercentile() > 0.0) {
+        return true;
+    }
+    const model_t::TFeatureVec& features = model::function_t::features(key.function());
+    return std::any_of(features.begin(), features.end(), [](model_t::EFeature feature) {
+        return model_t::includeEmptyBuckets(feature);
+    });
+}
+
+void CAnomalyJob::sampleDormantBuckets(model::CAnomalyDetector& detector) {
+    // The detector had no data in the buckets finalised while it was dormant
+    // and no results for them, see dormantDetectorHasResults, but its models
+    // must still be sampled for them as they would have been if it had been
+    // restored up front.
+    core_t::TTime bucketLength{m_ModelConfig.bucketLength()};
+    core_t::TTime startTime{detector.lastBucketEndTime()};
+    if (startTime >= m_LastFinalisedBucketEndTime) {
+        return;
+    }
+
+    model::CHierarchicalResults results;
+    for (core_t::TTime time = startTime; time < m_LastFinalisedBucketEndTime;
+         time += bucketLength) {
+        detector.buildResults(time, time + bucketLength, results);
+        detector.releaseMemory(time - m_ModelConfig.samplingAgeCutoff());
+        results.clear();
+    }
+    if (m_ModelConfig.modelPruneWindow() > 0) {
+        detector.pruneModels((m_ModelConfig.modelPruneWindow() + bucketLength - 1) / bucketLength);
+    }
+}
+
 bool CAnomalyJob::persistModelsState(core::CDataAdder& persister,
                                      core_t::TTime timestamp,
                                      const std::string& outputFormat) {
+    this->materialiseDormantDetectors();
+
     TKeyCRefAnomalyDetectorPtrPrVec detectors;
     this->sortedDetectors(detectors);
 
@@ -1117,6 +1517,8 @@ bool CAnomalyJob::doPersistStateInForeground(core::CDataAdder& persister,
         }
     }
 
+    this->materialiseDormantDetectors();
+
     TKeyCRefAnomalyDetectorPtrPrVec detectors;
     this->sortedDetectors(detectors);
     std::string normaliserState;
@@ -1143,6 +1545,12 @@ bool CAnomalyJob::backgroundPersistState() {
         return false;
     }
 
+    core::CStopWatch timer{true};
+
+    // Make sure the copies made for the previous persist are available.
+    this->copyDetectorsForPersistBeforeUpdate();
+    this->materialiseDormantDetectors();
+
     // Pass arguments by value: this is what we want for
     // passing to a new thread.
     // Do NOT add std::ref wrappers around these arguments - they
@@ -1161,6 +1569,11 @@ bool CAnomalyJob::backgroundPersistState() {
     TKeyCRefAnomalyDetectorPtrPrVec& copiedDetectors = args->s_Detectors;
     copiedDetectors.reserve(m_Detectors.size());
 
+    // Only detectors whose state has changed since the last background
+    // persist need to be copied: the copies of the others are still exact
+    // and are never modified so can be shared with this persist. Rather
+    // than copying the changed detectors now they are shared until either
+    // the persistence thread copies them or they are about to be modified.
     for (const auto& detector_ : m_Detectors) {
         model::CAnomalyDetector* detector(detector_.second.get());
         if (detector == nullptr) {
@@ -1170,16 +1583,30 @@ bool CAnomalyJob::backgroundPersistState() {
         }
         model::CSearchKey::TStrCRefKeyCRefPr key(std::cref(detector_.first.first),
                                                  std::cref(detector_.first.second));
-        if (detector->isSimpleCount()) {
-            copiedDetectors.push_back(TKeyCRefAnomalyDetectorPtrPr(
-                key, TAnomalyDetectorPtr(new model::CSimpleCountDetector(true, *detector))));
+        auto copy = m_PersistenceCopies.find(detector_.first);
+        if (copy != m_PersistenceCopies.end() &&
+            copy->second->stateEpoch() == detector->stateEpoch()) {
+            copiedDetectors.push_back(TKeyCRefAnomalyDetectorPtrPr(key, copy->second));
+            ++m_NumberPersistenceCopiesReused;
         } else {
-            copiedDetectors.push_back(TKeyCRefAnomalyDetectorPtrPr(
-                key, TAnomalyDetectorPtr(new model::CAnomalyDetector(true, *detector))));
+            if (copy != m_PersistenceCopies.end()) {
+                m_PersistenceCopies.erase(copy);
+            }
+            copiedDetectors.push_back(TKeyCRefAnomalyDetectorPtrPr(key, detector_.second));
+            args->s_LiveDetectors.emplace(detector, 0);
         }
     }
     std::sort(copiedDetectors.begin(), copiedDetectors.end(),
               maths::common::COrderings::SFirstLess());
+    for (std::size_t i = 0; i < copiedDetectors.size(); ++i) {
+        auto live = args->s_LiveDetectors.find(copiedDetectors[i].second.get());
+        if (live != args->s_LiveDetectors.end()) {
+            live->second = i;
+        }
+    }
+
+    LOG_DEBUG(<< args->s_LiveDetectors.size() << " of " << copiedDetectors.size()
+              << " detectors need copying for background persist");
 
     if (m_PersistenceManager->addPersistFunc(std::bind(
             &CAnomalyJob::runBackgroundPersist, this, args, std::placeholders::_1)) == false) {
@@ -1187,11 +1614,80 @@ bool CAnomalyJob::backgroundPersistState() {
         return false;
     }
 
+    m_PendingPersistArgs = std::move(args);
+    m_PersistPauseTime += timer.stop();
+
     m_PersistenceManager->useBackgroundPersistence();
 
     return true;
 }
 
+void CAnomalyJob::copyDetectorForPersistBeforeUpdate(const model::CAnomalyDetector& detector) {
+    if (m_PendingPersistArgs != nullptr) {
+        core::CStopWatch timer{true};
+        bool anyLive{m_PendingPersistArgs->copyLiveDetector(detector)};
+        m_PersistPauseTime += timer.stop();
+        if (anyLive == false) {
+            this->retainPersistenceCopies();
+        }
+    }
+}
+
+void CAnomalyJob::copyDetectorsForPersistBeforeUpdate() {
+    if (m_PendingPersistArgs != nullptr) {
+        core::CStopWatch timer{true};
+        m_PendingPersistArgs->copyLiveDetectors();
+        m_PersistPauseTime += timer.stop();
+        this->retainPersistenceCopies();
+    }
+}
+
+void CAnomalyJob::retainPersistenceCopies() {
+    for (const auto& copy : m_PendingPersistArgs->s_Detectors) {
+        m_PersistenceCopies[model::CSearchKey::TStrKeyPr{copy.first.first, copy.first.second}] =
+            copy.second;
+    }
+    m_PendingPersistArgs.reset();
+    this->refreshPersistenceCopiesMemoryUsage();
+}
+
+void CAnomalyJob::releaseStalePersistenceCopies() {
+    std::size_t numberCopies{m_PersistenceCopies.size()};
+    for (auto i = m_PersistenceCopies.begin(); i != m_PersistenceCopies.end(); /**/) {
+        auto detector = m_Detectors.find(i->first);
+        if (detector == m_Detectors.end() || detector->second == nullptr ||
+            detector->second->stateEpoch() != i->second->stateEpoch()) {
+            i = m_PersistenceCopies.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    if (m_PersistenceCopies.size() != numberCopies) {
+        this->refreshPersistenceCopiesMemoryUsage();
+    }
+}
+
+void CAnomalyJob::refreshPersistenceCopiesMemoryUsage() {
+    // A copy is only kept while its detector is unchanged so use the memory
+    // the resource monitor last measured for the detector. This avoids
+    // estimating the copies' memory which would affect program counters.
+    model::CResourceMonitor& resourceMonitor{m_Limits.resourceMonitor()};
+    std::size_t memoryUsage{0};
+    for (const auto& copy : m_PersistenceCopies) {
+        auto detector = m_Detectors.find(copy.first);
+        if (detector != m_Detectors.end() && detector->second != nullptr) {
+            memoryUsage += resourceMonitor.lastMemoryUsage(*detector->second);
+        }
+    }
+    m_PersistenceCopiesMemoryUsage = memoryUsage;
+    this->refreshRetainedMemoryUsage();
+}
+
+void CAnomalyJob::refreshRetainedMemoryUsage() {
+    m_Limits.resourceMonitor().retainedMemory(m_PersistenceCopiesMemoryUsage +
+                                              m_DormantDetectorsMemoryUsage);
+}
+
 bool CAnomalyJob::runForegroundPersist(core::CDataAdder& persister) {
     LOG_INFO(<< "Foreground persist commencing...");
 
@@ -1208,6 +1704,8 @@ bool CAnomalyJob::runBackgroundPersist(TBackgroundPersistArgsPtr args,
         return false;
     }
 
+    args->copyLiveDetectors();
+
     core_t::TTime snapshotTimestamp(core::CTimeUtils::now());
     const std::string snapshotId(core::CStringUtils::typeToString(snapshotTimestamp));
     const std::string description{"Periodic background persist at " +
@@ -1224,6 +1722,8 @@ bool CAnomalyJob::persistModelsState(const TKeyCRefAnomalyDetectorPtrPrVec& dete
                                      core::CDataAdder& persister,
                                      core_t::TTime timestamp,
                                      const std::string& outputFormat) {
+    core::CProgramStageTimers::CScopedTimer stageTimer{stage_t::E_TSADPersistState};
+
     try {
         const std::string snapShotId{core::CStringUtils::typeToString(timestamp)};
         core::CDataAdder::TOStreamP strm =
@@ -1278,6 +1778,8 @@ bool CAnomalyJob::persistCopiedState(const std::string& description,
                                      core_t::TTime latestRecordTime,
                                      core_t::TTime lastResultsTime,
                                      core::CDataAdder& persister) {
+    core::CProgramStageTimers::CScopedTimer stageTimer{stage_t::E_TSADPersistState};
+
     // Ensure that the cache of program counters is cleared upon exiting the current scope.
     // As the cache is cleared when the simple count detector is persisted this may seem
     // unnecessary at first, but there are occasions when the simple count detector does not exist,
@@ -1286,7 +1788,9 @@ bool CAnomalyJob::persistCopiedState(const std::string& description,
 
     // Persist state for each detector separately by streaming
     try {
-        core::CStateCompressor compressor(persister);
+        // Blocks of state are compressed in parallel if the default async
+        // executor has threads available.
+        core::CStateCompressor compressor(persister, true);
 
         core::CDataAdder::TOStreamP strm =
             compressor.addStreamed(m_JobId + '_' + STATE_TYPE + '_' + snapshotId);
@@ -1297,8 +1801,14 @@ bool CAnomalyJob::persistCopiedState(const std::string& description,
             // values can change.  There should be no use of m_ variables in the
             // following code block.
             {
-                // The JSON inserter must be destructed before the stream is complete
-                core::CJsonStatePersistInserter inserter(*strm);
+                // The inserter must be destructed before the stream is complete
+                std::unique_ptr<core::CStatePersistInserter> inserter_;
+                if (m_PersistInBinary) {
+                    inserter_ = std::make_unique<core::CBinaryStatePersistInserter>(*strm);
+                } else {
+                    inserter_ = std::make_unique<core::CJsonStatePersistInserter>(*strm);
+                }
+                core::CStatePersistInserter& inserter{*inserter_};
                 inserter.insertValue(TIME_TAG, time);
                 inserter.insertValue(VERSION_TAG, model::CAnomalyDetector::STATE_VERSION);
                 inserter.insertLevel(
@@ -1418,6 +1928,8 @@ void CAnomalyJob::updateAggregatorAndAggregate(bool isInterim,
 
 void CAnomalyJob::updateNormalizerAndNormalizeResults(bool isInterim,
                                                       model::CHierarchicalResults& results) {
+    core::CProgramStageTimers::CScopedTimer stageTimer{stage_t::E_TSADNormalizeResults};
+
     m_Normalizer.setJob(model::CHierarchicalResultsNormalizer::E_RefreshSettings);
     results.bottomUpBreadthFirst(m_Normalizer);
     results.pivotsBottomUpBreadthFirst(m_Normalizer);
@@ -1564,6 +2076,17 @@ CAnomalyJob::detectorForKey(bool isRestoring,
         model::CSearchKey::TStrCRefKeyCRefPr(std::cref(partition), std::cref(key)),
         model::CStrKeyPrHash(), model::CStrKeyPrEqual());
 
+    // Detectors which were restored lazily are restored when first needed,
+    // as for new detectors only if allocations are allowed.
+    if (itr == m_Detectors.end() && m_DormantDetectors.empty() == false) {
+        auto dormant = m_DormantDetectors.find(
+            model::CSearchKey::TStrCRefKeyCRefPr(std::cref(partition), std::cref(key)),
+            model::CStrKeyPrHash(), model::CStrKeyPrEqual());
+        if (dormant != m_DormantDetectors.end()) {
+            return this->materialiseDormantDetector(dormant);
+        }
+    }
+
     // Check if we need to and are allowed to create a new detector.
     if (itr == m_Detectors.end() && resourceMonitor.areAllocationsAllowed()) {
         // Create an placeholder for the anomaly detector.
@@ -1607,6 +2130,12 @@ void CAnomalyJob::pruneAllModels(std::size_t buckets) {
         LOG_DEBUG(<< "Pruning all models older than " << buckets << " buckets");
     }
 
+    this->copyDetectorsForPersistBeforeUpdate();
+    if (buckets == 0) {
+        this->materialiseDormantDetectors();
+    }
+    // Otherwise dormant detectors are pruned when they're restored.
+
     for (const auto& detector_ : m_Detectors) {
         model::CAnomalyDetector* detector = detector_.second.get();
         if (detector == nullptr) {
@@ -1666,6 +2195,7 @@ void CAnomalyJob::addRecord(const TAnomalyDetectorPtr detector,
         fieldValues.push_back(fieldValue(fieldNames[i], dataRowFields));
     }
 
+    this->copyDetectorForPersistBeforeUpdate(*detector);
     detector->addRecord(time, fieldValues);
 }
 
@@ -1680,5 +2210,29 @@ CAnomalyJob::SBackgroundPersistArgs::SBackgroundPersistArgs(
       s_InterimBucketCorrector(interimBucketCorrector), s_Aggregator(aggregator),
       s_LatestRecordTime(latestRecordTime), s_LastResultsTime(lastResultsTime) {
 }
+
+bool CAnomalyJob::SBackgroundPersistArgs::copyLiveDetector(const model::CAnomalyDetector& detector) {
+    core::CScopedFastLock lock{s_LiveDetectorsMutex};
+    auto live = s_LiveDetectors.find(&detector);
+    if (live != s_LiveDetectors.end()) {
+        s_Detectors[live->second].second = copyForPersistence(detector);
+        s_LiveDetectors.erase(live);
+    }
+    return s_LiveDetectors.empty() == false;
+}
+
+void CAnomalyJob::SBackgroundPersistArgs::copyLiveDetectors() {
+    // Take the lock for each copy in turn so the main thread only ever
+    // has to wait for one detector to be copied.
+    for (;;) {
+        core::CScopedFastLock lock{s_LiveDetectorsMutex};
+        if (s_LiveDetectors.empty()) {
+            break;
+        }
+        auto live = s_LiveDetectors.begin();
+        s_Detectors[live->second].second = copyForPersistence(*live->first);
+        s_LiveDetectors.erase(live);
+    }
+}
 }
 }
@@ -20,6 +20,7 @@
 #include <core/CStateDecompressor.h>
 #include <core/CStateRestoreTraverser.h>
 #include <core/CStringUtils.h>
+#include <core/Concurrency.h>
 
 #include <model/CTokenListReverseSearchCreator.h>
 
@@ -28,6 +29,8 @@
 #include <api/CPerPartitionCategoryIdMapper.h>
 #include <api/CPersistenceManager.h>
 
+#include <algorithm>
+#include <map>
 #include <memory>
 #include <sstream>
 
@@ -50,6 +53,7 @@ const std::string CFieldDataCategorizer::MLCATEGORY_NAME{"mlcategory"};
 const double CFieldDataCategorizer::SIMILARITY_THRESHOLD{0.7};
 const std::string CFieldDataCategorizer::STATE_TYPE{"categorizer_state"};
 const std::string CFieldDataCategorizer::STATE_VERSION{"1"};
+const std::size_t CFieldDataCategorizer::RECORD_BATCH_SIZE{1000};
 
 CFieldDataCategorizer::CFieldDataCategorizer(std::string jobId,
                                              const CAnomalyJobConfig::CAnalysisConfig& analysisConfig,
@@ -59,10 +63,12 @@ CFieldDataCategorizer::CFieldDataCategorizer(std::string jobId,
                                              CDataProcessor* chainedProcessor,
                                              core::CJsonOutputStreamWrapper& outputStream,
                                              CPersistenceManager* persistenceManager,
-                                             bool stopCategorizationOnWarnStatus)
+                                             bool stopCategorizationOnWarnStatus,
+                                             std::size_t numberThreads)
     : CDataProcessor{timeFieldName, timeFieldFormat}, m_JobId{std::move(jobId)}, m_Limits{limits},
       m_ChainedProcessor{chainedProcessor}, m_OutputStream{outputStream},
       m_StopCategorizationOnWarnStatus{stopCategorizationOnWarnStatus},
+      m_NumberThreads{std::max(numberThreads, std::size_t{1})},
       m_JsonOutputWriter{m_JobId, m_OutputStream}, m_AnnotationJsonWriter{m_OutputStream},
       m_PartitionFieldName{analysisConfig.categorizationPartitionFieldName()},
       m_CategorizationFieldName{analysisConfig.categorizationFieldName()}, m_PersistenceManager{persistenceManager} {
@@ -71,6 +77,14 @@ CFieldDataCategorizer::CFieldDataCategorizer(std::string jobId,
         LOG_DEBUG(<< "Configuring categorization filtering");
         m_CategorizationFilter.configure(analysisConfig.categorizationFilters());
     }
+    if (m_NumberThreads > 1) {
+        if (m_PartitionFieldName.empty()) {
+            LOG_DEBUG(<< "Categorizing on one thread as per-partition categorization is not used");
+            m_NumberThreads = 1;
+        } else {
+            m_BufferedRecords.reserve(RECORD_BATCH_SIZE);
+        }
+    }
 }
 
 CFieldDataCategorizer::~CFieldDataCategorizer() {
@@ -94,6 +108,11 @@ bool CFieldDataCategorizer::handleRecord(const TStrStrUMap& dataRowFields, TOpti
     // Non-empty control fields take precedence over everything else
     auto iter = dataRowFields.find(CONTROL_FIELD_NAME);
     if (iter != dataRowFields.end() && !iter->second.empty()) {
+        // Records received before the control message must be processed
+        // before it
+        if (this->handleBufferedRecords() == false) {
+            return false;
+        }
         // Always handle control messages, but signal completion of handling ONLY if we are the last handler
         // e.g. flush requests are acknowledged here if this is the last handler
         bool msgHandled{this->handleControlMessage(iter->second, m_ChainedProcessor == nullptr)};
@@ -107,6 +126,20 @@ bool CFieldDataCategorizer::handleRecord(const TStrStrUMap& dataRowFields, TOpti
         time = this->parseTime(dataRowFields);
     }
 
+    if (m_NumberThreads > 1) {
+        m_BufferedRecords.emplace_back(dataRowFields, time);
+        if (m_BufferedRecords.size() < RECORD_BATCH_SIZE) {
+            return true;
+        }
+        if (this->handleBufferedRecords() == false) {
+            return false;
+        }
+        if (m_PersistenceManager != nullptr) {
+            m_PersistenceManager->startPersistIfAppropriate();
+        }
+        return true;
+    }
+
     CGlobalCategoryId globalCategoryId{this->computeAndUpdateCategory(dataRowFields, time)};
     if (globalCategoryId.isHardFailure() == false) {
         if (m_OutputFieldCategory != nullptr) {
@@ -131,6 +164,10 @@ bool CFieldDataCategorizer::handleRecord(const TStrStrUMap& dataRowFields, TOpti
 
 void CFieldDataCategorizer::finalise() {
 
+    if (this->handleBufferedRecords() == false) {
+        LOG_ERROR(<< "Failed to pass on buffered records");
+    }
+
     // Make sure model size stats are up to date
     for (const auto& dataCategorizerEntry : m_DataCategorizers) {
         dataCategorizerEntry.second->forceResourceRefresh(m_Limits.resourceMonitor());
@@ -160,13 +197,37 @@ CGlobalCategoryId
 CFieldDataCategorizer::computeAndUpdateCategory(const TStrStrUMap& dataRowFields,
                                                 const TOptionalTime& time) {
     CGlobalCategoryId globalCategoryId;
+    CSingleFieldDataCategorizer* dataCategorizer{
+        this->checkedCategorizerForRecord(dataRowFields, globalCategoryId)};
+    if (dataCategorizer == nullptr) {
+        return globalCategoryId;
+    }
+    const std::string& fieldValue{dataRowFields.at(m_CategorizationFieldName)};
+    if (m_CategorizationFilter.empty()) {
+        globalCategoryId = dataCategorizer->computeAndUpdateCategory(
+            false, dataRowFields, time, fieldValue, fieldValue,
+            m_Limits.resourceMonitor(), m_JsonOutputWriter);
+    } else {
+        std::string filtered{m_CategorizationFilter.apply(fieldValue)};
+        globalCategoryId = dataCategorizer->computeAndUpdateCategory(
+            false, dataRowFields, time, filtered, fieldValue,
+            m_Limits.resourceMonitor(), m_JsonOutputWriter);
+    }
+    if (globalCategoryId.isValid()) {
+        dataCategorizer->writeStatsIfUrgent(m_JsonOutputWriter, m_AnnotationJsonWriter);
+    }
+    return globalCategoryId;
+}
 
+CSingleFieldDataCategorizer*
+CFieldDataCategorizer::checkedCategorizerForRecord(const TStrStrUMap& dataRowFields,
+                                                   CGlobalCategoryId& globalCategoryId) {
     auto fieldIter = dataRowFields.find(m_CategorizationFieldName);
     if (fieldIter == dataRowFields.end()) {
         LOG_WARN(<< "Assigning ML category " << globalCategoryId << " to record with no "
                  << m_CategorizationFieldName << " field:" << core_t::LINE_ENDING
                  << this->debugPrintRecord(dataRowFields));
-        return globalCategoryId;
+        return nullptr;
     }
 
     const std::string& fieldValue{fieldIter->second};
@@ -174,7 +235,7 @@ CFieldDataCategorizer::computeAndUpdateCategory(const TStrStrUMap& dataRowFields
         LOG_WARN(<< "Assigning ML category " << globalCategoryId << " to record with blank "
                  << m_CategorizationFieldName << " field:" << core_t::LINE_ENDING
                  << this->debugPrintRecord(dataRowFields));
-        return globalCategoryId;
+        return nullptr;
     }
 
     const std::string& partitionFieldValue{this->categorizerKeyForRecord(dataRowFields)};
@@ -195,28 +256,111 @@ CFieldDataCategorizer::computeAndUpdateCategory(const TStrStrUMap& dataRowFields
             }
         }
         m_Limits.resourceMonitor().categorizerAllocationFailures(m_CategorizerAllocationFailures);
-        return CGlobalCategoryId::hardFailure();
+        globalCategoryId = CGlobalCategoryId::hardFailure();
+        return nullptr;
     }
     if (m_StopCategorizationOnWarnStatus &&
         dataCategorizer->categorizationStatus() == model_t::E_CategorizationStatusWarn) {
         LOG_TRACE(<< "Ignoring input record as its categorizer has a 'warn' status:"
                   << core_t::LINE_ENDING << this->debugPrintRecord(dataRowFields));
-        return CGlobalCategoryId::hardFailure();
+        globalCategoryId = CGlobalCategoryId::hardFailure();
+        return nullptr;
     }
-    if (m_CategorizationFilter.empty()) {
-        globalCategoryId = dataCategorizer->computeAndUpdateCategory(
-            false, dataRowFields, time, fieldValue, fieldValue,
-            m_Limits.resourceMonitor(), m_JsonOutputWriter);
-    } else {
-        std::string filtered{m_CategorizationFilter.apply(fieldValue)};
-        globalCategoryId = dataCategorizer->computeAndUpdateCategory(
-            false, dataRowFields, time, filtered, fieldValue,
-            m_Limits.resourceMonitor(), m_JsonOutputWriter);
+    return dataCategorizer;
+}
+
+bool CFieldDataCategorizer::handleBufferedRecords() {
+    if (m_BufferedRecords.empty()) {
+        return true;
     }
-    if (globalCategoryId.isValid()) {
-        dataCategorizer->writeStatsIfUrgent(m_JsonOutputWriter, m_AnnotationJsonWriter);
+
+    // Creating categorizers and checking whether records can be categorized
+    // can change shared state so is done serially in input order.
+    using TSizeVec = std::vector<std::size_t>;
+    std::map<CSingleFieldDataCategorizer*, TSizeVec> recordsByCategorizer;
+    for (std::size_t i = 0; i < m_BufferedRecords.size(); ++i) {
+        SBufferedRecord& record{m_BufferedRecords[i]};
+        record.s_DataCategorizer = this->checkedCategorizerForRecord(
+            record.s_Fields, record.s_GlobalCategoryId);
+        if (record.s_DataCategorizer != nullptr) {
+            recordsByCategorizer[record.s_DataCategorizer].push_back(i);
+        }
     }
-    return globalCategoryId;
+
+    // Each categorizer is only touched by the thread which categorizes its
+    // records, which it does in input order.
+    std::vector<const TSizeVec*> recordsToCategorize;
+    recordsToCategorize.reserve(recordsByCategorizer.size());
+    for (const auto& entry : recordsByCategorizer) {
+        recordsToCategorize.push_back(&entry.second);
+    }
+    core::parallel_for_each(m_NumberThreads, 0, recordsToCategorize.size(), [&](std::size_t i) {
+        for (auto j : *recordsToCategorize[i]) {
+            SBufferedRecord& record{m_BufferedRecords[j]};
+            const std::string& fieldValue{record.s_Fields.at(m_CategorizationFieldName)};
+            if (m_CategorizationFilter.empty()) {
+                record.s_Categorization = record.s_DataCategorizer->computeLocalCategory(
+                    false, record.s_Fields, fieldValue, fieldValue);
+            } else {
+                std::string filtered{m_CategorizationFilter.apply(fieldValue)};
+                record.s_Categorization = record.s_DataCategorizer->computeLocalCategory(
+                    false, record.s_Fields, filtered, fieldValue);
+            }
+        }
+    });
+
+    // Global IDs are allocated in input order so they don't depend on the
+    // number of threads.  This must happen for the whole batch before any
+    // definitions are written because they can refer to categories created
+    // later in the batch.
+    for (auto& record : m_BufferedRecords) {
+        if (record.s_DataCategorizer != nullptr) {
+            record.s_GlobalCategoryId = record.s_DataCategorizer->mapCategory(
+                record.s_Categorization.s_LocalCategoryId, record.s_Time);
+        }
+    }
+
+    // The categorizers' state already includes the whole batch so a periodic
+    // persist triggered by the chained processor mustn't happen until it has
+    // been passed every record. Otherwise the records after the snapshot would
+    // be categorized twice after restoring it.
+    if (m_PersistenceManager != nullptr) {
+        m_PersistenceManager->deferPersistence();
+    }
+
+    bool result{true};
+    for (auto& record : m_BufferedRecords) {
+        if (record.s_GlobalCategoryId.isValid()) {
+            if (record.s_Categorization.s_Changed) {
+                record.s_DataCategorizer->writeCategoryIfChanged(
+                    record.s_Categorization.s_LocalCategoryId,
+                    m_Limits.resourceMonitor(), m_JsonOutputWriter);
+            }
+            record.s_DataCategorizer->writeStatsIfUrgent(m_JsonOutputWriter,
+                                                         m_AnnotationJsonWriter);
+        }
+        if (record.s_GlobalCategoryId.isHardFailure()) {
+            continue;
+        }
+        if (m_OutputFieldCategory != nullptr) {
+            record.s_Fields[MLCATEGORY_NAME] =
+                core::CStringUtils::typeToString(record.s_GlobalCategoryId.globalId());
+        }
+        if (m_ChainedProcessor != nullptr &&
+            m_ChainedProcessor->handleRecord(record.s_Fields, record.s_Time) == false) {
+            result = false;
+            break;
+        }
+        ++m_NumRecordsHandled;
+    }
+
+    m_BufferedRecords.clear();
+
+    if (m_PersistenceManager != nullptr) {
+        m_PersistenceManager->resumePersistence();
+    }
+
+    return result;
 }
 
 const std::string& CFieldDataCategorizer::categorizerKeyForRecord(const TStrStrUMap& dataRowFields) {
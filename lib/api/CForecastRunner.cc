@@ -14,6 +14,7 @@
 #include <core/CLogger.h>
 #include <core/CStopWatch.h>
 #include <core/CTimeUtils.h>
+#include <core/Concurrency.h>
 
 #include <model/CForecastDataSink.h>
 #include <model/CForecastModelPersist.h>
@@ -22,6 +23,8 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/system/error_code.hpp>
 
+#include <algorithm>
+#include <future>
 #include <sstream>
 
 namespace ml {
@@ -29,6 +32,45 @@ namespace api {
 
 namespace {
 const std::string EMPTY_STRING;
+
+using TForecastModelWrapperPtr = std::unique_ptr<model::CForecastDataSink::CForecastModelWrapper>;
+
+//! \brief The state for forecasting a single model in a batch.
+//!
+//! The model is either held in memory or it is a record read from the
+//! forecast persistence file which is restored by the thread which
+//! forecasts it.
+struct SForecastTask {
+    explicit SForecastTask(model::CForecastDataSink::CForecastModelWrapper&& model)
+        : s_Model{std::make_unique<model::CForecastDataSink::CForecastModelWrapper>(
+              std::move(model))} {}
+    explicit SForecastTask(model::CForecastModelPersist::TByteVec&& record)
+        : s_PersistedModel{std::move(record)} {}
+
+    //! Restore the model from its persisted record.
+    bool restore(const model::CForecastModelPersist::CRestore& modelRestore) {
+        model::CForecastModelPersist::TMathsModelPtr model;
+        core_t::TTime firstDataTime;
+        core_t::TTime lastDataTime;
+        model_t::EFeature feature;
+        std::string byFieldValue;
+        if (modelRestore.restoreModel(s_PersistedModel, model, firstDataTime,
+                                      lastDataTime, feature, byFieldValue) == false) {
+            return false;
+        }
+        s_PersistedModel = model::CForecastModelPersist::TByteVec{};
+        s_Model = std::make_unique<model::CForecastDataSink::CForecastModelWrapper>(
+            feature, byFieldValue, std::move(model), firstDataTime, lastDataTime);
+        return true;
+    }
+
+    model::CForecastModelPersist::TByteVec s_PersistedModel;
+    TForecastModelWrapperPtr s_Model;
+    model::CForecastDataSink::TErrorBarVec s_ErrorBars;
+    std::string s_Message;
+    bool s_Success{false};
+};
+using TForecastTaskVec = std::vector<SForecastTask>;
 }
 
 const std::size_t CForecastRunner::DEFAULT_MAX_FORECAST_MODEL_MEMORY{20971520}; // 20MB
@@ -57,9 +99,11 @@ const std::string CForecastRunner::INFO_NO_MODELS_CAN_CURRENTLY_BE_FORECAST("Ins
 
 CForecastRunner::CForecastRunner(const std::string& jobId,
                                  core::CJsonOutputStreamWrapper& strmOut,
-                                 model::CResourceMonitor& resourceMonitor)
-    : m_JobId{jobId}, m_ConcurrentOutputStream{strmOut},
-      m_ResourceMonitor{resourceMonitor}, m_Shutdown{false} {
+                                 model::CResourceMonitor& resourceMonitor,
+                                 std::size_t numberThreads)
+    : m_JobId{jobId}, m_ConcurrentOutputStream{strmOut}, m_ResourceMonitor{resourceMonitor},
+      m_NumberThreads{std::max(numberThreads, std::size_t{1})},
+      m_Executor{core::makeThreadPoolExecutor(m_NumberThreads)}, m_Shutdown{false} {
     m_Worker = std::thread([this] { this->forecastWorker(); });
 }
 
@@ -101,8 +145,6 @@ void CForecastRunner::forecastWorker() {
                 forecastJob.forecastEnd(), forecastJob.s_ExpiryTime,
                 forecastJob.s_MemoryUsage, m_ConcurrentOutputStream);
 
-            std::string message;
-
             // collecting the runtime messages first and sending it in 1 go
             TStrUSet messages(forecastJob.s_Messages);
             double processedModels = 0;
@@ -111,7 +153,17 @@ void CForecastRunner::forecastWorker() {
             std::size_t failedForecasts = 0;
             sink.writeStats(0.0, 0, forecastJob.s_Messages);
 
-            // while loops allow us to free up memory for every model right after each forecast is done
+            // Models are forecast in batches on the runner's own thread pool.
+            // Each model's results are buffered and written to the sink in the
+            // order the models were taken so the output doesn't depend on the
+            // number of threads. Models persisted to disk are read sequentially
+            // and restored by the forecasting threads. The while loops allow us
+            // to free up memory for every batch right after its forecasts are
+            // written, so at most one batch of models is in memory.
+            std::size_t batchSize{m_NumberThreads * FORECAST_BATCH_SIZE_PER_THREAD};
+            TForecastTaskVec batch;
+            batch.reserve(batchSize);
+
             while (!forecastJob.s_ForecastSeries.empty()) {
                 TForecastResultSeries& series = forecastJob.s_ForecastSeries.back();
                 std::unique_ptr<model::CForecastModelPersist::CRestore> modelRestore;
@@ -123,46 +175,66 @@ void CForecastRunner::forecastWorker() {
                         series.s_ToForecastPersisted);
                 }
 
-                while (series.s_ToForecast.empty() == false || modelRestore != nullptr) {
-                    // check if we should backfill from persistence
-                    if (series.s_ToForecast.empty()) {
-                        TMathsModelPtr model;
-                        core_t::TTime firstDataTime;
-                        core_t::TTime lastDataTime;
-                        model_t::EFeature feature;
-                        std::string byFieldValue;
-
-                        if (modelRestore->nextModel(model, firstDataTime, lastDataTime,
-                                                    feature, byFieldValue)) {
-                            series.s_ToForecast.emplace_back(
-                                feature, byFieldValue, std::move(model),
-                                firstDataTime, lastDataTime);
-                        } else {
-                            // restorer exhausted, no need for further restoring
-                            modelRestore.reset();
+                for (;;) {
+                    while (batch.size() < batchSize) {
+                        if (series.s_ToForecast.empty() == false) {
+                            batch.emplace_back(std::move(series.s_ToForecast.back()));
+                            series.s_ToForecast.pop_back();
+                            continue;
+                        }
+
+                        // check if we should backfill from persistence
+                        model::CForecastModelPersist::TByteVec record;
+                        if (modelRestore == nullptr || modelRestore->nextRecord(record) == false) {
                             break;
                         }
+                        batch.emplace_back(std::move(record));
                     }
 
-                    const TForecastModelWrapper& model{series.s_ToForecast.back()};
-                    bool success{model.forecast(
-                        series, forecastJob.s_StartTime, forecastJob.forecastEnd(),
-                        forecastJob.s_BoundsPercentile, sink, message)};
-                    series.s_ToForecast.pop_back();
-
-                    if (success == false) {
-                        LOG_DEBUG(<< "Detector " << series.s_DetectorIndex
-                                  << " failed to forecast");
-                        ++failedForecasts;
+                    if (batch.empty()) {
+                        break;
                     }
 
-                    if (message.empty() == false) {
-                        messages.insert("Detector[" + std::to_string(series.s_DetectorIndex) +
-                                        "]: " + message);
-                        message.clear();
+                    // Each thread takes every m_NumberThreads'th model of the batch.
+                    std::size_t partitions{std::min(m_NumberThreads, batch.size())};
+                    std::vector<std::future<bool>> forecasted;
+                    forecasted.reserve(partitions);
+                    for (std::size_t offset = 0; offset < partitions; ++offset) {
+                        forecasted.push_back(core::async(*m_Executor, [&, offset] {
+                            for (std::size_t i = offset; i < batch.size(); i += partitions) {
+                                SForecastTask& task{batch[i]};
+                                if (task.s_Model == nullptr &&
+                                    task.restore(*modelRestore) == false) {
+                                    continue;
+                                }
+                                task.s_Success = task.s_Model->forecast(
+                                    forecastJob.s_StartTime, forecastJob.forecastEnd(),
+                                    forecastJob.s_BoundsPercentile,
+                                    task.s_ErrorBars, task.s_Message);
+                            }
+                            return true;
+                        }));
                     }
+                    core::get_conjunction_of_all(forecasted);
+
+                    for (const auto& task : batch) {
+                        if (task.s_Model != nullptr) {
+                            task.s_Model->write(series, task.s_ErrorBars, sink);
+                        }
 
-                    ++processedModels;
+                        if (task.s_Success == false) {
+                            LOG_DEBUG(<< "Detector " << series.s_DetectorIndex
+                                      << " failed to forecast");
+                            ++failedForecasts;
+                        }
+
+                        if (task.s_Message.empty() == false) {
+                            messages.insert("Detector[" + std::to_string(series.s_DetectorIndex) +
+                                            "]: " + task.s_Message);
+                        }
+                    }
+                    processedModels += static_cast<double>(batch.size());
+                    batch.clear();
 
                     if (processedModels != totalNumberOfForecastableModels) {
                         std::uint64_t elapsedTime = timer.lap();
@@ -21,7 +21,11 @@
 #include <api/CModelSizeStatsJsonWriter.h>
 #include <api/CModelSnapshotJsonWriter.h>
 
+#include <rapidjson/writer.h>
+
 #include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <sstream>
 
 namespace ml {
@@ -84,6 +88,91 @@ const std::string GEO_RESULTS("geo_results");
 const std::string ACTUAL_POINT("actual_point");
 const std::string TYPICAL_POINT("typical_point");
 
+//! Get the token which separates a field from the preceding one in an object
+//! and names it.
+std::string fieldToken(const std::string& name) {
+    return ",\"" + name + "\":";
+}
+
+// Pre-encoded tokens for the fields added to records when they're written
+const std::string DETECTOR_INDEX_TOKEN(fieldToken(DETECTOR_INDEX));
+const std::string BUCKET_SPAN_TOKEN(fieldToken(BUCKET_SPAN));
+const std::string JOB_ID_TOKEN(fieldToken(JOB_ID));
+const std::string TIMESTAMP_TOKEN(fieldToken(TIMESTAMP));
+const std::string IS_INTERIM_TOKEN(fieldToken(IS_INTERIM) + "true");
+
+//! Append the decimal representation of \p value to \p json.
+void appendInteger(std::int64_t value, std::string& json) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    json.append(buffer, result.ptr);
+}
+
+//! Write a double field. Non-finite values are logged and written as zero.
+template<typename WRITER>
+void writeDoubleField(const std::string& name, double value, WRITER& writer) {
+    if (std::isfinite(value) == false) {
+        LOG_ERROR(<< "Adding " << value << " to the \"" << name << "\" field of a JSON document");
+    }
+    writer.Key(name);
+    writer.Double(value);
+}
+
+//! Write a string field. Empty strings are skipped unless \p allowEmptyString.
+template<typename WRITER>
+void writeStringField(const std::string& name,
+                      const std::string& value,
+                      WRITER& writer,
+                      bool allowEmptyString = false) {
+    if (allowEmptyString || value.empty() == false) {
+        writer.Key(name);
+        writer.String(value);
+    }
+}
+
+//! Write an array of doubles field. Non-finite values are logged (once) and
+//! written as zero.
+template<typename WRITER>
+void writeDoubleArrayField(const std::string& name,
+                           const CHierarchicalResultsWriter::TDouble1Vec& values,
+                           WRITER& writer) {
+    writer.Key(name);
+    writer.StartArray();
+    bool considerLogging{true};
+    for (auto value : values) {
+        if (considerLogging && std::isfinite(value) == false) {
+            LOG_ERROR(<< "Adding " << value << " to the \"" << name << "\" array in a JSON document");
+            considerLogging = false;
+        }
+        writer.Double(value);
+    }
+    writer.EndArray();
+}
+
+//! Write the geo results field for a lat_long function.
+template<typename WRITER>
+void writeGeoResultsField(const CHierarchicalResultsWriter::TDouble1Vec& typical,
+                          const CHierarchicalResultsWriter::TDouble1Vec& actual,
+                          bool hasTypical,
+                          bool hasActual,
+                          WRITER& writer) {
+    auto geoPointToString = [](const auto& point) -> std::string {
+        std::ostringstream result;
+        // We don't want scientific notation and geo points only have precision up to 12 digits
+        result << std::fixed << std::setprecision(12) << point[0] << "," << point[1];
+        return result.str();
+    };
+    writer.Key(GEO_RESULTS);
+    writer.StartObject();
+    if (hasTypical) {
+        writeStringField(TYPICAL_POINT, geoPointToString(typical), writer);
+    }
+    if (hasActual) {
+        writeStringField(ACTUAL_POINT, geoPointToString(actual), writer);
+    }
+    writer.EndObject();
+}
+
 //! Get a numeric field from a JSON document.
 //! Assumes the document contains the field.
 //! The caller is responsible for ensuring this, and a
@@ -98,28 +187,26 @@ double doubleFromDocument(const CJsonOutputWriter::TDocumentWeakPtr& weakDoc,
     return (*docPtr)[field].GetDouble();
 }
 
-//! Sort rapidjson documents by the probability lowest to highest
+//! Sort records by the probability lowest to highest
 class CProbabilityLess {
 public:
-    bool operator()(const CJsonOutputWriter::TDocumentWeakPtrIntPr& lhs,
-                    const CJsonOutputWriter::TDocumentWeakPtrIntPr& rhs) const {
-        return doubleFromDocument(lhs.first, PROBABILITY) <
-               doubleFromDocument(rhs.first, PROBABILITY);
+    bool operator()(const CJsonOutputWriter::SRecord& lhs,
+                    const CJsonOutputWriter::SRecord& rhs) const {
+        return lhs.s_Probability < rhs.s_Probability;
     }
 };
 
 const CProbabilityLess PROBABILITY_LESS = CProbabilityLess();
 
-//! Sort rapidjson documents by detector name first then probability lowest to highest
+//! Sort records by detector name first then probability lowest to highest
 class CDetectorThenProbabilityLess {
 public:
-    bool operator()(const CJsonOutputWriter::TDocumentWeakPtrIntPr& lhs,
-                    const CJsonOutputWriter::TDocumentWeakPtrIntPr& rhs) const {
-        if (lhs.second == rhs.second) {
-            return doubleFromDocument(lhs.first, PROBABILITY) <
-                   doubleFromDocument(rhs.first, PROBABILITY);
+    bool operator()(const CJsonOutputWriter::SRecord& lhs,
+                    const CJsonOutputWriter::SRecord& rhs) const {
+        if (lhs.s_DetectorIndex == rhs.s_DetectorIndex) {
+            return lhs.s_Probability < rhs.s_Probability;
         }
-        return lhs.second < rhs.second;
+        return lhs.s_DetectorIndex < rhs.s_DetectorIndex;
     }
 };
 
@@ -157,9 +244,16 @@ const CInfluencerGreater BUCKET_INFLUENCER_GREATER = CInfluencerGreater(INITIAL_
 CJsonOutputWriter::CJsonOutputWriter(const std::string& jobId,
                                      core::CJsonOutputStreamWrapper& strmOut)
     : m_JobId(jobId), m_Writer(strmOut), m_LastNonInterimBucketTime(0),
-      m_Finalised(false), m_RecordOutputLimit(0) {
+      m_Finalised(false), m_RecordOutputLimit(0), m_RecordWriter(m_RecordBuffer),
+      m_NumberRecordsJson(0) {
     // Don't write any output in the constructor because, the way things work at
     // the moment, the output stream might be redirected after construction
+
+    // The job ID is escaped once here rather than for every record
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.String(m_JobId);
+    m_EncodedJobId.assign(buffer.GetString(), buffer.GetSize());
 }
 
 CJsonOutputWriter::~CJsonOutputWriter() {
@@ -196,71 +290,87 @@ bool CJsonOutputWriter::acceptResult(const CHierarchicalResultsWriter::TResults&
         return true;
     }
 
-    TDocumentWeakPtr newDoc;
     if (!results.s_IsOverallResult) {
-        newDoc = m_Writer.makeStorableDoc();
-        this->addPopulationCauseFields(results, newDoc);
-        m_NestedDocs.push_back(newDoc);
+        this->startRecordJson();
+        this->writePopulationCauseFields(results);
+        m_RecordWriter.EndObject();
+        m_CausesJson.push_back(m_CausesJson.empty() ? '[' : ',');
+        m_CausesJson.append(m_RecordBuffer.GetString(), m_RecordBuffer.GetSize());
 
         return true;
     }
 
     ++bucketData.s_RecordCount;
 
-    TDocumentWeakPtrIntPrVec& detectorDocumentsToWrite = bucketData.s_DocumentsToWrite;
+    TRecordVec& recordsToWrite = bucketData.s_RecordsToWrite;
 
     bool makeHeap(false);
+    std::size_t json;
     // If a max number of records to output has not been set or we haven't
-    // reached that limit yet just append the new document to the array
+    // reached that limit yet just append the new record to the array
     if (m_RecordOutputLimit == 0 || bucketData.s_RecordCount <= m_RecordOutputLimit) {
-        newDoc = m_Writer.makeStorableDoc();
-        detectorDocumentsToWrite.push_back(TDocumentWeakPtrIntPr(newDoc, results.s_Identifier));
+        json = this->newRecordJson();
 
-        // the document array is now full, make a max heap
+        // the record array is now full, make a max heap
         makeHeap = bucketData.s_RecordCount == m_RecordOutputLimit;
     } else {
-        // Have reached the limit of records to write so compare the new doc
-        // to the highest probability anomaly doc and replace if more anomalous
+        // Have reached the limit of records to write so compare the new record
+        // to the highest probability anomaly record and replace if more anomalous
         if (results.s_Probability >= bucketData.s_HighestProbability) {
-            // Discard any associated nested docs
-            m_NestedDocs.clear();
+            // Discard any associated causes
+            m_CausesJson.clear();
             return true;
         }
 
-        newDoc = m_Writer.makeStorableDoc();
-        // remove the highest prob doc and insert new one
-        std::pop_heap(detectorDocumentsToWrite.begin(),
-                      detectorDocumentsToWrite.end(), PROBABILITY_LESS);
-        detectorDocumentsToWrite.pop_back();
-
-        detectorDocumentsToWrite.push_back(TDocumentWeakPtrIntPr(newDoc, results.s_Identifier));
+        // remove the highest prob record and reuse its JSON for the new one
+        std::pop_heap(recordsToWrite.begin(), recordsToWrite.end(), PROBABILITY_LESS);
+        json = recordsToWrite.back().s_Json;
+        recordsToWrite.pop_back();
 
         makeHeap = true;
     }
+    recordsToWrite.push_back(SRecord{results.s_Probability, results.s_Identifier, json});
+
+    this->startRecordJson();
 
     // The check for population results must come first because some population
     // results are also metrics
     if (results.s_ResultType == CHierarchicalResultsWriter::E_PopulationResult) {
-        this->addPopulationFields(results, newDoc);
+        this->writePopulationFields(results);
     } else if (results.s_IsMetric) {
-        this->addMetricFields(results, newDoc);
+        this->writeMetricFields(results);
     } else {
-        this->addEventRateFields(results, newDoc);
+        this->writeEventRateFields(results);
     }
 
-    this->addInfluences(results.s_Influences, newDoc);
+    this->writeInfluences(results.s_Influences);
+
+    // The record is left open so the fields which depend on its bucket can
+    // be appended when it's written
+    m_RecordsJson[json].assign(m_RecordBuffer.GetString(), m_RecordBuffer.GetSize());
 
     if (makeHeap) {
-        std::make_heap(detectorDocumentsToWrite.begin(),
-                       detectorDocumentsToWrite.end(), PROBABILITY_LESS);
+        std::make_heap(recordsToWrite.begin(), recordsToWrite.end(), PROBABILITY_LESS);
 
-        bucketData.s_HighestProbability =
-            doubleFromDocument(detectorDocumentsToWrite.front().first, PROBABILITY);
+        bucketData.s_HighestProbability = recordsToWrite.front().s_Probability;
     }
 
     return true;
 }
 
+std::size_t CJsonOutputWriter::newRecordJson() {
+    if (m_NumberRecordsJson == m_RecordsJson.size()) {
+        m_RecordsJson.emplace_back();
+    }
+    return m_NumberRecordsJson++;
+}
+
+void CJsonOutputWriter::startRecordJson() {
+    m_RecordBuffer.Clear();
+    m_RecordWriter.Reset(m_RecordBuffer);
+    m_RecordWriter.StartObject();
+}
+
 bool CJsonOutputWriter::acceptInfluencer(core_t::TTime time,
                                          const model::CHierarchicalResults::TNode& node,
                                          bool isBucketInfluencer) {
@@ -351,7 +461,8 @@ bool CJsonOutputWriter::endOutputBatch(bool isInterim, std::uint64_t bucketProce
     // After writing the buckets clear all the bucket data so that we don't
     // accumulate memory.
     m_BucketDataByTime.clear();
-    m_NestedDocs.clear();
+    m_NumberRecordsJson = 0;
+    m_CausesJson.clear();
 
     return true;
 }
@@ -361,38 +472,19 @@ void CJsonOutputWriter::writeBucket(bool isInterim,
                                     SBucketData& bucketData,
                                     std::uint64_t bucketProcessingTime) {
     // Write records
-    if (!bucketData.s_DocumentsToWrite.empty()) {
+    if (!bucketData.s_RecordsToWrite.empty()) {
         // Sort the results so they are grouped by detector and
         // ordered by probability
-        std::sort(bucketData.s_DocumentsToWrite.begin(),
-                  bucketData.s_DocumentsToWrite.end(), DETECTOR_PROBABILITY_LESS);
+        std::sort(bucketData.s_RecordsToWrite.begin(),
+                  bucketData.s_RecordsToWrite.end(), DETECTOR_PROBABILITY_LESS);
 
         m_Writer.StartObject();
         m_Writer.String(RECORDS);
         m_Writer.StartArray();
 
         // Iterate over the different detectors that we have results for
-        for (TDocumentWeakPtrIntPrVecItr detectorIter =
-                 bucketData.s_DocumentsToWrite.begin();
-             detectorIter != bucketData.s_DocumentsToWrite.end(); ++detectorIter) {
-            // Write the document, adding some extra fields as we go
-            int detectorIndex = detectorIter->second;
-            TDocumentWeakPtr weakDoc = detectorIter->first;
-            TDocumentPtr docPtr = weakDoc.lock();
-            if (!docPtr) {
-                LOG_ERROR(<< "Inconsistent program state. JSON document unavailable.");
-                continue;
-            }
-
-            m_Writer.addIntFieldToObj(DETECTOR_INDEX, detectorIndex, *docPtr);
-            m_Writer.addIntFieldToObj(BUCKET_SPAN, bucketData.s_BucketSpan, *docPtr);
-            m_Writer.addStringFieldCopyToObj(JOB_ID, m_JobId, *docPtr);
-            m_Writer.addTimeFieldToObj(TIMESTAMP, bucketTime, *docPtr);
-
-            if (isInterim) {
-                m_Writer.addBoolFieldToObj(IS_INTERIM, isInterim, *docPtr);
-            }
-            m_Writer.write(*docPtr);
+        for (const auto& record : bucketData.s_RecordsToWrite) {
+            this->writeRecord(record, isInterim, bucketTime, bucketData.s_BucketSpan);
         }
         m_Writer.EndArray();
         m_Writer.EndObject();
@@ -490,206 +582,152 @@ void CJsonOutputWriter::writeBucket(bool isInterim,
     m_Writer.EndObject();
 }
 
-void CJsonOutputWriter::addMetricFields(const CHierarchicalResultsWriter::TResults& results,
-                                        TDocumentWeakPtr weakDoc) {
-    TDocumentPtr docPtr = weakDoc.lock();
-    if (!docPtr) {
-        LOG_ERROR(<< "Inconsistent program state. JSON document unavailable.");
-        return;
+void CJsonOutputWriter::writeRecord(const SRecord& record,
+                                    bool isInterim,
+                                    core_t::TTime bucketTime,
+                                    core_t::TTime bucketSpan) {
+    // Complete the record in place: its JSON isn't needed again after it's
+    // been written.
+    std::string& json{m_RecordsJson[record.s_Json]};
+    json += DETECTOR_INDEX_TOKEN;
+    appendInteger(record.s_DetectorIndex, json);
+    json += BUCKET_SPAN_TOKEN;
+    appendInteger(bucketSpan, json);
+    if (m_JobId.empty() == false) {
+        json += JOB_ID_TOKEN;
+        json += m_EncodedJobId;
+    }
+    json += TIMESTAMP_TOKEN;
+    appendInteger(core::CTimeUtils::toEpochMs(bucketTime), json);
+    if (isInterim) {
+        json += IS_INTERIM_TOKEN;
     }
+    json += '}';
+    m_Writer.RawValue(json.data(), json.size(), rapidjson::kObjectType);
+}
 
+void CJsonOutputWriter::writeMetricFields(const CHierarchicalResultsWriter::TResults& results) {
     // record_score, probability, fieldName, byFieldName, byFieldValue, partitionFieldName,
     // partitionFieldValue, function, typical, actual. influences?
-    m_Writer.addDoubleFieldToObj(INITIAL_RECORD_SCORE,
-                                 results.s_NormalizedAnomalyScore, *docPtr);
-    m_Writer.addDoubleFieldToObj(RECORD_SCORE, results.s_NormalizedAnomalyScore, *docPtr);
-    m_Writer.addDoubleFieldToObj(PROBABILITY, results.s_Probability, *docPtr);
-    m_Writer.addDoubleFieldToObj(MULTI_BUCKET_IMPACT, results.s_MultiBucketImpact, *docPtr);
-    m_Writer.addStringFieldCopyToObj(FIELD_NAME, results.s_MetricValueField, *docPtr);
+    writeDoubleField(INITIAL_RECORD_SCORE, results.s_NormalizedAnomalyScore, m_RecordWriter);
+    writeDoubleField(RECORD_SCORE, results.s_NormalizedAnomalyScore, m_RecordWriter);
+    writeDoubleField(PROBABILITY, results.s_Probability, m_RecordWriter);
+    writeDoubleField(MULTI_BUCKET_IMPACT, results.s_MultiBucketImpact, m_RecordWriter);
+    writeStringField(FIELD_NAME, results.s_MetricValueField, m_RecordWriter);
     if (!results.s_ByFieldName.empty()) {
-        m_Writer.addStringFieldCopyToObj(BY_FIELD_NAME, results.s_ByFieldName, *docPtr);
+        writeStringField(BY_FIELD_NAME, results.s_ByFieldName, m_RecordWriter);
         // If name is present then force output of value too, even when empty
-        m_Writer.addStringFieldCopyToObj(BY_FIELD_VALUE, results.s_ByFieldValue,
-                                         *docPtr, true);
+        writeStringField(BY_FIELD_VALUE, results.s_ByFieldValue, m_RecordWriter, true);
         // But allow correlatedByFieldValue to be unset if blank
-        m_Writer.addStringFieldCopyToObj(CORRELATED_BY_FIELD_VALUE,
-                                         results.s_CorrelatedByFieldValue, *docPtr);
+        writeStringField(CORRELATED_BY_FIELD_VALUE,
+                         results.s_CorrelatedByFieldValue, m_RecordWriter);
     }
     if (!results.s_PartitionFieldName.empty()) {
-        m_Writer.addStringFieldCopyToObj(PARTITION_FIELD_NAME,
-                                         results.s_PartitionFieldName, *docPtr);
+        writeStringField(PARTITION_FIELD_NAME, results.s_PartitionFieldName, m_RecordWriter);
         // If name is present then force output of value too, even when empty
-        m_Writer.addStringFieldCopyToObj(
-            PARTITION_FIELD_VALUE, results.s_PartitionFieldValue, *docPtr, true);
-    }
-    m_Writer.addStringFieldCopyToObj(FUNCTION, results.s_FunctionName, *docPtr);
-    m_Writer.addStringFieldCopyToObj(FUNCTION_DESCRIPTION,
-                                     results.s_FunctionDescription, *docPtr);
-    m_Writer.addDoubleArrayFieldToObj(TYPICAL, results.s_BaselineMean, *docPtr);
-    m_Writer.addDoubleArrayFieldToObj(ACTUAL, results.s_CurrentMean, *docPtr);
+        writeStringField(PARTITION_FIELD_VALUE, results.s_PartitionFieldValue,
+                         m_RecordWriter, true);
+    }
+    writeStringField(FUNCTION, results.s_FunctionName, m_RecordWriter);
+    writeStringField(FUNCTION_DESCRIPTION, results.s_FunctionDescription, m_RecordWriter);
+    writeDoubleArrayField(TYPICAL, results.s_BaselineMean, m_RecordWriter);
+    writeDoubleArrayField(ACTUAL, results.s_CurrentMean, m_RecordWriter);
     if (results.s_FunctionName ==
         CAnomalyJobConfig::CAnalysisConfig::CDetectorConfig::FUNCTION_LAT_LONG) {
-        rapidjson::Value geoResults = m_Writer.makeObject();
-        auto geoPointToString = [](const auto& point) -> std::string {
-            std::ostringstream result;
-            // We don't want scientific notation and geo points only have precision up to 12 digits
-            result << std::fixed << std::setprecision(12) << point[0] << "," << point[1];
-            return result.str();
-        };
-        if (results.s_BaselineMean.size() == 2) {
-            m_Writer.addStringFieldCopyToObj(
-                TYPICAL_POINT, geoPointToString(results.s_BaselineMean), geoResults);
-        }
-        if (results.s_CurrentMean.size() == 2) {
-            m_Writer.addStringFieldCopyToObj(
-                ACTUAL_POINT, geoPointToString(results.s_CurrentMean), geoResults);
-        }
-        m_Writer.addMember(GEO_RESULTS, geoResults, *docPtr);
+        writeGeoResultsField(results.s_BaselineMean, results.s_CurrentMean,
+                             results.s_BaselineMean.size() == 2,
+                             results.s_CurrentMean.size() == 2, m_RecordWriter);
     }
 }
 
-void CJsonOutputWriter::addPopulationFields(const CHierarchicalResultsWriter::TResults& results,
-                                            TDocumentWeakPtr weakDoc) {
-    TDocumentPtr docPtr = weakDoc.lock();
-    if (!docPtr) {
-        LOG_ERROR(<< "Inconsistent program state. JSON document unavailable.");
-        return;
-    }
-
+void CJsonOutputWriter::writePopulationFields(const CHierarchicalResultsWriter::TResults& results) {
     // record_score, probability, fieldName, byFieldName,
     // overFieldName, overFieldValue, partitionFieldName, partitionFieldValue,
     // function, causes, influences?
-    m_Writer.addDoubleFieldToObj(INITIAL_RECORD_SCORE,
-                                 results.s_NormalizedAnomalyScore, *docPtr);
-    m_Writer.addDoubleFieldToObj(RECORD_SCORE, results.s_NormalizedAnomalyScore, *docPtr);
-    m_Writer.addDoubleFieldToObj(PROBABILITY, results.s_Probability, *docPtr);
-    m_Writer.addStringFieldCopyToObj(FIELD_NAME, results.s_MetricValueField, *docPtr);
+    writeDoubleField(INITIAL_RECORD_SCORE, results.s_NormalizedAnomalyScore, m_RecordWriter);
+    writeDoubleField(RECORD_SCORE, results.s_NormalizedAnomalyScore, m_RecordWriter);
+    writeDoubleField(PROBABILITY, results.s_Probability, m_RecordWriter);
+    writeStringField(FIELD_NAME, results.s_MetricValueField, m_RecordWriter);
     // There are no by field values at this level for population
     // results - they're in the "causes" object
-    m_Writer.addStringFieldCopyToObj(BY_FIELD_NAME, results.s_ByFieldName, *docPtr);
+    writeStringField(BY_FIELD_NAME, results.s_ByFieldName, m_RecordWriter);
     if (!results.s_OverFieldName.empty()) {
-        m_Writer.addStringFieldCopyToObj(OVER_FIELD_NAME, results.s_OverFieldName, *docPtr);
+        writeStringField(OVER_FIELD_NAME, results.s_OverFieldName, m_RecordWriter);
         // If name is present then force output of value too, even when empty
-        m_Writer.addStringFieldCopyToObj(OVER_FIELD_VALUE,
-                                         results.s_OverFieldValue, *docPtr, true);
+        writeStringField(OVER_FIELD_VALUE, results.s_OverFieldValue, m_RecordWriter, true);
     }
     if (!results.s_PartitionFieldName.empty()) {
-        m_Writer.addStringFieldCopyToObj(PARTITION_FIELD_NAME,
-                                         results.s_PartitionFieldName, *docPtr);
+        writeStringField(PARTITION_FIELD_NAME, results.s_PartitionFieldName, m_RecordWriter);
         // If name is present then force output of value too, even when empty
-        m_Writer.addStringFieldCopyToObj(
-            PARTITION_FIELD_VALUE, results.s_PartitionFieldValue, *docPtr, true);
+        writeStringField(PARTITION_FIELD_VALUE, results.s_PartitionFieldValue,
+                         m_RecordWriter, true);
     }
-    m_Writer.addStringFieldCopyToObj(FUNCTION, results.s_FunctionName, *docPtr);
-    m_Writer.addStringFieldCopyToObj(FUNCTION_DESCRIPTION,
-                                     results.s_FunctionDescription, *docPtr);
+    writeStringField(FUNCTION, results.s_FunctionName, m_RecordWriter);
+    writeStringField(FUNCTION_DESCRIPTION, results.s_FunctionDescription, m_RecordWriter);
 
     // Add nested causes
-    if (m_NestedDocs.size() > 0) {
-        rapidjson::Value causeArray = m_Writer.makeArray(m_NestedDocs.size());
-        for (std::size_t index = 0; index < m_NestedDocs.size(); ++index) {
-            TDocumentWeakPtr nwDocPtr = m_NestedDocs[index];
-            TDocumentPtr nDocPtr = nwDocPtr.lock();
-            if (!nDocPtr) {
-                LOG_ERROR(<< "Inconsistent program state. JSON document unavailable.");
-                continue;
-            }
-            rapidjson::Value& docAsValue = *nDocPtr;
-
-            m_Writer.pushBack(docAsValue, causeArray);
-        }
-        m_Writer.addMember(CAUSES, causeArray, *docPtr);
-
-        m_NestedDocs.clear();
+    if (m_CausesJson.empty() == false) {
+        m_CausesJson.push_back(']');
+        m_RecordWriter.Key(CAUSES);
+        m_RecordWriter.RawValue(m_CausesJson.data(), m_CausesJson.size(),
+                                rapidjson::kArrayType);
+        m_CausesJson.clear();
     } else {
         LOG_WARN(<< "Expected some causes for a population anomaly but got none");
     }
 }
 
-void CJsonOutputWriter::addPopulationCauseFields(const CHierarchicalResultsWriter::TResults& results,
-                                                 TDocumentWeakPtr weakDoc) {
-    TDocumentPtr docPtr = weakDoc.lock();
-    if (!docPtr) {
-        LOG_ERROR(<< "Inconsistent program state. JSON document unavailable.");
-        return;
-    }
-
+void CJsonOutputWriter::writePopulationCauseFields(const CHierarchicalResultsWriter::TResults& results) {
     // probability, fieldName, byFieldName, byFieldValue,
     // overFieldName, overFieldValue, partitionFieldName, partitionFieldValue,
     // function, typical, actual, influences
-    m_Writer.addDoubleFieldToObj(PROBABILITY, results.s_Probability, *docPtr);
-    m_Writer.addStringFieldCopyToObj(FIELD_NAME, results.s_MetricValueField, *docPtr);
+    writeDoubleField(PROBABILITY, results.s_Probability, m_RecordWriter);
+    writeStringField(FIELD_NAME, results.s_MetricValueField, m_RecordWriter);
     if (!results.s_ByFieldName.empty()) {
-        m_Writer.addStringFieldCopyToObj(BY_FIELD_NAME, results.s_ByFieldName, *docPtr);
+        writeStringField(BY_FIELD_NAME, results.s_ByFieldName, m_RecordWriter);
         // If name is present then force output of value too, even when empty
-        m_Writer.addStringFieldCopyToObj(BY_FIELD_VALUE, results.s_ByFieldValue,
-                                         *docPtr, true);
+        writeStringField(BY_FIELD_VALUE, results.s_ByFieldValue, m_RecordWriter, true);
         // But allow correlatedByFieldValue to be unset if blank
-        m_Writer.addStringFieldCopyToObj(CORRELATED_BY_FIELD_VALUE,
-                                         results.s_CorrelatedByFieldValue, *docPtr);
+        writeStringField(CORRELATED_BY_FIELD_VALUE,
+                         results.s_CorrelatedByFieldValue, m_RecordWriter);
     }
     if (!results.s_OverFieldName.empty()) {
-        m_Writer.addStringFieldCopyToObj(OVER_FIELD_NAME, results.s_OverFieldName, *docPtr);
+        writeStringField(OVER_FIELD_NAME, results.s_OverFieldName, m_RecordWriter);
         // If name is present then force output of value too, even when empty
-        m_Writer.addStringFieldCopyToObj(OVER_FIELD_VALUE,
-                                         results.s_OverFieldValue, *docPtr, true);
+        writeStringField(OVER_FIELD_VALUE, results.s_OverFieldValue, m_RecordWriter, true);
     }
     if (!results.s_PartitionFieldName.empty()) {
-        m_Writer.addStringFieldCopyToObj(PARTITION_FIELD_NAME,
-                                         results.s_PartitionFieldName, *docPtr);
+        writeStringField(PARTITION_FIELD_NAME, results.s_PartitionFieldName, m_RecordWriter);
         // If name is present then force output of value too, even when empty
-        m_Writer.addStringFieldCopyToObj(
-            PARTITION_FIELD_VALUE, results.s_PartitionFieldValue, *docPtr, true);
-    }
-    m_Writer.addStringFieldCopyToObj(FUNCTION, results.s_FunctionName, *docPtr);
-    m_Writer.addStringFieldCopyToObj(FUNCTION_DESCRIPTION,
-                                     results.s_FunctionDescription, *docPtr);
-    m_Writer.addDoubleArrayFieldToObj(TYPICAL, results.s_PopulationAverage, *docPtr);
-    m_Writer.addDoubleArrayFieldToObj(ACTUAL, results.s_FunctionValue, *docPtr);
+        writeStringField(PARTITION_FIELD_VALUE, results.s_PartitionFieldValue,
+                         m_RecordWriter, true);
+    }
+    writeStringField(FUNCTION, results.s_FunctionName, m_RecordWriter);
+    writeStringField(FUNCTION_DESCRIPTION, results.s_FunctionDescription, m_RecordWriter);
+    writeDoubleArrayField(TYPICAL, results.s_PopulationAverage, m_RecordWriter);
+    writeDoubleArrayField(ACTUAL, results.s_FunctionValue, m_RecordWriter);
     if (results.s_FunctionName ==
         CAnomalyJobConfig::CAnalysisConfig::CDetectorConfig::FUNCTION_LAT_LONG) {
-        rapidjson::Value geoResults = m_Writer.makeObject();
-        auto geoPointToString = [](const auto& point) -> std::string {
-            std::ostringstream result;
-            // We don't want scientific notation and geo points only have precision up to 12 digits
-            result << std::fixed << std::setprecision(12) << point[0] << "," << point[1];
-            return result.str();
-        };
-        if (results.s_BaselineMean.size() == 2) {
-            m_Writer.addStringFieldCopyToObj(
-                TYPICAL_POINT, geoPointToString(results.s_PopulationAverage), geoResults);
-        }
-        if (results.s_FunctionValue.size() == 2) {
-            m_Writer.addStringFieldCopyToObj(
-                ACTUAL_POINT, geoPointToString(results.s_FunctionValue), geoResults);
-        }
-        m_Writer.addMember(GEO_RESULTS, geoResults, *docPtr);
+        writeGeoResultsField(results.s_PopulationAverage, results.s_FunctionValue,
+                             results.s_BaselineMean.size() == 2,
+                             results.s_FunctionValue.size() == 2, m_RecordWriter);
     }
 }
 
-void CJsonOutputWriter::addInfluences(const CHierarchicalResultsWriter::TStoredStringPtrStoredStringPtrPrDoublePrVec& influenceResults,
-                                      TDocumentWeakPtr weakDoc) {
+void CJsonOutputWriter::writeInfluences(const CHierarchicalResultsWriter::TStoredStringPtrStoredStringPtrPrDoublePrVec& influenceResults) {
     if (influenceResults.empty()) {
         return;
     }
 
-    TDocumentPtr docPtr = weakDoc.lock();
-    if (!docPtr) {
-        LOG_ERROR(<< "Inconsistent program state. JSON document unavailable.");
-        return;
-    }
-
     //! This function takes the raw c_str pointers of the string objects in
-    //! influenceResults. These strings must exist up to the time the results
-    //! are written
+    //! influenceResults. These strings must exist until the influences have
+    //! been written
 
     using TCharPtrDoublePr = std::pair<const char*, double>;
     using TCharPtrDoublePrVec = std::vector<TCharPtrDoublePr>;
-    using TCharPtrDoublePrVecIter = TCharPtrDoublePrVec::iterator;
     using TCharPtrCharPtrDoublePrVecPr = std::pair<const char*, TCharPtrDoublePrVec>;
     using TStrCharPtrCharPtrDoublePrVecPrUMap =
         boost::unordered_map<std::string, TCharPtrCharPtrDoublePrVecPr>;
-    using TStrCharPtrCharPtrDoublePrVecPrUMapIter = TStrCharPtrCharPtrDoublePrVecPrUMap::iterator;
 
     TStrCharPtrCharPtrDoublePrVecPrUMap influences;
 
@@ -704,70 +742,56 @@ void CJsonOutputWriter::addInfluences(const CHierarchicalResultsWriter::TStoredS
     }
 
     // Order by influence
-    for (TStrCharPtrCharPtrDoublePrVecPrUMapIter iter = influences.begin();
-         iter != influences.end(); ++iter) {
-        std::sort(iter->second.second.begin(), iter->second.second.end(), INFLUENCE_LESS);
+    for (auto& influence : influences) {
+        std::sort(influence.second.second.begin(),
+                  influence.second.second.end(), INFLUENCE_LESS);
     }
 
-    rapidjson::Value influencesDoc = m_Writer.makeArray(influences.size());
-
-    for (TStrCharPtrCharPtrDoublePrVecPrUMapIter iter = influences.begin();
-         iter != influences.end(); ++iter) {
-        rapidjson::Value influenceDoc(rapidjson::kObjectType);
-
-        rapidjson::Value values = m_Writer.makeArray(influences.size());
-        for (TCharPtrDoublePrVecIter arrayIter = iter->second.second.begin();
-             arrayIter != iter->second.second.end(); ++arrayIter) {
-            m_Writer.pushBack(arrayIter->first, values);
+    // Note influences are written using the field name "influencers"
+    m_RecordWriter.Key(INFLUENCERS);
+    m_RecordWriter.StartArray();
+    for (const auto& influence : influences) {
+        m_RecordWriter.StartObject();
+        m_RecordWriter.Key(INFLUENCER_FIELD_NAME);
+        m_RecordWriter.String(influence.second.first);
+        m_RecordWriter.Key(INFLUENCER_FIELD_VALUES);
+        m_RecordWriter.StartArray();
+        for (const auto& value : influence.second.second) {
+            m_RecordWriter.String(value.first);
         }
-
-        m_Writer.addMember(INFLUENCER_FIELD_NAME, iter->second.first, influenceDoc);
-        m_Writer.addMember(INFLUENCER_FIELD_VALUES, values, influenceDoc);
-        m_Writer.pushBack(influenceDoc, influencesDoc);
+        m_RecordWriter.EndArray();
+        m_RecordWriter.EndObject();
     }
-
-    // Note influences are written using the field name "influencers"
-    m_Writer.addMember(INFLUENCERS, influencesDoc, *docPtr);
+    m_RecordWriter.EndArray();
 }
 
-void CJsonOutputWriter::addEventRateFields(const CHierarchicalResultsWriter::TResults& results,
-                                           TDocumentWeakPtr weakDoc) {
-    TDocumentPtr docPtr = weakDoc.lock();
-    if (!docPtr) {
-        LOG_ERROR(<< "Inconsistent program state. JSON document unavailable.");
-        return;
-    }
-
+void CJsonOutputWriter::writeEventRateFields(const CHierarchicalResultsWriter::TResults& results) {
     // record_score, probability, fieldName, byFieldName, byFieldValue, partitionFieldName,
     // partitionFieldValue, functionName, typical, actual, influences?
 
-    m_Writer.addDoubleFieldToObj(INITIAL_RECORD_SCORE,
-                                 results.s_NormalizedAnomalyScore, *docPtr);
-    m_Writer.addDoubleFieldToObj(RECORD_SCORE, results.s_NormalizedAnomalyScore, *docPtr);
-    m_Writer.addDoubleFieldToObj(PROBABILITY, results.s_Probability, *docPtr);
-    m_Writer.addDoubleFieldToObj(MULTI_BUCKET_IMPACT, results.s_MultiBucketImpact, *docPtr);
-    m_Writer.addStringFieldCopyToObj(FIELD_NAME, results.s_MetricValueField, *docPtr);
+    writeDoubleField(INITIAL_RECORD_SCORE, results.s_NormalizedAnomalyScore, m_RecordWriter);
+    writeDoubleField(RECORD_SCORE, results.s_NormalizedAnomalyScore, m_RecordWriter);
+    writeDoubleField(PROBABILITY, results.s_Probability, m_RecordWriter);
+    writeDoubleField(MULTI_BUCKET_IMPACT, results.s_MultiBucketImpact, m_RecordWriter);
+    writeStringField(FIELD_NAME, results.s_MetricValueField, m_RecordWriter);
     if (!results.s_ByFieldName.empty()) {
-        m_Writer.addStringFieldCopyToObj(BY_FIELD_NAME, results.s_ByFieldName, *docPtr);
+        writeStringField(BY_FIELD_NAME, results.s_ByFieldName, m_RecordWriter);
         // If name is present then force output of value too, even when empty
-        m_Writer.addStringFieldCopyToObj(BY_FIELD_VALUE, results.s_ByFieldValue,
-                                         *docPtr, true);
+        writeStringField(BY_FIELD_VALUE, results.s_ByFieldValue, m_RecordWriter, true);
         // But allow correlatedByFieldValue to be unset if blank
-        m_Writer.addStringFieldCopyToObj(CORRELATED_BY_FIELD_VALUE,
-                                         results.s_CorrelatedByFieldValue, *docPtr);
+        writeStringField(CORRELATED_BY_FIELD_VALUE,
+                         results.s_CorrelatedByFieldValue, m_RecordWriter);
     }
     if (!results.s_PartitionFieldName.empty()) {
-        m_Writer.addStringFieldCopyToObj(PARTITION_FIELD_NAME,
-                                         results.s_PartitionFieldName, *docPtr);
+        writeStringField(PARTITION_FIELD_NAME, results.s_PartitionFieldName, m_RecordWriter);
         // If name is present then force output of value too, even when empty
-        m_Writer.addStringFieldCopyToObj(
-            PARTITION_FIELD_VALUE, results.s_PartitionFieldValue, *docPtr, true);
-    }
-    m_Writer.addStringFieldCopyToObj(FUNCTION, results.s_FunctionName, *docPtr);
-    m_Writer.addStringFieldCopyToObj(FUNCTION_DESCRIPTION,
-                                     results.s_FunctionDescription, *docPtr);
-    m_Writer.addDoubleArrayFieldToObj(TYPICAL, results.s_BaselineMean, *docPtr);
-    m_Writer.addDoubleArrayFieldToObj(ACTUAL, results.s_CurrentMean, *docPtr);
+        writeStringField(PARTITION_FIELD_VALUE, results.s_PartitionFieldValue,
+                         m_RecordWriter, true);
+    }
+    writeStringField(FUNCTION, results.s_FunctionName, m_RecordWriter);
+    writeStringField(FUNCTION_DESCRIPTION, results.s_FunctionDescription, m_RecordWriter);
+    writeDoubleArrayField(TYPICAL, results.s_BaselineMean, m_RecordWriter);
+    writeDoubleArrayField(ACTUAL, results.s_CurrentMean, m_RecordWriter);
 }
 
 void CJsonOutputWriter::addInfluencerFields(bool isBucketInfluencer,
@@ -240,9 +240,27 @@ bool CPersistenceManager::startPersistIfAppropriate() {
         }
     }
 
+    if (m_IsPersistDeferred) {
+        m_IsPersistDue = true;
+        return false;
+    }
+
     return this->startPersist(now);
 }
 
+void CPersistenceManager::deferPersistence() {
+    m_IsPersistDeferred = true;
+}
+
+bool CPersistenceManager::resumePersistence() {
+    m_IsPersistDeferred = false;
+    if (m_IsPersistDue == false) {
+        return false;
+    }
+    m_IsPersistDue = false;
+    return this->startPersist(core::CTimeUtils::now());
+}
+
 bool CPersistenceManager::startPersist(core_t::TTime timeOfPersistence) {
     if (this->isBusy()) {
         LOG_WARN(<< "Cannot start persist as a previous "
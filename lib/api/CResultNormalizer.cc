@@ -11,13 +11,38 @@
 #include <api/CResultNormalizer.h>
 
 #include <core/CStringUtils.h>
+#include <core/Concurrency.h>
 
 #include <maths/common/CTools.h>
 
+#include <algorithm>
+#include <array>
 #include <fstream>
+#include <limits>
 
 namespace ml {
 namespace api {
+namespace {
+//! The number of positional records to normalize in each batch.
+const std::size_t RECORD_BATCH_SIZE{4096};
+//! The position of a field which is missing from the records.
+const std::size_t MISSING_FIELD{std::numeric_limits<std::size_t>::max()};
+
+//! Get the names of the fields needed to normalize a record in the order
+//! they're passed to normalizedScore.
+const CResultNormalizer::TStrVec& requiredFieldNames() {
+    static const CResultNormalizer::TStrVec FIELD_NAMES{
+        CResultNormalizer::LEVEL,
+        CResultNormalizer::PARTITION_FIELD_NAME,
+        CResultNormalizer::PARTITION_FIELD_VALUE,
+        CResultNormalizer::PERSON_FIELD_NAME,
+        CResultNormalizer::PERSON_FIELD_VALUE,
+        CResultNormalizer::FUNCTION_NAME,
+        CResultNormalizer::VALUE_FIELD_NAME,
+        CResultNormalizer::PROBABILITY_NAME};
+    return FIELD_NAMES;
+}
+}
 
 // Initialise statics
 const std::string CResultNormalizer::LEVEL("level");
@@ -41,7 +66,7 @@ CResultNormalizer::CResultNormalizer(const model::CAnomalyDetectorModelConfig& m
     : m_ModelConfig(modelConfig), m_OutputWriter(outputWriter),
       m_WriteFieldNames(true),
       m_OutputFieldNormalizedScore(m_OutputFields[NORMALIZED_SCORE_NAME]),
-      m_Normalizer(m_ModelConfig) {
+      m_Normalizer(m_ModelConfig), m_NumberRecords(0), m_NumberBufferedRecords(0) {
 }
 
 bool CResultNormalizer::initNormalizer(const std::string& stateFileName) {
@@ -97,45 +122,15 @@ bool CResultNormalizer::handleRecord(const TStrStrUMap& dataRowFields) {
               << valueFieldName << "', probability='" << probability << "'");
 
     if (isNormalizable) {
-        const model::CAnomalyScore::CNormalizer* levelNormalizer = nullptr;
-        double score = probability > m_ModelConfig.maximumAnomalousProbability()
-                           ? 0.0
-                           : maths::common::CTools::anomalyScore(probability);
-        if (level == ROOT_LEVEL) {
-            levelNormalizer = &m_Normalizer.bucketNormalizer();
-        } else if (level == LEAF_LEVEL) {
-            levelNormalizer = m_Normalizer.leafNormalizer(
-                partitionName, personName, function, valueFieldName);
-        } else if (level == PARTITION_LEVEL) {
-            levelNormalizer = m_Normalizer.partitionNormalizer(partitionName);
-        } else if (level == BUCKET_INFLUENCER_LEVEL) {
-            levelNormalizer = m_Normalizer.influencerBucketNormalizer(personName);
-        } else if (level == INFLUENCER_LEVEL) {
-            levelNormalizer = m_Normalizer.influencerNormalizer(personName);
-        } else {
-            LOG_ERROR(<< "Unexpected   : " << level);
-        }
-        if (levelNormalizer != nullptr) {
-            if (levelNormalizer->canNormalize()) {
-                model::CAnomalyScore::CNormalizer::CMaximumScoreScope scope{
-                    partitionName, partitionValue, personName, personValue};
-                if (levelNormalizer->normalize(scope, score) == false) {
-                    LOG_ERROR(<< "Failed to normalize score " << score << " at level \""
-                              << level << "\" using scope " << scope.print());
-                }
-            }
-        } else {
-            LOG_ERROR(<< "No normalizer available at level '" << level
-                      << "' with partition field name '" << partitionName
-                      << "' and person field name '" << personName << "'");
-        }
-
         m_OutputFieldNormalizedScore =
-            (score > 0.0) ? core::CStringUtils::typeToStringPretty(score) : ZERO;
+            this->normalizedScore(level, partitionName, partitionValue, personName,
+                                  personValue, function, valueFieldName, probability);
     } else {
         m_OutputFieldNormalizedScore.clear();
     }
 
+    ++m_NumberRecords;
+
     if (m_OutputWriter.writeRow(dataRowFields, m_OutputFields) == false) {
         LOG_ERROR(<< "Unable to write normalized output");
         return false;
@@ -144,6 +139,135 @@ bool CResultNormalizer::handleRecord(const TStrStrUMap& dataRowFields) {
     return true;
 }
 
+bool CResultNormalizer::handlePositionalRecord(const TStrVec& fieldNames,
+                                               const TStrVec& fieldValues) {
+    if (m_WriteFieldNames) {
+        if (m_OutputWriter.fieldNames(fieldNames, TStrVec{NORMALIZED_SCORE_NAME}) == false) {
+            LOG_ERROR(<< "Unable to set field names for output");
+            return false;
+        }
+        m_WriteFieldNames = false;
+
+        m_FieldPositions.clear();
+        for (const auto& name : requiredFieldNames()) {
+            auto position = std::find(fieldNames.begin(), fieldNames.end(), name);
+            m_FieldPositions.push_back(
+                position == fieldNames.end()
+                    ? MISSING_FIELD
+                    : static_cast<std::size_t>(position - fieldNames.begin()));
+        }
+        m_RowFieldValues.clear();
+        for (const auto& name : fieldNames) {
+            m_RowFieldValues.push_back(&m_RowFields[name]);
+        }
+    }
+
+    if (m_NumberBufferedRecords == m_BufferedRecords.size()) {
+        m_BufferedRecords.emplace_back();
+    }
+    m_BufferedRecords[m_NumberBufferedRecords++] = fieldValues;
+    ++m_NumberRecords;
+
+    return m_NumberBufferedRecords < RECORD_BATCH_SIZE || this->flushPositionalRecords();
+}
+
+bool CResultNormalizer::flushPositionalRecords() {
+    m_BufferedScores.resize(m_NumberBufferedRecords);
+    core::parallel_for_each(0, m_NumberBufferedRecords, [this](std::size_t i) {
+        m_BufferedScores[i] = this->normalizedScore(m_BufferedRecords[i]);
+    });
+
+    std::size_t numberRecords{m_NumberBufferedRecords};
+    m_NumberBufferedRecords = 0;
+
+    for (std::size_t i = 0; i < numberRecords; ++i) {
+        const TStrVec& fieldValues{m_BufferedRecords[i]};
+        for (std::size_t j = 0; j < m_RowFieldValues.size(); ++j) {
+            if (j < fieldValues.size()) {
+                *m_RowFieldValues[j] = fieldValues[j];
+            } else {
+                m_RowFieldValues[j]->clear();
+            }
+        }
+        m_OutputFieldNormalizedScore.swap(m_BufferedScores[i]);
+        if (m_OutputWriter.writeRow(m_RowFields, m_OutputFields) == false) {
+            LOG_ERROR(<< "Unable to write normalized output");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::size_t CResultNormalizer::numberRecords() const {
+    return m_NumberRecords;
+}
+
+std::string CResultNormalizer::normalizedScore(const std::string& level,
+                                               const std::string& partitionName,
+                                               const std::string& partitionValue,
+                                               const std::string& personName,
+                                               const std::string& personValue,
+                                               const std::string& function,
+                                               const std::string& valueFieldName,
+                                               double probability) const {
+    const model::CAnomalyScore::CNormalizer* levelNormalizer = nullptr;
+    double score = probability > m_ModelConfig.maximumAnomalousProbability()
+                       ? 0.0
+                       : maths::common::CTools::anomalyScore(probability);
+    if (level == ROOT_LEVEL) {
+        levelNormalizer = &m_Normalizer.bucketNormalizer();
+    } else if (level == LEAF_LEVEL) {
+        levelNormalizer = m_Normalizer.leafNormalizer(partitionName, personName,
+                                                      function, valueFieldName);
+    } else if (level == PARTITION_LEVEL) {
+        levelNormalizer = m_Normalizer.partitionNormalizer(partitionName);
+    } else if (level == BUCKET_INFLUENCER_LEVEL) {
+        levelNormalizer = m_Normalizer.influencerBucketNormalizer(personName);
+    } else if (level == INFLUENCER_LEVEL) {
+        levelNormalizer = m_Normalizer.influencerNormalizer(personName);
+    } else {
+        LOG_ERROR(<< "Unexpected   : " << level);
+    }
+    if (levelNormalizer != nullptr) {
+        if (levelNormalizer->canNormalize()) {
+            model::CAnomalyScore::CNormalizer::CMaximumScoreScope scope{
+                partitionName, partitionValue, personName, personValue};
+            if (levelNormalizer->normalize(scope, score) == false) {
+                LOG_ERROR(<< "Failed to normalize score " << score << " at level \""
+                          << level << "\" using scope " << scope.print());
+            }
+        }
+    } else {
+        LOG_ERROR(<< "No normalizer available at level '" << level
+                  << "' with partition field name '" << partitionName
+                  << "' and person field name '" << personName << "'");
+    }
+
+    return (score > 0.0) ? core::CStringUtils::typeToStringPretty(score) : ZERO;
+}
+
+std::string CResultNormalizer::normalizedScore(const TStrVec& fieldValues) const {
+    // These are in the order of requiredFieldNames.
+    std::array<const std::string*, 8> fields;
+    for (std::size_t i = 0; i < m_FieldPositions.size(); ++i) {
+        if (m_FieldPositions[i] >= fieldValues.size()) {
+            LOG_ERROR(<< "Cannot interpret " << requiredFieldNames()[i]
+                      << " field in record: " << core::CStringUtils::join(fieldValues, ","));
+            return std::string{};
+        }
+        fields[i] = &fieldValues[m_FieldPositions[i]];
+    }
+    double probability;
+    if (core::CStringUtils::stringToType(*fields.back(), probability) == false) {
+        LOG_ERROR(<< "Cannot interpret " << PROBABILITY_NAME
+                  << " field in record: " << core::CStringUtils::join(fieldValues, ","));
+        return std::string{};
+    }
+    return this->normalizedScore(*fields[0], *fields[1], *fields[2], *fields[3],
+                                 *fields[4], *fields[5], *fields[6], probability);
+}
+
 bool CResultNormalizer::parseDataFields(const TStrStrUMap& dataRowFields,
                                         std::string& level,
                                         std::string& partitionName,
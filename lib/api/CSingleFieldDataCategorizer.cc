@@ -60,45 +60,73 @@ CGlobalCategoryId CSingleFieldDataCategorizer::computeAndUpdateCategory(
     const std::string& rawMessage,
     model::CResourceMonitor& resourceMonitor,
     CJsonOutputWriter& jsonOutputWriter) {
-    model::CLocalCategoryId localCategoryId{m_DataCategorizer->computeCategory(
-        isDryRun, fields, messageToCategorize, rawMessage.length())};
-    CGlobalCategoryId globalCategoryId{m_CategoryIdMapper->map(localCategoryId)};
-    if (globalCategoryId.isValid() == false) {
-        return globalCategoryId;
+    SLocalCategorization categorization{this->computeLocalCategory(
+        isDryRun, fields, messageToCategorize, rawMessage)};
+    CGlobalCategoryId globalCategoryId{
+        this->mapCategory(categorization.s_LocalCategoryId, messageTime)};
+    if (globalCategoryId.isValid() && categorization.s_Changed) {
+        this->writeCategoryIfChanged(categorization.s_LocalCategoryId,
+                                     resourceMonitor, jsonOutputWriter);
     }
+    return globalCategoryId;
+}
 
-    if (messageTime.has_value()) {
-        m_LastMessageTime = messageTime;
+CSingleFieldDataCategorizer::SLocalCategorization
+CSingleFieldDataCategorizer::computeLocalCategory(bool isDryRun,
+                                                  const model::CDataCategorizer::TStrStrUMap& fields,
+                                                  const std::string& messageToCategorize,
+                                                  const std::string& rawMessage) {
+    SLocalCategorization categorization;
+    categorization.s_LocalCategoryId = m_DataCategorizer->computeCategory(
+        isDryRun, fields, messageToCategorize, rawMessage.length());
+    if (categorization.s_LocalCategoryId.isValid() == false) {
+        return categorization;
     }
-    bool exampleAdded{m_DataCategorizer->addExample(localCategoryId, rawMessage)};
-    bool searchTermsChanged{m_DataCategorizer->cacheReverseSearch(localCategoryId)};
-    if (exampleAdded || searchTermsChanged) {
-        // In this case we are certain that there will have been a change, as
-        // the count of the chosen category will have been incremented
-        m_DataCategorizer->writeCategoryIfChanged(
-            localCategoryId,
-            [this, &jsonOutputWriter](
-                model::CLocalCategoryId localCategoryId_, const std::string& terms,
-                const std::string& regex, std::size_t maxMatchingFieldLength,
-                const model::CCategoryExamplesCollector::TStrFSet& examples, std::size_t numMatches,
-                const model::CDataCategorizer::TLocalCategoryIdVec& usurpedCategories) {
-                jsonOutputWriter.writeCategoryDefinition(
-                    m_PartitionFieldName, m_CategoryIdMapper->categorizerKey(),
-                    m_CategoryIdMapper->map(localCategoryId_), terms, regex,
-                    maxMatchingFieldLength, examples, numMatches,
-                    m_CategoryIdMapper->mapVec(usurpedCategories));
-            });
-        if (localCategoryId.id() % 10 == 0) {
-            // Even if memory limiting is disabled, force a refresh occasionally
-            // so the user has some idea what's going on with memory.
-            resourceMonitor.forceRefresh(*m_DataCategorizer);
-        } else {
-            resourceMonitor.refresh(*m_DataCategorizer);
-        }
+
+    bool exampleAdded{m_DataCategorizer->addExample(categorization.s_LocalCategoryId, rawMessage)};
+    bool searchTermsChanged{
+        m_DataCategorizer->cacheReverseSearch(categorization.s_LocalCategoryId)};
+    // In this case we are certain that there will have been a change, as the
+    // count of the chosen category will have been incremented
+    categorization.s_Changed = exampleAdded || searchTermsChanged;
+    return categorization;
+}
+
+CGlobalCategoryId
+CSingleFieldDataCategorizer::mapCategory(model::CLocalCategoryId localCategoryId,
+                                         const TOptionalTime& messageTime) {
+    CGlobalCategoryId globalCategoryId{m_CategoryIdMapper->map(localCategoryId)};
+    if (globalCategoryId.isValid() && messageTime.has_value()) {
+        m_LastMessageTime = messageTime;
     }
     return globalCategoryId;
 }
 
+void CSingleFieldDataCategorizer::writeCategoryIfChanged(model::CLocalCategoryId localCategoryId,
+                                                         model::CResourceMonitor& resourceMonitor,
+                                                         CJsonOutputWriter& jsonOutputWriter) {
+    m_DataCategorizer->writeCategoryIfChanged(
+        localCategoryId,
+        [this, &jsonOutputWriter](
+            model::CLocalCategoryId localCategoryId_, const std::string& terms,
+            const std::string& regex, std::size_t maxMatchingFieldLength,
+            const model::CCategoryExamplesCollector::TStrFSet& examples, std::size_t numMatches,
+            const model::CDataCategorizer::TLocalCategoryIdVec& usurpedCategories) {
+            jsonOutputWriter.writeCategoryDefinition(
+                m_PartitionFieldName, m_CategoryIdMapper->categorizerKey(),
+                m_CategoryIdMapper->map(localCategoryId_), terms, regex,
+                maxMatchingFieldLength, examples, numMatches,
+                m_CategoryIdMapper->mapVec(usurpedCategories));
+        });
+    if (localCategoryId.id() % 10 == 0) {
+        // Even if memory limiting is disabled, force a refresh occasionally
+        // so the user has some idea what's going on with memory.
+        resourceMonitor.forceRefresh(*m_DataCategorizer);
+    } else {
+        resourceMonitor.refresh(*m_DataCategorizer);
+    }
+}
+
 CSingleFieldDataCategorizer::TPersistFunc
 CSingleFieldDataCategorizer::makeForegroundPersistFunc() const {
     model::CDataCategorizer::TPersistFunc categorizerPersistFunc{
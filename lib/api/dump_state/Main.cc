@@ -144,7 +144,7 @@ bool persistCategorizerStateToFile(const std::string& outputFileName,
 
     ml::api::CFieldDataCategorizer categorizer{
         "job",   jobConfig.analysisConfig(), limits,  "time", timeFormat,
-        nullptr, wrappedOutStream,           nullptr, false};
+        nullptr, wrappedOutStream,           nullptr, false,      1};
 
     ml::api::CFieldDataCategorizer::TStrStrUMap dataRowFields;
     dataRowFields["_raw"] = "thing";
@@ -202,7 +202,7 @@ bool persistAnomalyDetectorStateToFile(const std::string& configFileName,
 
     ml::api::CAnomalyJob origJob(jobId, limits, jobConfig, modelConfig, wrappedOutputStream,
                                  std::bind(&reportPersistComplete, std::placeholders::_1),
-                                 nullptr, -1, "time", timeFormat, 0);
+                                 nullptr, -1, "time", timeFormat, 0, false, false, 1);
 
     using TInputParserUPtr = std::unique_ptr<ml::api::CInputParser>;
     const TInputParserUPtr parser{[&inputFilename, &inputStrm]() -> TInputParserUPtr {
@@ -14,6 +14,7 @@
 #include <core/CDataSearcher.h>
 #include <core/CJsonOutputStreamWrapper.h>
 #include <core/CStringUtils.h>
+#include <core/Concurrency.h>
 
 #include <model/CLimits.h>
 
@@ -28,6 +29,7 @@
 #include <set>
 #include <sstream>
 #include <tuple>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(CFieldDataCategorizerTest)
 
@@ -53,6 +55,7 @@ public:
 class CTestChainedProcessor : public CDataProcessor {
 public:
     using TIntSet = std::set<int>;
+    using TIntVec = std::vector<int>;
 
 public:
     void finalise() override { m_Finalised = true; }
@@ -76,6 +79,7 @@ public:
             categoryId > 0) {
             m_CategoryIdsHandled.insert(categoryId);
         }
+        m_CategoryIdSequence.push_back(categoryId);
         ++m_NumRecordsHandled;
         return true;
     }
@@ -104,6 +108,8 @@ public:
 
     const TIntSet& categoryIdsHandled() const { return m_CategoryIdsHandled; }
 
+    const TIntVec& categoryIdSequence() const { return m_CategoryIdSequence; }
+
 private:
     bool m_Finalised = false;
 
@@ -111,6 +117,7 @@ private:
     std::uint64_t m_NumControlMessages = 0;
 
     TIntSet m_CategoryIdsHandled;
+    TIntVec m_CategoryIdSequence;
 };
 
 class CTestDataSearcher : public core::CDataSearcher {
@@ -427,6 +434,77 @@ BOOST_AUTO_TEST_CASE(testWithPerPartitionCategorization) {
     BOOST_REQUIRE_EQUAL(origJson, newJson);
 }
 
+BOOST_AUTO_TEST_CASE(testMultiThreadedPerPartitionCategorization) {
+
+    // Categorizing on several threads must assign the same global category
+    // IDs, pass records on in the same order and end up in the same state as
+    // categorizing on one thread.
+
+    CAnomalyJobConfig config;
+    BOOST_TEST_REQUIRE(config.initFromFile("testfiles/new_persist_per_partition_categorization.json"));
+
+    const std::string partitions[]{"elasticsearch", "kibana", "logstash", "beats", "apm"};
+    const std::string templates[]{"Node {} started on port {}",
+                                  "Failed to connect to {} after {} attempts",
+                                  "User {} logged in from host {}",
+                                  "Shard {} of index {} relocated",
+                                  "GC pause of {}ms on thread {}"};
+
+    auto categorize = [&](std::size_t numberThreads, CTestChainedProcessor& chainedProcessor) {
+        model::CLimits limits;
+        std::ostringstream outputStrm;
+        core::CJsonOutputStreamWrapper wrappedOutputStream{outputStrm};
+        CTestFieldDataCategorizer categorizer{"job",
+                                              config.analysisConfig(),
+                                              limits,
+                                              &chainedProcessor,
+                                              wrappedOutputStream,
+                                              nullptr,
+                                              false,
+                                              numberThreads};
+
+        CFieldDataCategorizer::TStrStrUMap dataRowFields;
+        categorizer.registerMutableField(CFieldDataCategorizer::MLCATEGORY_NAME,
+                                         dataRowFields[CFieldDataCategorizer::MLCATEGORY_NAME]);
+        for (std::size_t i = 0; i < 2500; ++i) {
+            std::string message{templates[(i * 7) % 5]};
+            for (std::size_t j = 0; j < 2; ++j) {
+                message.replace(message.find("{}"), 2,
+                                core::CStringUtils::typeToString((i * 31 + j) % 17));
+            }
+            dataRowFields["message"] = message;
+            dataRowFields["event.dataset"] = partitions[(i * 3 + i / 11) % 5];
+            BOOST_TEST_REQUIRE(categorizer.handleRecord(dataRowFields));
+            if (i == 1234) {
+                CFieldDataCategorizer::TStrStrUMap flushFields{{".", "f7"}};
+                BOOST_TEST_REQUIRE(categorizer.handleRecord(flushFields));
+                BOOST_REQUIRE_EQUAL(i + 1, chainedProcessor.numRecordsHandled());
+            }
+        }
+        categorizer.finalise();
+        BOOST_REQUIRE_EQUAL(2500, categorizer.numRecordsHandled());
+
+        CTestDataAdder adder;
+        categorizer.persistStateInForeground(adder, "");
+        return dynamic_cast<std::ostringstream&>(*adder.getStream()).str();
+    };
+
+    CTestChainedProcessor serialChainedProcessor;
+    std::string serialState{categorize(1, serialChainedProcessor)};
+
+    core::startDefaultAsyncExecutor(3);
+    CTestChainedProcessor parallelChainedProcessor;
+    std::string parallelState{categorize(3, parallelChainedProcessor)};
+    core::stopDefaultAsyncExecutor();
+
+    BOOST_REQUIRE_EQUAL(2500, parallelChainedProcessor.numRecordsHandled());
+    BOOST_TEST_REQUIRE(serialChainedProcessor.categoryIdsHandled().size() > 5);
+    BOOST_REQUIRE_EQUAL(
+        core::CContainerPrinter::print(serialChainedProcessor.categoryIdSequence()),
+        core::CContainerPrinter::print(parallelChainedProcessor.categoryIdSequence()));
+    BOOST_REQUIRE_EQUAL(serialState, parallelState);
+}
+
 BOOST_AUTO_TEST_CASE(testNodeReverseSearch) {
     model::CLimits limits;
     CAnomalyJobConfig config;
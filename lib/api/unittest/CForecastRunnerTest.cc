@@ -9,8 +9,10 @@
  * limitation.
  */
 
+#include <core/CContainerPrinter.h>
 #include <core/CJsonOutputStreamWrapper.h>
 #include <core/CLogger.h>
+#include <core/Concurrency.h>
 #include <core/Constants.h>
 
 #include <model/CAnomalyDetectorModelConfig.h>
@@ -27,6 +29,7 @@
 #include <cmath>
 #include <memory>
 #include <string>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(CForecastRunnerTest)
 
@@ -60,6 +63,15 @@ void generatePopulationRecord(ml::core_t::TTime time, CTestAnomalyJob::TStrStrUM
     dataRows["person"] = "jill";
 }
 
+void generateRecordWithPerson(ml::core_t::TTime time, CTestAnomalyJob::TStrStrUMap& dataRows) {
+    double x = static_cast<double>(time - START_TIME) / BUCKET_LENGTH;
+    std::size_t person = static_cast<std::size_t>(time / (BUCKET_LENGTH / 2)) % 40;
+    double count = (std::sin(x / 4.0 + static_cast<double>(person)) + 1.0) * 42.0;
+    dataRows["time"] = ml::core::CStringUtils::typeToString(time);
+    dataRows["person"] = "person" + std::to_string(person);
+    dataRows["count"] = ml::core::CStringUtils::typeToString(count);
+}
+
 void populateJob(TGenerateRecord generateRecord, CTestAnomalyJob& job, std::size_t buckets = 1000) {
     ml::core_t::TTime time = START_TIME;
     CTestAnomalyJob::TStrStrUMap dataRows;
@@ -142,6 +154,67 @@ BOOST_AUTO_TEST_CASE(testSummaryCount) {
                         forecastStats["forecast_expiry_timestamp"].GetInt64());
 }
 
+BOOST_AUTO_TEST_CASE(testParallel) {
+    // Check that forecasting in parallel produces the same records in the same
+    // order as forecasting serially and that forecasts use their own threads
+    // whatever the default async executor is doing.
+
+    auto forecast = [](std::size_t forecastThreads) {
+        std::stringstream outputStrm;
+        {
+            ml::core::CJsonOutputStreamWrapper streamWrapper(outputStrm);
+            ml::model::CLimits limits;
+            ml::api::CAnomalyJobConfig jobConfig = CTestAnomalyJob::makeSimpleJobConfig(
+                "count", "", "person", "", "", {}, "count");
+
+            ml::model::CAnomalyDetectorModelConfig modelConfig =
+                ml::model::CAnomalyDetectorModelConfig::defaultConfig(BUCKET_LENGTH);
+
+            CTestAnomalyJob job("job", limits, jobConfig, modelConfig, streamWrapper,
+                                {}, nullptr, -1, "time", "", 0, false, false,
+                                forecastThreads);
+            populateJob(generateRecordWithPerson, job, 2000);
+
+            CTestAnomalyJob::TStrStrUMap dataRows;
+            dataRows["."] = "p{\"duration\":" + std::to_string(13 * BUCKET_LENGTH) +
+                            ",\"forecast_id\": \"42\"" +
+                            ",\"create_time\": \"1511370819\" }";
+            BOOST_TEST_REQUIRE(job.handleRecord(dataRows));
+        }
+
+        rapidjson::Document doc;
+        doc.Parse<rapidjson::kParseDefaultFlags>(outputStrm.str());
+        BOOST_TEST_REQUIRE(!doc.HasParseError());
+
+        std::vector<std::string> result;
+        for (const auto& m : doc.GetArray()) {
+            if (m.HasMember("model_forecast")) {
+                const rapidjson::Value& record = m["model_forecast"];
+                result.push_back(std::string(record["by_field_value"].GetString()) +
+                                 " " + std::to_string(record["timestamp"].GetInt64()) +
+                                 " " + std::to_string(record["forecast_prediction"].GetDouble()));
+            }
+        }
+        return result;
+    };
+
+    auto expected = forecast(1);
+    auto actual = forecast(3);
+
+    // Hold the default async executor busy, as another stage of the job would.
+    ml::core::startDefaultAsyncExecutor(2);
+    ml::core::defaultAsyncExecutor().busy(true);
+    auto actualWithDefaultBusy = forecast(3);
+    ml::core::defaultAsyncExecutor().busy(false);
+    ml::core::stopDefaultAsyncExecutor();
+
+    BOOST_REQUIRE_EQUAL(40 * 13, expected.size());
+    BOOST_REQUIRE_EQUAL(ml::core::CContainerPrinter::print(expected),
+                        ml::core::CContainerPrinter::print(actual));
+    BOOST_REQUIRE_EQUAL(ml::core::CContainerPrinter::print(expected),
+                        ml::core::CContainerPrinter::print(actualWithDefaultBusy));
+}
+
 BOOST_AUTO_TEST_CASE(testPopulation) {
     std::stringstream outputStrm;
     {
@@ -14,6 +14,7 @@
 #include <core/COsFileFuncs.h>
 #include <core/CScopedRapidJsonPoolAllocator.h>
 #include <core/CSmallVector.h>
+#include <core/CStopWatch.h>
 #include <core/CTimeUtils.h>
 
 #include <maths/common/CTools.h>
@@ -1903,4 +1904,142 @@ BOOST_AUTO_TEST_CASE(testThroughputWithoutScopedAllocator) {
     testThroughputHelper(false);
 }
 
+BOOST_AUTO_TEST_CASE(testRecordsThroughput) {
+    // Replay a recorded stream of results, with many records per bucket, each
+    // having influences, and population records having causes. This is the
+    // workload which dominates output for noisy jobs.
+
+    using TResults = ml::api::CHierarchicalResultsWriter::SResults;
+    using TResultsVec = std::vector<TResults>;
+
+    std::string partitionFieldName("tfn");
+    std::string partitionFieldValue("tfv");
+    std::string overFieldName("pfn");
+    std::string overFieldValue("pfv");
+    std::string byFieldName("airline");
+    std::string byFieldValue("GAL");
+    std::string correlatedByFieldValue("BAW");
+    std::string fieldName("responsetime");
+    std::string function("mean");
+    std::string functionDescription("mean(responsetime)");
+    ml::api::CHierarchicalResultsWriter::TStoredStringPtrStoredStringPtrPrDoublePrVec influences{
+        {{ml::model::CStringStore::influencers().get("host"),
+          ml::model::CStringStore::influencers().get("web-1")},
+         0.8},
+        {{ml::model::CStringStore::influencers().get("user"),
+          ml::model::CStringStore::influencers().get("alice")},
+         0.6},
+        {{ml::model::CStringStore::influencers().get("host"),
+          ml::model::CStringStore::influencers().get("web-2")},
+         0.9}};
+
+    auto makeStream = [&](ml::core_t::TTime time) {
+        TResultsVec stream;
+        stream.emplace_back(ml::api::CHierarchicalResultsWriter::E_SimpleCountResult,
+                            partitionFieldName, partitionFieldValue, byFieldName,
+                            byFieldValue, correlatedByFieldValue, time, function,
+                            functionDescription, 42.0, 79, TDouble1Vec(1, 6953.0),
+                            TDouble1Vec(1, 10090.0), 2.24, 0.5, 0.0, -5.0, fieldName,
+                            influences, false, false, 3, 100, EMPTY_STRING_LIST);
+        for (std::size_t i = 0; i < 50; ++i) {
+            double probability{0.001 * static_cast<double>(1 + (i * 7) % 50)};
+            if (i % 5 == 4) {
+                for (std::size_t j = 0; j < 2; ++j) {
+                    stream.emplace_back(
+                        false, false, partitionFieldName, partitionFieldValue,
+                        overFieldName, overFieldValue, byFieldName, byFieldValue,
+                        correlatedByFieldValue, time, function, functionDescription,
+                        TDouble1Vec(1, 10090.0), TDouble1Vec(1, 6953.0), 2.24,
+                        0.5, probability, 79, fieldName, influences, false, true,
+                        static_cast<int>(i % 3), 100);
+                }
+                stream.emplace_back(
+                    false, true, partitionFieldName, partitionFieldValue, overFieldName,
+                    overFieldValue, byFieldName, byFieldValue, correlatedByFieldValue,
+                    time, function, functionDescription, TDouble1Vec(1, 10090.0),
+                    TDouble1Vec(1, 6953.0), 2.24, 0.5, probability, 79, fieldName,
+                    influences, false, true, static_cast<int>(i % 3), 100);
+            } else {
+                stream.emplace_back(
+                    ml::api::CHierarchicalResultsWriter::E_Result,
+                    partitionFieldName, partitionFieldValue, byFieldName,
+                    byFieldValue, correlatedByFieldValue, time, function,
+                    functionDescription, 42.0, 79, TDouble1Vec(1, 6953.0),
+                    TDouble1Vec(1, 10090.0), 2.24, 0.8, probability, -5.0,
+                    fieldName, influences, false, true, static_cast<int>(i % 3),
+                    100, EMPTY_STRING_LIST);
+            }
+        }
+        return stream;
+    };
+
+    auto writeBucket = [](const TResultsVec& stream, ml::api::CJsonOutputWriter& writer) {
+        for (const auto& result : stream) {
+            BOOST_TEST_REQUIRE(writer.acceptResult(result));
+        }
+        BOOST_TEST_REQUIRE(writer.endOutputBatch(false, 1U));
+    };
+
+    // Check that records are written in full when their buffers are reused
+    // for later buckets, both with and without a limit on the number written.
+    for (std::size_t limit : {0, 10}) {
+        std::ostringstream sstream;
+        {
+            ml::core::CJsonOutputStreamWrapper outputStream(sstream);
+            ml::api::CJsonOutputWriter writer("job", outputStream);
+            writer.limitNumberRecords(limit);
+            writeBucket(makeStream(1), writer);
+            writeBucket(makeStream(2), writer);
+        }
+
+        rapidjson::Document arrayDoc;
+        arrayDoc.Parse<rapidjson::kParseDefaultFlags>(sstream.str());
+        BOOST_TEST_REQUIRE(!arrayDoc.HasParseError());
+        BOOST_TEST_REQUIRE(arrayDoc.IsArray());
+
+        std::size_t bucket{0};
+        for (const auto& doc : arrayDoc.GetArray()) {
+            if (doc.HasMember("records") == false) {
+                continue;
+            }
+            ++bucket;
+            const rapidjson::Value& records = doc["records"];
+            BOOST_REQUIRE_EQUAL(rapidjson::SizeType(limit == 0 ? 50 : limit), records.Size());
+            for (const auto& record : records.GetArray()) {
+                BOOST_REQUIRE_EQUAL(static_cast<std::int64_t>(1000 * bucket),
+                                    record["timestamp"].GetInt64());
+                BOOST_REQUIRE_EQUAL(std::string("job"), record["job_id"].GetString());
+                BOOST_REQUIRE_EQUAL(100, record["bucket_span"].GetInt());
+                BOOST_REQUIRE_EQUAL(rapidjson::SizeType(2), record["influencers"].Size());
+                if (record.HasMember("over_field_name")) {
+                    BOOST_REQUIRE_EQUAL(rapidjson::SizeType(2), record["causes"].Size());
+                } else {
+                    BOOST_TEST_REQUIRE(record.HasMember("causes") == false);
+                }
+            }
+        }
+        BOOST_REQUIRE_EQUAL(2, bucket);
+    }
+
+    // Write to /dev/null (Unix) or nul (Windows)
+    std::ofstream ofs(ml::core::COsFileFuncs::NULL_FILENAME);
+    BOOST_TEST_REQUIRE(ofs.is_open());
+
+    ml::core::CJsonOutputStreamWrapper outputStream(ofs);
+    ml::api::CJsonOutputWriter writer("job", outputStream);
+
+    static const std::size_t TEST_SIZE(2000);
+
+    TResultsVec stream{makeStream(1)};
+    ml::core::CStopWatch watch{true};
+    for (std::size_t count = 0; count < TEST_SIZE; ++count) {
+        writeBucket(stream, writer);
+    }
+    std::uint64_t duration{watch.stop()};
+
+    LOG_INFO(<< "Writing " << 50 * TEST_SIZE << " records took " << duration << " ms");
+    LOG_INFO(<< "Throughput " << 50000 * TEST_SIZE / std::max(duration, std::uint64_t{1})
+             << " records/s");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
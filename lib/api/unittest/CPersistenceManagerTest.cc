@@ -13,6 +13,7 @@
 #include <core/COsFileFuncs.h>
 #include <core/CProgramCounters.h>
 #include <core/CStringUtils.h>
+#include <core/Concurrency.h>
 #include <core/CoreTypes.h>
 
 #include <model/CAnomalyDetectorModelConfig.h>
@@ -24,6 +25,8 @@
 #include <api/CNdJsonInputParser.h>
 #include <api/CPersistenceManager.h>
 #include <api/CSingleStreamDataAdder.h>
+#include <api/CSingleStreamSearcher.h>
+#include <api/CStateRestoreStreamFilter.h>
 
 #include "CTestAnomalyJob.h"
 #include "CTestFieldDataCategorizer.h"
@@ -34,6 +37,7 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(CPersistenceManagerTest)
 
@@ -302,6 +306,136 @@ protected:
         BOOST_REQUIRE_EQUAL(backgroundState, foregroundState);
     }
 
+    void backgroundPersistAfterPartialChange(const std::string& configFileName) {
+        // Background persistence only copies detectors whose state changed
+        // since the previous background persist. Check that persisting again
+        // with and without intervening data matches foreground persistence.
+
+        static const ml::core_t::TTime BUCKET_SIZE{3600};
+        static const std::string JOB_ID{"job"};
+
+        std::ifstream inputStrm{"testfiles/big_ascending.txt"};
+        BOOST_TEST_REQUIRE(inputStrm.is_open());
+        std::string firstInput;
+        std::string secondInput;
+        std::string lastRecord;
+        std::string line;
+        for (std::size_t i = 0; std::getline(inputStrm, line); ++i) {
+            (i < 250 ? firstInput : secondInput) += line + '\n';
+            if (i < 250) {
+                lastRecord = line + '\n';
+            }
+        }
+
+        std::ofstream outputStrm{ml::core::COsFileFuncs::NULL_FILENAME};
+        BOOST_TEST_REQUIRE(outputStrm.is_open());
+
+        ml::model::CLimits limits;
+        ml::api::CAnomalyJobConfig jobConfig;
+        BOOST_TEST_REQUIRE(jobConfig.initFromFile(configFileName));
+
+        ml::model::CAnomalyDetectorModelConfig modelConfig{
+            ml::model::CAnomalyDetectorModelConfig::defaultConfig(BUCKET_SIZE)};
+
+        std::ostringstream* backgroundStream{nullptr};
+        ml::api::CSingleStreamDataAdder::TOStreamP backgroundStreamPtr{
+            backgroundStream = new std::ostringstream()};
+        ml::api::CSingleStreamDataAdder backgroundDataAdder{backgroundStreamPtr};
+
+        std::ostringstream* foregroundStream{nullptr};
+        ml::api::CSingleStreamDataAdder::TOStreamP foregroundStreamPtr{
+            foregroundStream = new std::ostringstream()};
+        ml::api::CSingleStreamDataAdder foregroundDataAdder{foregroundStreamPtr};
+
+        // The 30000 second persist interval is set large enough that the timer
+        // will not trigger during the test - we bypass the timer in this test
+        // and kick off the background persistence chain explicitly
+        ml::api::CPersistenceManager persistenceManager{
+            30000, false, backgroundDataAdder, foregroundDataAdder};
+
+        ml::core_t::TTime snapshotTimestamp;
+        std::string description;
+        std::string snapshotId;
+        std::size_t numDocs{0};
+
+        // Extract the state written by the last persist to a stream with the
+        // snapshot ID, which can differ between persists, replaced by "snap"
+        // and the zero byte separators replaced to avoid '\0's in the output
+        // if the test fails.
+        auto lastState = [&snapshotId](const std::ostringstream& stream,
+                                       std::size_t& previousLength) {
+            std::string state{stream.str().substr(previousLength)};
+            previousLength += state.length();
+            BOOST_REQUIRE_EQUAL(1, ml::core::CStringUtils::replaceFirst(
+                                       snapshotId, "snap", state));
+            std::replace(state.begin(), state.end(), '\0', ',');
+            return state;
+        };
+        std::size_t backgroundLength{0};
+        std::size_t foregroundLength{0};
+
+        {
+            ml::core::CJsonOutputStreamWrapper wrappedOutputStream{outputStrm};
+
+            CTestAnomalyJob job{JOB_ID,
+                                limits,
+                                jobConfig,
+                                modelConfig,
+                                wrappedOutputStream,
+                                std::bind(&reportPersistComplete, std::placeholders::_1,
+                                          std::ref(snapshotTimestamp), std::ref(description),
+                                          std::ref(snapshotId), std::ref(numDocs)),
+                                &persistenceManager,
+                                -1,
+                                "time",
+                                "%d/%b/%Y:%T %z"};
+
+            ml::api::CDataProcessor& processor{job};
+
+            auto handleInput = [&processor](const std::string& input) {
+                std::istringstream strm{input};
+                ml::api::CNdJsonInputParser parser{
+                    {CTestFieldDataCategorizer::MLCATEGORY_NAME}, strm};
+                return parser.readStreamIntoMaps(
+                    [&processor](const ml::api::CDataProcessor::TStrStrUMap& dataRowFields) {
+                        return processor.handleRecord(
+                            dataRowFields, ml::api::CDataProcessor::TOptionalTime{});
+                    });
+            };
+            auto persistInBackgroundThenForeground = [&] {
+                BOOST_TEST_REQUIRE(processor.periodicPersistStateInBackground());
+                BOOST_TEST_REQUIRE(persistenceManager.startPersistInBackground());
+                BOOST_TEST_REQUIRE(persistenceManager.waitForIdle());
+                std::string backgroundState{lastState(*backgroundStream, backgroundLength)};
+
+                BOOST_TEST_REQUIRE(processor.periodicPersistStateInForeground());
+                persistenceManager.startPersist();
+                std::string foregroundState{lastState(*foregroundStream, foregroundLength)};
+
+                BOOST_REQUIRE_EQUAL(backgroundState, foregroundState);
+            };
+
+            BOOST_TEST_REQUIRE(handleInput(firstInput));
+            persistInBackgroundThenForeground();
+            BOOST_REQUIRE_EQUAL(0, job.numberPersistenceCopiesReused());
+
+            // Nothing has changed so this reuses all the previous copies.
+            persistInBackgroundThenForeground();
+            std::size_t numberReused{job.numberPersistenceCopiesReused()};
+            BOOST_REQUIRE_EQUAL(job.detectorPartitionMap().size(), numberReused);
+
+            // Repeating the last record changes the simple count detector and
+            // one partition of each of the seven detectors so only the copies
+            // of those are replaced.
+            BOOST_TEST_REQUIRE(handleInput(lastRecord));
+            persistInBackgroundThenForeground();
+            BOOST_REQUIRE_EQUAL(2 * numberReused - 8, job.numberPersistenceCopiesReused());
+
+            BOOST_TEST_REQUIRE(handleInput(secondInput));
+            persistInBackgroundThenForeground();
+        }
+    }
+
     void foregroundPersistWithGivenSnapshotDescriptors(const std::string& configFileName) {
         // Start by creating processors with non-trivial state
 
@@ -418,6 +552,10 @@ BOOST_FIXTURE_TEST_CASE(testDetectorBackgroundPersistStaticsConsistency, CTestFi
     this->foregroundBackgroundCompAnomalyDetectionAfterStaticsUpdate("testfiles/new_mlfields_over.json");
 }
 
+BOOST_FIXTURE_TEST_CASE(testDetectorBackgroundPersistAfterPartialChange, CTestFixture) {
+    this->backgroundPersistAfterPartialChange("testfiles/new_mlfields_partition.json");
+}
+
 BOOST_FIXTURE_TEST_CASE(testBackgroundPersistCategorizationConsistency, CTestFixture) {
 
     static const std::string JOB_ID{"job"};
@@ -571,4 +709,156 @@ BOOST_FIXTURE_TEST_CASE(testCategorizationOnlyPersist, CTestFixture) {
     BOOST_REQUIRE_EQUAL(backgroundState, foregroundState);
 }
 
+BOOST_FIXTURE_TEST_CASE(testRestoreSnapshotTakenDuringCategorizationBatch, CTestFixture) {
+    // Categorizing on several threads passes records on to the anomaly job in
+    // batches. A periodic persist which falls due part way through a batch
+    // must wait until the whole batch has been passed on. Otherwise the rest
+    // of the batch would be categorized twice after restoring the snapshot.
+
+    static const ml::core_t::TTime BUCKET_SIZE{3600};
+    static const std::string JOB_ID{"job"};
+
+    ml::api::CAnomalyJobConfig jobConfig;
+    BOOST_TEST_REQUIRE(jobConfig.initFromFile(
+        "testfiles/new_persist_per_partition_categorization.json"));
+    ml::model::CAnomalyDetectorModelConfig modelConfig{
+        ml::model::CAnomalyDetectorModelConfig::defaultConfig(BUCKET_SIZE)};
+
+    const std::string partitions[]{"elasticsearch", "kibana", "logstash"};
+    const std::string templates[]{"Node {} started on port {}",
+                                  "Failed to connect to {} after {} attempts",
+                                  "Shard {} of index {} relocated"};
+    std::vector<CTestFieldDataCategorizer::TStrStrUMap> records;
+    for (std::size_t i = 0; i < 300; ++i) {
+        std::string message{templates[(i * 7) % 3]};
+        for (std::size_t j = 0; j < 2; ++j) {
+            message.replace(message.find("{}"), 2,
+                            ml::core::CStringUtils::typeToString((i * 31 + j) % 17));
+        }
+        records.push_back({{"time", ml::core::CStringUtils::typeToString(i * BUCKET_SIZE / 2)},
+                           {"message", message},
+                           {"event.dataset", partitions[(i + i / 7) % 3]}});
+    }
+    const CTestFieldDataCategorizer::TStrStrUMap flush{{".", "f1"}};
+
+    // The categorizer's state is the last document to be persisted.
+    auto categorizerState = [](const std::string& persistedState) {
+        std::size_t start{persistedState.rfind("{\"index\":")};
+        BOOST_TEST_REQUIRE(start != std::string::npos);
+        BOOST_TEST_REQUIRE(persistedState.find("categorizer_state", start) != std::string::npos);
+        return persistedState.substr(start);
+    };
+
+    std::ofstream outputStrm{ml::core::COsFileFuncs::NULL_FILENAME};
+    BOOST_TEST_REQUIRE(outputStrm.is_open());
+    ml::core::CJsonOutputStreamWrapper wrappedOutputStream{outputStrm};
+
+    ml::core::startDefaultAsyncExecutor(2);
+
+    std::string snapshot;
+    ml::core_t::TTime snapshotLatestRecordTime{0};
+    std::string expectedState;
+    {
+        ml::model::CLimits limits;
+
+        std::ostringstream* persistStream{nullptr};
+        ml::api::CSingleStreamDataAdder::TOStreamP persistStreamPtr{
+            persistStream = new std::ostringstream()};
+        ml::api::CSingleStreamDataAdder dataAdder{persistStreamPtr};
+
+        // Persist in the foreground every 20 buckets, which falls due part
+        // way through the first batch of records.
+        ml::api::CPersistenceManager persistenceManager{0, true, dataAdder, 20};
+
+        CTestAnomalyJob job{
+            JOB_ID,
+            limits,
+            jobConfig,
+            modelConfig,
+            wrappedOutputStream,
+            [&](const ml::api::CModelSnapshotJsonWriter::SModelSnapshotReport& report) {
+                if (snapshotLatestRecordTime == 0) {
+                    snapshotLatestRecordTime = report.s_LatestRecordTime;
+                }
+            },
+            &persistenceManager};
+        CTestFieldDataCategorizer categorizer{JOB_ID,
+                                              jobConfig.analysisConfig(),
+                                              limits,
+                                              &job,
+                                              wrappedOutputStream,
+                                              &persistenceManager,
+                                              false,
+                                              2};
+        BOOST_TEST_REQUIRE(persistenceManager.firstProcessorForegroundPeriodicPersistFunc(
+            std::bind(&ml::api::CDataProcessor::periodicPersistStateInForeground, &categorizer)));
+
+        for (std::size_t i = 0; i < 200; ++i) {
+            BOOST_TEST_REQUIRE(categorizer.handleRecord(records[i]));
+        }
+        BOOST_TEST_REQUIRE(categorizer.handleRecord(flush));
+        snapshot = persistStream->str();
+        BOOST_TEST_REQUIRE(snapshot.empty() == false);
+        BOOST_REQUIRE_EQUAL(records[199].at("time"),
+                            ml::core::CStringUtils::typeToString(snapshotLatestRecordTime));
+
+        for (std::size_t i = 200; i < records.size(); ++i) {
+            BOOST_TEST_REQUIRE(categorizer.handleRecord(records[i]));
+        }
+        categorizer.finalise();
+
+        ml::api::CSingleStreamDataAdder::TOStreamP stateStreamPtr{new std::ostringstream()};
+        ml::api::CSingleStreamDataAdder stateAdder{stateStreamPtr};
+        BOOST_TEST_REQUIRE(categorizer.persistStateInForeground(stateAdder, ""));
+        expectedState = categorizerState(
+            dynamic_cast<std::ostringstream&>(*stateStreamPtr).str());
+    }
+
+    // Restore from the first snapshot and pass on the records after it.
+    std::string state;
+    {
+        ml::model::CLimits limits;
+        CTestAnomalyJob job{JOB_ID, limits, jobConfig, modelConfig, wrappedOutputStream};
+        CTestFieldDataCategorizer categorizer{JOB_ID,
+                                              jobConfig.analysisConfig(),
+                                              limits,
+                                              &job,
+                                              wrappedOutputStream,
+                                              nullptr,
+                                              false,
+                                              2};
+
+        std::stringstream* output{new std::stringstream()};
+        ml::api::CSingleStreamSearcher::TIStreamP strm{output};
+        boost::iostreams::filtering_ostream in;
+        in.push(ml::api::CStateRestoreStreamFilter());
+        in.push(*output);
+        in << snapshot;
+        in.flush();
+        ml::api::CSingleStreamSearcher retriever{strm};
+        ml::core_t::TTime completeToTime{0};
+        BOOST_TEST_REQUIRE(categorizer.restoreState(retriever, completeToTime));
+
+        for (const auto& record : records) {
+            ml::core_t::TTime time{0};
+            BOOST_TEST_REQUIRE(ml::core::CStringUtils::stringToType(record.at("time"), time));
+            if (time > snapshotLatestRecordTime) {
+                BOOST_TEST_REQUIRE(categorizer.handleRecord(record));
+            }
+        }
+        categorizer.finalise();
+
+        ml::api::CSingleStreamDataAdder::TOStreamP stateStreamPtr{new std::ostringstream()};
+        ml::api::CSingleStreamDataAdder stateAdder{stateStreamPtr};
+        BOOST_TEST_REQUIRE(categorizer.persistStateInForeground(stateAdder, ""));
+        state = categorizerState(dynamic_cast<std::ostringstream&>(*stateStreamPtr).str());
+    }
+
+    ml::core::stopDefaultAsyncExecutor();
+
+    std::replace(expectedState.begin(), expectedState.end(), '\0', ',');
+    std::replace(state.begin(), state.end(), '\0', ',');
+    BOOST_REQUIRE_EQUAL(expectedState, state);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
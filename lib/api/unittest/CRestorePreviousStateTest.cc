@@ -9,9 +9,11 @@
  * limitation.
  */
 
+#include <core/CContainerPrinter.h>
 #include <core/CJsonOutputStreamWrapper.h>
 #include <core/CLogger.h>
 #include <core/COsFileFuncs.h>
+#include <core/Concurrency.h>
 
 #include <model/CAnomalyDetectorModelConfig.h>
 #include <model/CLimits.h>
@@ -32,6 +34,7 @@
 
 #include <fstream>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -139,16 +142,13 @@ void categorizerRestoreHelper(const std::string& stateFile, bool isSymmetric) {
     }
 }
 
-void anomalyDetectorRestoreHelper(const std::string& stateFile,
-                                  const std::string& configFileName,
-                                  bool isSymmetric,
-                                  int latencyBuckets) {
-    // Open the input state file
-    std::ifstream inputStrm(stateFile.c_str());
-    BOOST_TEST_REQUIRE(inputStrm.is_open());
-    std::string origPersistedState(std::istreambuf_iterator<char>{inputStrm},
-                                   std::istreambuf_iterator<char>{});
-
+std::string restoreAndPersistDetector(const std::string& origPersistedState,
+                                     const std::string& configFileName,
+                                     int latencyBuckets,
+                                     std::size_t& numDocsInStateFile,
+                                     std::size_t& numRestoredDocs,
+                                     std::size_t restoreThreads = 1,
+                                     bool restoreLazily = false) {
     // Start by creating a detector with non-trivial state
     static const ml::core_t::TTime BUCKET_SIZE(3600);
     static const std::string JOB_ID("job");
@@ -167,13 +167,13 @@ void anomalyDetectorRestoreHelper(const std::string& stateFile,
     ml::core::CJsonOutputStreamWrapper wrappedOutputStream(outputStrm);
 
     std::string restoredSnapshotId;
-    std::size_t numRestoredDocs(0);
     CTestAnomalyJob restoredJob(
         JOB_ID, limits, jobConfig, modelConfig, wrappedOutputStream,
         std::bind(&reportPersistComplete, std::placeholders::_1,
-                  std::ref(restoredSnapshotId), std::ref(numRestoredDocs)));
+                  std::ref(restoredSnapshotId), std::ref(numRestoredDocs)),
+        nullptr, -1, CTestAnomalyJob::DEFAULT_TIME_FIELD_NAME,
+        CTestAnomalyJob::EMPTY_STRING, 0, false, restoreLazily);
 
-    std::size_t numDocsInStateFile(0);
     {
         ml::core_t::TTime completeToTime(0);
 
@@ -189,7 +189,14 @@ void anomalyDetectorRestoreHelper(const std::string& stateFile,
             in.component<ml::api::CStateRestoreStreamFilter>(0)->getDocCount();
 
         ml::api::CSingleStreamSearcher retriever(strm);
-        BOOST_TEST_REQUIRE(restoredJob.restoreState(retriever, completeToTime));
+        if (restoreThreads > 1) {
+            ml::core::startDefaultAsyncExecutor(restoreThreads);
+        }
+        bool restored{restoredJob.restoreState(retriever, completeToTime)};
+        if (restoreThreads > 1) {
+            ml::core::stopDefaultAsyncExecutor();
+        }
+        BOOST_TEST_REQUIRE(restored);
         BOOST_TEST_REQUIRE(completeToTime > 0);
     }
 
@@ -202,6 +209,24 @@ void anomalyDetectorRestoreHelper(const std::string& stateFile,
         newPersistedState = strm->str();
     }
 
+    return newPersistedState;
+}
+
+void anomalyDetectorRestoreHelper(const std::string& stateFile,
+                                  const std::string& configFileName,
+                                  bool isSymmetric,
+                                  int latencyBuckets) {
+    // Open the input state file
+    std::ifstream inputStrm(stateFile.c_str());
+    BOOST_TEST_REQUIRE(inputStrm.is_open());
+    std::string origPersistedState(std::istreambuf_iterator<char>{inputStrm},
+                                   std::istreambuf_iterator<char>{});
+
+    std::size_t numDocsInStateFile(0);
+    std::size_t numRestoredDocs(0);
+    std::string newPersistedState{restoreAndPersistDetector(
+        origPersistedState, configFileName, latencyBuckets, numDocsInStateFile, numRestoredDocs)};
+
     if (isSymmetric) {
 #ifdef Linux
         // Test the persisted state of the restored detector is the
@@ -249,6 +274,147 @@ BOOST_FIXTURE_TEST_CASE(testRestoreDetectorPartition, ml::test::CProgramCounterC
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(testRestoreDetectorPartitionInParallel,
+                        ml::test::CProgramCounterClearingFixture) {
+    // Restoring detectors in parallel should give the same state as
+    // restoring them one at a time.
+
+    std::ifstream inputStrm("testfiles/state/7.9.0/partition_detector_state.json");
+    BOOST_TEST_REQUIRE(inputStrm.is_open());
+    std::string origPersistedState(std::istreambuf_iterator<char>{inputStrm},
+                                   std::istreambuf_iterator<char>{});
+
+    std::size_t numDocsInStateFile(0);
+    std::size_t numRestoredDocs(0);
+    std::string expectedPersistedState{restoreAndPersistDetector(
+        origPersistedState, "testfiles/new_mlfields_partition.json", 0,
+        numDocsInStateFile, numRestoredDocs)};
+
+    std::string persistedState{restoreAndPersistDetector(
+        origPersistedState, "testfiles/new_mlfields_partition.json", 0,
+        numDocsInStateFile, numRestoredDocs, 4)};
+
+    BOOST_REQUIRE_EQUAL(stripDocIds(expectedPersistedState), stripDocIds(persistedState));
+}
+
+BOOST_FIXTURE_TEST_CASE(testRestoreDetectorPartitionLazily,
+                        ml::test::CProgramCounterClearingFixture) {
+    // Detectors restored lazily are restored when the job is persisted and
+    // this should give the same state as restoring them up front.
+
+    std::ifstream inputStrm("testfiles/state/7.9.0/partition_detector_state.json");
+    BOOST_TEST_REQUIRE(inputStrm.is_open());
+    std::string origPersistedState(std::istreambuf_iterator<char>{inputStrm},
+                                   std::istreambuf_iterator<char>{});
+
+    std::size_t numDocsInStateFile(0);
+    std::size_t numRestoredDocs(0);
+    std::string expectedPersistedState{restoreAndPersistDetector(
+        origPersistedState, "testfiles/new_mlfields_partition.json", 0,
+        numDocsInStateFile, numRestoredDocs)};
+
+    std::string persistedState{restoreAndPersistDetector(
+        origPersistedState, "testfiles/new_mlfields_partition.json", 0,
+        numDocsInStateFile, numRestoredDocs, 1, true)};
+
+    BOOST_REQUIRE_EQUAL(stripDocIds(expectedPersistedState), stripDocIds(persistedState));
+}
+
+BOOST_FIXTURE_TEST_CASE(testRestoreDetectorPartitionLazilyWithEmptyBuckets,
+                        ml::test::CProgramCounterClearingFixture) {
+    // Detectors restored lazily stay dormant while buckets in which they have
+    // no data are finalised, unless they have results for those buckets. Once
+    // restored they should have the same state as detectors restored up front.
+
+    static const ml::core_t::TTime BUCKET_SIZE{3600};
+
+    ml::api::CAnomalyJobConfig jobConfig = CTestAnomalyJob::makeSimpleJobConfig(
+        "mean", "value", "", "", "partition");
+    ml::model::CAnomalyDetectorModelConfig modelConfig =
+        ml::model::CAnomalyDetectorModelConfig::defaultConfig(BUCKET_SIZE);
+
+    auto addRecords = [](CTestAnomalyJob& job, ml::core_t::TTime start, ml::core_t::TTime end,
+                         const std::vector<std::string>& partitions) {
+        CTestAnomalyJob::TStrStrUMap dataRows;
+        for (ml::core_t::TTime time = start; time < end; time += 600) {
+            for (const auto& partition : partitions) {
+                dataRows["time"] = std::to_string(time);
+                dataRows["value"] = std::to_string(10 + (time / 600) % 7);
+                dataRows["partition"] = partition;
+                BOOST_TEST_REQUIRE(job.handleRecord(dataRows));
+            }
+        }
+    };
+    auto persist = [](CTestAnomalyJob& job) {
+        std::ostringstream* strm(nullptr);
+        ml::api::CSingleStreamDataAdder::TOStreamP ptr(strm = new std::ostringstream());
+        ml::api::CSingleStreamDataAdder persister(ptr);
+        BOOST_TEST_REQUIRE(job.persistStateInForeground(persister, ""));
+        return strm->str();
+    };
+
+    std::ofstream outputStrm(ml::core::COsFileFuncs::NULL_FILENAME);
+    BOOST_TEST_REQUIRE(outputStrm.is_open());
+    ml::core::CJsonOutputStreamWrapper wrappedOutputStream(outputStrm);
+
+    std::string origPersistedState;
+    {
+        ml::model::CLimits limits;
+        CTestAnomalyJob job("job", limits, jobConfig, modelConfig, wrappedOutputStream);
+        addRecords(job, 0, 20 * BUCKET_SIZE, {"a", "b", "c"});
+        origPersistedState = persist(job);
+    }
+
+    using TStrUInt64Map = std::map<std::string, std::uint64_t>;
+
+    auto restoreAndAddRecords = [&](bool restoreLazily) {
+        ml::model::CLimits limits;
+        CTestAnomalyJob job("job", limits, jobConfig, modelConfig,
+                            wrappedOutputStream, CTestAnomalyJob::TPersistCompleteFunc(),
+                            nullptr, -1, CTestAnomalyJob::DEFAULT_TIME_FIELD_NAME,
+                            CTestAnomalyJob::EMPTY_STRING, 0, false, restoreLazily);
+
+        std::stringstream* output = new std::stringstream();
+        ml::api::CSingleStreamSearcher::TIStreamP strm(output);
+        boost::iostreams::filtering_ostream in;
+        in.push(ml::api::CStateRestoreStreamFilter());
+        in.push(*output);
+        in << origPersistedState;
+        in.flush();
+        ml::api::CSingleStreamSearcher retriever(strm);
+        ml::core_t::TTime completeToTime{0};
+        std::size_t allocationLimit{limits.resourceMonitor().allocationLimit()};
+        BOOST_TEST_REQUIRE(job.restoreState(retriever, completeToTime));
+        BOOST_TEST_REQUIRE(completeToTime > 0);
+        if (restoreLazily) {
+            // The dormant detectors' state counts towards the memory limit.
+            BOOST_TEST_REQUIRE(limits.resourceMonitor().allocationLimit() < allocationLimit);
+        }
+
+        // Partition "b" is only needed after five buckets and "c" only when
+        // the job is persisted.
+        addRecords(job, 20 * BUCKET_SIZE, 25 * BUCKET_SIZE, {"a"});
+        addRecords(job, 25 * BUCKET_SIZE, 27 * BUCKET_SIZE, {"a", "b"});
+        addRecords(job, 27 * BUCKET_SIZE, 28 * BUCKET_SIZE, {"a"});
+        persist(job);
+
+        // The memory measured for the models depends on when it's measured
+        // so compare the models' checksums rather than their state.
+        TStrUInt64Map checksums;
+        for (const auto& detector : job.detectorPartitionMap()) {
+            checksums[detector.first.first] = detector.second->model()->checksum();
+        }
+        return checksums;
+    };
+
+    TStrUInt64Map expectedChecksums{restoreAndAddRecords(false)};
+    TStrUInt64Map checksums{restoreAndAddRecords(true)};
+
+    BOOST_REQUIRE_EQUAL(4, expectedChecksums.size());
+    BOOST_REQUIRE_EQUAL(ml::core::CContainerPrinter::print(expectedChecksums),
+                        ml::core::CContainerPrinter::print(checksums));
+}
+
 BOOST_FIXTURE_TEST_CASE(testRestoreDetectorDc, ml::test::CProgramCounterClearingFixture) {
     for (const auto& version : BWC_VERSIONS) {
         LOG_INFO(<< "Test restoring state from version " << version.s_Version);
@@ -10,6 +10,7 @@
  */
 
 #include <core/CLogger.h>
+#include <core/Concurrency.h>
 
 #include <model/CAnomalyDetectorModelConfig.h>
 
@@ -543,4 +544,87 @@ BOOST_AUTO_TEST_CASE(testInitNormalizer) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(testPositionalRecordsInParallel) {
+    // Test that normalizing positional records in parallel batches gives
+    // the same output, in the same order, as normalizing record maps.
+
+    using TStrVec = ml::api::CResultNormalizer::TStrVec;
+    using TStrVecVec = std::vector<TStrVec>;
+
+    ml::model::CAnomalyDetectorModelConfig modelConfig =
+        ml::model::CAnomalyDetectorModelConfig::defaultConfig(900);
+
+    TStrVec fieldNames;
+    TStrVecVec records;
+    {
+        std::ifstream inputStrm("testfiles/new_normalizerInput.csv");
+        ml::api::CCsvInputParser inputParser(inputStrm);
+        BOOST_TEST_REQUIRE(inputParser.readStreamIntoVecs(
+            [&](const TStrVec& names, const TStrVec& values) {
+                fieldNames = names;
+                records.push_back(values);
+                return true;
+            }));
+    }
+
+    // Repeat the records so that there are several batches.
+    std::size_t numberRecords{20 * records.size()};
+
+    auto readDocs = [](const std::string& results) {
+        std::vector<rapidjson::Document> docs;
+        std::stringstream ss(results);
+        std::string docString;
+        while (std::getline(ss, docString)) {
+            docs.emplace_back();
+            docs.back().Parse<rapidjson::kParseDefaultFlags>(docString.c_str());
+        }
+        return docs;
+    };
+
+    ml::api::CNdJsonOutputWriter expectedOutputWriter;
+    {
+        ml::api::CResultNormalizer normalizer(modelConfig, expectedOutputWriter);
+        BOOST_TEST_REQUIRE(normalizer.initNormalizer("testfiles/new_quantilesState.json"));
+        ml::api::CResultNormalizer::TStrStrUMap fields;
+        for (std::size_t i = 0; i < numberRecords; ++i) {
+            const TStrVec& record{records[i % records.size()]};
+            for (std::size_t j = 0; j < fieldNames.size(); ++j) {
+                fields[fieldNames[j]] = record[j];
+            }
+            BOOST_TEST_REQUIRE(normalizer.handleRecord(fields));
+        }
+        BOOST_REQUIRE_EQUAL(numberRecords, normalizer.numberRecords());
+    }
+
+    ml::core::startDefaultAsyncExecutor(4);
+
+    ml::api::CNdJsonOutputWriter outputWriter;
+    {
+        ml::api::CResultNormalizer normalizer(modelConfig, outputWriter);
+        BOOST_TEST_REQUIRE(normalizer.initNormalizer("testfiles/new_quantilesState.json"));
+        for (std::size_t i = 0; i < numberRecords; ++i) {
+            BOOST_TEST_REQUIRE(normalizer.handlePositionalRecord(
+                fieldNames, records[i % records.size()]));
+        }
+        BOOST_TEST_REQUIRE(normalizer.flushPositionalRecords());
+        BOOST_REQUIRE_EQUAL(numberRecords, normalizer.numberRecords());
+    }
+
+    ml::core::stopDefaultAsyncExecutor();
+
+    std::vector<rapidjson::Document> expectedDocs{readDocs(expectedOutputWriter.internalString())};
+    std::vector<rapidjson::Document> docs{readDocs(outputWriter.internalString())};
+    BOOST_REQUIRE_EQUAL(numberRecords, expectedDocs.size());
+    BOOST_REQUIRE_EQUAL(numberRecords, docs.size());
+
+    for (std::size_t i = 0; i < numberRecords; ++i) {
+        for (const auto& name : fieldNames) {
+            BOOST_REQUIRE_EQUAL(std::string(expectedDocs[i][name].GetString()),
+                                std::string(docs[i][name].GetString()));
+        }
+        BOOST_REQUIRE_EQUAL(std::string(expectedDocs[i]["normalized_score"].GetString()),
+                            std::string(docs[i]["normalized_score"].GetString()));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -52,7 +52,8 @@ void reportPersistComplete(ml::api::CModelSnapshotJsonWriter::SModelSnapshotRepo
 void detectorPersistHelper(const std::string& configFileName,
                            const std::string& inputFilename,
                            int latencyBuckets,
-                           const std::string& timeFormat = std::string()) {
+                           const std::string& timeFormat = std::string(),
+                           bool persistInBinary = false) {
     // Start by creating a detector with non-trivial state
     static const ml::core_t::TTime BUCKET_SIZE(3600);
     static const std::string JOB_ID("job");
@@ -83,7 +84,7 @@ void detectorPersistHelper(const std::string& configFileName,
             JOB_ID, limits, jobConfig, modelConfig, wrappedOutputStream,
             std::bind(&reportPersistComplete, std::placeholders::_1,
                       std::ref(origSnapshotId), std::ref(numOrigDocs)),
-            nullptr, -1, "time", timeFormat);
+            nullptr, -1, "time", timeFormat, 0, persistInBinary);
 
         // The categorizer knows how to assign categories to records
         CTestFieldDataCategorizer categorizer(JOB_ID, jobConfig.analysisConfig(),
@@ -132,7 +133,9 @@ void detectorPersistHelper(const std::string& configFileName,
         CTestAnomalyJob restoredJob(
             JOB_ID, limits, jobConfig, modelConfig, wrappedOutputStream,
             std::bind(&reportPersistComplete, std::placeholders::_1,
-                      std::ref(restoredSnapshotId), std::ref(numRestoredDocs)));
+                      std::ref(restoredSnapshotId), std::ref(numRestoredDocs)),
+            nullptr, -1, CTestAnomalyJob::DEFAULT_TIME_FIELD_NAME,
+            CTestAnomalyJob::EMPTY_STRING, 0, persistInBinary);
 
         // The categorizer knows how to assign categories to records
         CTestFieldDataCategorizer restoredCategorizer(
@@ -197,6 +200,11 @@ BOOST_AUTO_TEST_CASE(testDetectorPersistBy) {
                           "testfiles/big_ascending.txt", 0, "%d/%b/%Y:%T %z");
 }
 
+BOOST_AUTO_TEST_CASE(testDetectorPersistByBinary) {
+    detectorPersistHelper("testfiles/new_mlfields.json", "testfiles/big_ascending.txt",
+                          0, "%d/%b/%Y:%T %z", true);
+}
+
 BOOST_AUTO_TEST_CASE(testDetectorPersistOver) {
     detectorPersistHelper("testfiles/new_mlfields_over.json",
                           "testfiles/big_ascending.txt", 0, "%d/%b/%Y:%T %z");
@@ -22,7 +22,10 @@ CTestAnomalyJob::CTestAnomalyJob(const std::string& jobId,
                                  ml::core_t::TTime maxQuantileInterval,
                                  const std::string& timeFieldName,
                                  const std::string& timeFieldFormat,
-                                 std::size_t maxAnomalyRecords)
+                                 std::size_t maxAnomalyRecords,
+                                 bool persistInBinary,
+                                 bool restoreLazily,
+                                 std::size_t forecastThreads)
     : ml::api::CAnomalyJob(jobId,
                            limits,
                            jobConfig,
@@ -33,7 +36,10 @@ CTestAnomalyJob::CTestAnomalyJob(const std::string& jobId,
                            maxQuantileInterval,
                            timeFieldName,
                            timeFieldFormat,
-                           maxAnomalyRecords) {
+                           maxAnomalyRecords,
+                           persistInBinary,
+                           restoreLazily,
+                           forecastThreads) {
 }
 
 ml::api::CAnomalyJobConfig
@@ -38,7 +38,10 @@ public:
                     ml::core_t::TTime maxQuantileInterval = -1,
                     const std::string& timeFieldName = DEFAULT_TIME_FIELD_NAME,
                     const std::string& timeFieldFormat = EMPTY_STRING,
-                    std::size_t maxAnomalyRecords = 0u);
+                    std::size_t maxAnomalyRecords = 0u,
+                    bool persistInBinary = false,
+                    bool restoreLazily = false,
+                    std::size_t forecastThreads = 1);
 
     //! Bring base class overload of handleRecord() into scope
     using CAnomalyJob::handleRecord;
@@ -47,6 +50,8 @@ public:
         return this->handleRecord(dataRowFields, TOptionalTime{});
     }
 
+    using CAnomalyJob::detectorPartitionMap;
+
     static ml::api::CAnomalyJobConfig
     makeSimpleJobConfig(const std::string& functionName,
                         const std::string& fieldName,
@@ -17,7 +17,8 @@ CTestFieldDataCategorizer::CTestFieldDataCategorizer(
     ml::api::CDataProcessor* chainedProcessor,
     ml::core::CJsonOutputStreamWrapper& outputStream,
     ml::api::CPersistenceManager* persistenceManager,
-    bool stopCategorizationOnWarnStatus)
+    bool stopCategorizationOnWarnStatus,
+    std::size_t numberThreads)
     : ml::api::CFieldDataCategorizer{jobId,
                                      config,
                                      limits,
@@ -26,7 +27,8 @@ CTestFieldDataCategorizer::CTestFieldDataCategorizer(
                                      chainedProcessor,
                                      outputStream,
                                      persistenceManager,
-                                     stopCategorizationOnWarnStatus} {
+                                     stopCategorizationOnWarnStatus,
+                                     numberThreads} {
 }
 
 CTestFieldDataCategorizer::CTestFieldDataCategorizer(
@@ -38,7 +40,8 @@ CTestFieldDataCategorizer::CTestFieldDataCategorizer(
     ml::api::CDataProcessor* chainedProcessor,
     ml::core::CJsonOutputStreamWrapper& outputStream,
     ml::api::CPersistenceManager* persistenceManager,
-    bool stopCategorizationOnWarnStatus)
+    bool stopCategorizationOnWarnStatus,
+    std::size_t numberThreads)
     : ml::api::CFieldDataCategorizer{jobId,
                                      config,
                                      limits,
@@ -47,5 +50,6 @@ CTestFieldDataCategorizer::CTestFieldDataCategorizer(
                                      chainedProcessor,
                                      outputStream,
                                      persistenceManager,
-                                     stopCategorizationOnWarnStatus} {
+                                     stopCategorizationOnWarnStatus,
+                                     numberThreads} {
 }
@@ -34,7 +34,8 @@ public:
                               ml::api::CDataProcessor* chainedProcessor,
                               ml::core::CJsonOutputStreamWrapper& outputStream,
                               ml::api::CPersistenceManager* persistenceManager = nullptr,
-                              bool stopCategorizationOnWarnStatus = false);
+                              bool stopCategorizationOnWarnStatus = false,
+                              std::size_t numberThreads = 1);
 
     CTestFieldDataCategorizer(const std::string& jobId,
                               const ml::api::CAnomalyJobConfig::CAnalysisConfig& config,
@@ -44,7 +45,8 @@ public:
                               ml::api::CDataProcessor* chainedProcessor,
                               ml::core::CJsonOutputStreamWrapper& outputStream,
                               ml::api::CPersistenceManager* persistenceManager = nullptr,
-                              bool stopCategorizationOnWarnStatus = false);
+                              bool stopCategorizationOnWarnStatus = false,
+                              std::size_t numberThreads = 1);
 
     //! Bring base class overload of handleRecord() into scope
     using CFieldDataCategorizer::handleRecord;
@@ -0,0 +1,106 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+#include <core/CBinaryStatePersistInserter.h>
+
+#include <cstring>
+#include <ostream>
+
+namespace ml {
+namespace core {
+
+namespace {
+//! The buffer size at which buffered state is written to the stream.
+const std::size_t FLUSH_SIZE{65536};
+}
+
+const char CBinaryStatePersistInserter::MARKER{'\xb1'};
+const char CBinaryStatePersistInserter::FORMAT_VERSION{1};
+
+CBinaryStatePersistInserter::CBinaryStatePersistInserter(std::ostream& outputStream)
+    : m_OutputStream(outputStream) {
+    m_Buffer.reserve(FLUSH_SIZE + 4096);
+    m_Buffer.push_back(MARKER);
+    m_Buffer.push_back(FORMAT_VERSION);
+}
+
+CBinaryStatePersistInserter::~CBinaryStatePersistInserter() {
+    // The root level is ended in the same way as any other
+    this->writeType(E_EndLevel);
+    this->flush();
+}
+
+void CBinaryStatePersistInserter::insertValue(const std::string& name,
+                                              const std::string& value) {
+    this->writeType(E_String);
+    this->writeString(name);
+    this->writeString(value);
+    this->flushIfFull();
+}
+
+void CBinaryStatePersistInserter::insertValue(const std::string& name,
+                                              double value,
+                                              CIEEE754::EPrecision precision) {
+    // Rounding here means the restored value is the same as it would have
+    // been had it been persisted as JSON.
+    value = CIEEE754::round(value, precision);
+    char bytes[sizeof(double)];
+    std::memcpy(bytes, &value, sizeof(double));
+    this->writeType(E_Double);
+    this->writeString(name);
+    m_Buffer.append(bytes, sizeof(double));
+    this->flushIfFull();
+}
+
+void CBinaryStatePersistInserter::flush() {
+    this->writeBuffer();
+    m_OutputStream.flush();
+}
+
+void CBinaryStatePersistInserter::newLevel(const std::string& name) {
+    this->writeType(E_NewLevel);
+    this->writeString(name);
+}
+
+void CBinaryStatePersistInserter::endLevel() {
+    this->writeType(E_EndLevel);
+    this->flushIfFull();
+}
+
+void CBinaryStatePersistInserter::writeType(ERecordType type) {
+    m_Buffer.push_back(static_cast<char>(type));
+}
+
+void CBinaryStatePersistInserter::writeVarint(std::size_t value) {
+    // LEB128: seven bits per byte with the high bit set on all but the last
+    while (value >= 0x80) {
+        m_Buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    m_Buffer.push_back(static_cast<char>(value));
+}
+
+void CBinaryStatePersistInserter::writeString(const std::string& value) {
+    this->writeVarint(value.size());
+    m_Buffer.append(value);
+}
+
+void CBinaryStatePersistInserter::flushIfFull() {
+    if (m_Buffer.size() >= FLUSH_SIZE) {
+        this->writeBuffer();
+    }
+}
+
+void CBinaryStatePersistInserter::writeBuffer() {
+    m_OutputStream.write(m_Buffer.data(), static_cast<std::streamsize>(m_Buffer.size()));
+    m_Buffer.clear();
+}
+}
+}
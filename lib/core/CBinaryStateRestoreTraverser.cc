@@ -0,0 +1,330 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+#include <core/CBinaryStateRestoreTraverser.h>
+
+#include <core/CBinaryStatePersistInserter.h>
+#include <core/CLogger.h>
+#include <core/CStringUtils.h>
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+
+namespace ml {
+namespace core {
+
+namespace {
+const std::string EMPTY_STRING;
+
+//! The number of bytes read from the stream at a time.
+const std::size_t READ_SIZE{65536};
+}
+
+CBinaryStateRestoreTraverser::CBinaryStateRestoreTraverser(std::istream& inputStream)
+    : m_InputStream(inputStream) {
+}
+
+bool CBinaryStateRestoreTraverser::isBinaryState(std::istream& inputStream) {
+    return inputStream.peek() ==
+           std::char_traits<char>::to_int_type(CBinaryStatePersistInserter::MARKER);
+}
+
+bool CBinaryStateRestoreTraverser::isEof() const {
+    if (m_Eof) {
+        return true;
+    }
+    return const_cast<CBinaryStateRestoreTraverser*>(this)->fillBuffer() == false;
+}
+
+bool CBinaryStateRestoreTraverser::next() {
+    if (this->haveBadState()) {
+        return false;
+    }
+
+    if (!m_Started) {
+        if (this->start() == false) {
+            return false;
+        }
+    }
+
+    if (m_LevelEnded) {
+        return false;
+    }
+
+    // Skip over a nested level that's not of interest
+    if (m_CurrentIsLevel) {
+        m_CurrentIsLevel = false;
+        if (this->skipLevel() == false) {
+            return false;
+        }
+    }
+
+    return this->advance();
+}
+
+bool CBinaryStateRestoreTraverser::hasSubLevel() const {
+    if (!m_Started) {
+        if (const_cast<CBinaryStateRestoreTraverser*>(this)->start() == false) {
+            return false;
+        }
+    }
+
+    return m_CurrentIsLevel;
+}
+
+const std::string& CBinaryStateRestoreTraverser::name() const {
+    if (this->haveBadState()) {
+        return EMPTY_STRING;
+    }
+
+    if (!m_Started) {
+        if (const_cast<CBinaryStateRestoreTraverser*>(this)->start() == false) {
+            return EMPTY_STRING;
+        }
+    }
+
+    return m_Name;
+}
+
+const std::string& CBinaryStateRestoreTraverser::value() const {
+    if (this->haveBadState()) {
+        return EMPTY_STRING;
+    }
+
+    if (!m_Started) {
+        if (const_cast<CBinaryStateRestoreTraverser*>(this)->start() == false) {
+            return EMPTY_STRING;
+        }
+    }
+
+    return m_Value;
+}
+
+bool CBinaryStateRestoreTraverser::descend() {
+    if (!m_Started) {
+        if (this->start() == false) {
+            return false;
+        }
+    }
+
+    if (m_CurrentIsLevel == false) {
+        return false;
+    }
+
+    m_LevelNames.push_back(m_Name);
+    ++m_Level;
+    m_CurrentIsLevel = false;
+
+    // If the level is empty set the current element to be completely empty
+    // so that the sub-level traverser will find nothing and then ascend.
+    if (this->advance() == false) {
+        m_Name.clear();
+        m_Value.clear();
+        return this->haveBadState() == false;
+    }
+
+    return true;
+}
+
+bool CBinaryStateRestoreTraverser::ascend() {
+    // If we're trying to ascend above the root level then something has gone
+    // wrong
+    if (m_Level == 0) {
+        LOG_ERROR(<< "Inconsistency - trying to ascend above binary state root");
+        return false;
+    }
+
+    if (m_LevelEnded == false) {
+        if (m_CurrentIsLevel && this->skipLevel() == false) {
+            return false;
+        }
+        if (this->skipLevel() == false) {
+            return false;
+        }
+    }
+
+    // The current element becomes the one whose level we descended into, so
+    // next() moves on to the element after it.
+    --m_Level;
+    m_LevelEnded = false;
+    m_CurrentIsLevel = false;
+    m_Name = std::move(m_LevelNames.back());
+    m_LevelNames.pop_back();
+    m_Value.clear();
+
+    return true;
+}
+
+bool CBinaryStateRestoreTraverser::start() {
+    m_Started = true;
+
+    std::uint8_t marker{0};
+    std::uint8_t version{0};
+    if (this->readByte(marker) == false || this->readByte(version) == false) {
+        return this->fail("no binary state header");
+    }
+    if (marker != static_cast<std::uint8_t>(CBinaryStatePersistInserter::MARKER)) {
+        return this->fail("input is not binary state");
+    }
+    if (version != static_cast<std::uint8_t>(CBinaryStatePersistInserter::FORMAT_VERSION)) {
+        return this->fail("unsupported binary state version " + CStringUtils::typeToString(version));
+    }
+
+    return this->advance() || m_Eof;
+}
+
+bool CBinaryStateRestoreTraverser::advance() {
+    std::uint8_t type{0};
+    if (this->readByte(type) == false) {
+        return this->fail("unexpected end of input");
+    }
+
+    switch (type) {
+    case CBinaryStatePersistInserter::E_String:
+        m_CurrentIsLevel = false;
+        return this->readString(&m_Name) && this->readString(&m_Value);
+    case CBinaryStatePersistInserter::E_Double: {
+        m_CurrentIsLevel = false;
+        double value;
+        if (this->readString(&m_Name) == false || this->readDouble(value) == false) {
+            return false;
+        }
+        m_Value = CStringUtils::typeToStringPrecise(value, CIEEE754::E_DoublePrecision);
+        return true;
+    }
+    case CBinaryStatePersistInserter::E_NewLevel:
+        m_CurrentIsLevel = true;
+        m_Value.clear();
+        return this->readString(&m_Name);
+    case CBinaryStatePersistInserter::E_EndLevel:
+        m_CurrentIsLevel = false;
+        m_LevelEnded = true;
+        m_Eof = (m_Level == 0);
+        return false;
+    default:
+        break;
+    }
+
+    return this->fail("unknown record type " + CStringUtils::typeToString(type));
+}
+
+bool CBinaryStateRestoreTraverser::skipLevel() {
+    std::size_t depth{1};
+    while (depth > 0) {
+        std::uint8_t type{0};
+        if (this->readByte(type) == false) {
+            return this->fail("unexpected end of input");
+        }
+        switch (type) {
+        case CBinaryStatePersistInserter::E_String:
+            if (this->readString(nullptr) == false || this->readString(nullptr) == false) {
+                return false;
+            }
+            break;
+        case CBinaryStatePersistInserter::E_Double:
+            if (this->readString(nullptr) == false ||
+                this->readRaw(sizeof(double), nullptr) == false) {
+                return false;
+            }
+            break;
+        case CBinaryStatePersistInserter::E_NewLevel:
+            if (this->readString(nullptr) == false) {
+                return false;
+            }
+            ++depth;
+            break;
+        case CBinaryStatePersistInserter::E_EndLevel:
+            --depth;
+            break;
+        default:
+            return this->fail("unknown record type " + CStringUtils::typeToString(type));
+        }
+    }
+    return true;
+}
+
+bool CBinaryStateRestoreTraverser::fillBuffer() {
+    if (m_BufferPos < m_Buffer.size()) {
+        return true;
+    }
+    m_Buffer.resize(READ_SIZE);
+    m_InputStream.read(&m_Buffer[0], static_cast<std::streamsize>(READ_SIZE));
+    m_Buffer.resize(static_cast<std::size_t>(m_InputStream.gcount()));
+    m_BufferPos = 0;
+    return m_Buffer.empty() == false;
+}
+
+bool CBinaryStateRestoreTraverser::readByte(std::uint8_t& value) {
+    if (this->fillBuffer() == false) {
+        return false;
+    }
+    value = static_cast<std::uint8_t>(m_Buffer[m_BufferPos++]);
+    return true;
+}
+
+bool CBinaryStateRestoreTraverser::readVarint(std::size_t& length) {
+    length = 0;
+    for (std::size_t shift = 0; shift < 64; shift += 7) {
+        std::uint8_t byte{0};
+        if (this->readByte(byte) == false) {
+            return this->fail("unexpected end of input");
+        }
+        length |= static_cast<std::size_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return this->fail("bad length");
+}
+
+bool CBinaryStateRestoreTraverser::readString(std::string* value) {
+    std::size_t length{0};
+    return this->readVarint(length) && this->readRaw(length, value);
+}
+
+bool CBinaryStateRestoreTraverser::readDouble(double& value) {
+    char bytes[sizeof(double)];
+    for (auto& byte : bytes) {
+        std::uint8_t byte_{0};
+        if (this->readByte(byte_) == false) {
+            return this->fail("unexpected end of input");
+        }
+        byte = static_cast<char>(byte_);
+    }
+    std::memcpy(&value, bytes, sizeof(double));
+    return true;
+}
+
+bool CBinaryStateRestoreTraverser::readRaw(std::size_t length, std::string* value) {
+    if (value != nullptr) {
+        value->clear();
+    }
+    while (length > 0) {
+        if (this->fillBuffer() == false) {
+            return this->fail("unexpected end of input");
+        }
+        std::size_t n{std::min(length, m_Buffer.size() - m_BufferPos)};
+        if (value != nullptr) {
+            value->append(m_Buffer, m_BufferPos, n);
+        }
+        m_BufferPos += n;
+        length -= n;
+    }
+    return true;
+}
+
+bool CBinaryStateRestoreTraverser::fail(const std::string& reason) {
+    LOG_ERROR(<< "Cannot restore binary state: " << reason);
+    this->setBadState();
+    return false;
+}
+}
+}
@@ -12,16 +12,37 @@
 
 #include <core/CBase64Filter.h>
 #include <core/CLogger.h>
+#include <core/Concurrency.h>
 
+#include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 
+#include <deque>
+#include <future>
 #include <iostream>
+#include <string>
 
 namespace ml {
 namespace core {
+namespace {
+//! The size of the blocks which are compressed in parallel.
+const std::size_t PARALLEL_BLOCK_SIZE{1024 * 1024};
 
-CCompressOStream::CCompressOStream(CStateCompressor::CChunkFilter& filter)
-    : std::ostream(&m_StreamBuf), m_UploadThread(*this, m_StreamBuf, filter) {
+//! Compress \p block as a single gzip member.
+std::string compressBlock(const std::string& block) {
+    std::string result;
+    boost::iostreams::filtering_ostream compressor;
+    compressor.push(boost::iostreams::gzip_compressor());
+    compressor.push(boost::iostreams::back_inserter(result));
+    compressor.write(block.data(), static_cast<std::streamsize>(block.size()));
+    boost::iostreams::close(compressor);
+    return result;
+}
+}
+
+CCompressOStream::CCompressOStream(CStateCompressor::CChunkFilter& filter, bool compressInParallel)
+    : std::ostream(&m_StreamBuf),
+      m_UploadThread(*this, m_StreamBuf, filter, compressInParallel) {
 
     if (m_UploadThread.start() == false) {
         this->setstate(std::ios_base::failbit | std::ios_base::badbit);
@@ -43,9 +64,16 @@ void CCompressOStream::close() {
 
 CCompressOStream::CCompressThread::CCompressThread(CCompressOStream& stream,
                                                    CDualThreadStreamBuf& streamBuf,
-                                                   CStateCompressor::CChunkFilter& filter)
-    : m_Stream(stream), m_StreamBuf(streamBuf), m_FilterSink(filter), m_OutFilter() {
-    m_OutFilter.push(boost::iostreams::gzip_compressor());
+                                                   CStateCompressor::CChunkFilter& filter,
+                                                   bool compressInParallel)
+    : m_Stream(stream), m_StreamBuf(streamBuf), m_FilterSink(filter),
+      m_CompressInParallel(compressInParallel && defaultAsyncThreadPoolSize() > 1),
+      m_OutFilter() {
+    // When compressing in parallel the blocks are gzipped before they're
+    // written to the filter.
+    if (m_CompressInParallel == false) {
+        m_OutFilter.push(boost::iostreams::gzip_compressor());
+    }
     m_OutFilter.push(CBase64Encoder());
     m_OutFilter.push(boost::ref(m_FilterSink));
 }
@@ -53,6 +81,11 @@ CCompressOStream::CCompressThread::CCompressThread(CCompressOStream& stream,
 void CCompressOStream::CCompressThread::run() {
     LOG_TRACE(<< "CompressThread run");
 
+    if (m_CompressInParallel) {
+        this->runInParallel();
+        return;
+    }
+
     char buf[4096];
     std::size_t bytesDone = 0;
     bool closeMe = false;
@@ -72,6 +105,57 @@ void CCompressOStream::CCompressThread::run() {
     boost::iostreams::close(m_OutFilter);
 }
 
+void CCompressOStream::CCompressThread::runInParallel() {
+    using TStrFutureDeque = std::deque<std::future<std::string>>;
+
+    std::size_t maxPendingBlocks{2 * defaultAsyncThreadPoolSize()};
+    TStrFutureDeque pendingBlocks;
+    auto writeNextBlock = [&] {
+        std::string compressed{pendingBlocks.front().get()};
+        pendingBlocks.pop_front();
+        m_OutFilter.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+    };
+
+    char buf[4096];
+    std::string block;
+    block.reserve(PARALLEL_BLOCK_SIZE);
+    std::size_t bytesDone = 0;
+    std::size_t blocksDone = 0;
+    bool closeMe = false;
+    while (closeMe == false) {
+        std::streamsize n = m_StreamBuf.sgetn(buf, 4096);
+        LOG_TRACE(<< "Read from in stream: " << n);
+        if (n != -1) {
+            bytesDone += n;
+            block.append(buf, n);
+        }
+
+        if (m_StreamBuf.endOfFile() && (m_StreamBuf.in_avail() == 0)) {
+            closeMe = true;
+        }
+
+        // Empty input must still be written as one (empty) gzip member.
+        if (block.size() >= PARALLEL_BLOCK_SIZE ||
+            (closeMe && (block.empty() == false || blocksDone == 0))) {
+            if (pendingBlocks.size() >= maxPendingBlocks) {
+                writeNextBlock();
+            }
+            pendingBlocks.push_back(async(defaultAsyncExecutor(), [block_ = std::move(block)] {
+                return compressBlock(block_);
+            }));
+            ++blocksDone;
+            block.clear();
+            block.reserve(PARALLEL_BLOCK_SIZE);
+        }
+    }
+    while (pendingBlocks.empty() == false) {
+        writeNextBlock();
+    }
+    LOG_TRACE(<< "CompressThread complete, written: " << bytesDone
+              << ", bytes in " << blocksDone << " blocks");
+    boost::iostreams::close(m_OutFilter);
+}
+
 void CCompressOStream::CCompressThread::shutdown() {
     m_StreamBuf.signalEndOfFile();
     LOG_TRACE(<< "CompressThread shutdown called");
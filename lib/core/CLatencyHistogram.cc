@@ -0,0 +1,112 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+
+#include <core/CLatencyHistogram.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ml {
+namespace core {
+namespace {
+//! Get the index of the most significant set bit of \p x, which must be
+//! non-zero.
+std::size_t mostSignificantBit(std::uint64_t x) {
+    std::size_t result{0};
+    for (std::size_t shift : {32, 16, 8, 4, 2, 1}) {
+        if ((x >> shift) != 0) {
+            x >>= shift;
+            result += shift;
+        }
+    }
+    return result;
+}
+}
+
+CLatencyHistogram::CLatencyHistogram() : m_Count{0}, m_Total{0}, m_Max{0} {
+    for (auto& count : m_Counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void CLatencyHistogram::record(std::uint64_t value) {
+    m_Counts[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    m_Count.fetch_add(1, std::memory_order_relaxed);
+    m_Total.fetch_add(value, std::memory_order_relaxed);
+    std::uint64_t previousMax{m_Max.load(std::memory_order_relaxed)};
+    while (previousMax < value &&
+           m_Max.compare_exchange_weak(previousMax, value, std::memory_order_relaxed) == false) {
+    }
+}
+
+std::uint64_t CLatencyHistogram::count() const {
+    return m_Count.load(std::memory_order_relaxed);
+}
+
+std::uint64_t CLatencyHistogram::total() const {
+    return m_Total.load(std::memory_order_relaxed);
+}
+
+std::uint64_t CLatencyHistogram::max() const {
+    return m_Max.load(std::memory_order_relaxed);
+}
+
+std::uint64_t CLatencyHistogram::quantile(double q) const {
+    std::uint64_t count{this->count()};
+    if (count == 0) {
+        return 0;
+    }
+    std::uint64_t max{this->max()};
+    q = std::min(std::max(q, 0.0), 1.0);
+    auto rank = std::max(static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count))),
+                         std::uint64_t{1});
+    std::uint64_t cumulative{0};
+    for (std::size_t i = 0; i < m_Counts.size(); ++i) {
+        cumulative += m_Counts[i].load(std::memory_order_relaxed);
+        if (cumulative >= rank) {
+            return std::min(bucketUpperBound(i), max);
+        }
+    }
+    // We can only get here if values were recorded while we were reading.
+    return max;
+}
+
+void CLatencyHistogram::clear() {
+    for (auto& count : m_Counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    m_Count.store(0, std::memory_order_relaxed);
+    m_Total.store(0, std::memory_order_relaxed);
+    m_Max.store(0, std::memory_order_relaxed);
+}
+
+std::size_t CLatencyHistogram::bucket(std::uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return static_cast<std::size_t>(value);
+    }
+    // The top SUB_BUCKET_BITS + 1 bits of the value choose the bucket. The
+    // leading one identifies the power of two and the rest the sub-bucket.
+    std::size_t shift{mostSignificantBit(value) - SUB_BUCKET_BITS};
+    return (shift + 1) * SUB_BUCKET_COUNT +
+           static_cast<std::size_t>((value >> shift) - SUB_BUCKET_COUNT);
+}
+
+std::uint64_t CLatencyHistogram::bucketUpperBound(std::size_t bucket) {
+    if (bucket < SUB_BUCKET_COUNT) {
+        return bucket;
+    }
+    std::size_t shift{bucket / SUB_BUCKET_COUNT - 1};
+    std::uint64_t lower{static_cast<std::uint64_t>(bucket % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT)
+                        << shift};
+    return lower + ((std::uint64_t{1} << shift) - 1);
+}
+}
+}
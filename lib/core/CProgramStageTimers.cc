@@ -0,0 +1,119 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+
+#include <core/CProgramStageTimers.h>
+
+#include <core/CThreadCpuTime.h>
+
+#include <ostream>
+
+namespace ml {
+namespace core {
+
+CProgramStageTimers::CStage::CStage() : m_CpuTime{0} {
+}
+
+void CProgramStageTimers::CStage::record(std::uint64_t elapsedTime, std::uint64_t cpuTime) {
+    m_Latencies.record(elapsedTime);
+    m_CpuTime.fetch_add(cpuTime, std::memory_order_relaxed);
+}
+
+const CLatencyHistogram& CProgramStageTimers::CStage::latencies() const {
+    return m_Latencies;
+}
+
+std::uint64_t CProgramStageTimers::CStage::cpuTime() const {
+    return m_CpuTime.load(std::memory_order_relaxed);
+}
+
+void CProgramStageTimers::CStage::clear() {
+    m_Latencies.clear();
+    m_CpuTime.store(0, std::memory_order_relaxed);
+}
+
+CProgramStageTimers::CScopedTimer::CScopedTimer(stage_t::EStageTypes stage)
+    : m_Stage{nullptr}, m_MeasureCpu{false}, m_StartTime{0}, m_StartCpuTime{0} {
+    if (CProgramStageTimers::enabled()) {
+        m_Stage = &CProgramStageTimers::stage(stage);
+        m_MeasureCpu = ms_Instance.m_StageDefinitions[stage].s_MeasureCpu;
+        m_StartCpuTime = m_MeasureCpu ? CThreadCpuTime::nanoseconds() : 0;
+        m_StartTime = CProgramStageTimers::now();
+    }
+}
+
+CProgramStageTimers::CScopedTimer::~CScopedTimer() {
+    if (m_Stage != nullptr) {
+        std::uint64_t endTime{CProgramStageTimers::now()};
+        std::uint64_t endCpuTime{m_MeasureCpu ? CThreadCpuTime::nanoseconds() : 0};
+        // Guard against the clocks going backwards.
+        m_Stage->record(endTime > m_StartTime ? endTime - m_StartTime : 0,
+                        endCpuTime > m_StartCpuTime ? endCpuTime - m_StartCpuTime : 0);
+    }
+}
+
+CProgramStageTimers CProgramStageTimers::ms_Instance;
+
+CProgramStageTimers::CProgramStageTimers() : m_Enabled{false} {
+}
+
+CProgramStageTimers& CProgramStageTimers::instance() {
+    return ms_Instance;
+}
+
+void CProgramStageTimers::enable(bool enabled) {
+    ms_Instance.m_Enabled.store(enabled);
+}
+
+bool CProgramStageTimers::enabled() {
+    return ms_Instance.m_Enabled.load(std::memory_order_relaxed);
+}
+
+CProgramStageTimers::CStage& CProgramStageTimers::stage(stage_t::EStageTypes stage) {
+    return ms_Instance.m_Stages[stage];
+}
+
+const CProgramStageTimers::TStageDefinitionArray& CProgramStageTimers::definitions() {
+    return ms_Instance.m_StageDefinitions;
+}
+
+void CProgramStageTimers::clear() {
+    for (auto& stage : ms_Instance.m_Stages) {
+        stage.clear();
+    }
+}
+
+std::uint64_t CProgramStageTimers::now() {
+    return ms_Instance.m_Clock.nanoseconds();
+}
+
+std::ostream& operator<<(std::ostream& o, const CProgramStageTimers& timers) {
+    // Elapsed times are printed in microseconds and totals in milliseconds.
+    for (const auto& definition : timers.m_StageDefinitions) {
+        const auto& stage = timers.m_Stages[definition.s_Type];
+        const auto& latencies = stage.latencies();
+        if (latencies.count() == 0) {
+            continue;
+        }
+        o << '\n'
+          << definition.s_Name << ": count = " << latencies.count()
+          << ", total = " << latencies.total() / 1000000 << "ms";
+        if (definition.s_MeasureCpu) {
+            o << ", cpu = " << stage.cpuTime() / 1000000 << "ms";
+        }
+        o << ", p50 = " << latencies.quantile(0.5) / 1000
+          << "us, p90 = " << latencies.quantile(0.9) / 1000
+          << "us, p99 = " << latencies.quantile(0.99) / 1000
+          << "us, max = " << latencies.max() / 1000 << "us";
+    }
+    return o;
+}
+}
+}
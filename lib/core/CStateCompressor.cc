@@ -19,9 +19,9 @@ namespace core {
 const std::string CStateCompressor::COMPRESSED_ATTRIBUTE("compressed");
 const std::string CStateCompressor::END_OF_STREAM_ATTRIBUTE("eos");
 
-CStateCompressor::CStateCompressor(CDataAdder& compressedAdder)
+CStateCompressor::CStateCompressor(CDataAdder& compressedAdder, bool compressInParallel)
     : m_FilterSink(compressedAdder),
-      m_OutStream(std::make_shared<CCompressOStream>(std::ref(m_FilterSink))) {
+      m_OutStream(std::make_shared<CCompressOStream>(std::ref(m_FilterSink), compressInParallel)) {
     LOG_TRACE(<< "New compressor");
 }
 
@@ -72,8 +72,8 @@ bool CStaticThreadPool::busy() const {
     return m_Busy.load();
 }
 
-void CStaticThreadPool::busy(bool value) {
-    m_Busy.store(value);
+bool CStaticThreadPool::busy(bool value) {
+    return m_Busy.exchange(value);
 }
 
 void CStaticThreadPool::shutdown() {
@@ -0,0 +1,34 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+#include <core/CThreadCpuTime.h>
+
+#include <core/CLogger.h>
+
+#include <time.h>
+
+namespace ml {
+namespace core {
+
+std::uint64_t CThreadCpuTime::nanoseconds() {
+    struct timespec ts;
+
+    if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0) {
+        LOG_ERROR(<< "Failed to get reading from thread CPU clock");
+        return 0;
+    }
+
+    std::uint64_t result(static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ULL);
+    result += static_cast<std::uint64_t>(ts.tv_nsec);
+
+    return result;
+}
+}
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+#include <core/CThreadCpuTime.h>
+
+#include <core/CLogger.h>
+#include <core/CWindowsError.h>
+#include <core/WindowsSafe.h>
+
+namespace ml {
+namespace core {
+
+std::uint64_t CThreadCpuTime::nanoseconds() {
+    FILETIME creationTime;
+    FILETIME exitTime;
+    FILETIME kernelTime;
+    FILETIME userTime;
+
+    if (GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime,
+                       &kernelTime, &userTime) == FALSE) {
+        LOG_ERROR(<< "Failed to get thread times: " << CWindowsError());
+        return 0;
+    }
+
+    // The FILETIMEs count 100 nanosecond intervals
+    ULARGE_INTEGER kernel;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    ULARGE_INTEGER user;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+
+    return (static_cast<std::uint64_t>(kernel.QuadPart) +
+            static_cast<std::uint64_t>(user.QuadPart)) *
+           100ULL;
+}
+}
+}
@@ -16,6 +16,7 @@
 #include <core/CStrCaseCmp.h>
 #include <core/CStringUtils.h>
 
+#include <algorithm>
 #include <fstream>
 
 #include <ctype.h>
@@ -87,18 +88,25 @@ const CWordDictionary& CWordDictionary::instance() {
     return *ms_Instance;
 }
 
-bool CWordDictionary::isInDictionary(const std::string& str) const {
-    return m_DictionaryWords.find(str) != m_DictionaryWords.end();
+bool CWordDictionary::isInDictionary(std::string_view str) const {
+    return this->find(str) != m_DictionaryWords.end();
 }
 
-CWordDictionary::EPartOfSpeech CWordDictionary::partOfSpeech(const std::string& str) const {
-    TStrUMapCItr iter = m_DictionaryWords.find(str);
+CWordDictionary::EPartOfSpeech CWordDictionary::partOfSpeech(std::string_view str) const {
+    TStrUMapCItr iter = this->find(str);
     if (iter == m_DictionaryWords.end()) {
         return E_NotInDictionary;
     }
     return iter->second;
 }
 
+CWordDictionary::TStrUMapCItr CWordDictionary::find(std::string_view str) const {
+    if (str.length() > m_MaxWordLength) {
+        return m_DictionaryWords.end();
+    }
+    return m_DictionaryWords.find(str, CStrHashIgnoreCase{}, CStrEqualIgnoreCase{});
+}
+
 CWordDictionary::CWordDictionary() {
     std::string fileToLoad(CResourceLocator::resourceDir() + '/' + DICTIONARY_FILE);
 
@@ -135,6 +143,7 @@ CWordDictionary::CWordDictionary() {
                 continue;
             }
             word.erase(sepPos);
+            m_MaxWordLength = std::max(m_MaxWordLength, word.length());
             m_DictionaryWords[word] = partOfSpeech;
         }
 
@@ -148,21 +157,21 @@ CWordDictionary::~CWordDictionary() {
     ms_Instance = nullptr;
 }
 
-size_t CWordDictionary::CStrHashIgnoreCase::operator()(const std::string& str) const {
+size_t CWordDictionary::CStrHashIgnoreCase::operator()(std::string_view str) const {
     size_t hash(0);
 
-    for (std::string::const_iterator iter = str.begin(); iter != str.end(); ++iter) {
+    for (const char c : str) {
         hash *= 17;
-        hash += ::tolower(*iter);
+        hash += ::tolower(c);
     }
 
     return hash;
 }
 
-bool CWordDictionary::CStrEqualIgnoreCase::operator()(const std::string& lhs,
-                                                      const std::string& rhs) const {
+bool CWordDictionary::CStrEqualIgnoreCase::operator()(std::string_view lhs,
+                                                      std::string_view rhs) const {
     return lhs.length() == rhs.length() &&
-           CStrCaseCmp::strCaseCmp(lhs.c_str(), rhs.c_str()) == 0;
+           CStrCaseCmp::strNCaseCmp(lhs.data(), rhs.data(), lhs.length()) == 0;
 }
 }
 }
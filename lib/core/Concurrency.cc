@@ -26,7 +26,7 @@ class CImmediateExecutor final : public CExecutor {
 public:
     void schedule(std::function<void()>&& f) override { f(); }
     bool busy() const override { return false; }
-    void busy(bool) override {}
+    bool busy(bool) override { return false; }
 };
 
 //! \brief Executes a function in a thread pool.
@@ -38,7 +38,7 @@ public:
         m_ThreadPool.schedule(std::forward<std::function<void()>>(f));
     }
     bool busy() const override { return m_ThreadPool.busy(); }
-    void busy(bool value) override { return m_ThreadPool.busy(value); }
+    bool busy(bool value) override { return m_ThreadPool.busy(value); }
 
 private:
     CStaticThreadPool m_ThreadPool;
@@ -108,6 +108,18 @@ CExecutor& defaultAsyncExecutor() {
     return singletonExecutor.get();
 }
 
+std::unique_ptr<CExecutor> makeThreadPoolExecutor(std::size_t threadPoolSize) {
+    if (threadPoolSize > 1) {
+        try {
+            return std::make_unique<CThreadPoolExecutor>(threadPoolSize);
+        } catch (const std::exception& e) {
+            LOG_ERROR(<< "Failed to create thread pool with '" << e.what()
+                      << "'. Falling back to running single threaded");
+        }
+    }
+    return std::make_unique<CImmediateExecutor>();
+}
+
 bool get_conjunction_of_all(std::vector<std::future<bool>>& futures) {
 
     // This waits until results are present. If we get an exception we still want
@@ -135,10 +147,7 @@ bool get_conjunction_of_all(std::vector<std::future<bool>>& futures) {
 
 namespace concurrency_detail {
 CDefaultAsyncExecutorBusyForScope::CDefaultAsyncExecutorBusyForScope()
-    : m_WasBusy{defaultAsyncExecutor().busy()} {
-    if (m_WasBusy == false) {
-        defaultAsyncExecutor().busy(true);
-    }
+    : m_WasBusy{defaultAsyncExecutor().busy(true)} {
 }
 
 CDefaultAsyncExecutorBusyForScope::~CDefaultAsyncExecutorBusyForScope() {
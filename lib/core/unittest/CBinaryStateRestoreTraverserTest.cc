@@ -0,0 +1,270 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+
+#include <core/CBinaryStatePersistInserter.h>
+#include <core/CBinaryStateRestoreTraverser.h>
+#include <core/CJsonStatePersistInserter.h>
+#include <core/CJsonStateRestoreTraverser.h>
+#include <core/CLogger.h>
+#include <core/CStringUtils.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(CBinaryStateRestoreTraverserTest)
+
+using namespace ml;
+
+namespace {
+
+void persist2ndLevel(core::CStatePersistInserter& inserter) {
+    inserter.insertValue("level2A", 3.14, core::CIEEE754::E_SinglePrecision);
+    inserter.insertValue("level2B", "z");
+}
+
+void persist1stLevel(bool emptySubLevel, core::CStatePersistInserter& inserter) {
+    inserter.insertValue("level1A", "a");
+    inserter.insertValue("level1B", 25);
+    if (emptySubLevel) {
+        inserter.insertLevel("level1C", [](core::CStatePersistInserter&) {});
+    } else {
+        inserter.insertLevel("level1C", &persist2ndLevel);
+    }
+    inserter.insertValue("level1D", "afterAscending");
+}
+
+std::string persistBinary(bool emptySubLevel) {
+    std::ostringstream strm;
+    {
+        core::CBinaryStatePersistInserter inserter(strm);
+        inserter.insertLevel("_source", [emptySubLevel](core::CStatePersistInserter& inserter_) {
+            persist1stLevel(emptySubLevel, inserter_);
+        });
+    }
+    return strm.str();
+}
+
+bool traverse2ndLevel(core::CStateRestoreTraverser& traverser) {
+    BOOST_REQUIRE_EQUAL(std::string("level2A"), traverser.name());
+    double value{0.0};
+    BOOST_TEST_REQUIRE(core::CStringUtils::stringToType(traverser.value(), value));
+    BOOST_REQUIRE_EQUAL(core::CIEEE754::round(3.14, core::CIEEE754::E_SinglePrecision), value);
+    BOOST_TEST_REQUIRE(!traverser.hasSubLevel());
+    BOOST_TEST_REQUIRE(traverser.next());
+    BOOST_REQUIRE_EQUAL(std::string("level2B"), traverser.name());
+    BOOST_REQUIRE_EQUAL(std::string("z"), traverser.value());
+    BOOST_TEST_REQUIRE(!traverser.hasSubLevel());
+    BOOST_TEST_REQUIRE(!traverser.next());
+
+    return true;
+}
+
+bool traverse2ndLevelEmpty(core::CStateRestoreTraverser& traverser) {
+    BOOST_TEST_REQUIRE(traverser.name().empty());
+    BOOST_TEST_REQUIRE(traverser.value().empty());
+    BOOST_TEST_REQUIRE(!traverser.hasSubLevel());
+    BOOST_TEST_REQUIRE(!traverser.next());
+
+    return true;
+}
+
+bool traverse1stLevel(bool emptySubLevel, bool skipSubLevel, core::CStateRestoreTraverser& traverser) {
+    BOOST_REQUIRE_EQUAL(std::string("level1A"), traverser.name());
+    BOOST_REQUIRE_EQUAL(std::string("a"), traverser.value());
+    BOOST_TEST_REQUIRE(!traverser.hasSubLevel());
+    BOOST_TEST_REQUIRE(traverser.next());
+    BOOST_REQUIRE_EQUAL(std::string("level1B"), traverser.name());
+    BOOST_REQUIRE_EQUAL(std::string("25"), traverser.value());
+    BOOST_TEST_REQUIRE(!traverser.hasSubLevel());
+    BOOST_TEST_REQUIRE(traverser.next());
+    BOOST_REQUIRE_EQUAL(std::string("level1C"), traverser.name());
+    BOOST_TEST_REQUIRE(traverser.hasSubLevel());
+    if (skipSubLevel == false) {
+        BOOST_TEST_REQUIRE(traverser.traverseSubLevel(
+            emptySubLevel ? &traverse2ndLevelEmpty : &traverse2ndLevel));
+    }
+    BOOST_TEST_REQUIRE(traverser.next());
+    BOOST_REQUIRE_EQUAL(std::string("level1D"), traverser.name());
+    BOOST_REQUIRE_EQUAL(std::string("afterAscending"), traverser.value());
+    BOOST_TEST_REQUIRE(!traverser.hasSubLevel());
+    BOOST_TEST_REQUIRE(!traverser.next());
+
+    return true;
+}
+
+void restoreAndCheck(bool emptySubLevel, bool skipSubLevel) {
+    std::istringstream strm(persistBinary(emptySubLevel));
+    BOOST_TEST_REQUIRE(core::CBinaryStateRestoreTraverser::isBinaryState(strm));
+
+    core::CBinaryStateRestoreTraverser traverser(strm);
+
+    BOOST_TEST_REQUIRE(!traverser.isEof());
+    BOOST_REQUIRE_EQUAL(std::string("_source"), traverser.name());
+    BOOST_TEST_REQUIRE(traverser.hasSubLevel());
+    BOOST_TEST_REQUIRE(traverser.traverseSubLevel([&](core::CStateRestoreTraverser& traverser_) {
+        return traverse1stLevel(emptySubLevel, skipSubLevel, traverser_);
+    }));
+    BOOST_TEST_REQUIRE(!traverser.next());
+    BOOST_TEST_REQUIRE(traverser.isEof());
+    BOOST_TEST_REQUIRE(!traverser.haveBadState());
+}
+
+//! Copy whatever state \p traverser points at to \p inserter.
+bool copyState(core::CStateRestoreTraverser& traverser, core::CStatePersistInserter& inserter) {
+    do {
+        if (traverser.hasSubLevel()) {
+            std::string name{traverser.name()};
+            bool ok{true};
+            inserter.insertLevel(name, [&](core::CStatePersistInserter& inserter_) {
+                ok = traverser.traverseSubLevel([&](core::CStateRestoreTraverser& traverser_) {
+                    return traverser_.name().empty() || copyState(traverser_, inserter_);
+                });
+            });
+            if (ok == false) {
+                return false;
+            }
+        } else {
+            inserter.insertValue(traverser.name(), traverser.value());
+        }
+    } while (traverser.next());
+    return true;
+}
+}
+
+BOOST_AUTO_TEST_CASE(testRestore) {
+    restoreAndCheck(false, false);
+}
+
+BOOST_AUTO_TEST_CASE(testRestoreEmptySubLevel) {
+    restoreAndCheck(true, false);
+}
+
+BOOST_AUTO_TEST_CASE(testRestoreSkippingSubLevel) {
+    restoreAndCheck(false, true);
+}
+
+BOOST_AUTO_TEST_CASE(testIsBinaryState) {
+    std::istringstream json("{\"a\":\"1\"}");
+    BOOST_TEST_REQUIRE(!core::CBinaryStateRestoreTraverser::isBinaryState(json));
+    // Detection mustn't consume input
+    core::CJsonStateRestoreTraverser traverser(json);
+    BOOST_REQUIRE_EQUAL(std::string("a"), traverser.name());
+    BOOST_REQUIRE_EQUAL(std::string("1"), traverser.value());
+
+    std::istringstream binary(persistBinary(false));
+    BOOST_TEST_REQUIRE(core::CBinaryStateRestoreTraverser::isBinaryState(binary));
+}
+
+BOOST_AUTO_TEST_CASE(testBadState) {
+    std::istringstream json("{\"a\":\"1\"}");
+    core::CBinaryStateRestoreTraverser jsonTraverser(json);
+    BOOST_TEST_REQUIRE(jsonTraverser.name().empty());
+    BOOST_TEST_REQUIRE(jsonTraverser.haveBadState());
+
+    std::string state{persistBinary(false)};
+    std::istringstream truncated(state.substr(0, state.size() - 20));
+    core::CBinaryStateRestoreTraverser truncatedTraverser(truncated);
+    BOOST_TEST_REQUIRE(!truncatedTraverser.traverseSubLevel(
+        [](core::CStateRestoreTraverser& traverser) {
+            while (traverser.next()) {
+            }
+            return true;
+        }));
+    BOOST_TEST_REQUIRE(truncatedTraverser.haveBadState());
+}
+
+BOOST_AUTO_TEST_CASE(testLargeStateMatchesJson) {
+
+    // Check state spanning many buffers restores to the same values as the
+    // equivalent JSON state.
+
+    auto persist = [](core::CStatePersistInserter& inserter) {
+        for (std::size_t i = 0; i < 5000; ++i) {
+            inserter.insertLevel("l", [i](core::CStatePersistInserter& inserter_) {
+                inserter_.insertValue("i", i);
+                inserter_.insertValue("s", std::string(i % 300, 'x'));
+                inserter_.insertValue("d", 1.0 / static_cast<double>(i + 3),
+                                      core::CIEEE754::E_DoublePrecision);
+                inserter_.insertValue("f", 1e-3 * static_cast<double>(i),
+                                      core::CIEEE754::E_SinglePrecision);
+                inserter_.insertValue("h", -1e300 * static_cast<double>(i),
+                                      core::CIEEE754::E_HalfPrecision);
+            });
+        }
+    };
+
+    std::ostringstream jsonStrm;
+    {
+        core::CJsonStatePersistInserter inserter(jsonStrm);
+        persist(inserter);
+    }
+    std::ostringstream binaryStrm;
+    {
+        core::CBinaryStatePersistInserter inserter(binaryStrm);
+        persist(inserter);
+    }
+    LOG_DEBUG(<< "JSON size = " << jsonStrm.str().size()
+              << ", binary size = " << binaryStrm.str().size());
+    BOOST_TEST_REQUIRE(binaryStrm.str().size() < jsonStrm.str().size());
+
+    auto values = [](core::CStateRestoreTraverser& traverser) {
+        std::vector<double> result;
+        do {
+            BOOST_TEST_REQUIRE(traverser.traverseSubLevel([&](core::CStateRestoreTraverser& traverser_) {
+                do {
+                    if (traverser_.name() != "s") {
+                        double value;
+                        BOOST_TEST_REQUIRE(core::CStringUtils::stringToType(
+                            traverser_.value(), value));
+                        result.push_back(value);
+                    }
+                } while (traverser_.next());
+                return true;
+            }));
+        } while (traverser.next());
+        return result;
+    };
+
+    // Reduced precision values are restored exactly as rounded from binary
+    // state, but JSON state only holds enough digits to get close to that.
+    auto assertClose = [](const std::vector<double>& expected,
+                          const std::vector<double>& actual) {
+        BOOST_REQUIRE_EQUAL(expected.size(), actual.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            BOOST_REQUIRE_CLOSE_FRACTION(expected[i], actual[i], 1e-4);
+        }
+    };
+
+    std::istringstream jsonIn(jsonStrm.str());
+    core::CJsonStateRestoreTraverser jsonTraverser(jsonIn);
+    std::istringstream binaryIn(binaryStrm.str());
+    core::CBinaryStateRestoreTraverser binaryTraverser(binaryIn);
+    assertClose(values(jsonTraverser), values(binaryTraverser));
+
+    // Converting the binary state to JSON gives the same structure
+    std::istringstream binaryIn2(binaryStrm.str());
+    core::CBinaryStateRestoreTraverser binaryTraverser2(binaryIn2);
+    std::ostringstream convertedStrm;
+    {
+        core::CJsonStatePersistInserter inserter(convertedStrm);
+        BOOST_TEST_REQUIRE(copyState(binaryTraverser2, inserter));
+    }
+    std::istringstream convertedIn(convertedStrm.str());
+    core::CJsonStateRestoreTraverser convertedTraverser(convertedIn);
+    std::istringstream jsonIn2(jsonStrm.str());
+    core::CJsonStateRestoreTraverser jsonTraverser2(jsonIn2);
+    assertClose(values(jsonTraverser2), values(convertedTraverser));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -17,9 +17,13 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <exception>
+#include <future>
 #include <numeric>
+#include <thread>
 #include <vector>
 
 BOOST_AUTO_TEST_SUITE(CConcurrencyTest)
@@ -264,6 +268,103 @@ BOOST_AUTO_TEST_CASE(testParallelForEachReentry) {
     core::stopDefaultAsyncExecutor();
 }
 
+BOOST_AUTO_TEST_CASE(testParallelForEachConcurrentCallers) {
+
+    // Test that only one of several threads calling parallel_for_each at once
+    // marks the default executor busy, so nested calls can't deadlock.
+
+    core::startDefaultAsyncExecutor(4);
+
+    BOOST_REQUIRE_EQUAL(false, core::defaultAsyncExecutor().busy(true));
+    BOOST_REQUIRE_EQUAL(true, core::defaultAsyncExecutor().busy(true));
+    BOOST_REQUIRE_EQUAL(true, core::defaultAsyncExecutor().busy(false));
+    BOOST_REQUIRE_EQUAL(false, core::defaultAsyncExecutor().busy());
+
+    double expected{};
+    TIntVecVec values;
+    {
+        TIntVec element(10);
+        std::iota(element.begin(), element.end(), 0.0);
+        expected = 20.0 * std::accumulate(element.begin(), element.end(), 0.0);
+        values.resize(20, element);
+    }
+
+    std::vector<double> actuals(8, 0.0);
+    std::vector<std::thread> callers;
+    for (std::size_t i = 0; i < actuals.size(); ++i) {
+        callers.emplace_back([&values, &actuals, i] {
+            for (std::size_t t = 0; t < 20; ++t) {
+                auto results = core::parallel_for_each(
+                    values.begin(), values.end(),
+                    core::bindRetrievableState(
+                        [](double& sum, const TIntVec& element) {
+                            sum += parallelSum(element);
+                        },
+                        0.0));
+                double actual{0.0};
+                for (const auto& result : results) {
+                    actual += result.s_FunctionState;
+                }
+                actuals[i] += actual;
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+
+    for (auto actual : actuals) {
+        BOOST_REQUIRE_EQUAL(20.0 * expected, actual);
+    }
+    BOOST_REQUIRE_EQUAL(false, core::defaultAsyncExecutor().busy());
+
+    core::stopDefaultAsyncExecutor();
+}
+
+BOOST_AUTO_TEST_CASE(testThreadPoolExecutor) {
+
+    // Test that an executor with its own thread pool runs tasks concurrently
+    // while the default executor is busy and that it doesn't mark the default
+    // executor busy.
+
+    core::startDefaultAsyncExecutor(2);
+
+    // The pool is never bigger than the hardware supports.
+    std::size_t threads{std::min(std::size_t{std::thread::hardware_concurrency()},
+                                 std::size_t{3})};
+    auto executor = core::makeThreadPoolExecutor(threads);
+
+    bool wasDefaultBusy{false};
+    bool wereConcurrent{false};
+    core::parallel_for_each(std::size_t{0}, std::size_t{1}, [&](std::size_t) {
+        wasDefaultBusy = core::defaultAsyncExecutor().busy();
+
+        std::atomic_size_t started{0};
+        std::vector<std::future<bool>> finished;
+        for (std::size_t i = 0; i < threads; ++i) {
+            finished.push_back(core::async(*executor, [&started, threads] {
+                // This only succeeds if all the tasks run at the same time.
+                started.fetch_add(1);
+                for (std::size_t j = 0; j < 10000 && started.load() < threads; ++j) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+                }
+                return started.load() == threads;
+            }));
+        }
+        wereConcurrent = core::get_conjunction_of_all(finished);
+    });
+    BOOST_REQUIRE_EQUAL(true, wasDefaultBusy);
+    BOOST_REQUIRE_EQUAL(true, wereConcurrent);
+    BOOST_REQUIRE_EQUAL(false, core::defaultAsyncExecutor().busy());
+
+    // Small pools execute in the thread which schedules the task.
+    auto immediate = core::makeThreadPoolExecutor(1);
+    auto id = core::async(*immediate, [] { return std::this_thread::get_id(); });
+    BOOST_REQUIRE_EQUAL(std::this_thread::get_id(), id.get());
+
+    core::stopDefaultAsyncExecutor();
+}
+
 BOOST_AUTO_TEST_CASE(testParallelForEachFunctionVector) {
 
     // Test we get identical results if we supply a number of threads and single
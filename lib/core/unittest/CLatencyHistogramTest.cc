@@ -0,0 +1,153 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+
+#include <core/CLatencyHistogram.h>
+#include <core/CLogger.h>
+
+#include <test/CRandomNumbers.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(CLatencyHistogramTest)
+
+using namespace ml;
+
+namespace {
+using TDoubleVec = std::vector<double>;
+using TUInt64Vec = std::vector<std::uint64_t>;
+}
+
+BOOST_AUTO_TEST_CASE(testBuckets) {
+    // Check that every value is no more than its bucket's upper bound, is
+    // greater than the previous bucket's and that the relative width of the
+    // buckets which hold more than one value is bounded.
+
+    using TUInt64Limits = std::numeric_limits<std::uint64_t>;
+
+    TUInt64Vec values;
+    for (std::uint64_t value = 0; value < 10000; ++value) {
+        values.push_back(value);
+    }
+    for (std::size_t shift = 14; shift < 64; ++shift) {
+        std::uint64_t power{std::uint64_t{1} << shift};
+        for (std::uint64_t value : {power - 1, power, power + 1, power + (power >> 1)}) {
+            values.push_back(value);
+        }
+    }
+    values.push_back(TUInt64Limits::max());
+
+    double maxRelativeWidth{0.0};
+    for (auto value : values) {
+        std::size_t bucket{core::CLatencyHistogram::bucket(value)};
+        BOOST_TEST_REQUIRE(bucket < core::CLatencyHistogram::NUMBER_BUCKETS);
+        std::uint64_t upper{core::CLatencyHistogram::bucketUpperBound(bucket)};
+        BOOST_TEST_REQUIRE(value <= upper);
+        if (bucket > 0) {
+            std::uint64_t lower{core::CLatencyHistogram::bucketUpperBound(bucket - 1)};
+            BOOST_TEST_REQUIRE(value > lower);
+            if (upper - lower > 1) {
+                maxRelativeWidth = std::max(maxRelativeWidth,
+                                            static_cast<double>(upper - lower) /
+                                                static_cast<double>(lower + 1));
+            }
+        }
+    }
+    LOG_DEBUG(<< "max relative width = " << maxRelativeWidth);
+    BOOST_TEST_REQUIRE(maxRelativeWidth <= 1.0 / core::CLatencyHistogram::SUB_BUCKET_COUNT);
+
+    BOOST_REQUIRE_EQUAL(core::CLatencyHistogram::NUMBER_BUCKETS - 1,
+                        core::CLatencyHistogram::bucket(TUInt64Limits::max()));
+    BOOST_REQUIRE_EQUAL(TUInt64Limits::max(), core::CLatencyHistogram::bucketUpperBound(
+                                                  core::CLatencyHistogram::NUMBER_BUCKETS - 1));
+}
+
+BOOST_AUTO_TEST_CASE(testQuantiles) {
+    // Test the quantiles of log-normally distributed latencies against the
+    // exact values.
+
+    test::CRandomNumbers rng;
+
+    core::CLatencyHistogram histogram;
+    BOOST_REQUIRE_EQUAL(0, histogram.count());
+    BOOST_REQUIRE_EQUAL(0, histogram.quantile(0.5));
+
+    TDoubleVec samples;
+    rng.generateLogNormalSamples(10.0, 4.0, 100000, samples);
+
+    TUInt64Vec values;
+    std::uint64_t total{0};
+    for (auto sample : samples) {
+        values.push_back(static_cast<std::uint64_t>(sample));
+        histogram.record(values.back());
+        total += values.back();
+    }
+    std::sort(values.begin(), values.end());
+
+    BOOST_REQUIRE_EQUAL(values.size(), histogram.count());
+    BOOST_REQUIRE_EQUAL(total, histogram.total());
+    BOOST_REQUIRE_EQUAL(values.back(), histogram.max());
+    BOOST_REQUIRE_EQUAL(values.back(), histogram.quantile(1.0));
+
+    for (double q : {0.0, 0.1, 0.5, 0.9, 0.99, 0.999}) {
+        std::size_t rank{std::max(
+            static_cast<std::size_t>(std::ceil(q * static_cast<double>(values.size()))),
+            std::size_t{1})};
+        double expected{static_cast<double>(values[rank - 1])};
+        double actual{static_cast<double>(histogram.quantile(q))};
+        LOG_DEBUG(<< "q = " << q << ", expected = " << expected << ", actual = " << actual);
+        BOOST_TEST_REQUIRE(actual >= expected);
+        BOOST_TEST_REQUIRE(actual <= expected * (1.0 + 1.0 / core::CLatencyHistogram::SUB_BUCKET_COUNT));
+    }
+
+    histogram.clear();
+    BOOST_REQUIRE_EQUAL(0, histogram.count());
+    BOOST_REQUIRE_EQUAL(0, histogram.total());
+    BOOST_REQUIRE_EQUAL(0, histogram.max());
+    BOOST_REQUIRE_EQUAL(0, histogram.quantile(0.99));
+}
+
+BOOST_AUTO_TEST_CASE(testConcurrentRecording) {
+    // Check we don't lose any values recorded from several threads.
+
+    core::CLatencyHistogram histogram;
+
+    std::size_t numberThreads{4};
+    std::uint64_t numberValues{50000};
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < numberThreads; ++i) {
+        threads.emplace_back([&histogram, i, numberValues] {
+            for (std::uint64_t value = 1; value <= numberValues; ++value) {
+                histogram.record(value * (i + 1));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::uint64_t expectedTotal{0};
+    for (std::size_t i = 0; i < numberThreads; ++i) {
+        expectedTotal += (i + 1) * numberValues * (numberValues + 1) / 2;
+    }
+    BOOST_REQUIRE_EQUAL(numberThreads * numberValues, histogram.count());
+    BOOST_REQUIRE_EQUAL(expectedTotal, histogram.total());
+    BOOST_REQUIRE_EQUAL(numberThreads * numberValues, histogram.max());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,110 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+
+#include <core/CLogger.h>
+#include <core/CProgramStageTimers.h>
+#include <core/CThreadCpuTime.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(CProgramStageTimersTest)
+
+using namespace ml;
+
+namespace {
+using TStageTimers = core::CProgramStageTimers;
+
+//! Keep the thread busy for at least \p nanoseconds of CPU time.
+void spin(std::uint64_t nanoseconds) {
+    std::uint64_t start{core::CThreadCpuTime::nanoseconds()};
+    while (core::CThreadCpuTime::nanoseconds() - start < nanoseconds) {
+    }
+}
+
+//! Restores the stage timers to their default state.
+class CStageTimersFixture {
+public:
+    CStageTimersFixture() { TStageTimers::clear(); }
+    ~CStageTimersFixture() {
+        TStageTimers::enable(false);
+        TStageTimers::clear();
+    }
+};
+}
+
+BOOST_FIXTURE_TEST_CASE(testDisabled, CStageTimersFixture) {
+    BOOST_TEST_REQUIRE(TStageTimers::enabled() == false);
+    {
+        TStageTimers::CScopedTimer timer{stage_t::E_TSADOutputResults};
+        spin(1000000);
+    }
+    BOOST_REQUIRE_EQUAL(0, TStageTimers::stage(stage_t::E_TSADOutputResults).latencies().count());
+    BOOST_REQUIRE_EQUAL(0, TStageTimers::stage(stage_t::E_TSADOutputResults).cpuTime());
+}
+
+BOOST_FIXTURE_TEST_CASE(testTiming, CStageTimersFixture) {
+    TStageTimers::enable(true);
+
+    // Nested stages are recorded independently.
+    {
+        TStageTimers::CScopedTimer outer{stage_t::E_TSADOutputResults};
+        for (std::size_t i = 0; i < 3; ++i) {
+            TStageTimers::CScopedTimer inner{stage_t::E_TSADSampleModels};
+            spin(2000000);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    const auto& outer = TStageTimers::stage(stage_t::E_TSADOutputResults);
+    const auto& inner = TStageTimers::stage(stage_t::E_TSADSampleModels);
+    LOG_DEBUG(<< "outer: elapsed = " << outer.latencies().total()
+              << ", cpu = " << outer.cpuTime());
+    LOG_DEBUG(<< "inner: elapsed = " << inner.latencies().total()
+              << ", cpu = " << inner.cpuTime());
+
+    BOOST_REQUIRE_EQUAL(1, outer.latencies().count());
+    BOOST_REQUIRE_EQUAL(3, inner.latencies().count());
+
+    // The outer stage's elapsed time includes the sleep but its CPU time
+    // doesn't.
+    BOOST_TEST_REQUIRE(inner.cpuTime() >= 6000000);
+    BOOST_TEST_REQUIRE(inner.latencies().total() >= inner.cpuTime());
+    BOOST_TEST_REQUIRE(outer.cpuTime() >= inner.cpuTime());
+    BOOST_TEST_REQUIRE(outer.latencies().total() >= inner.latencies().total() + 50000000);
+    BOOST_TEST_REQUIRE(outer.cpuTime() < outer.latencies().total() - 40000000);
+
+    // We don't read the CPU clock for handling records.
+    {
+        TStageTimers::CScopedTimer timer{stage_t::E_TSADHandleRecord};
+        spin(1000000);
+    }
+    BOOST_REQUIRE_EQUAL(
+        1, TStageTimers::stage(stage_t::E_TSADHandleRecord).latencies().count());
+    BOOST_REQUIRE_EQUAL(0, TStageTimers::stage(stage_t::E_TSADHandleRecord).cpuTime());
+
+    std::ostringstream dump;
+    dump << TStageTimers::instance();
+    LOG_DEBUG(<< "dump = " << dump.str());
+    BOOST_TEST_REQUIRE(dump.str().find("handle_record: count = 1") != std::string::npos);
+    BOOST_TEST_REQUIRE(dump.str().find("sample_models: count = 3") != std::string::npos);
+    BOOST_TEST_REQUIRE(dump.str().find("persist_state") == std::string::npos);
+
+    TStageTimers::clear();
+    BOOST_REQUIRE_EQUAL(0, outer.latencies().count());
+    BOOST_REQUIRE_EQUAL(0, inner.cpuTime());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
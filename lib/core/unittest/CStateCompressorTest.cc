@@ -14,6 +14,8 @@
 #include <core/CLogger.h>
 #include <core/CStateCompressor.h>
 #include <core/CStateDecompressor.h>
+#include <core/CStopWatch.h>
+#include <core/Concurrency.h>
 
 #include <boost/generator_iterator.hpp>
 #include <boost/random.hpp>
@@ -301,4 +303,64 @@ BOOST_AUTO_TEST_CASE(testChunking) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(testParallelCompression) {
+    // Check that data compressed in parallel blocks round trips, including
+    // sizes either side of the block size, and compare the throughput with
+    // compressing in a single thread.
+
+    auto compressAndDecompress = [](bool compressInParallel, const std::string& data,
+                                    std::size_t& numDocs, std::uint64_t& compressTime) {
+        CMockDataAdder adder(3000000);
+        {
+            ml::core::CStopWatch watch{true};
+            ml::core::CStateCompressor compressor(adder, compressInParallel);
+            ml::core::CDataAdder::TOStreamP strm = compressor.addStreamed("");
+            strm->write(data.data(), static_cast<std::streamsize>(data.size()));
+            BOOST_TEST_REQUIRE(compressor.streamComplete(strm, true));
+            compressTime = watch.stop();
+            numDocs = compressor.numCompressedDocs();
+        }
+        CMockDataSearcher searcher(adder);
+        ml::core::CStateDecompressor decompressor(searcher);
+        ml::core::CDataSearcher::TIStreamP strm = decompressor.search(1, 1);
+        std::istreambuf_iterator<char> eos;
+        return std::string(std::istreambuf_iterator<char>(*strm), eos);
+    };
+
+    ml::core::startDefaultAsyncExecutor(4);
+
+    TRandom rng(1849434026ul);
+    TGenerator generator(rng, TDistribution(0, 254));
+    TGeneratorItr randItr(&generator);
+
+    std::size_t numDocs;
+    std::uint64_t compressTime;
+    for (std::size_t size : {0, 1, 1048575, 1048576, 1048577, 5000000}) {
+        std::string data;
+        for (std::size_t i = 0; i < size; ++i) {
+            data += char(*randItr++);
+        }
+        BOOST_REQUIRE_EQUAL(data, compressAndDecompress(true, data, numDocs, compressTime));
+    }
+
+    // A model state sized document.
+    std::ostringstream state;
+    {
+        CJsonStatePersistInserter inserter(state);
+        insert1stLevel(inserter, 20000);
+    }
+
+    std::size_t serialNumDocs;
+    std::uint64_t serialCompressTime;
+    BOOST_REQUIRE_EQUAL(state.str(), compressAndDecompress(false, state.str(), serialNumDocs,
+                                                           serialCompressTime));
+    BOOST_REQUIRE_EQUAL(state.str(), compressAndDecompress(true, state.str(),
+                                                           numDocs, compressTime));
+    LOG_INFO(<< "Compressed " << state.str().size() << " bytes to " << serialNumDocs
+             << " documents in " << serialCompressTime << "ms in serial and to "
+             << numDocs << " documents in " << compressTime << "ms in parallel");
+
+    ml::core::stopDefaultAsyncExecutor();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -15,6 +15,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <string>
+#include <string_view>
+
 BOOST_AUTO_TEST_SUITE(CWordDictionaryTest)
 
 BOOST_AUTO_TEST_CASE(testLookups) {
@@ -58,6 +61,26 @@ BOOST_AUTO_TEST_CASE(testPartOfSpeech) {
                         dict.partOfSpeech("a"));
 }
 
+BOOST_AUTO_TEST_CASE(testSubstringLookups) {
+    const ml::core::CWordDictionary& dict = ml::core::CWordDictionary::instance();
+
+    // Views into a larger string must only match the characters they cover.
+    std::string message{"Houses COMPLETED without helloworld"};
+    std::string_view view{message};
+
+    BOOST_REQUIRE_EQUAL(ml::core::CWordDictionary::E_Plural,
+                        dict.partOfSpeech(view.substr(0, 6)));
+    BOOST_REQUIRE_EQUAL(ml::core::CWordDictionary::E_Noun,
+                        dict.partOfSpeech(view.substr(0, 5)));
+    BOOST_REQUIRE_EQUAL(ml::core::CWordDictionary::E_Verb,
+                        dict.partOfSpeech(view.substr(7, 9)));
+    BOOST_REQUIRE_EQUAL(ml::core::CWordDictionary::E_Preposition,
+                        dict.partOfSpeech(view.substr(17, 7)));
+    BOOST_TEST_REQUIRE(dict.isInDictionary(view.substr(25, 5)));
+    BOOST_TEST_REQUIRE(!dict.isInDictionary(view.substr(25)));
+    BOOST_TEST_REQUIRE(!dict.isInDictionary(view));
+}
+
 BOOST_AUTO_TEST_CASE(testWeightingFunctors) {
     {
         ml::core::CWordDictionary::TWeightAll2 weighter;
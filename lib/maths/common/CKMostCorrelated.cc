@@ -20,6 +20,7 @@
 #include <maths/common/CBasicStatisticsPersist.h>
 #include <maths/common/CChecksum.h>
 #include <maths/common/CLinearAlgebra.h>
+#include <maths/common/CLinearAlgebraEigen.h>
 #include <maths/common/CLinearAlgebraPersist.h>
 #include <maths/common/CSampling.h>
 #include <maths/common/CTools.h>
@@ -49,6 +50,25 @@ using TSizeSizePrUSet = boost::unordered_set<TSizeSizePr>;
 using TPoint = std::array<double, CKMostCorrelated::NUMBER_PROJECTIONS>;
 using TPointSizePr = std::pair<TPoint, std::size_t>;
 using TPointSizePrVec = std::vector<TPointSizePr>;
+using TSizeVec = std::vector<std::size_t>;
+using TSizeVecVec = std::vector<TSizeVec>;
+using TProjectionVector =
+    Eigen::Matrix<double, static_cast<int>(CKMostCorrelated::NUMBER_PROJECTIONS), 1>;
+using TAlignedProjectionMap = Eigen::Map<TProjectionVector, Eigen::Aligned16>;
+using TConstAlignedProjectionMap = Eigen::Map<const TProjectionVector, Eigen::Aligned16>;
+
+//! Get the sign hash of \p point using \p bits components starting at
+//! \p offset.
+//!
+//! \note Since each component is a random projection of the residuals
+//! this is a random hyperplane hash of the point.
+std::size_t signHash(const TPoint& point, std::size_t offset, std::size_t bits) {
+    std::size_t result{0};
+    for (std::size_t i = 0; i < bits; ++i) {
+        result = (result << 1) | (point[(offset + i) % point.size()] < 0.0 ? 1 : 0);
+    }
+    return result;
+}
 
 //! \brief Unary predicate to check variables, corresponding
 //! to labeled points, are not equal to a specified variable.
@@ -113,6 +133,13 @@ const std::string X_TAG("b");
 const std::string Y_TAG("c");
 
 const double MINIMUM_FREQUENCY = 0.25;
+const std::size_t NO_BLOCK{std::numeric_limits<std::size_t>::max()};
+//! The number of hash tables used to seed the neighbourhood search.
+const std::size_t NUMBER_HASH_TABLES{3};
+//! The target mean number of points per hash bucket.
+const std::size_t TARGET_BUCKET_SIZE{8};
+//! The maximum number of bucket members to compare with each seed.
+const std::size_t MAXIMUM_BUCKET_COMPARISONS{16};
 
 } // unnamed::
 
@@ -125,18 +152,21 @@ CKMostCorrelated::CKMostCorrelated(std::size_t k, double decayRate, bool initial
 
 bool CKMostCorrelated::acceptRestoreTraverser(core::CStateRestoreTraverser& traverser) {
     m_Projections.clear();
+    m_CurrentBlocks.clear();
+    m_CurrentVariables.clear();
     m_CurrentProjected.clear();
     m_Projected.clear();
     m_Moments.clear();
     m_MostCorrelated.clear();
 
+    TSizeVectorUMap currentProjected;
     do {
         const std::string& name = traverser.name();
         RESTORE(RNG_TAG, m_Rng.fromString(traverser.value()))
         RESTORE(PROJECTIONS_TAG,
                 core::CPersistUtils::restore(PROJECTIONS_TAG, m_Projections, traverser))
         RESTORE(CURRENT_PROJECTED_TAG,
-                core::CPersistUtils::restore(CURRENT_PROJECTED_TAG, m_CurrentProjected, traverser))
+                core::CPersistUtils::restore(CURRENT_PROJECTED_TAG, currentProjected, traverser))
         RESTORE(PROJECTED_TAG,
                 core::CPersistUtils::restore(PROJECTED_TAG, m_Projected, traverser))
         RESTORE_BUILT_IN(MAXIMUM_COUNT_TAG, m_MaximumCount)
@@ -145,13 +175,17 @@ bool CKMostCorrelated::acceptRestoreTraverser(core::CStateRestoreTraverser& trav
                 core::CPersistUtils::restore(MOST_CORRELATED_TAG, m_MostCorrelated, traverser))
     } while (traverser.next());
 
+    m_CurrentBlocks.assign(m_Moments.size(), NO_BLOCK);
+    this->currentProjected(currentProjected);
+    this->initializeCurrentProjection();
+
     return true;
 }
 
 void CKMostCorrelated::acceptPersistInserter(core::CStatePersistInserter& inserter) const {
     inserter.insertValue(RNG_TAG, m_Rng.toString());
     core::CPersistUtils::persist(PROJECTIONS_TAG, m_Projections, inserter);
-    core::CPersistUtils::persist(CURRENT_PROJECTED_TAG, m_CurrentProjected, inserter);
+    core::CPersistUtils::persist(CURRENT_PROJECTED_TAG, this->currentProjected(), inserter);
     core::CPersistUtils::persist(PROJECTED_TAG, m_Projected, inserter);
     inserter.insertValue(MAXIMUM_COUNT_TAG, m_MaximumCount);
     core::CPersistUtils::persist(MOMENTS_TAG, m_Moments, inserter);
@@ -215,6 +249,7 @@ void CKMostCorrelated::correlations(std::size_t n, TDoubleVec& result) const {
 
 void CKMostCorrelated::addVariables(std::size_t n) {
     core::CAllocationStrategy::resize(m_Moments, std::max(n, m_Moments.size()));
+    m_CurrentBlocks.resize(m_Moments.size(), NO_BLOCK);
 }
 
 void CKMostCorrelated::removeVariables(const TSizeVec& remove) {
@@ -243,13 +278,19 @@ void CKMostCorrelated::add(std::size_t X, double x) {
 
     TMeanVarAccumulator& moments = m_Moments[X];
     moments.add(x);
-    TVector projected(0.0);
     if (CBasicStatistics::count(moments) > 2.0) {
         double m = CBasicStatistics::mean(moments);
         double sd = std::sqrt(CBasicStatistics::variance(moments));
         if (sd > 10.0 * std::numeric_limits<double>::epsilon() * std::fabs(m)) {
-            projected = m_Projections.back() * (x - m) / sd;
-            m_CurrentProjected[X] += projected;
+            std::size_t& block = m_CurrentBlocks[X];
+            if (block == NO_BLOCK) {
+                block = m_CurrentVariables.size();
+                m_CurrentVariables.push_back(X);
+                m_CurrentProjected.resize(m_CurrentProjected.size() + NUMBER_PROJECTIONS, 0.0);
+            }
+            TAlignedProjectionMap projected{&m_CurrentProjected[block * NUMBER_PROJECTIONS]};
+            TConstAlignedProjectionMap projection{m_CurrentProjection.data()};
+            projected.noalias() += ((x - m) / sd) * projection;
         }
     }
 }
@@ -257,9 +298,8 @@ void CKMostCorrelated::add(std::size_t X, double x) {
 void CKMostCorrelated::capture() {
     m_MaximumCount += 1.0;
 
-    for (TSizeVectorUMapCItr i = m_CurrentProjected.begin();
-         i != m_CurrentProjected.end(); ++i) {
-        std::size_t X = i->first;
+    for (std::size_t i = 0; i < m_CurrentVariables.size(); ++i) {
+        std::size_t X = m_CurrentVariables[i];
         TSizeVectorPackedBitVectorPrUMapItr j = m_Projected.find(X);
         if (j == m_Projected.end()) {
             TVector zero(0.0);
@@ -270,16 +310,26 @@ void CKMostCorrelated::capture() {
                              boost::make_tuple(X), boost::make_tuple(zero, indicator))
                     .first;
         }
-        j->second.first += i->second;
+        auto block = m_CurrentProjected.begin() + i * NUMBER_PROJECTIONS;
+        j->second.first += TVector(block, block + NUMBER_PROJECTIONS);
     }
     for (TSizeVectorPackedBitVectorPrUMapItr i = m_Projected.begin();
          i != m_Projected.end(); ++i) {
-        i->second.second.extend(m_CurrentProjected.count(i->first) > 0);
+        std::size_t X = i->first;
+        i->second.second.extend(X < m_CurrentBlocks.size() &&
+                                m_CurrentBlocks[X] != NO_BLOCK);
     }
 
-    m_Projections.pop_back();
+    // Only the blocks of the variables which received values need resetting.
+    for (auto X : m_CurrentVariables) {
+        m_CurrentBlocks[X] = NO_BLOCK;
+    }
+    m_CurrentVariables.clear();
     m_CurrentProjected.clear();
 
+    m_Projections.pop_back();
+    this->initializeCurrentProjection();
+
     if (m_Projections.empty()) {
         LOG_TRACE(<< "# projections = " << m_Projected.size());
 
@@ -359,7 +409,7 @@ uint64_t CKMostCorrelated::checksum(uint64_t seed) const {
     seed = CChecksum::calculate(seed, m_K);
     seed = CChecksum::calculate(seed, m_DecayRate);
     seed = CChecksum::calculate(seed, m_Projections);
-    seed = CChecksum::calculate(seed, m_CurrentProjected);
+    seed = CChecksum::calculate(seed, this->currentProjected());
     seed = CChecksum::calculate(seed, m_Projected);
     seed = CChecksum::calculate(seed, m_MaximumCount);
     seed = CChecksum::calculate(seed, m_Moments);
@@ -369,6 +419,9 @@ uint64_t CKMostCorrelated::checksum(uint64_t seed) const {
 void CKMostCorrelated::debugMemoryUsage(const core::CMemoryUsage::TMemoryUsagePtr& mem) const {
     mem->setName("CKMostCorrelated");
     core::CMemoryDebug::dynamicSize("m_Projections", m_Projections, mem);
+    core::CMemoryDebug::dynamicSize("m_CurrentProjection", m_CurrentProjection, mem);
+    core::CMemoryDebug::dynamicSize("m_CurrentBlocks", m_CurrentBlocks, mem);
+    core::CMemoryDebug::dynamicSize("m_CurrentVariables", m_CurrentVariables, mem);
     core::CMemoryDebug::dynamicSize("m_CurrentProjected", m_CurrentProjected, mem);
     core::CMemoryDebug::dynamicSize("m_Projected", m_Projected, mem);
     core::CMemoryDebug::dynamicSize("m_Moments", m_Moments, mem);
@@ -377,6 +430,9 @@ void CKMostCorrelated::debugMemoryUsage(const core::CMemoryUsage::TMemoryUsagePt
 
 std::size_t CKMostCorrelated::memoryUsage() const {
     std::size_t mem = core::CMemory::dynamicSize(m_Projections);
+    mem += core::CMemory::dynamicSize(m_CurrentProjection);
+    mem += core::CMemory::dynamicSize(m_CurrentBlocks);
+    mem += core::CMemory::dynamicSize(m_CurrentVariables);
     mem += core::CMemory::dynamicSize(m_CurrentProjected);
     mem += core::CMemory::dynamicSize(m_Projected);
     mem += core::CMemory::dynamicSize(m_Moments);
@@ -434,8 +490,8 @@ void CKMostCorrelated::mostCorrelated(TCorrelationVec& result) const {
         LOG_TRACE(<< "Nearest neighbour search");
 
         // 1) Build an r-tree,
-        // 2) Lookup up V / replace nearest neighbours of each point
-        //    and its negative to initialise search,
+        // 2) Seed the search by comparing points which share a sign hash
+        //    bucket with each seed point or with its negative,
         // 3) Create a predicate with separation corresponding to the
         //    smallest correlation,
         // 4) Search for neighbours of each point and its negative for
@@ -465,13 +521,9 @@ void CKMostCorrelated::mostCorrelated(TCorrelationVec& result) const {
         }
         LOG_TRACE(<< "# points = " << points.size());
 
-        unsigned int k = static_cast<unsigned int>(replace / V + 1);
-        LOG_TRACE(<< "k = " << k);
-
-        // The nearest neighbour search is very slow compared with
-        // the search over the smallest correlation box predicate
-        // so we use a small number of seed variables if V is large
-        // compared to the number to replace.
+        // Comparing with every point in a bucket would be quadratic in
+        // the bucket size so we use a small number of seed variables if
+        // V is large compared to the number to replace.
         TSizeVec seeds;
         if (2 * replace < V) {
             CSampling::uniformSample(m_Rng, 0, V, 2 * replace, seeds);
@@ -483,49 +535,82 @@ void CKMostCorrelated::mostCorrelated(TCorrelationVec& result) const {
                          boost::counting_iterator<std::size_t>(V));
         }
 
-        try {
-            TPointRTree rtree(points);
-            TPointSizePrVec nearest;
-            for (std::size_t i = 0; i < seeds.size(); ++i) {
-                std::size_t X = points[seeds[i]].second;
-                const TVectorPackedBitVectorPr& px = m_Projected.at(X);
+        auto addCandidate = [&](std::size_t X, const TVectorPackedBitVectorPr& px,
+                                std::size_t Y) {
+            std::size_t n = mostCorrelated.count();
+            std::size_t S = n == desired ? mostCorrelated.biggest().s_X : 0;
+            std::size_t T = n == desired ? mostCorrelated.biggest().s_Y : 0;
+            const TVectorPackedBitVectorPr& py = m_Projected.at(Y);
+            SCorrelation cxy(X, px.first, px.second, Y, py.first, py.second);
+            if (lookup.count(std::make_pair(cxy.s_X, cxy.s_Y)) > 0) {
+                return;
+            }
+            if (mostCorrelated.add(cxy)) {
+                if (n == desired) {
+                    lookup.erase(std::make_pair(S, T));
+                }
+                lookup.insert(std::make_pair(cxy.s_X, cxy.s_Y));
+            }
+        };
 
-                nearest.clear();
-                bgi::query(rtree,
-                           bgi::satisfies(CNotEqual(X)) &&
-                               bgi::satisfies(CPairNotIn(lookup, X)) &&
-                               bgi::nearest((px.first.to<double>()).toBoostArray(), k),
-                           std::back_inserter(nearest));
-                bgi::query(rtree,
-                           bgi::satisfies(CNotEqual(X)) &&
-                               bgi::satisfies(CPairNotIn(lookup, X)) &&
-                               bgi::nearest((-px.first.to<double>()).toBoostArray(), k),
-                           std::back_inserter(nearest));
+        // Choose the number of bits so the buckets have roughly the target
+        // size. If we use every component all tables are the same.
+        std::size_t bits{1};
+        while (bits < NUMBER_PROJECTIONS && (V >> (bits + 1)) >= TARGET_BUCKET_SIZE) {
+            ++bits;
+        }
+        std::size_t tables{bits == NUMBER_PROJECTIONS ? 1 : NUMBER_HASH_TABLES};
+        std::size_t mask{(std::size_t(1) << bits) - 1};
+        LOG_TRACE(<< "bits = " << bits << ", tables = " << tables);
+
+        TSizeVecVec buckets(mask + 1);
+        TSizeVec hashes(V);
+        TSizeVec positions(V);
+        for (std::size_t t = 0; t < tables; ++t) {
+            std::size_t offset{(t * NUMBER_PROJECTIONS) / tables};
+            for (auto& bucket : buckets) {
+                bucket.clear();
+            }
+            for (std::size_t i = 0; i < V; ++i) {
+                hashes[i] = signHash(points[i].first, offset, bits);
+                positions[i] = buckets[hashes[i]].size();
+                buckets[hashes[i]].push_back(i);
+            }
 
-                for (std::size_t j = 0; j < nearest.size(); ++j) {
-                    std::size_t n = mostCorrelated.count();
-                    std::size_t S = n == desired ? mostCorrelated.biggest().s_X : 0;
-                    std::size_t T = n == desired ? mostCorrelated.biggest().s_Y : 0;
-                    std::size_t Y = nearest[j].second;
-                    const TVectorPackedBitVectorPr& py = m_Projected.at(Y);
-                    SCorrelation cxy(X, px.first, px.second, Y, py.first, py.second);
-                    if (lookup.count(std::make_pair(cxy.s_X, cxy.s_Y)) > 0) {
-                        continue;
-                    }
-                    if (mostCorrelated.add(cxy)) {
-                        if (n == desired) {
-                            lookup.erase(std::make_pair(S, T));
-                        }
-                        lookup.insert(std::make_pair(cxy.s_X, cxy.s_Y));
-                    }
+            for (auto i : seeds) {
+                std::size_t X = points[i].second;
+                const TVectorPackedBitVectorPr& px = m_Projected.at(X);
+                // Points whose projections are positively correlated with
+                // X share its bucket and negatively correlated ones share
+                // the bucket of its negative.
+                const TSizeVec& same = buckets[hashes[i]];
+                const TSizeVec& opposite = buckets[~hashes[i] & mask];
+                std::size_t n{std::min(same.size(), MAXIMUM_BUCKET_COMPARISONS + 1)};
+                for (std::size_t j = 1; j < n; ++j) {
+                    std::size_t Y{points[same[(positions[i] + j) % same.size()]].second};
+                    addCandidate(X, px, Y);
+                }
+                n = std::min(opposite.size(), MAXIMUM_BUCKET_COMPARISONS);
+                for (std::size_t j = 0; j < n; ++j) {
+                    std::size_t Y{points[opposite[(positions[i] + j) % opposite.size()]].second};
+                    addCandidate(X, px, Y);
                 }
             }
-            LOG_TRACE(<< "# seeds = " << mostCorrelated.count());
-            LOG_TRACE(<< "seed most correlated = " << mostCorrelated);
+        }
+        LOG_TRACE(<< "# seeds = " << mostCorrelated.count());
+        LOG_TRACE(<< "seed most correlated = " << mostCorrelated);
+
+        // If we didn't fill the collection any pair with positive correlation
+        // could be added.
+        double maximumThreshold{SCorrelation().distance(amax)};
 
+        try {
+            TPointRTree rtree(points);
+            TPointSizePrVec nearest;
             for (std::size_t i = 0; i < points.size(); ++i) {
-                const SCorrelation& biggest = mostCorrelated.biggest();
-                double threshold = biggest.distance(amax);
+                double threshold = mostCorrelated.count() < replace
+                                       ? maximumThreshold
+                                       : mostCorrelated.biggest().distance(amax);
                 LOG_TRACE(<< "threshold = " << threshold);
 
                 std::size_t X = points[i].second;
@@ -556,21 +641,7 @@ void CKMostCorrelated::mostCorrelated(TCorrelationVec& result) const {
                 LOG_TRACE(<< "# candidates = " << nearest.size());
 
                 for (std::size_t j = 0; j < nearest.size(); ++j) {
-                    std::size_t n = mostCorrelated.count();
-                    std::size_t S = n == desired ? mostCorrelated.biggest().s_X : 0;
-                    std::size_t T = n == desired ? mostCorrelated.biggest().s_Y : 0;
-                    std::size_t Y = nearest[j].second;
-                    const TVectorPackedBitVectorPr& py = m_Projected.at(Y);
-                    SCorrelation cxy(X, px.first, px.second, Y, py.first, py.second);
-                    if (lookup.count(std::make_pair(cxy.s_X, cxy.s_Y)) > 0) {
-                        continue;
-                    }
-                    if (mostCorrelated.add(cxy)) {
-                        if (n == desired) {
-                            lookup.erase(std::make_pair(S, T));
-                        }
-                        lookup.insert(std::make_pair(cxy.s_X, cxy.s_Y));
-                    }
+                    addCandidate(X, px, nearest[j].second);
                 }
             }
         } catch (const std::exception& e) {
@@ -597,6 +668,7 @@ void CKMostCorrelated::nextProjection() {
     }
 
     m_Projected.clear();
+    this->initializeCurrentProjection();
 
     double factor = std::exp(-m_DecayRate);
     m_MaximumCount *= factor;
@@ -608,6 +680,40 @@ void CKMostCorrelated::nextProjection() {
     }
 }
 
+void CKMostCorrelated::initializeCurrentProjection() {
+    m_CurrentProjection.assign(NUMBER_PROJECTIONS, 0.0);
+    if (m_Projections.size() > 0) {
+        const TVector& projection{m_Projections.back()};
+        for (std::size_t i = 0; i < NUMBER_PROJECTIONS; ++i) {
+            m_CurrentProjection[i] = projection(i);
+        }
+    }
+}
+
+CKMostCorrelated::TSizeVectorUMap CKMostCorrelated::currentProjected() const {
+    TSizeVectorUMap result;
+    result.reserve(m_CurrentVariables.size());
+    for (std::size_t i = 0; i < m_CurrentVariables.size(); ++i) {
+        auto block = m_CurrentProjected.begin() + i * NUMBER_PROJECTIONS;
+        result.emplace(m_CurrentVariables[i], TVector(block, block + NUMBER_PROJECTIONS));
+    }
+    return result;
+}
+
+void CKMostCorrelated::currentProjected(const TSizeVectorUMap& currentProjected) {
+    for (const auto& projected : currentProjected) {
+        std::size_t X = projected.first;
+        if (X >= m_CurrentBlocks.size()) {
+            m_CurrentBlocks.resize(X + 1, NO_BLOCK);
+        }
+        m_CurrentBlocks[X] = m_CurrentVariables.size();
+        m_CurrentVariables.push_back(X);
+        for (std::size_t i = 0; i < NUMBER_PROJECTIONS; ++i) {
+            m_CurrentProjected.push_back(projected.second(i));
+        }
+    }
+}
+
 const CKMostCorrelated::TVectorVec& CKMostCorrelated::projections() const {
     return m_Projections;
 }
@@ -275,6 +275,14 @@ bool CModel::shouldPersist() const {
     return true;
 }
 
+void CModel::compact(const STimeSeriesDecompositionRestoreParams& /*decompositionParams*/,
+                     const SDistributionRestoreParams& /*distributionParams*/) {
+}
+
+bool CModel::isCompact() const {
+    return false;
+}
+
 //////// CModelStub ////////
 
 CModelStub::CModelStub() : CModel(stubParameters()) {
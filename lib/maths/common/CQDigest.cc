@@ -43,9 +43,9 @@ const std::string CQDigest::N_TAG("b");
 const std::string CQDigest::NODE_TAG("c");
 
 CQDigest::CQDigest(uint64_t k, double decayRate)
-    : m_K(k), m_N(0u), m_Root(nullptr),
-      m_NodeAllocator(static_cast<std::size_t>(3 * m_K + 2)), m_DecayRate(decayRate) {
-    m_Root = &m_NodeAllocator.create(CNode(0, 1, 0, 0));
+    : m_K(k), m_N(0u), m_Root(NO_NODE), m_DecayRate(decayRate) {
+    m_Nodes.reserve(static_cast<std::size_t>(3 * m_K + 2));
+    m_Root = this->createNode(CNode(0, 1, 0, 0));
 }
 
 void CQDigest::acceptPersistInserter(core::CStatePersistInserter& inserter) const {
@@ -53,7 +53,7 @@ void CQDigest::acceptPersistInserter(core::CStatePersistInserter& inserter) cons
     inserter.insertValue(N_TAG, m_N);
 
     // Note the tree is serialized flat in pre-order.
-    m_Root->persistRecursive(NODE_TAG, inserter);
+    this->persistRecursive(m_Root, inserter);
 }
 
 bool CQDigest::acceptRestoreTraverser(core::CStateRestoreTraverser& traverser) {
@@ -70,9 +70,11 @@ bool CQDigest::acceptRestoreTraverser(core::CStateRestoreTraverser& traverser) {
                 LOG_ERROR(<< "Failed to restore NODE_TAG, got " << traverser.value());
             }
             if (nodeCount++ == 0) {
-                m_Root = &m_NodeAllocator.create(node);
+                m_Nodes.clear();
+                m_FreeNodes.clear();
+                m_Root = this->createNode(node);
             } else {
-                m_Root->insert(m_NodeAllocator, node);
+                this->insert(m_Root, node);
             }
             continue;
         }
@@ -84,7 +86,7 @@ bool CQDigest::acceptRestoreTraverser(core::CStateRestoreTraverser& traverser) {
 }
 
 void CQDigest::checkRestoredInvariants() const {
-    VIOLATES_INVARIANT_NO_EVALUATION(m_Root, ==, nullptr);
+    VIOLATES_INVARIANT_NO_EVALUATION(m_Root, ==, NO_NODE);
 
     // This check on invariants is proving unreliable as it
     // fails on occasion, see ml-cpp#1728 for details.
@@ -99,10 +101,7 @@ void CQDigest::add(uint32_t value, uint64_t n) {
 
     m_N += n;
 
-    CNode* expanded = m_Root->expand(m_NodeAllocator, value);
-    if (expanded) {
-        m_Root = expanded;
-    }
+    bool expanded{this->expand(value)};
 
     // If we already have the leaf node then incrementing a
     // leaf node count can't cause us to violate any constraints
@@ -111,29 +110,28 @@ void CQDigest::add(uint32_t value, uint64_t n) {
     // tree. Otherwise, we can get away with just compressing
     // the path from the leaf to the root.
 
-    CNode& leaf = m_Root->insert(m_NodeAllocator, CNode(value, value, n, n));
+    uint32_t leaf{this->insert(m_Root, CNode(value, value, n, n))};
     if (expanded || (m_N / m_K) != ((m_N - n) / m_K)) {
         // Compress the whole tree.
         this->compress();
-    } else if (leaf.count() == n) {
+    } else if (m_Nodes[leaf].count() == n) {
         // Compress the path to the new leaf.
-        TNodePtrVec compress(1u, &leaf);
-        this->compress(compress);
+        m_CompressionQueue.assign(1, leaf);
+        this->compress(m_CompressionQueue);
     }
 }
 
 void CQDigest::merge(const CQDigest& digest) {
-    TNodePtrVec nodes;
-    digest.m_Root->postOrder(nodes);
+    TUInt32Vec nodes;
+    digest.postOrder(digest.m_Root, nodes);
 
-    CNode* expanded = m_Root->expand(m_NodeAllocator, digest.m_Root->max());
-    if (expanded) {
-        m_Root = expanded;
-    }
+    this->expand(digest.m_Nodes[digest.m_Root].max());
 
-    for (const auto& node : nodes) {
-        m_N += node->count();
-        m_Root->insert(m_NodeAllocator, *node);
+    for (const auto& i : nodes) {
+        // Each node is inserted separately so it only brings its own count.
+        const CNode& node{digest.m_Nodes[i]};
+        m_N += node.count();
+        this->insert(m_Root, CNode(node.min(), node.max(), node.count(), node.count()));
     }
 
     // Compress the whole tree.
@@ -148,7 +146,7 @@ void CQDigest::propagateForwardsByTime(double time) {
 
     double alpha = std::exp(-m_DecayRate * time);
 
-    m_N = m_Root->age(alpha);
+    m_N = this->age(m_Root, alpha);
 
     // Compress the whole tree.
     this->compress();
@@ -174,13 +172,16 @@ bool CQDigest::scale(double factor) {
     }
 
     // Get a sketch of the current q-digest.
-    TNodePtrVec nodes;
-    m_Root->postOrder(nodes);
-    std::sort(nodes.begin(), nodes.end(), SLevelLess());
+    TUInt32Vec nodes;
+    this->postOrder(m_Root, nodes);
+    std::sort(nodes.begin(), nodes.end(), [this](uint32_t lhs, uint32_t rhs) {
+        return SLevelLess{}(m_Nodes[lhs], m_Nodes[rhs]);
+    });
     TUInt32UInt32UInt64TrVec sketch;
     sketch.reserve(nodes.size());
     for (const auto& node : nodes) {
-        sketch.emplace_back(node->min(), node->max(), node->count());
+        sketch.emplace_back(m_Nodes[node].min(), m_Nodes[node].max(),
+                            m_Nodes[node].count());
     }
 
     // Start again from scratch.
@@ -218,15 +219,17 @@ bool CQDigest::scale(double factor) {
 }
 
 void CQDigest::clear() {
-    // Release all current nodes.
-    TNodePtrVec nodes;
-    m_Root->postOrder(nodes);
+    TUInt32Vec nodes;
+    this->postOrder(m_Root, nodes);
     for (const auto& node : nodes) {
-        m_N -= node->count();
+        m_N -= m_Nodes[node].count();
     }
 
-    // Reset root to its initial state and sanity check total count.
-    m_Root = &m_NodeAllocator.create(CNode(0, 1, 0, 0));
+    // Release all current nodes, reset root to its initial
+    // state and sanity check total count.
+    m_Nodes.clear();
+    m_FreeNodes.clear();
+    m_Root = this->createNode(CNode(0, 1, 0, 0));
     if (m_N != 0) {
         LOG_ERROR(<< "Inconsistency - sum of node counts did not equal N");
         m_N = 0;
@@ -244,7 +247,7 @@ bool CQDigest::quantile(double q, uint32_t& result) const {
     // Compute the count fraction we need to the left of the value.
     uint64_t n = static_cast<uint64_t>(q * static_cast<double>(m_N) + 0.5);
 
-    result = m_Root->quantile(0, n);
+    result = this->subtreeQuantile(m_Root, 0, n);
 
     return true;
 }
@@ -256,16 +259,16 @@ bool CQDigest::quantileSublevelSetSupremum(double f, uint32_t& result) const {
         return false;
     }
     if (f <= 0.0) {
-        m_Root->sublevelSetSupremum(-1, result);
+        this->subtreeSublevelSetSupremum(m_Root, -1, result);
         return true;
     }
     if (f > 1.0) {
-        m_Root->superlevelSetInfimum(m_Root->max() + 1, result);
+        this->subtreeSuperlevelSetInfimum(m_Root, m_Nodes[m_Root].max() + 1, result);
         return true;
     }
 
     uint64_t n = static_cast<uint64_t>(f * static_cast<double>(m_N) + 0.5);
-    m_Root->quantileSublevelSetSupremum(n, 0, result);
+    this->subtreeQuantileSublevelSetSupremum(m_Root, n, 0, result);
     return true;
 }
 
@@ -309,7 +312,7 @@ bool CQDigest::cdf(uint32_t x, double confidence, double& lowerBound, double& up
     }
 
     uint64_t l = 0ull;
-    m_Root->cdfLowerBound(x, l);
+    this->subtreeCdfLowerBound(m_Root, x, l);
     lowerBound = static_cast<double>(l) / static_cast<double>(m_N);
     if (confidence > 0.0) {
         lowerBound = cdfQuantile(static_cast<double>(m_N), lowerBound,
@@ -317,7 +320,7 @@ bool CQDigest::cdf(uint32_t x, double confidence, double& lowerBound, double& up
     }
 
     uint64_t u = 0ull;
-    m_Root->cdfUpperBound(x, u);
+    this->subtreeCdfUpperBound(m_Root, x, u);
     upperBound = static_cast<double>(u) / static_cast<double>(m_N);
     if (confidence > 0.0) {
         upperBound = cdfQuantile(static_cast<double>(m_N), upperBound,
@@ -336,10 +339,10 @@ void CQDigest::pdf(uint32_t x, double confidence, double& lowerBound, double& up
     }
 
     uint32_t infimum = 0;
-    m_Root->superlevelSetInfimum(x, infimum);
+    this->subtreeSuperlevelSetInfimum(m_Root, x, infimum);
 
     uint32_t supremum = std::numeric_limits<uint32_t>::max();
-    m_Root->sublevelSetSupremum(static_cast<int64_t>(x), supremum);
+    this->subtreeSublevelSetSupremum(m_Root, static_cast<int64_t>(x), supremum);
 
     double infimumLowerBound;
     double infimumUpperBound;
@@ -362,11 +365,11 @@ void CQDigest::pdf(uint32_t x, double confidence, double& lowerBound, double& up
 }
 
 void CQDigest::sublevelSetSupremum(uint32_t x, uint32_t& result) const {
-    m_Root->sublevelSetSupremum(static_cast<int64_t>(x), result);
+    this->subtreeSublevelSetSupremum(m_Root, static_cast<int64_t>(x), result);
 }
 
 void CQDigest::superlevelSetInfimum(uint32_t x, uint32_t& result) const {
-    m_Root->superlevelSetInfimum(x, result);
+    this->subtreeSuperlevelSetInfimum(m_Root, x, result);
 }
 
 void CQDigest::summary(TUInt32UInt64PrVec& result) const {
@@ -376,25 +379,26 @@ void CQDigest::summary(TUInt32UInt64PrVec& result) const {
         return;
     }
 
-    TNodePtrVec nodes;
-    m_Root->postOrder(nodes);
+    TUInt32Vec nodes;
+    this->postOrder(m_Root, nodes);
 
     result.reserve(nodes.size());
 
-    uint32_t last = nodes[0]->max();
-    uint64_t count = nodes[0]->count();
+    uint32_t last = m_Nodes[nodes[0]].max();
+    uint64_t count = m_Nodes[nodes[0]].count();
     for (std::size_t i = 1; i < nodes.size(); ++i) {
-        if (nodes[i]->max() != last) {
+        const CNode& node{m_Nodes[nodes[i]]};
+        if (node.max() != last) {
             result.emplace_back(last, count);
-            last = nodes[i]->max();
+            last = node.max();
         }
 
-        count += nodes[i]->count();
+        count += node.count();
     }
 
     // Check if any count is aligned with the root max.
     if (result.empty() || result.back().second < count) {
-        result.emplace_back(m_Root->max(), count);
+        result.emplace_back(m_Nodes[m_Root].max(), count);
     }
 
     if (result.back().second != m_N) {
@@ -425,29 +429,30 @@ bool CQDigest::checkInvariants() const {
     //   2) Subtree count at the root = n
     //   2) The node invariants are satisfied.
 
-    if (m_Root->size() > 3 * m_K) {
-        LOG_ERROR(<< "|Q| = " << m_Root->size() << " 3k = " << 3 * m_K);
+    std::size_t size{this->subtreeSize(m_Root)};
+    if (size > 3 * m_K) {
+        LOG_ERROR(<< "|Q| = " << size << " 3k = " << 3 * m_K);
         return false;
     }
 
-    if (m_Root->subtreeCount() != m_N) {
-        LOG_ERROR(<< "Bad count: " << m_Root->subtreeCount() << ", n = " << m_N);
+    if (m_Nodes[m_Root].subtreeCount() != m_N) {
+        LOG_ERROR(<< "Bad count: " << m_Nodes[m_Root].subtreeCount() << ", n = " << m_N);
         return false;
     }
 
-    return m_Root->checkInvariants(m_N / m_K);
+    return this->checkSubtreeInvariants(m_Root, m_N / m_K);
 }
 
 std::string CQDigest::print() const {
     std::ostringstream result;
 
-    TNodePtrVec nodes;
-    m_Root->postOrder(nodes);
+    TUInt32Vec nodes;
+    this->postOrder(m_Root, nodes);
 
     result << m_N << " | " << m_K << " | {";
     for (const auto& node : nodes) {
-        result << " \"" << node->print() << ',' << node->count() << ','
-               << node->subtreeCount() << '"';
+        result << " \"" << m_Nodes[node].print() << ',' << m_Nodes[node].count()
+               << ',' << m_Nodes[node].subtreeCount() << '"';
     }
     result << " }";
 
@@ -456,106 +461,90 @@ std::string CQDigest::print() const {
 
 void CQDigest::compress() {
     for (std::size_t i = 0; i < 3 * m_K + 2; ++i) {
-        TNodePtrVec compress;
-        m_Root->postOrder(compress);
-        if (!this->compress(compress)) {
+        m_CompressionQueue.clear();
+        this->postOrder(m_Root, m_CompressionQueue);
+        if (!this->compress(m_CompressionQueue)) {
             return;
         }
     }
     LOG_ERROR(<< "Failed to compress tree");
 }
 
-bool CQDigest::compress(TNodePtrVec& compress) {
+bool CQDigest::compress(TUInt32Vec& compress) {
     bool compressed = false;
 
-    std::make_heap(compress.begin(), compress.end(), SLevelLess());
+    auto levelLess = [this](uint32_t lhs, uint32_t rhs) {
+        return SLevelLess{}(m_Nodes[lhs], m_Nodes[rhs]);
+    };
+
+    std::make_heap(compress.begin(), compress.end(), levelLess);
 
     while (!compress.empty()) {
-        CNode& node = *compress.front();
+        uint32_t node{compress.front()};
 
-        std::pop_heap(compress.begin(), compress.end(), SLevelLess());
+        std::pop_heap(compress.begin(), compress.end(), levelLess);
         compress.pop_back();
 
-        if (CNode* parent = node.compress(m_NodeAllocator, m_N / m_K)) {
+        uint32_t parent{this->compress(node, m_N / m_K)};
+        if (parent != NO_NODE) {
             compressed = true;
 
             compress.push_back(parent);
-            std::push_heap(compress.begin(), compress.end(), SLevelLess());
+            std::push_heap(compress.begin(), compress.end(), levelLess);
         }
     }
 
     return compressed;
 }
 
-bool CQDigest::SLevelLess::operator()(const CNode* lhs, const CNode* rhs) const {
-    return lhs->span() > rhs->span() ||
-           (lhs->span() == rhs->span() && lhs->max() > rhs->max());
-}
-
-bool CQDigest::SPostLess::operator()(const CNode* lhs, const CNode* rhs) const {
-    return lhs->max() < rhs->max() ||
-           (lhs->max() == rhs->max() && lhs->span() < rhs->span());
-}
-
-const std::string CQDigest::CNode::MIN_TAG("a");
-const std::string CQDigest::CNode::MAX_TAG("b");
-const std::string CQDigest::CNode::COUNT_TAG("c");
-
-CQDigest::CNode::CNode()
-    : m_Ancestor(nullptr), m_Descendants(), m_Min(0xDEADBEEF),
-      m_Max(0xDEADBEEF), m_Count(0xDEADBEEF), m_SubtreeCount(0xDEADBEEF) {
-}
-
-CQDigest::CNode::CNode(uint32_t min, uint32_t max, uint64_t count, uint64_t subtreeCount)
-    : m_Ancestor(nullptr), m_Descendants(), m_Min(min), m_Max(max),
-      m_Count(count), m_SubtreeCount(subtreeCount) {
-}
-
-std::size_t CQDigest::CNode::size() const {
+std::size_t CQDigest::subtreeSize(uint32_t node) const {
     std::size_t size = 1;
 
-    for (const auto& descendant : m_Descendants) {
-        size += descendant->size();
+    for (const auto& descendant : m_Nodes[node].m_Descendants) {
+        size += this->subtreeSize(descendant);
     }
 
     return size;
 }
 
-uint32_t CQDigest::CNode::quantile(uint64_t leftCount, uint64_t n) const {
+uint32_t CQDigest::subtreeQuantile(uint32_t node, uint64_t leftCount, uint64_t n) const {
     // We need to find the smallest node in post-order where
     // the left count is greater than n. At each level we visit
     // the smallest, in post order, node in the q-digest for
     // which the left count is greater than n. Terminating when
     // this node doesn't have any descendants.
 
-    for (const auto& descendant : m_Descendants) {
-        uint64_t count = descendant->subtreeCount();
+    for (const auto& descendant : m_Nodes[node].m_Descendants) {
+        uint64_t count = m_Nodes[descendant].subtreeCount();
         if (leftCount + count >= n) {
-            return descendant->quantile(leftCount, n);
+            return this->subtreeQuantile(descendant, leftCount, n);
         }
         leftCount += count;
     }
 
-    return m_Max;
+    return m_Nodes[node].max();
 }
 
-bool CQDigest::CNode::quantileSublevelSetSupremum(uint64_t n,
+bool CQDigest::subtreeQuantileSublevelSetSupremum(uint32_t node,
+                                                  uint64_t n,
                                                   uint64_t leftCount,
                                                   uint32_t& result) const {
     // We are looking for the right end of the rightmost node
     // whose count together with those nodes to the left is
     // is less than n.
 
-    if (leftCount + m_SubtreeCount < n) {
-        result = std::max(result, m_Max);
+    const CNode& root{m_Nodes[node]};
+
+    if (leftCount + root.subtreeCount() < n) {
+        result = std::max(result, root.max());
         return true;
     }
 
-    leftCount += m_SubtreeCount;
-    for (auto i = m_Descendants.rbegin(); i != m_Descendants.rend(); ++i) {
-        leftCount -= (*i)->subtreeCount();
-        if (leftCount + (*i)->count() < n &&
-            (*i)->quantileSublevelSetSupremum(n, leftCount, result)) {
+    leftCount += root.subtreeCount();
+    for (auto i = root.m_Descendants.rbegin(); i != root.m_Descendants.rend(); ++i) {
+        leftCount -= m_Nodes[*i].subtreeCount();
+        if (leftCount + m_Nodes[*i].count() < n &&
+            this->subtreeQuantileSublevelSetSupremum(*i, n, leftCount, result)) {
             break;
         }
     }
@@ -563,350 +552,457 @@ bool CQDigest::CNode::quantileSublevelSetSupremum(uint64_t n,
     return false;
 }
 
-void CQDigest::CNode::cdfLowerBound(uint32_t x, uint64_t& result) const {
+void CQDigest::subtreeCdfLowerBound(uint32_t node, uint32_t x, uint64_t& result) const {
     // The lower bound is the sum of the counts at the nodes
     // for which the maximum value is less than or equal to x.
 
-    if (m_Max <= x) {
-        result += m_SubtreeCount;
+    const CNode& root{m_Nodes[node]};
+
+    if (root.max() <= x) {
+        result += root.subtreeCount();
     } else {
-        for (const auto& descendant : m_Descendants) {
-            descendant->cdfLowerBound(x, result);
+        for (const auto& descendant : root.m_Descendants) {
+            this->subtreeCdfLowerBound(descendant, x, result);
         }
     }
 }
 
-void CQDigest::CNode::cdfUpperBound(uint32_t x, uint64_t& result) const {
+void CQDigest::subtreeCdfUpperBound(uint32_t node, uint32_t x, uint64_t& result) const {
     // The upper bound is the sum of the counts at the nodes
     // for which the minimum value is less than or equal to x.
 
-    if (m_Max <= x) {
-        result += m_SubtreeCount;
-    } else if (m_Min <= x) {
-        result += m_Count;
-        for (const auto& descendant : m_Descendants) {
-            descendant->cdfUpperBound(x, result);
+    const CNode& root{m_Nodes[node]};
+
+    if (root.max() <= x) {
+        result += root.subtreeCount();
+    } else if (root.min() <= x) {
+        result += root.count();
+        for (const auto& descendant : root.m_Descendants) {
+            this->subtreeCdfUpperBound(descendant, x, result);
         }
     }
 }
 
-void CQDigest::CNode::sublevelSetSupremum(const int64_t x, uint32_t& result) const {
-    for (auto i = m_Descendants.rbegin(); i != m_Descendants.rend(); ++i) {
-        if (static_cast<int64_t>((*i)->max()) > x) {
-            result = std::min(result, (*i)->max());
+void CQDigest::subtreeSublevelSetSupremum(uint32_t node, const int64_t x, uint32_t& result) const {
+    const CNode& root{m_Nodes[node]};
+    for (auto i = root.m_Descendants.rbegin(); i != root.m_Descendants.rend(); ++i) {
+        if (static_cast<int64_t>(m_Nodes[*i].max()) > x) {
+            result = std::min(result, m_Nodes[*i].max());
         } else {
-            (*i)->sublevelSetSupremum(x, result);
+            this->subtreeSublevelSetSupremum(*i, x, result);
             break;
         }
     }
-    if (static_cast<int64_t>(m_Max) > x && m_Count > 0) {
-        result = std::min(result, m_Max);
+    if (static_cast<int64_t>(root.max()) > x && root.count() > 0) {
+        result = std::min(result, root.max());
     }
 }
 
-void CQDigest::CNode::superlevelSetInfimum(uint32_t x, uint32_t& result) const {
-    for (const auto& descendant : m_Descendants) {
-        if (descendant->max() < x) {
-            result = std::max(result, descendant->max());
+void CQDigest::subtreeSuperlevelSetInfimum(uint32_t node, uint32_t x, uint32_t& result) const {
+    const CNode& root{m_Nodes[node]};
+    for (const auto& descendant : root.m_Descendants) {
+        if (m_Nodes[descendant].max() < x) {
+            result = std::max(result, m_Nodes[descendant].max());
         } else {
-            descendant->superlevelSetInfimum(x, result);
+            this->subtreeSuperlevelSetInfimum(descendant, x, result);
             break;
         }
     }
-    if (m_Max < x && m_Count > 0) {
-        result = std::max(result, m_Max);
+    if (root.max() < x && root.count() > 0) {
+        result = std::max(result, root.max());
     }
 }
 
-void CQDigest::CNode::postOrder(TNodePtrVec& nodes) const {
-    for (const auto& descendant : m_Descendants) {
-        descendant->postOrder(nodes);
+void CQDigest::postOrder(uint32_t node, TUInt32Vec& nodes) const {
+    for (const auto& descendant : m_Nodes[node].m_Descendants) {
+        this->postOrder(descendant, nodes);
     }
-    nodes.push_back(const_cast<CNode*>(this));
+    nodes.push_back(node);
 }
 
-CQDigest::CNode* CQDigest::CNode::expand(CNodeAllocator& allocator, const uint32_t& value) {
-    if (m_Max >= value) {
+uint64_t CQDigest::age(uint32_t node, double factor) {
+    CNode& root{m_Nodes[node]};
+
+    root.m_SubtreeCount = 0;
+
+    for (const auto& descendant : root.m_Descendants) {
+        root.m_SubtreeCount += this->age(descendant, factor);
+    }
+
+    if (root.m_Count > 0) {
+        root.m_Count = static_cast<uint64_t>(
+            std::max(static_cast<double>(root.m_Count) * factor + 0.5, 1.0));
+    }
+    root.m_SubtreeCount += root.m_Count;
+
+    return root.m_SubtreeCount;
+}
+
+void CQDigest::persistRecursive(uint32_t node, core::CStatePersistInserter& inserter) const {
+    inserter.insertLevel(NODE_TAG, std::bind(&CNode::acceptPersistInserter,
+                                             &m_Nodes[node], std::placeholders::_1));
+
+    // Note the tree is serialized flat in pre-order.
+    for (const auto& descendant : m_Nodes[node].m_Descendants) {
+        this->persistRecursive(descendant, inserter);
+    }
+}
+
+bool CQDigest::checkSubtreeInvariants(uint32_t node, uint64_t compressionFactor) const {
+    // 1) span is a power of 2
+    // 2) q-digest connectivity is consistent.
+    // 3) subtree counts are consistent.
+    // 4) if node != leaf count(node) <= floor(n/k)
+    // 5) count(parent) + count(left) + count(right) > floor(n/k)
+
+    const CNode& root{m_Nodes[node]};
+
+    // Subtracting 1 will flip all the bits to the right of the last 1 in the
+    // current binary representation.  If the span is a power of 2 then it will
+    // only have 1 bit set, so span minus 1 will have completely different bits
+    // set to span.  Then an inclusive OR and an exclusive OR of span and span
+    // minus 1 will be identical.  If span is not a power of 2 then subtracting
+    // 1 will leave some set bits set, meaning the OR and XOR give different
+    // results.
+    uint32_t span(root.span());
+    uint32_t spanMinusOne(span - 1);
+    if ((span | spanMinusOne) != (span ^ spanMinusOne)) {
+        LOG_ERROR(<< "Bad span: " << root.print());
+        return false;
+    }
+
+    SPostLess postLess;
+    uint64_t subtreeCount = root.count();
+
+    const TUInt32Vec& descendants{root.m_Descendants};
+    for (std::size_t i = 0; i < descendants.size(); ++i) {
+        const CNode& descendant{m_Nodes[descendants[i]]};
+        if (descendant.m_Ancestor != node) {
+            LOG_ERROR(<< "Bad connectivity: " << root.print() << " -> "
+                      << descendant.print() << " <- "
+                      << (descendant.isRoot() ? EMPTY_STRING
+                                              : m_Nodes[descendant.m_Ancestor].print()));
+        }
+        if (!root.isAncestor(descendant)) {
+            LOG_ERROR(<< "Bad connectivity: " << root.print() << " -> "
+                      << descendant.print());
+            return false;
+        }
+        if (i + 1u < descendants.size() &&
+            !postLess(descendant, m_Nodes[descendants[i + 1u]])) {
+            LOG_ERROR(<< "Bad order: " << descendant.print()
+                      << " >= " << m_Nodes[descendants[i + 1u]].print());
+            return false;
+        }
+        if (!this->checkSubtreeInvariants(descendants[i], compressionFactor)) {
+            return false;
+        }
+        subtreeCount += descendant.subtreeCount();
+    }
+
+    if (subtreeCount != root.subtreeCount()) {
+        LOG_ERROR(<< "Bad subtree count: expected " << subtreeCount << " got "
+                  << root.subtreeCount());
+        return false;
+    }
+
+    if (!root.isLeaf() && !root.isRoot() && root.count() > compressionFactor) {
+        LOG_ERROR(<< "Bad count: " << root.count() << ", floor(n/k) = " << compressionFactor);
+        return false;
+    }
+
+    if (!root.isRoot()) {
+        const CNode& ancestor{m_Nodes[root.m_Ancestor]};
+        uint32_t sibling{this->sibling(root.m_Ancestor, node)};
+        uint64_t count = root.count() +
+                         (sibling != NO_NODE ? m_Nodes[sibling].count() : 0ull) +
+                         (ancestor.isParent(root) ? ancestor.count() : 0ull);
+        if (count < compressionFactor) {
+            LOG_ERROR(<< "Bad triple count: " << count << ", floor(n/k) = " << compressionFactor);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CQDigest::expand(uint32_t value) {
+    if (m_Nodes[m_Root].max() >= value) {
         // No expansion necessary.
-        return nullptr;
+        return false;
+    }
+
+    uint32_t root{m_Root};
+    if (m_Nodes[root].count() > 0) {
+        root = this->createNode(CNode(m_Nodes[m_Root].min(), m_Nodes[m_Root].max(), 0, 0));
     }
 
-    CNode* result = m_Count == 0 ? this : &allocator.create(CNode(m_Min, m_Max, 0, 0));
-    uint32_t levelSpan = result->span();
+    CNode& result{m_Nodes[root]};
+    uint32_t levelSpan = result.span();
     do {
-        result->m_Max += levelSpan;
+        result.m_Max += levelSpan;
         levelSpan <<= 1;
-    } while (result->m_Max < value);
+    } while (result.m_Max < value);
 
-    if (result != this) {
-        m_Ancestor = result;
-        result->m_Descendants.push_back(this);
-        result->m_SubtreeCount += m_SubtreeCount;
+    if (root != m_Root) {
+        m_Nodes[m_Root].m_Ancestor = root;
+        result.m_Descendants.push_back(m_Root);
+        result.m_SubtreeCount += m_Nodes[m_Root].subtreeCount();
+        m_Root = root;
     }
 
-    return result;
+    return true;
 }
 
-CQDigest::CNode& CQDigest::CNode::insert(CNodeAllocator& allocator, const CNode& node) {
-    m_SubtreeCount += node.subtreeCount();
+uint32_t CQDigest::insert(uint32_t node, const CNode& value) {
+    // Note that creating a node can reallocate the node array so
+    // we mustn't hold references to nodes across createNode.
 
-    if (*this == node) {
-        m_Count += node.count();
-        return *this;
+    m_Nodes[node].m_SubtreeCount += value.subtreeCount();
+
+    if (m_Nodes[node] == value) {
+        m_Nodes[node].m_Count += value.count();
+        return node;
     }
 
-    auto next = std::lower_bound(m_Descendants.begin(), m_Descendants.end(),
-                                 &node, SPostLess());
+    const TUInt32Vec& descendants{m_Nodes[node].m_Descendants};
+    auto next = std::lower_bound(descendants.begin(), descendants.end(), value,
+                                 [this](uint32_t lhs, const CNode& rhs) {
+                                     return SPostLess{}(m_Nodes[lhs], rhs);
+                                 });
 
     // If it exists the ancestor will be after the node
     // in post order.
-    for (auto i = next; i != m_Descendants.end(); ++i) {
-        if ((*i)->isAncestor(node) || **i == node) {
-            return (*i)->insert(allocator, node);
+    for (auto i = next; i != descendants.end(); ++i) {
+        if (m_Nodes[*i].isAncestor(value) || m_Nodes[*i] == value) {
+            return this->insert(*i, value);
         }
     }
 
     // This is the lowest ancestor in the q-digest. Insert
     // the node below it in post order and move descendants
     // if necessary.
-    CNode& newNode = allocator.create(node);
-    newNode.m_Ancestor = this;
-    m_Descendants.insert(next, &newNode);
-    if (!newNode.isLeaf()) {
-        newNode.takeDescendants(*this);
+    auto position = std::distance(descendants.begin(), next);
+    uint32_t result{this->createNode(value)};
+    m_Nodes[result].m_Ancestor = node;
+    TUInt32Vec& newDescendants{m_Nodes[node].m_Descendants};
+    newDescendants.insert(newDescendants.begin() + position, result);
+    if (!m_Nodes[result].isLeaf()) {
+        this->takeDescendants(result, node);
     }
 
-    return newNode;
+    return result;
 }
 
-CQDigest::CNode* CQDigest::CNode::compress(CNodeAllocator& allocator, uint64_t compressionFactor) {
-    if (!m_Ancestor) {
+uint32_t CQDigest::compress(uint32_t node, uint64_t compressionFactor) {
+    CNode& root{m_Nodes[node]};
+
+    if (root.isRoot()) {
         // The node is no longer in the q-digest.
-        return nullptr;
+        return NO_NODE;
     }
 
-    // Warning this function zeros m_Ancestor copy up front.
-    CNode* ancestor = m_Ancestor;
+    // Warning detaching zeros m_Ancestor so copy up front.
+    uint32_t ancestor{root.m_Ancestor};
 
     // Get the sibling of this node if it exists.
-    CNode* sibling = ancestor->sibling(*this);
+    uint32_t sibling{this->sibling(ancestor, node)};
 
-    uint64_t count = (ancestor->isParent(*this) ? ancestor->count() : 0ull) +
-                     this->count() + (sibling ? sibling->count() : 0ull);
+    bool isParent{m_Nodes[ancestor].isParent(root)};
+    uint64_t count = (isParent ? m_Nodes[ancestor].count() : 0ull) + root.count() +
+                     (sibling != NO_NODE ? m_Nodes[sibling].count() : 0ull);
 
     // Check if we should compress this node.
     if (count >= compressionFactor) {
-        return nullptr;
+        return NO_NODE;
     }
 
-    if (ancestor->isParent(*this)) {
-        ancestor->m_Count = count;
-        this->detach(allocator);
-        if (sibling) {
-            sibling->detach(allocator);
+    if (isParent) {
+        m_Nodes[ancestor].m_Count = count;
+        this->detach(node);
+        if (sibling != NO_NODE) {
+            this->detach(sibling);
         }
         return ancestor;
     }
 
     // We'll recycle this node for the parent.
 
-    m_Count = count;
-    this->isLeftChild() ? m_Max += this->span() : m_Min -= this->span();
-    this->takeDescendants(*ancestor);
-    if (sibling) {
-        sibling->detach(allocator);
+    root.m_Count = count;
+    root.isLeftChild() ? root.m_Max += root.span() : root.m_Min -= root.span();
+    this->takeDescendants(node, ancestor);
+    if (sibling != NO_NODE) {
+        this->detach(sibling);
     }
 
-    return this;
+    return node;
 }
 
-uint64_t CQDigest::CNode::age(double factor) {
-    m_SubtreeCount = 0;
-
-    for (auto& descendant : m_Descendants) {
-        m_SubtreeCount += descendant->age(factor);
-    }
+uint32_t CQDigest::sibling(uint32_t ancestor, uint32_t node) const {
+    const CNode& root{m_Nodes[node]};
 
-    if (m_Count > 0) {
-        m_Count = static_cast<uint64_t>(
-            std::max(static_cast<double>(m_Count) * factor + 0.5, 1.0));
-    }
-    m_SubtreeCount += m_Count;
-
-    return m_SubtreeCount;
-}
+    uint32_t min = root.min();
+    root.isLeftChild() ? min += root.span() : min -= root.span();
+    uint32_t max = root.max();
+    root.isLeftChild() ? max += root.span() : max -= root.span();
+    CNode sibling(min, max, 0u, 0u);
 
-uint32_t CQDigest::CNode::span() const {
-    return m_Max - m_Min + 1;
-}
+    const TUInt32Vec& descendants{m_Nodes[ancestor].m_Descendants};
+    auto next = std::lower_bound(descendants.begin(), descendants.end(), sibling,
+                                 [this](uint32_t lhs, const CNode& rhs) {
+                                     return SPostLess{}(m_Nodes[lhs], rhs);
+                                 });
 
-uint32_t CQDigest::CNode::min() const {
-    return m_Min;
-}
+    if (next != descendants.end() && m_Nodes[*next].isSibling(root)) {
+        return *next;
+    }
 
-uint32_t CQDigest::CNode::max() const {
-    return m_Max;
+    return NO_NODE;
 }
 
-const uint64_t& CQDigest::CNode::count() const {
-    return m_Count;
+void CQDigest::detach(uint32_t node) {
+    uint32_t ancestor{m_Nodes[node].m_Ancestor};
+    this->removeDescendant(ancestor, node);
+    this->takeDescendants(ancestor, node);
+    m_Nodes[node].m_Ancestor = NO_NODE;
+    m_FreeNodes.push_back(node);
 }
 
-const uint64_t& CQDigest::CNode::subtreeCount() const {
-    return m_SubtreeCount;
+void CQDigest::removeDescendant(uint32_t ancestor, uint32_t node) {
+    // Remove node from the descendants.
+    TUInt32Vec& descendants{m_Nodes[ancestor].m_Descendants};
+    descendants.erase(std::remove(descendants.begin(), descendants.end(), node),
+                      descendants.end());
 }
 
-void CQDigest::CNode::persistRecursive(const std::string& nodeTag,
-                                       core::CStatePersistInserter& inserter) const {
-    inserter.insertLevel(NODE_TAG, std::bind(&CNode::acceptPersistInserter,
-                                             this, std::placeholders::_1));
+bool CQDigest::takeDescendants(uint32_t taker, uint32_t node) {
+    CNode& root{m_Nodes[taker]};
+    CNode& other{m_Nodes[node]};
 
-    // Note the tree is serialized flat in pre-order.
-    for (const auto& descendant : m_Descendants) {
-        descendant->persistRecursive(nodeTag, inserter);
+    if (other.m_Descendants.empty()) {
+        return false;
     }
-}
 
-void CQDigest::CNode::acceptPersistInserter(core::CStatePersistInserter& inserter) const {
-    inserter.insertValue(MIN_TAG, m_Min);
-    inserter.insertValue(MAX_TAG, m_Max);
-    inserter.insertValue(COUNT_TAG, m_Count);
-}
+    auto postLess = [this](uint32_t lhs, uint32_t rhs) {
+        return SPostLess{}(m_Nodes[lhs], m_Nodes[rhs]);
+    };
 
-bool CQDigest::CNode::acceptRestoreTraverser(core::CStateRestoreTraverser& traverser) {
-    do {
-        const std::string& name = traverser.name();
-        if (name == MIN_TAG) {
-            if (core::CStringUtils::stringToType(traverser.value(), m_Min) == false) {
-                LOG_ERROR(<< "Invalid min in " << traverser.value());
-                return false;
-            }
-        }
-        if (name == MAX_TAG) {
-            if (core::CStringUtils::stringToType(traverser.value(), m_Max) == false) {
-                LOG_ERROR(<< "Invalid max in " << traverser.value());
-                return false;
-            }
-        }
-        if (name == COUNT_TAG) {
-            if (core::CStringUtils::stringToType(traverser.value(), m_Count) == false) {
-                LOG_ERROR(<< "Invalid count in " << traverser.value());
-                return false;
+    if (!root.isAncestor(other)) {
+        // Find our descendants among the descendants of node.
+        TUInt32Vec nodesToTake;
+        TUInt32Vec nodesToLeave;
+        for (const auto& descendant : other.m_Descendants) {
+            if (root.isAncestor(m_Nodes[descendant])) {
+                nodesToTake.push_back(descendant);
+                m_Nodes[descendant].m_Ancestor = taker;
+                root.m_SubtreeCount += m_Nodes[descendant].subtreeCount();
+            } else {
+                nodesToLeave.push_back(descendant);
             }
-            m_SubtreeCount = m_Count;
         }
-    } while (traverser.next());
 
-    return true;
-}
-
-bool CQDigest::CNode::checkInvariants(uint64_t compressionFactor) const {
-    // 1) span is a power of 2
-    // 2) q-digest connectivity is consistent.
-    // 3) subtree counts are consistent.
-    // 4) if node != leaf count(node) <= floor(n/k)
-    // 5) count(parent) + count(left) + count(right) > floor(n/k)
+        // Merge the descendants.
+        TUInt32Vec descendants;
+        descendants.reserve(root.m_Descendants.size() + nodesToTake.size());
+        std::merge(root.m_Descendants.begin(), root.m_Descendants.end(),
+                   nodesToTake.begin(), nodesToTake.end(),
+                   std::back_inserter(descendants), postLess);
 
-    // Subtracting 1 will flip all the bits to the right of the last 1 in the
-    // current binary representation.  If the span is a power of 2 then it will
-    // only have 1 bit set, so span minus 1 will have completely different bits
-    // set to span.  Then an inclusive OR and an exclusive OR of span and span
-    // minus 1 will be identical.  If span is not a power of 2 then subtracting
-    // 1 will leave some set bits set, meaning the OR and XOR give different
-    // results.
-    uint32_t span(this->span());
-    uint32_t spanMinusOne(span - 1);
-    if ((span | spanMinusOne) != (span ^ spanMinusOne)) {
-        LOG_ERROR(<< "Bad span: " << this->print());
-        return false;
-    }
+        // Update the node's descendants.
+        nodesToLeave.swap(other.m_Descendants);
 
-    SPostLess postLess;
-    uint64_t subtreeCount = m_Count;
+        // Write the result back to this node.
+        descendants.swap(root.m_Descendants);
 
-    for (std::size_t i = 0; i < m_Descendants.size(); ++i) {
-        if (m_Descendants[i]->m_Ancestor != this) {
-            LOG_ERROR(<< "Bad connectivity: " << this->print() << " -> "
-                      << m_Descendants[i]->print() << " <- "
-                      << m_Descendants[i]->m_Ancestor->print());
-        }
-        if (!this->isAncestor(*m_Descendants[i])) {
-            LOG_ERROR(<< "Bad connectivity: " << this->print() << " -> "
-                      << m_Descendants[i]->print());
-            return false;
-        }
-        if (i + 1u < m_Descendants.size() &&
-            !postLess(m_Descendants[i], m_Descendants[i + 1u])) {
-            LOG_ERROR(<< "Bad order: " << m_Descendants[i]->print()
-                      << " >= " << m_Descendants[i + 1u]->print());
-            return false;
-        }
-        if (!m_Descendants[i]->checkInvariants(compressionFactor)) {
-            return false;
-        }
-        subtreeCount += m_Descendants[i]->subtreeCount();
+        return !nodesToTake.empty();
     }
 
-    if (subtreeCount != m_SubtreeCount) {
-        LOG_ERROR(<< "Bad subtree count: expected " << subtreeCount << " got " << m_SubtreeCount);
-        return false;
+    for (const auto& descendant : other.m_Descendants) {
+        m_Nodes[descendant].m_Ancestor = taker;
     }
 
-    if (!this->isLeaf() && !this->isRoot() && m_Count > compressionFactor) {
-        LOG_ERROR(<< "Bad count: " << m_Count << ", floor(n/k) = " << compressionFactor);
-        return false;
-    }
+    // Merge the descendants.
+    TUInt32Vec descendants;
+    descendants.reserve(root.m_Descendants.size() + other.m_Descendants.size());
+    std::merge(root.m_Descendants.begin(), root.m_Descendants.end(),
+               other.m_Descendants.begin(), other.m_Descendants.end(),
+               std::back_inserter(descendants), postLess);
 
-    if (!this->isRoot()) {
-        const CNode* sibling = m_Ancestor->sibling(*this);
-        uint64_t count = m_Count + (sibling ? sibling->count() : 0ull) +
-                         (m_Ancestor->isParent(*this) ? m_Ancestor->count() : 0ull);
-        if (count < compressionFactor) {
-            LOG_ERROR(<< "Bad triple count: " << count << ", floor(n/k) = " << compressionFactor);
-            return false;
-        }
-    }
+    // Clear out the node's descendants.
+    other.m_Descendants.clear();
+
+    // Write the result back to this node.
+    descendants.swap(root.m_Descendants);
 
     return true;
 }
 
-std::string CQDigest::CNode::print() const {
-    std::ostringstream result;
-    result << '[' << m_Min << ',' << m_Max << ']';
-    return result.str();
+uint32_t CQDigest::createNode(const CNode& node) {
+    if (m_FreeNodes.empty()) {
+        m_Nodes.push_back(node);
+        m_Nodes.back().m_Ancestor = NO_NODE;
+        m_Nodes.back().m_Descendants.clear();
+        return static_cast<uint32_t>(m_Nodes.size() - 1);
+    }
+
+    // Reuse a recycled node. Its descendants have always been
+    // taken by its ancestor so this keeps their capacity.
+    uint32_t result{m_FreeNodes.back()};
+    m_FreeNodes.pop_back();
+    CNode& freeNode{m_Nodes[result]};
+    freeNode.m_Ancestor = NO_NODE;
+    freeNode.m_Descendants.clear();
+    freeNode.m_Min = node.m_Min;
+    freeNode.m_Max = node.m_Max;
+    freeNode.m_Count = node.m_Count;
+    freeNode.m_SubtreeCount = node.m_SubtreeCount;
+    return result;
 }
 
-bool CQDigest::CNode::operator==(const CNode& node) const {
-    return m_Min == node.m_Min && m_Max == node.m_Max;
+bool CQDigest::SLevelLess::operator()(const CNode& lhs, const CNode& rhs) const {
+    return lhs.span() > rhs.span() || (lhs.span() == rhs.span() && lhs.max() > rhs.max());
 }
 
-std::size_t CQDigest::CNode::numberDescendants() const {
-    return m_Descendants.size();
+bool CQDigest::SPostLess::operator()(const CNode& lhs, const CNode& rhs) const {
+    return lhs.max() < rhs.max() || (lhs.max() == rhs.max() && lhs.span() < rhs.span());
 }
 
-CQDigest::TNodePtrVecCItr CQDigest::CNode::beginDescendants() const {
-    return m_Descendants.begin();
+const std::string CQDigest::CNode::MIN_TAG("a");
+const std::string CQDigest::CNode::MAX_TAG("b");
+const std::string CQDigest::CNode::COUNT_TAG("c");
+
+CQDigest::CNode::CNode()
+    : m_Ancestor(NO_NODE), m_Descendants(), m_Min(0xDEADBEEF),
+      m_Max(0xDEADBEEF), m_Count(0xDEADBEEF), m_SubtreeCount(0xDEADBEEF) {
 }
 
-CQDigest::TNodePtrVecCItr CQDigest::CNode::endDescendants() const {
-    return m_Descendants.end();
+CQDigest::CNode::CNode(uint32_t min, uint32_t max, uint64_t count, uint64_t subtreeCount)
+    : m_Ancestor(NO_NODE), m_Descendants(), m_Min(min), m_Max(max),
+      m_Count(count), m_SubtreeCount(subtreeCount) {
 }
 
-CQDigest::CNode* CQDigest::CNode::sibling(const CNode& node) const {
-    uint32_t min = node.min();
-    node.isLeftChild() ? min += node.span() : min -= node.span();
-    uint32_t max = node.max();
-    node.isLeftChild() ? max += node.span() : max -= node.span();
-    CNode sibling(min, max, 0u, 0u);
+uint32_t CQDigest::CNode::span() const {
+    return m_Max - m_Min + 1;
+}
 
-    auto next = std::lower_bound(m_Descendants.begin(), m_Descendants.end(),
-                                 &sibling, SPostLess());
+uint32_t CQDigest::CNode::min() const {
+    return m_Min;
+}
 
-    if (next != m_Descendants.end() && (*next)->isSibling(node)) {
-        return *next;
-    }
+uint32_t CQDigest::CNode::max() const {
+    return m_Max;
+}
+
+const uint64_t& CQDigest::CNode::count() const {
+    return m_Count;
+}
 
-    return nullptr;
+const uint64_t& CQDigest::CNode::subtreeCount() const {
+    return m_SubtreeCount;
+}
+
+bool CQDigest::CNode::operator==(const CNode& node) const {
+    return m_Min == node.m_Min && m_Max == node.m_Max;
 }
 
 bool CQDigest::CNode::isSibling(const CNode& node) const {
@@ -927,7 +1023,7 @@ bool CQDigest::CNode::isAncestor(const CNode& node) const {
 }
 
 bool CQDigest::CNode::isRoot() const {
-    return m_Ancestor == nullptr;
+    return m_Ancestor == NO_NODE;
 }
 
 bool CQDigest::CNode::isLeaf() const {
@@ -943,148 +1039,43 @@ bool CQDigest::CNode::isLeftChild() const {
     return (m_Min / this->span()) % 2 == 0;
 }
 
-void CQDigest::CNode::detach(CNodeAllocator& allocator) {
-    m_Ancestor->removeDescendant(*this);
-    m_Ancestor->takeDescendants(*this);
-    m_Ancestor = nullptr;
-    allocator.release(*this);
-}
-
-void CQDigest::CNode::removeDescendant(CNode& node) {
-    // Remove node from the descendants.
-    m_Descendants.erase(std::remove(m_Descendants.begin(), m_Descendants.end(), &node),
-                        m_Descendants.end());
+void CQDigest::CNode::acceptPersistInserter(core::CStatePersistInserter& inserter) const {
+    inserter.insertValue(MIN_TAG, m_Min);
+    inserter.insertValue(MAX_TAG, m_Max);
+    inserter.insertValue(COUNT_TAG, m_Count);
 }
 
-bool CQDigest::CNode::takeDescendants(CNode& node) {
-    if (node.numberDescendants() == 0) {
-        return false;
-    }
-
-    if (!this->isAncestor(node)) {
-        // Find our descendants among the descendants of node.
-        TNodePtrVec nodesToTake;
-        TNodePtrVec nodesToLeave;
-        for (auto i = node.beginDescendants(); i != node.endDescendants(); ++i) {
-            if (this->isAncestor(**i)) {
-                nodesToTake.push_back(*i);
-                (*i)->m_Ancestor = this;
-                m_SubtreeCount += (*i)->subtreeCount();
-            } else {
-                nodesToLeave.push_back(*i);
+bool CQDigest::CNode::acceptRestoreTraverser(core::CStateRestoreTraverser& traverser) {
+    do {
+        const std::string& name = traverser.name();
+        if (name == MIN_TAG) {
+            if (core::CStringUtils::stringToType(traverser.value(), m_Min) == false) {
+                LOG_ERROR(<< "Invalid min in " << traverser.value());
+                return false;
             }
         }
-
-        // Merge the descendants.
-        TNodePtrVec descendants;
-        descendants.reserve(m_Descendants.size() + nodesToTake.size());
-        std::merge(m_Descendants.begin(), m_Descendants.end(), nodesToTake.begin(),
-                   nodesToTake.end(), std::back_inserter(descendants), SPostLess());
-
-        // Update the node's descendants.
-        nodesToLeave.swap(node.m_Descendants);
-
-        // Write the result back to this node.
-        descendants.swap(m_Descendants);
-
-        return !nodesToTake.empty();
-    }
-
-    for (auto i = node.beginDescendants(); i != node.endDescendants(); ++i) {
-        (*i)->m_Ancestor = this;
-    }
-
-    // Merge the descendants.
-    TNodePtrVec descendants;
-    descendants.reserve(m_Descendants.size() + node.numberDescendants());
-    std::merge(m_Descendants.begin(), m_Descendants.end(), node.beginDescendants(),
-               node.endDescendants(), std::back_inserter(descendants), SPostLess());
-
-    // Clear out the node's descendants.
-    TNodePtrVec empty;
-    empty.swap(node.m_Descendants);
-
-    // Write the result back to this node.
-    descendants.swap(m_Descendants);
-
-    return true;
-}
-
-CQDigest::CNodeAllocator::CNodeAllocator(std::size_t size) {
-    m_Nodes.push_back(TNodeVec());
-    m_Nodes.back().reserve(size);
-    m_FreeNodes.push_back(TNodePtrVec());
-}
-
-CQDigest::CNode& CQDigest::CNodeAllocator::create(const CNode& node) {
-    if (m_FreeNodes.front().empty()) {
-        // Add a new collection if necessary. This should
-        // only happen when merging two q-digests.
-        std::size_t size = m_Nodes.back().size();
-        if (size == m_Nodes.back().capacity()) {
-            m_Nodes.push_back(TNodeVec());
-            m_Nodes.back().reserve(size);
-            m_FreeNodes.push_back(TNodePtrVec());
-            LOG_TRACE(<< "Added new block " << m_Nodes.size());
-        }
-
-        TNodeVec& nodes = m_Nodes.back();
-        nodes.resize(nodes.size() + 1u);
-        nodes.back() = node;
-        return nodes.back();
-    }
-
-    CNode* freeNode = m_FreeNodes.front().back();
-    *freeNode = node;
-    m_FreeNodes.front().pop_back();
-    return *freeNode;
-}
-
-void CQDigest::CNodeAllocator::release(CNode& node) {
-    std::size_t block = this->findBlock(node);
-    if (block >= m_FreeNodes.size()) {
-        LOG_ABORT(<< "Bad block address = " << block
-                  << ", max = " << m_FreeNodes.size() - 1u);
-    }
-
-    m_FreeNodes[block].push_back(&node);
-
-    if (m_Nodes.size() > 1u) {
-        auto nodeItr = m_Nodes.begin();
-        std::advance(nodeItr, block);
-
-        // Remove the block if none of its nodes are in use.
-        if (m_FreeNodes[block].size() > nodeItr->size()) {
-            LOG_TRACE(<< "Removing block " << block);
-            m_FreeNodes.erase(m_FreeNodes.begin() + block);
-            m_Nodes.erase(nodeItr);
+        if (name == MAX_TAG) {
+            if (core::CStringUtils::stringToType(traverser.value(), m_Max) == false) {
+                LOG_ERROR(<< "Invalid max in " << traverser.value());
+                return false;
+            }
         }
-    }
-}
-
-std::size_t CQDigest::CNodeAllocator::findBlock(const CNode& node) const {
-    std::size_t result = 0;
-
-    if (m_Nodes.size() == 1u) {
-        return result;
-    }
-
-    const auto le = std::less_equal<const CNode*>();
-
-    for (auto i = m_Nodes.begin(); i != m_Nodes.end(); ++i, ++result) {
-        auto first = i->begin();
-        auto last = i->end();
-        if (first == last) {
-            continue;
+        if (name == COUNT_TAG) {
+            if (core::CStringUtils::stringToType(traverser.value(), m_Count) == false) {
+                LOG_ERROR(<< "Invalid count in " << traverser.value());
+                return false;
+            }
+            m_SubtreeCount = m_Count;
         }
+    } while (traverser.next());
 
-        --last;
-        if (le(&(*first), &node) && le(&node, &(*last))) {
-            break;
-        }
-    }
+    return true;
+}
 
-    return result;
+std::string CQDigest::CNode::print() const {
+    std::ostringstream result;
+    result << '[' << m_Min << ',' << m_Max << ']';
+    return result.str();
 }
 }
 }
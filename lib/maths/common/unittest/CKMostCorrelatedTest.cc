@@ -25,6 +25,8 @@
 #include <boost/range.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <vector>
 
@@ -407,6 +409,72 @@ BOOST_AUTO_TEST_CASE(testMostCorrelated) {
                         core::CContainerPrinter::print(actual));
 }
 
+BOOST_AUTO_TEST_CASE(testMostCorrelatedUnderfilledSeeds) {
+    // Check the variables with the highest estimated correlation emerge if
+    // the hashed seed pairs don't fill the collection. Each seed is compared
+    // with a bounded number of points, so this happens if we need to replace
+    // many more pairs than there are variables, but not so many that we
+    // search exhaustively. The variables are copies of a few signals so the
+    // seed pairs are all perfectly correlated and the search must look beyond
+    // the least correlated seed to fill the collection.
+
+    using TMaxCorrelationAccumulator =
+        maths::common::CBasicStatistics::COrderStatisticsHeap<CKMostCorrelatedForTest::TCorrelation>;
+
+    maths::common::CSampling::seed();
+
+    test::CRandomNumbers rng;
+
+    std::size_t signals = 6;
+    std::size_t variables = 1250;
+    std::size_t k = 70000;
+
+    CKMostCorrelatedForTest mostCorrelated(k, 0.0);
+    mostCorrelated.addVariables(variables);
+
+    TDoubleVec samples;
+    for (std::size_t i = 0; i < 19; ++i) {
+        rng.generateUniformSamples(0.0, 10.0, signals, samples);
+        for (std::size_t X = 0; X < variables; ++X) {
+            mostCorrelated.add(X, samples[X % signals]);
+        }
+        mostCorrelated.capture();
+    }
+
+    std::size_t V = mostCorrelated.projected().size();
+    BOOST_TEST_REQUIRE(2 * k > 96 * V);
+    BOOST_TEST_REQUIRE(10 * 2 * k <= V * (V - 1));
+
+    TMaxCorrelationAccumulator expected(2 * k);
+    for (CKMostCorrelatedForTest::TSizeVectorPackedBitVectorPrUMapCItr x =
+             mostCorrelated.projected().begin();
+         x != mostCorrelated.projected().end(); ++x) {
+        std::size_t X = x->first;
+        CKMostCorrelatedForTest::TSizeVectorPackedBitVectorPrUMapCItr y = x;
+        while (++y != mostCorrelated.projected().end()) {
+            std::size_t Y = y->first;
+            CKMostCorrelatedForTest::TCorrelation cxy(X, x->second.first,
+                                                      x->second.second, Y,
+                                                      y->second.first, y->second.second);
+            expected.add(cxy);
+        }
+    }
+    expected.sort();
+
+    CKMostCorrelatedForTest::TCorrelationVec actual;
+    mostCorrelated.mostCorrelated(actual);
+
+    // Many pairs are equally correlated so we check the correlations match.
+    BOOST_REQUIRE_EQUAL(expected.count(), actual.size());
+    double maximumError{0.0};
+    for (std::size_t i = 0; i < actual.size(); ++i) {
+        maximumError = std::max(maximumError, std::fabs(expected[i].absCorrelation() -
+                                                        actual[i].absCorrelation()));
+    }
+    LOG_DEBUG(<< "maximum error = " << maximumError);
+    BOOST_TEST_REQUIRE(maximumError < 1e-10);
+}
+
 BOOST_AUTO_TEST_CASE(testRemoveVariables) {
     // Test we correctly remove correlated pairs which include a variable
     // to prune.
@@ -145,8 +145,47 @@ BOOST_AUTO_TEST_CASE(testAdd) {
     }
 }
 
-BOOST_AUTO_TEST_CASE(testMerge, *boost::unit_test::disabled()) {
-    // TODO
+BOOST_AUTO_TEST_CASE(testMerge) {
+    // Test that merging two q-digests is close to adding all the
+    // values to a single q-digest.
+
+    CRandomNumbers generator;
+
+    TDoubleVec samples;
+    generator.generateUniformSamples(0.0, 5000.0, 4000u, samples);
+
+    CQDigest qDigest1(100u);
+    CQDigest qDigest2(100u);
+    CQDigest qDigestAll(100u);
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        uint32_t sample = static_cast<uint32_t>(std::floor(samples[i]));
+        // Use different ranges so the merged digest needs expanding.
+        (i < 3000 ? qDigest1 : qDigest2).add(i < 3000 ? sample / 4 : sample);
+        qDigestAll.add(i < 3000 ? sample / 4 : sample);
+    }
+
+    qDigest1.merge(qDigest2);
+    LOG_DEBUG(<< qDigest1.print());
+
+    BOOST_TEST_REQUIRE(qDigest1.checkInvariants());
+    BOOST_REQUIRE_EQUAL(qDigestAll.n(), qDigest1.n());
+
+    for (std::size_t i = 1; i < 20; ++i) {
+        double q = static_cast<double>(i) / 20.0;
+        double lowerBound;
+        double upperBound;
+        double expectedLowerBound;
+        double expectedUpperBound;
+        uint32_t quantile;
+        qDigest1.quantile(q, quantile);
+        qDigest1.cdf(quantile, 0.0, lowerBound, upperBound);
+        qDigestAll.cdf(quantile, 0.0, expectedLowerBound, expectedUpperBound);
+        LOG_TRACE(<< "q = " << q << ", quantile = " << quantile << ", cdf = ["
+                  << lowerBound << "," << upperBound << "], expected ["
+                  << expectedLowerBound << "," << expectedUpperBound << "]");
+        BOOST_REQUIRE_CLOSE_ABSOLUTE(expectedLowerBound, lowerBound, 0.05);
+        BOOST_REQUIRE_CLOSE_ABSOLUTE(expectedUpperBound, upperBound, 0.05);
+    }
 }
 
 BOOST_AUTO_TEST_CASE(testCdf) {
@@ -579,4 +618,58 @@ BOOST_AUTO_TEST_CASE(testPersist) {
     BOOST_REQUIRE_EQUAL(origXml, newXml);
 }
 
+BOOST_AUTO_TEST_CASE(testReuse) {
+    // Test that clearing and restoring into a q-digest which already
+    // holds values, and so has recycled nodes, gives the same result
+    // as using a new q-digest.
+
+    CRandomNumbers generator;
+
+    TDoubleVec samples;
+    generator.generateUniformSamples(0.0, 5000.0, 1000u, samples);
+
+    CQDigest qDigest(50u, 0.01);
+    CQDigest expectedQDigest(50u, 0.01);
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        qDigest.add(static_cast<uint32_t>(std::floor(samples[i] / 2.0)));
+    }
+    qDigest.propagateForwardsByTime(1.0);
+    qDigest.clear();
+    BOOST_REQUIRE_EQUAL(expectedQDigest.print(), qDigest.print());
+
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        uint32_t sample = static_cast<uint32_t>(std::floor(samples[i]));
+        qDigest.add(sample);
+        expectedQDigest.add(sample);
+        if (i % 100 == 99) {
+            qDigest.propagateForwardsByTime(1.0);
+            expectedQDigest.propagateForwardsByTime(1.0);
+        }
+    }
+    BOOST_TEST_REQUIRE(qDigest.checkInvariants());
+    BOOST_REQUIRE_EQUAL(expectedQDigest.print(), qDigest.print());
+
+    std::string xml;
+    {
+        core::CRapidXmlStatePersistInserter inserter("root");
+        expectedQDigest.acceptPersistInserter(inserter);
+        inserter.toXml(xml);
+    }
+
+    CQDigest restoredQDigest(50u, 0.01);
+    for (std::size_t i = 0; i < 100; ++i) {
+        restoredQDigest.add(static_cast<uint32_t>(i * i));
+    }
+    {
+        core::CRapidXmlParser parser;
+        BOOST_TEST_REQUIRE(parser.parseStringIgnoreCdata(xml));
+        core::CRapidXmlStateRestoreTraverser traverser(parser);
+        BOOST_TEST_REQUIRE(traverser.traverseSubLevel(std::bind(
+            &CQDigest::acceptRestoreTraverser, &restoredQDigest, std::placeholders::_1)));
+    }
+    BOOST_TEST_REQUIRE(restoredQDigest.checkInvariants());
+    BOOST_REQUIRE_EQUAL(expectedQDigest.print(), restoredQDigest.print());
+    BOOST_REQUIRE_EQUAL(expectedQDigest.checksum(0), restoredQDigest.checksum(0));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
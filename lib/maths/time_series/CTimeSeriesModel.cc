@@ -13,9 +13,12 @@
 
 #include <core/CAllocationStrategy.h>
 #include <core/CFunctional.h>
+#include <core/CJsonStatePersistInserter.h>
+#include <core/CJsonStateRestoreTraverser.h>
 #include <core/CPersistUtils.h>
 #include <core/RestoreMacros.h>
 #include <core/UnwrapRef.h>
+#include <core/CompressUtils.h>
 
 #include <maths/common/CBasicStatistics.h>
 #include <maths/common/CBasicStatisticsPersist.h>
@@ -37,10 +40,13 @@
 #include <maths/time_series/CTimeSeriesMultibucketFeatures.h>
 #include <maths/time_series/CTimeSeriesSegmentation.h>
 
+#include <atomic>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <numeric>
+#include <sstream>
 #include <tuple>
 
 namespace ml {
@@ -147,6 +153,8 @@ const std::string PRIOR_OLD_TAG{"d"};
 const std::string ANOMALY_MODEL_OLD_TAG{"e"};
 const std::string IS_NON_NEGATIVE_OLD_TAG{"g"};
 const std::string IS_FORECASTABLE_OLD_TAG{"h"};
+// Compact state. This is never persisted as part of the model state.
+const std::string COMPACT_STATE_TAG{"a"};
 
 // Anomaly model
 // Version >= 7.3
@@ -605,6 +613,37 @@ void CTimeSeriesAnomalyModel::acceptPersistInserter(core::CStatePersistInserter&
 const maths_t::TDouble10VecWeightsAry1Vec CTimeSeriesAnomalyModel::UNIT{
     maths_t::CUnitWeights::unit<TDouble10Vec>(2)};
 
+namespace {
+//! Identifies each compacted state. Copies of a state share its identifier.
+std::atomic<std::uint64_t> nextCompactStateId{1};
+
+//! The number of times compact models have been restored for const queries.
+std::atomic<std::size_t> compactStateRestoreCount{0};
+}
+
+struct CUnivariateTimeSeriesModel::SCompactState {
+    SCompactState(const common::STimeSeriesDecompositionRestoreParams& decompositionParams,
+                  const common::SDistributionRestoreParams& distributionParams)
+        : s_Id{nextCompactStateId.fetch_add(1)},
+          s_DecompositionParams{decompositionParams}, s_DistributionParams{distributionParams} {}
+
+    void debugMemoryUsage(const core::CMemoryUsage::TMemoryUsagePtr& mem) const {
+        mem->setName("SCompactState");
+        core::CMemoryDebug::dynamicSize("s_State", s_State, mem);
+    }
+
+    std::size_t memoryUsage() const { return core::CMemory::dynamicSize(s_State); }
+
+    //! The unique identifier of this state.
+    std::uint64_t s_Id;
+    //! The parameters needed to restore the trend model.
+    common::STimeSeriesDecompositionRestoreParams s_DecompositionParams;
+    //! The parameters needed to restore the residual models.
+    common::SDistributionRestoreParams s_DistributionParams;
+    //! The deflated persisted state of the trend and residual models.
+    core::CCompressUtil::TByteVec s_State;
+};
+
 CUnivariateTimeSeriesModel::CUnivariateTimeSeriesModel(
     const common::CModelParams& params,
     std::size_t id,
@@ -647,7 +686,7 @@ std::size_t CUnivariateTimeSeriesModel::identifier() const {
 }
 
 CUnivariateTimeSeriesModel* CUnivariateTimeSeriesModel::clone(std::size_t id) const {
-    CUnivariateTimeSeriesModel* result{new CUnivariateTimeSeriesModel{*this, id}};
+    CUnivariateTimeSeriesModel* result{new CUnivariateTimeSeriesModel{*this, id, E_SharedCopy}};
     if (m_Correlations != nullptr) {
         result->modelCorrelations(*m_Correlations);
     }
@@ -659,14 +698,19 @@ CUnivariateTimeSeriesModel* CUnivariateTimeSeriesModel::cloneForPersistence() co
 }
 
 CUnivariateTimeSeriesModel* CUnivariateTimeSeriesModel::cloneForForecast() const {
-    return new CUnivariateTimeSeriesModel{*this, m_Id, true};
+    return new CUnivariateTimeSeriesModel{*this, m_Id, E_ForecastCopy};
 }
 
 bool CUnivariateTimeSeriesModel::isForecastPossible() const {
+    if (m_CompactState != nullptr) {
+        return this->inflatedCopy()->isForecastPossible();
+    }
     return m_IsForecastable && !m_ResidualModel->isNonInformative();
 }
 
 void CUnivariateTimeSeriesModel::modelCorrelations(CTimeSeriesCorrelations& model) {
+    // Correlated models access one another's trend models directly.
+    this->inflate();
     m_Correlations = &model;
     m_Correlations->addTimeSeries(m_Id, *this);
 }
@@ -687,6 +731,8 @@ CUnivariateTimeSeriesModel::TSize2Vec1Vec CUnivariateTimeSeriesModel::correlates
 }
 
 void CUnivariateTimeSeriesModel::addBucketValue(const TTimeDouble2VecSizeTrVec& values) {
+    this->inflate();
+    this->copyOnWrite();
     for (const auto& value : values) {
         m_ResidualModel->adjustOffset(
             {m_TrendModel->detrend(value.first, value.second[0], 0.0)},
@@ -701,6 +747,9 @@ CUnivariateTimeSeriesModel::addSamples(const common::CModelAddSamplesParams& par
         return E_Success;
     }
 
+    this->inflate();
+    this->copyOnWrite();
+
     TSizeVec valueorder(samples.size());
     std::iota(valueorder.begin(), valueorder.end(), 0);
     std::stable_sort(valueorder.begin(), valueorder.end(),
@@ -790,11 +839,16 @@ CUnivariateTimeSeriesModel::addSamples(const common::CModelAddSamplesParams& par
 }
 
 void CUnivariateTimeSeriesModel::skipTime(core_t::TTime gap) {
+    this->inflate();
+    this->copyOnWrite();
     m_TrendModel->skipTime(gap);
 }
 
 CUnivariateTimeSeriesModel::TDouble2Vec
 CUnivariateTimeSeriesModel::mode(core_t::TTime time, const TDouble2VecWeightsAry& weights) const {
+    if (m_CompactState != nullptr) {
+        return this->inflatedCopy()->mode(time, weights);
+    }
     return {m_ResidualModel->marginalLikelihoodMode(unpack(weights)) +
             common::CBasicStatistics::mean(m_TrendModel->value(time))};
 }
@@ -802,6 +856,9 @@ CUnivariateTimeSeriesModel::mode(core_t::TTime time, const TDouble2VecWeightsAry
 CUnivariateTimeSeriesModel::TDouble2Vec1Vec
 CUnivariateTimeSeriesModel::correlateModes(core_t::TTime time,
                                            const TDouble2VecWeightsAry1Vec& weights) const {
+    if (m_CompactState != nullptr) {
+        return this->inflatedCopy()->correlateModes(time, weights);
+    }
     TDouble2Vec1Vec result;
 
     TSize1Vec correlated;
@@ -829,6 +886,9 @@ CUnivariateTimeSeriesModel::correlateModes(core_t::TTime time,
 
 CUnivariateTimeSeriesModel::TDouble2Vec1Vec
 CUnivariateTimeSeriesModel::residualModes(const TDouble2VecWeightsAry& weights) const {
+    if (m_CompactState != nullptr) {
+        return this->inflatedCopy()->residualModes(weights);
+    }
     TDouble2Vec1Vec result;
     TDouble1Vec modes(m_ResidualModel->marginalLikelihoodModes(unpack(weights)));
     result.reserve(modes.size());
@@ -844,6 +904,10 @@ void CUnivariateTimeSeriesModel::detrend(const TTime2Vec1Vec& time,
     if (value.empty()) {
         return;
     }
+    if (m_CompactState != nullptr) {
+        this->inflatedCopy()->detrend(time, confidenceInterval, value);
+        return;
+    }
 
     if (value[0].size() == 1) {
         value[0][0] = m_TrendModel->detrend(time[0][0], value[0][0], confidenceInterval);
@@ -872,6 +936,10 @@ CUnivariateTimeSeriesModel::TDouble2Vec
 CUnivariateTimeSeriesModel::predict(core_t::TTime time,
                                     const TSizeDoublePr1Vec& correlatedValue,
                                     TDouble2Vec hint) const {
+    if (m_CompactState != nullptr) {
+        return this->inflatedCopy()->predict(time, correlatedValue, std::move(hint));
+    }
+
     double correlateCorrection{0.0};
     if (!correlatedValue.empty()) {
         TSize1Vec correlated{correlatedValue[0].first};
@@ -919,6 +987,10 @@ CUnivariateTimeSeriesModel::TDouble2Vec3Vec
 CUnivariateTimeSeriesModel::confidenceInterval(core_t::TTime time,
                                                double confidenceInterval,
                                                const TDouble2VecWeightsAry& weights_) const {
+    if (m_CompactState != nullptr) {
+        return this->inflatedCopy()->confidenceInterval(time, confidenceInterval, weights_);
+    }
+
     if (m_ResidualModel->isNonInformative()) {
         return TDouble2Vec3Vec();
     }
@@ -950,6 +1022,8 @@ bool CUnivariateTimeSeriesModel::forecast(core_t::TTime firstDataTime,
                                           const common::TForecastPushDatapointFunc& forecastPushDataPointFunc,
                                           std::string& messageOut) {
 
+    this->inflate();
+
     core_t::TTime horizon{std::min(lastDataTime + (lastDataTime - firstDataTime),
                                    lastDataTime + m_TrendModel->maximumForecastInterval())};
 
@@ -994,6 +1068,9 @@ bool CUnivariateTimeSeriesModel::probability(const common::CModelProbabilityPara
     if (value.empty()) {
         return true;
     }
+    if (m_CompactState != nullptr) {
+        return this->inflatedCopy()->probability(params, time, value, result);
+    }
     return value[0].size() == 1
                ? this->uncorrelatedProbability(params, time, value, result)
                : this->correlatedProbability(params, time, value, result);
@@ -1223,6 +1300,13 @@ void CUnivariateTimeSeriesModel::countWeights(core_t::TTime time,
                                               double countVarianceScale,
                                               TDouble2VecWeightsAry& trendWeights,
                                               TDouble2VecWeightsAry& residuaWeights) const {
+    if (m_CompactState != nullptr) {
+        this->inflatedCopy()->countWeights(time, value, trendCountWeight, residualCountWeight,
+                                           winsorisationDerate, countVarianceScale, trendWeights,
+                                           residuaWeights);
+        return;
+    }
+
     if (m_TrendModel->seasonalComponents().size() > 0) {
         countVarianceScale = 1.0;
     }
@@ -1258,6 +1342,12 @@ void CUnivariateTimeSeriesModel::addCountWeights(core_t::TTime time,
                                                  double countVarianceScale,
                                                  TDouble2VecWeightsAry& trendWeights,
                                                  TDouble2VecWeightsAry& residuaWeights) const {
+    if (m_CompactState != nullptr) {
+        this->inflatedCopy()->addCountWeights(time, trendCountWeight, residualCountWeight,
+                                              countVarianceScale, trendWeights, residuaWeights);
+        return;
+    }
+
     if (m_TrendModel->seasonalComponents().empty()) {
         countVarianceScale = 1.0;
     }
@@ -1272,6 +1362,10 @@ void CUnivariateTimeSeriesModel::addCountWeights(core_t::TTime time,
 void CUnivariateTimeSeriesModel::seasonalWeight(double confidence,
                                                 core_t::TTime time,
                                                 TDouble2Vec& weight) const {
+    if (m_CompactState != nullptr) {
+        this->inflatedCopy()->seasonalWeight(confidence, time, weight);
+        return;
+    }
     double scale{m_TrendModel
                      ->varianceScaleWeight(time, m_ResidualModel->marginalLikelihoodVariance(), confidence)
                      .second};
@@ -1279,6 +1373,9 @@ void CUnivariateTimeSeriesModel::seasonalWeight(double confidence,
 }
 
 std::uint64_t CUnivariateTimeSeriesModel::checksum(std::uint64_t seed) const {
+    if (m_CompactState != nullptr) {
+        return this->inflatedCopy()->checksum(seed);
+    }
     seed = common::CChecksum::calculate(seed, m_IsNonNegative);
     seed = common::CChecksum::calculate(seed, m_Controllers);
     seed = common::CChecksum::calculate(seed, m_TrendModel);
@@ -1298,6 +1395,7 @@ void CUnivariateTimeSeriesModel::debugMemoryUsage(const core::CMemoryUsage::TMem
     core::CMemoryDebug::dynamicSize("m_MultibucketFeatureModel",
                                     m_MultibucketFeatureModel, mem);
     core::CMemoryDebug::dynamicSize("m_AnomalyModel", m_AnomalyModel, mem);
+    core::CMemoryDebug::dynamicSize("m_CompactState", m_CompactState, mem);
 }
 
 std::size_t CUnivariateTimeSeriesModel::memoryUsage() const {
@@ -1306,7 +1404,8 @@ std::size_t CUnivariateTimeSeriesModel::memoryUsage() const {
            core::CMemory::dynamicSize(m_ResidualModel) +
            core::CMemory::dynamicSize(m_MultibucketFeature) +
            core::CMemory::dynamicSize(m_MultibucketFeatureModel) +
-           core::CMemory::dynamicSize(m_AnomalyModel);
+           core::CMemory::dynamicSize(m_AnomalyModel) +
+           core::CMemory::dynamicSize(m_CompactState);
 }
 
 bool CUnivariateTimeSeriesModel::acceptRestoreTraverser(const common::SModelRestoreParams& params,
@@ -1401,6 +1500,11 @@ void CUnivariateTimeSeriesModel::checkRestoredInvariants() const {
 }
 
 void CUnivariateTimeSeriesModel::persistModelsState(core::CStatePersistInserter& inserter) const {
+    if (m_CompactState != nullptr) {
+        this->inflatedCopy()->persistModelsState(inserter);
+        return;
+    }
+
     if (m_TrendModel != nullptr) {
         inserter.insertLevel(
             TREND_MODEL_6_3_TAG,
@@ -1419,7 +1523,13 @@ void CUnivariateTimeSeriesModel::persistModelsState(core::CStatePersistInserter&
 void CUnivariateTimeSeriesModel::acceptPersistInserter(core::CStatePersistInserter& inserter) const {
 
     // Note that we don't persist this->params() or the correlations
-    // because that state is reinitialized.
+    // because that state is reinitialized. Compact models are persisted
+    // in the same format as other models.
+    if (m_CompactState != nullptr) {
+        this->inflatedCopy()->acceptPersistInserter(inserter);
+        return;
+    }
+
     inserter.insertValue(VERSION_7_11_TAG, "");
     inserter.insertValue(ID_6_3_TAG, m_Id);
     inserter.insertValue(IS_NON_NEGATIVE_6_3_TAG, static_cast<int>(m_IsNonNegative));
@@ -1459,7 +1569,54 @@ void CUnivariateTimeSeriesModel::acceptPersistInserter(core::CStatePersistInsert
 }
 
 maths_t::EDataType CUnivariateTimeSeriesModel::dataType() const {
-    return m_ResidualModel->dataType();
+    return m_ResidualModel != nullptr ? m_ResidualModel->dataType()
+                                      : m_CompactState->s_DistributionParams.s_DataType;
+}
+
+void CUnivariateTimeSeriesModel::compact(const common::STimeSeriesDecompositionRestoreParams& decompositionParams,
+                                         const common::SDistributionRestoreParams& distributionParams) {
+    // We can't compact models which are shared with other models or which
+    // are referenced by the models of correlated time series.
+    if (m_CompactState != nullptr || m_Correlations != nullptr ||
+        m_TrendModel.use_count() > 1 || m_ResidualModel.use_count() > 1 ||
+        m_MultibucketFeatureModel.use_count() > 1) {
+        return;
+    }
+
+    std::ostringstream state;
+    {
+        core::CJsonStatePersistInserter inserter{state};
+        inserter.insertLevel(COMPACT_STATE_TAG,
+                             std::bind(&CUnivariateTimeSeriesModel::persistCompactState,
+                                       this, std::placeholders::_1));
+    }
+
+    auto compactState = std::make_unique<SCompactState>(decompositionParams,
+                                                        distributionParams);
+    core::CDeflator compressor{false, Z_BEST_COMPRESSION};
+    if (compressor.addString(state.str()) == false ||
+        compressor.finishAndTakeData(compactState->s_State) == false) {
+        LOG_ERROR(<< "Failed to compact model state");
+        return;
+    }
+    compactState->s_State.shrink_to_fit();
+
+    // The models are already stored efficiently so compressing them doesn't
+    // always save memory.
+    if (core::CMemory::dynamicSize(compactState) >=
+        core::CMemory::dynamicSize(m_TrendModel) + core::CMemory::dynamicSize(m_ResidualModel) +
+            core::CMemory::dynamicSize(m_MultibucketFeatureModel)) {
+        return;
+    }
+
+    m_CompactState = std::move(compactState);
+    m_TrendModel.reset();
+    m_ResidualModel.reset();
+    m_MultibucketFeatureModel.reset();
+}
+
+bool CUnivariateTimeSeriesModel::isCompact() const {
+    return m_CompactState != nullptr;
 }
 
 CUnivariateTimeSeriesModel::TDoubleWeightsAry
@@ -1472,10 +1629,16 @@ CUnivariateTimeSeriesModel::unpack(const TDouble2VecWeightsAry& weights) {
 }
 
 const CTimeSeriesDecompositionInterface& CUnivariateTimeSeriesModel::trendModel() const {
+    if (m_CompactState != nullptr) {
+        LOG_ABORT(<< "Can't access the trend of a compact model");
+    }
     return *m_TrendModel;
 }
 
 const common::CPrior& CUnivariateTimeSeriesModel::residualModel() const {
+    if (m_CompactState != nullptr) {
+        LOG_ABORT(<< "Can't access the residual model of a compact model");
+    }
     return *m_ResidualModel;
 }
 
@@ -1484,26 +1647,155 @@ CUnivariateTimeSeriesModel::decayRateControllers() const {
     return m_Controllers.get();
 }
 
+std::size_t CUnivariateTimeSeriesModel::numberCompactStateRestores() {
+    return compactStateRestoreCount.load();
+}
+
 CUnivariateTimeSeriesModel::CUnivariateTimeSeriesModel(const CUnivariateTimeSeriesModel& other,
                                                        std::size_t id,
-                                                       bool isForForecast)
+                                                       ECopyType type)
     : common::CModel(other.params()), m_Id(id),
       m_IsNonNegative(other.m_IsNonNegative), m_IsForecastable(other.m_IsForecastable),
-      m_TrendModel(other.m_TrendModel->clone()),
-      m_ResidualModel(other.m_ResidualModel->clone()),
-      m_MultibucketFeature(!isForForecast && other.m_MultibucketFeature
+      m_TrendModel(type == E_SharedCopy || other.m_TrendModel == nullptr
+                       ? other.m_TrendModel
+                       : TDecompositionPtr{other.m_TrendModel->clone()}),
+      m_ResidualModel(type == E_SharedCopy || other.m_ResidualModel == nullptr
+                          ? other.m_ResidualModel
+                          : TPriorPtr{other.m_ResidualModel->clone()}),
+      m_MultibucketFeature(type != E_ForecastCopy && other.m_MultibucketFeature
                                ? other.m_MultibucketFeature->clone()
                                : nullptr),
-      m_MultibucketFeatureModel(!isForForecast && other.m_MultibucketFeatureModel != nullptr
-                                    ? other.m_MultibucketFeatureModel->clone()
-                                    : nullptr),
-      m_AnomalyModel(!isForForecast && other.m_AnomalyModel != nullptr
+      m_AnomalyModel(type != E_ForecastCopy && other.m_AnomalyModel != nullptr
                          ? std::make_unique<CTimeSeriesAnomalyModel>(*other.m_AnomalyModel)
                          : nullptr),
       m_Correlations(nullptr) {
-    if (!isForForecast && other.m_Controllers != nullptr) {
+    if (type == E_SharedCopy) {
+        m_MultibucketFeatureModel = other.m_MultibucketFeatureModel;
+    } else if (type != E_ForecastCopy && other.m_MultibucketFeatureModel != nullptr) {
+        m_MultibucketFeatureModel.reset(other.m_MultibucketFeatureModel->clone());
+    }
+    if (type != E_ForecastCopy && other.m_Controllers != nullptr) {
         m_Controllers = std::make_unique<TDecayRateController2Ary>(*other.m_Controllers);
     }
+    if (other.m_CompactState != nullptr) {
+        if (type == E_InflatedCopy) {
+            this->inflateShared(*other.m_CompactState);
+        } else if (type == E_ForecastCopy) {
+            // Forecasting doesn't use the multi-bucket feature model.
+            this->inflate(*other.m_CompactState);
+            m_MultibucketFeatureModel.reset();
+        } else {
+            m_CompactState = std::make_unique<SCompactState>(*other.m_CompactState);
+        }
+    }
+}
+
+void CUnivariateTimeSeriesModel::inflate() {
+    if (m_CompactState != nullptr) {
+        this->inflate(*m_CompactState);
+        m_CompactState.reset();
+    }
+}
+
+void CUnivariateTimeSeriesModel::inflate(const SCompactState& state) {
+    core::CInflator decompressor{false};
+    core::CCompressUtil::TByteVec bytes;
+    if (decompressor.addVector(state.s_State) == false ||
+        decompressor.finishAndTakeData(bytes) == false) {
+        LOG_ABORT(<< "Failed to inflate compact model state");
+    }
+    std::istringstream input{std::string(bytes.begin(), bytes.end())};
+    core::CJsonStateRestoreTraverser traverser{input};
+    common::SModelRestoreParams params{this->params(), state.s_DecompositionParams,
+                                       state.s_DistributionParams};
+    if (traverser.traverseSubLevel(std::bind(&CUnivariateTimeSeriesModel::restoreCompactState,
+                                             this, std::cref(params),
+                                             std::placeholders::_1)) == false ||
+        m_TrendModel == nullptr || m_ResidualModel == nullptr) {
+        LOG_ABORT(<< "Failed to restore compact model state");
+    }
+}
+
+void CUnivariateTimeSeriesModel::inflateShared(const SCompactState& state) {
+    // Const queries of a compact model usually come in runs for one model,
+    // for example computing its probability and influences, so we keep the
+    // models restored for the last compact state on each thread. These are
+    // never modified: inflated copies are only used for const queries.
+    struct SInflatedModels {
+        std::uint64_t s_Id{0};
+        TDecompositionPtr s_TrendModel;
+        TPriorPtr s_ResidualModel;
+        TPriorPtr s_MultibucketFeatureModel;
+    };
+    static thread_local SInflatedModels last;
+
+    if (last.s_Id != state.s_Id) {
+        this->inflate(state);
+        ++compactStateRestoreCount;
+        last.s_Id = state.s_Id;
+        last.s_TrendModel = m_TrendModel;
+        last.s_ResidualModel = m_ResidualModel;
+        last.s_MultibucketFeatureModel = m_MultibucketFeatureModel;
+    } else {
+        m_TrendModel = last.s_TrendModel;
+        m_ResidualModel = last.s_ResidualModel;
+        m_MultibucketFeatureModel = last.s_MultibucketFeatureModel;
+    }
+}
+
+CUnivariateTimeSeriesModel::TUnivariateTimeSeriesModelPtr
+CUnivariateTimeSeriesModel::inflatedCopy() const {
+    return TUnivariateTimeSeriesModelPtr{
+        new CUnivariateTimeSeriesModel{*this, m_Id, E_InflatedCopy}};
+}
+
+void CUnivariateTimeSeriesModel::persistCompactState(core::CStatePersistInserter& inserter) const {
+    inserter.insertLevel(TREND_MODEL_6_3_TAG,
+                         std::bind<void>(CTimeSeriesDecompositionStateSerialiser{},
+                                         std::cref(*m_TrendModel), std::placeholders::_1));
+    inserter.insertLevel(RESIDUAL_MODEL_6_3_TAG,
+                         std::bind<void>(common::CPriorStateSerialiser{},
+                                         std::cref(*m_ResidualModel), std::placeholders::_1));
+    if (m_MultibucketFeatureModel != nullptr) {
+        inserter.insertLevel(MULTIBUCKET_FEATURE_MODEL_6_3_TAG,
+                             std::bind<void>(common::CPriorStateSerialiser{},
+                                             std::cref(*m_MultibucketFeatureModel),
+                                             std::placeholders::_1));
+    }
+}
+
+bool CUnivariateTimeSeriesModel::restoreCompactState(const common::SModelRestoreParams& params,
+                                                     core::CStateRestoreTraverser& traverser) {
+    do {
+        const std::string& name{traverser.name()};
+        RESTORE(TREND_MODEL_6_3_TAG, traverser.traverseSubLevel(std::bind<bool>(
+                                         CTimeSeriesDecompositionStateSerialiser(),
+                                         std::cref(params.s_DecompositionParams),
+                                         std::ref(m_TrendModel), std::placeholders::_1)))
+        RESTORE(RESIDUAL_MODEL_6_3_TAG,
+                traverser.traverseSubLevel(std::bind<bool>(
+                    common::CPriorStateSerialiser(), std::cref(params.s_DistributionParams),
+                    std::ref(m_ResidualModel), std::placeholders::_1)))
+        RESTORE(MULTIBUCKET_FEATURE_MODEL_6_3_TAG,
+                traverser.traverseSubLevel(std::bind<bool>(
+                    common::CPriorStateSerialiser(), std::cref(params.s_DistributionParams),
+                    std::ref(m_MultibucketFeatureModel), std::placeholders::_1)))
+    } while (traverser.next());
+    return true;
+}
+
+void CUnivariateTimeSeriesModel::copyOnWrite() {
+    // Models cloned for new series share these with their prototype until
+    // they are first updated.
+    if (m_TrendModel.use_count() > 1) {
+        m_TrendModel.reset(m_TrendModel->clone());
+    }
+    if (m_ResidualModel.use_count() > 1) {
+        m_ResidualModel.reset(m_ResidualModel->clone());
+    }
+    if (m_MultibucketFeatureModel != nullptr && m_MultibucketFeatureModel.use_count() > 1) {
+        m_MultibucketFeatureModel.reset(m_MultibucketFeatureModel->clone());
+    }
 }
 
 CUnivariateTimeSeriesModel::EUpdateResult
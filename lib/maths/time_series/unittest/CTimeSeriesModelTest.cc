@@ -15,6 +15,7 @@
 #include <core/CRapidXmlStatePersistInserter.h>
 #include <core/CRapidXmlStateRestoreTraverser.h>
 
+#include <maths/common/CGammaRateConjugate.h>
 #include <maths/common/CLogNormalMeanPrecConjugate.h>
 #include <maths/common/CMultimodalPrior.h>
 #include <maths/common/CMultivariateMultimodalPrior.h>
@@ -155,6 +156,11 @@ maths::common::CNormalMeanPrecConjugate univariateNormal(double decayRate = DECA
         maths_t::E_ContinuousData, decayRate);
 }
 
+maths::common::CGammaRateConjugate univariateGamma(double decayRate = DECAY_RATE) {
+    return maths::common::CGammaRateConjugate::nonInformativePrior(
+        maths_t::E_ContinuousData, 0.0, decayRate);
+}
+
 maths::common::CLogNormalMeanPrecConjugate univariateLogNormal(double decayRate = DECAY_RATE) {
     return maths::common::CLogNormalMeanPrecConjugate::nonInformativePrior(
         maths_t::E_ContinuousData, 0.0, decayRate);
@@ -423,6 +429,54 @@ BOOST_AUTO_TEST_CASE(testClone) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(testCloneSharesStateUntilUpdated) {
+    // Test that clones share the trend and residual models with their
+    // prototype until they're updated and that updates are not visible
+    // to the prototype or other clones.
+
+    core_t::TTime bucketLength{600};
+
+    test::CRandomNumbers rng;
+
+    maths::time_series::CTimeSeriesDecomposition trend{DECAY_RATE, bucketLength};
+    auto controllers = decayRateControllers(1);
+    maths::time_series::CUnivariateTimeSeriesModel prototype(
+        modelParams(bucketLength), 0, trend, univariateNormal(), &controllers);
+
+    std::size_t prototypeMemory{prototype.memoryUsage()};
+    std::uint64_t prototypeChecksum{prototype.checksum()};
+
+    std::vector<std::unique_ptr<maths::time_series::CUnivariateTimeSeriesModel>> clones;
+    for (std::size_t i = 1; i <= 10; ++i) {
+        clones.emplace_back(prototype.clone(i));
+    }
+
+    // The shared state is divided between the models which share it.
+    std::size_t cloneMemory{clones[0]->memoryUsage()};
+    LOG_DEBUG(<< "prototype memory = " << prototypeMemory << ", clone memory = " << cloneMemory);
+    BOOST_TEST_REQUIRE(2 * cloneMemory < prototypeMemory);
+    for (const auto& clone : clones) {
+        BOOST_REQUIRE_EQUAL(prototypeChecksum, clone->checksum());
+    }
+
+    TDoubleVec samples;
+    rng.generateNormalSamples(1.0, 4.0, 100, samples);
+    TDouble2VecWeightsAryVec weights{maths_t::CUnitWeights::unit<TDouble2Vec>(1)};
+    core_t::TTime time{0};
+    for (auto sample : samples) {
+        clones[0]->addSamples(addSampleParams(weights),
+                              {core::make_triple(time, TDouble2Vec{sample}, TAG)});
+        time += bucketLength;
+    }
+
+    BOOST_TEST_REQUIRE(prototypeChecksum != clones[0]->checksum());
+    BOOST_TEST_REQUIRE(clones[0]->memoryUsage() > cloneMemory);
+    BOOST_REQUIRE_EQUAL(prototypeChecksum, prototype.checksum());
+    for (std::size_t i = 1; i < clones.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(prototypeChecksum, clones[i]->checksum());
+    }
+}
+
 BOOST_AUTO_TEST_CASE(testMode) {
     // Test that we get the modes we expect based versus updating the trend(s)
     // and prior directly.
@@ -1708,6 +1762,141 @@ BOOST_AUTO_TEST_CASE(testMemoryUsage) {
     // TODO LOG_DEBUG(<< "Correlates");
 }
 
+BOOST_AUTO_TEST_CASE(testCompact) {
+    // Test that compacting the model of a sparse time series reduces its
+    // memory and that it behaves identically to the original model thereafter.
+
+    core_t::TTime bucketLength{600};
+    maths::common::CModelParams params{modelParams(bucketLength)};
+
+    test::CRandomNumbers rng;
+
+    maths::time_series::CTimeSeriesDecomposition trend{24.0 * DECAY_RATE, bucketLength};
+    maths::common::COneOfNPrior::TPriorPtrVec modePriors;
+    modePriors.emplace_back(univariateGamma().clone());
+    modePriors.emplace_back(univariateLogNormal().clone());
+    modePriors.emplace_back(univariateNormal().clone());
+    maths::common::COneOfNPrior modePrior{modePriors, maths_t::E_ContinuousData, DECAY_RATE};
+    maths::common::CXMeansOnline1d clusterer{
+        maths_t::E_ContinuousData, maths::common::CAvailableModeDistributions::ALL,
+        maths_t::E_ClustersFractionWeight, DECAY_RATE};
+    maths::common::COneOfNPrior::TPriorPtrVec priors;
+    priors.emplace_back(univariateGamma().clone());
+    priors.emplace_back(univariateLogNormal().clone());
+    priors.emplace_back(univariateNormal().clone());
+    priors.emplace_back(std::make_unique<maths::common::CMultimodalPrior>(
+        maths_t::E_ContinuousData, clusterer, modePrior, DECAY_RATE));
+    maths::common::COneOfNPrior residualModel{priors, maths_t::E_ContinuousData, DECAY_RATE};
+    auto controllers = decayRateControllers(1);
+    maths::time_series::CUnivariateTimeSeriesModel model{params, 1, trend,
+                                                         residualModel, &controllers};
+
+    TDoubleVec samples;
+    rng.generateNormalSamples(10.0, 4.0, 200, samples);
+    TDouble2VecWeightsAryVec weights{maths_t::CUnitWeights::unit<TDouble2Vec>(1)};
+    core_t::TTime time{0};
+    for (auto sample : samples) {
+        model.addSamples(addSampleParams(weights),
+                         {core::make_triple(time, TDouble2Vec{sample}, TAG)});
+        time += 6 * bucketLength;
+    }
+
+    std::unique_ptr<maths::time_series::CUnivariateTimeSeriesModel> expected{
+        model.cloneForPersistence()};
+
+    maths::common::SDistributionRestoreParams distributionParams{
+        maths_t::E_ContinuousData, DECAY_RATE};
+    maths::common::STimeSeriesDecompositionRestoreParams decompositionParams{
+        24.0 * DECAY_RATE, bucketLength, distributionParams};
+    model.compact(decompositionParams, distributionParams);
+    BOOST_TEST_REQUIRE(model.isCompact());
+
+    LOG_DEBUG(<< "memory = " << expected->memoryUsage()
+              << ", compact memory = " << model.memoryUsage());
+    BOOST_TEST_REQUIRE(model.memoryUsage() < expected->memoryUsage());
+
+    // Queries don't change the model or its memory and a run of queries
+    // only restores the compacted models once.
+    std::size_t compactMemory{model.memoryUsage()};
+    std::size_t restores{
+        maths::time_series::CUnivariateTimeSeriesModel::numberCompactStateRestores()};
+    BOOST_REQUIRE_EQUAL(expected->checksum(), model.checksum());
+    for (core_t::TTime time_ = time; time_ < time + 86400; time_ += 3600) {
+        BOOST_REQUIRE_EQUAL(expected->predict(time_)[0], model.predict(time_)[0]);
+        BOOST_REQUIRE_EQUAL(
+            core::CContainerPrinter::print(expected->confidenceInterval(
+                time_, 90.0, maths_t::CUnitWeights::unit<TDouble2Vec>(1))),
+            core::CContainerPrinter::print(model.confidenceInterval(
+                time_, 90.0, maths_t::CUnitWeights::unit<TDouble2Vec>(1))));
+    }
+    BOOST_REQUIRE_EQUAL(
+        restores + 1,
+        maths::time_series::CUnivariateTimeSeriesModel::numberCompactStateRestores());
+    BOOST_TEST_REQUIRE(model.isCompact());
+    BOOST_REQUIRE_EQUAL(compactMemory, model.memoryUsage());
+
+    // Querying another compact model restores its models instead.
+    std::unique_ptr<maths::time_series::CUnivariateTimeSeriesModel> other{
+        expected->cloneForPersistence()};
+    other->compact(decompositionParams, distributionParams);
+    BOOST_TEST_REQUIRE(other->isCompact());
+    BOOST_REQUIRE_EQUAL(expected->predict(time)[0], other->predict(time)[0]);
+    BOOST_REQUIRE_EQUAL(expected->predict(time)[0], model.predict(time)[0]);
+    BOOST_REQUIRE_EQUAL(
+        restores + 3,
+        maths::time_series::CUnivariateTimeSeriesModel::numberCompactStateRestores());
+
+    // Persisted state is unchanged.
+    std::string expectedXml;
+    std::string compactXml;
+    {
+        ml::core::CRapidXmlStatePersistInserter inserter{"root"};
+        expected->acceptPersistInserter(inserter);
+        inserter.toXml(expectedXml);
+    }
+    {
+        ml::core::CRapidXmlStatePersistInserter inserter{"root"};
+        model.acceptPersistInserter(inserter);
+        inserter.toXml(compactXml);
+    }
+    BOOST_REQUIRE_EQUAL(expectedXml, compactXml);
+
+    // Clones for persistence stay compact.
+    std::unique_ptr<maths::time_series::CUnivariateTimeSeriesModel> persisted{
+        model.cloneForPersistence()};
+    BOOST_TEST_REQUIRE(persisted->isCompact());
+    BOOST_REQUIRE_EQUAL(expected->checksum(), persisted->checksum());
+
+    // Clones for forecasting are expanded and leave the model compact.
+    std::unique_ptr<maths::time_series::CUnivariateTimeSeriesModel> forecast{
+        model.cloneForForecast()};
+    BOOST_TEST_REQUIRE(forecast->isCompact() == false);
+    BOOST_REQUIRE_EQUAL(expected->isForecastPossible(), model.isForecastPossible());
+    BOOST_TEST_REQUIRE(model.isCompact());
+    BOOST_REQUIRE_EQUAL(compactMemory, model.memoryUsage());
+
+    // The model is expanded when it's next updated. Compacting is equivalent
+    // to persisting and restoring the model so it should then evolve exactly
+    // as a restored copy does.
+    core::CRapidXmlParser parser;
+    BOOST_TEST_REQUIRE(parser.parseStringIgnoreCdata(expectedXml));
+    core::CRapidXmlStateRestoreTraverser traverser(parser);
+    maths::common::SModelRestoreParams restoreParams{params, decompositionParams,
+                                                     distributionParams};
+    expected = std::make_unique<maths::time_series::CUnivariateTimeSeriesModel>(
+        restoreParams, traverser);
+    rng.generateNormalSamples(1.0, 4.0, 100, samples);
+    for (auto sample : samples) {
+        expected->addSamples(addSampleParams(weights),
+                             {core::make_triple(time, TDouble2Vec{sample}, TAG)});
+        model.addSamples(addSampleParams(weights),
+                         {core::make_triple(time, TDouble2Vec{sample}, TAG)});
+        time += bucketLength;
+    }
+    BOOST_TEST_REQUIRE(model.isCompact() == false);
+    BOOST_REQUIRE_EQUAL(expected->checksum(), model.checksum());
+}
+
 BOOST_AUTO_TEST_CASE(testPersist) {
     // Test the restored model checksum matches the persisted model.
 
@@ -170,6 +170,18 @@ void SAnnotatedProbability::swap(SAnnotatedProbability& other) noexcept {
     std::swap(s_ShouldUpdateQuantiles, other.s_ShouldUpdateQuantiles);
 }
 
+void SAnnotatedProbability::clear() {
+    s_Probability = 1.0;
+    s_MultiBucketImpact = 0.0;
+    s_AttributeProbabilities.clear();
+    s_Influences.clear();
+    s_DescriptiveData.clear();
+    s_ResultType = model_t::CResultType::E_Final;
+    s_CurrentBucketCount.reset();
+    s_BaselineBucketCount.reset();
+    s_ShouldUpdateQuantiles = true;
+}
+
 void SAnnotatedProbability::acceptPersistInserter(core::CStatePersistInserter& inserter) const {
     core::CPersistUtils::persist(PROBABILITY_TAG, s_Probability, inserter);
     core::CPersistUtils::persist(MULTI_BUCKET_IMPACT_TAG, s_MultiBucketImpact, inserter);
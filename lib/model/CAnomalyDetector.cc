@@ -15,6 +15,7 @@
 #include <core/CLogger.h>
 #include <core/CMemory.h>
 #include <core/CProgramCounters.h>
+#include <core/CProgramStageTimers.h>
 #include <core/CStatePersistInserter.h>
 #include <core/CStateRestoreTraverser.h>
 
@@ -130,7 +131,7 @@ CAnomalyDetector::CAnomalyDetector(bool isForPersistence, const CAnomalyDetector
       m_ModelFactory(other.m_ModelFactory), // Shallow copy of model factory is OK
       m_Model(other.m_Model->cloneForPersistence()),
       // Empty message propagation function is fine in this case
-      m_IsForPersistence(isForPersistence) {
+      m_IsForPersistence(isForPersistence), m_StateEpoch(other.m_StateEpoch) {
     if (!isForPersistence) {
         LOG_ABORT(<< "This constructor only creates clones for persistence");
     }
@@ -161,6 +162,8 @@ void CAnomalyDetector::zeroModelsToTime(core_t::TTime time) {
 
     core_t::TTime bucketLength = m_ModelConfig.bucketLength();
 
+    ++m_StateEpoch;
+
     while (time >= (m_LastBucketEndTime + bucketLength)) {
         core_t::TTime bucketStartTime = m_LastBucketEndTime;
         m_LastBucketEndTime += bucketLength;
@@ -176,6 +179,7 @@ void CAnomalyDetector::zeroModelsToTime(core_t::TTime time) {
 
 bool CAnomalyDetector::acceptRestoreTraverser(const std::string& partitionFieldValue,
                                               core::CStateRestoreTraverser& traverser) {
+    ++m_StateEpoch;
     m_DataGatherer->clear();
     m_Model.reset();
 
@@ -364,6 +368,8 @@ const CAnomalyDetector::TStrVec& CAnomalyDetector::fieldsOfInterest() const {
 }
 
 void CAnomalyDetector::addRecord(core_t::TTime time, const TStrCPtrVec& fieldValues) {
+    ++m_StateEpoch;
+
     const TStrCPtrVec& processedFieldValues = this->preprocessFieldValues(fieldValues);
 
     CEventData eventData;
@@ -405,6 +411,11 @@ void CAnomalyDetector::sample(core_t::TTime startTime,
         return;
     }
 
+    // Sampling always updates the models, even for buckets without data.
+    ++m_StateEpoch;
+
+    core::CProgramStageTimers::CScopedTimer stageTimer{stage_t::E_TSADSampleModels};
+
     core_t::TTime bucketLength = m_ModelConfig.bucketLength();
 
     for (core_t::TTime time = startTime; time < endTime; time += bucketLength) {
@@ -430,6 +441,8 @@ void CAnomalyDetector::sampleBucketStatistics(core_t::TTime startTime,
         return;
     }
 
+    ++m_StateEpoch;
+
     core_t::TTime bucketLength = m_ModelConfig.bucketLength();
     for (core_t::TTime time = startTime; time < endTime; time += bucketLength) {
         m_Model->sampleBucketStatistics(time, time + bucketLength, resourceMonitor);
@@ -601,7 +614,7 @@ void CAnomalyDetector::buildInterimResults(core_t::TTime bucketStartTime,
 
 void CAnomalyDetector::pruneModels() {
     // Purge out any ancient models which are effectively dead.
-    m_Model->prune(m_Model->defaultPruneWindow());
+    this->pruneModelsOlderThan(m_Model->defaultPruneWindow());
 }
 
 void CAnomalyDetector::pruneModels(std::size_t buckets) {
@@ -609,16 +622,19 @@ void CAnomalyDetector::pruneModels(std::size_t buckets) {
 
     function_t::EFunction function{m_DataGatherer->function()};
     if (function_t::isAggressivePruningSupported(function)) {
-        m_Model->prune(buckets);
+        this->pruneModelsOlderThan(buckets);
     }
 }
 
 void CAnomalyDetector::resetBucket(core_t::TTime bucketStart) {
+    ++m_StateEpoch;
     m_DataGatherer->resetBucket(bucketStart);
 }
 
 void CAnomalyDetector::releaseMemory(core_t::TTime samplingCutoffTime) {
-    m_DataGatherer->releaseMemory(samplingCutoffTime);
+    if (m_DataGatherer->releaseMemory(samplingCutoffTime)) {
+        ++m_StateEpoch;
+    }
 }
 
 void CAnomalyDetector::showMemoryUsage(std::ostream& stream) const {
@@ -646,6 +662,12 @@ std::size_t CAnomalyDetector::staticSize() const {
     return sizeof(*this);
 }
 
+void CAnomalyDetector::auditMemoryUsage() {
+    if (m_Model != nullptr) {
+        m_Model->auditMemoryUsage();
+    }
+}
+
 bool CAnomalyDetector::supportsPruning() const {
     return true;
 }
@@ -663,7 +685,7 @@ core_t::TTime CAnomalyDetector::bucketLength() const {
 }
 
 void CAnomalyDetector::prune(std::size_t maximumAge) {
-    m_Model->prune(maximumAge);
+    this->pruneModelsOlderThan(maximumAge);
 }
 
 void CAnomalyDetector::updateModelSizeStats(CResourceMonitor::SModelSizeStats& modelSizeStats) const {
@@ -678,6 +700,7 @@ const core_t::TTime& CAnomalyDetector::lastBucketEndTime() const {
 }
 
 core_t::TTime& CAnomalyDetector::lastBucketEndTime() {
+    ++m_StateEpoch;
     return m_LastBucketEndTime;
 }
 
@@ -697,10 +720,16 @@ std::string CAnomalyDetector::description() const {
 }
 
 void CAnomalyDetector::timeNow(core_t::TTime time) {
+    // Only starting a new bucket changes the persisted gatherer state.
+    core_t::TTime bucketStart{m_DataGatherer->currentBucketStartTime()};
     m_DataGatherer->timeNow(time);
+    if (m_DataGatherer->currentBucketStartTime() != bucketStart) {
+        ++m_StateEpoch;
+    }
 }
 
 void CAnomalyDetector::skipSampling(core_t::TTime endTime) {
+    ++m_StateEpoch;
     m_Model->skipSampling(endTime);
     m_LastBucketEndTime = endTime;
 }
@@ -724,9 +753,14 @@ void CAnomalyDetector::buildResultsHelper(core_t::TTime bucketStartTime,
     CSearchKey key = m_DataGatherer->searchKey();
     LOG_TRACE(<< "OutputResults, for " << key.toCue());
 
-    if (m_Model->addResults(bucketStartTime, bucketEndTime,
-                            10, // TODO max number of attributes
-                            results)) {
+    bool added{false};
+    {
+        core::CProgramStageTimers::CScopedTimer stageTimer{stage_t::E_TSADComputeResults};
+        added = m_Model->addResults(bucketStartTime, bucketEndTime,
+                                    10, // TODO max number of attributes
+                                    results);
+    }
+    if (added) {
         if (bucketEndTime % bucketLength == 0) {
             lastSampledBucketUpdateFunc(bucketEndTime);
         }
@@ -764,9 +798,24 @@ const CAnomalyDetector::TModelPtr& CAnomalyDetector::model() const {
 }
 
 CAnomalyDetector::TModelPtr& CAnomalyDetector::model() {
+    ++m_StateEpoch;
     return m_Model;
 }
 
+std::uint64_t CAnomalyDetector::stateEpoch() const {
+    return m_StateEpoch;
+}
+
+void CAnomalyDetector::pruneModelsOlderThan(std::size_t maximumAge) {
+    // Only count this as a change if something was removed, so that
+    // pruning a detector which has nothing to prune leaves it clean.
+    std::size_t numberActive{this->numberActivePeople() + this->numberActiveAttributes()};
+    m_Model->prune(maximumAge);
+    if (this->numberActivePeople() + this->numberActiveAttributes() != numberActive) {
+        ++m_StateEpoch;
+    }
+}
+
 std::ostream& operator<<(std::ostream& strm, const CAnomalyDetector& detector) {
     strm << detector.m_DataGatherer->searchKey() << '/'
          << detector.m_DataGatherer->partitionFieldValue();
@@ -237,9 +237,12 @@ bool CAnomalyDetectorModel::addResults(core_t::TTime startTime,
                                            m_DataGatherer->partitionFieldValue());
     partitioningFields.add(m_DataGatherer->personFieldName(), EMPTY);
 
+    // This is swapped into the results so it is reused to pick up the
+    // memory of the results' pooled nodes.
+    SAnnotatedProbability annotatedProbability;
     for (auto pid : personIds) {
+        annotatedProbability.clear();
         if (this->category() == model_t::E_Counting) {
-            SAnnotatedProbability annotatedProbability;
             this->computeProbability(pid, startTime, endTime, partitioningFields,
                                      numberAttributeProbabilities, annotatedProbability);
             results.addSimpleCountResult(annotatedProbability, this, startTime);
@@ -251,7 +254,6 @@ bool CAnomalyDetectorModel::addResults(core_t::TTime startTime,
                           [&results](const std::string& influencer) {
                               results.addInfluencer(influencer);
                           });
-            SAnnotatedProbability annotatedProbability;
             annotatedProbability.s_ResultType = results.resultType();
             if (this->computeProbability(pid, startTime, endTime, partitioningFields,
                                          numberAttributeProbabilities, annotatedProbability)) {
@@ -324,6 +326,9 @@ std::size_t CAnomalyDetectorModel::memoryUsage() const {
     return mem;
 }
 
+void CAnomalyDetectorModel::auditMemoryUsage() {
+}
+
 CAnomalyDetectorModel::TOptionalSize
 CAnomalyDetectorModel::estimateMemoryUsage(std::size_t numberPeople,
                                            std::size_t numberAttributes,
@@ -514,6 +519,7 @@ bool CAnomalyDetectorModel::SFeatureModels::acceptRestoreTraverser(const SModelP
             s_Models.push_back(std::move(model));
         }
     } while (traverser.next());
+    this->auditMemoryUsage();
     return true;
 }
 
@@ -536,10 +542,51 @@ void CAnomalyDetectorModel::SFeatureModels::debugMemoryUsage(
     mem->setName("SFeatureModels");
     core::CMemoryDebug::dynamicSize("s_NewModel", s_NewModel, mem);
     core::CMemoryDebug::dynamicSize("s_Models", s_Models, mem);
+    core::CMemoryDebug::dynamicSize("s_ModelsMemoryUsage", s_ModelsMemoryUsage, mem);
 }
 
 std::size_t CAnomalyDetectorModel::SFeatureModels::memoryUsage() const {
-    return core::CMemory::dynamicSize(s_NewModel) + core::CMemory::dynamicSize(s_Models);
+    // This must agree with core::CMemory::dynamicSize(s_Models) when every
+    // model's memory is up-to-date.
+    std::size_t mem{core::CMemory::dynamicSize(s_NewModel)};
+    mem += s_Models.capacity() * sizeof(TMathsModelUPtr) + s_TotalModelsMemoryUsage;
+    mem += core::CMemory::dynamicSize(s_ModelsMemoryUsage);
+    return mem;
+}
+
+void CAnomalyDetectorModel::SFeatureModels::refreshMemoryUsage(std::size_t id) {
+    if (id >= s_Models.size()) {
+        LOG_ERROR(<< "Bad model identifier " << id);
+        return;
+    }
+    if (s_ModelsMemoryUsage.size() < s_Models.size()) {
+        core::CAllocationStrategy::resize(s_ModelsMemoryUsage, s_Models.size(), 0);
+    }
+    auto mem = static_cast<std::uint32_t>(std::min(
+        core::CMemory::dynamicSize(s_Models[id]),
+        static_cast<std::size_t>(std::numeric_limits<std::uint32_t>::max())));
+    s_TotalModelsMemoryUsage += mem;
+    s_TotalModelsMemoryUsage -= s_ModelsMemoryUsage[id];
+    s_ModelsMemoryUsage[id] = mem;
+}
+
+void CAnomalyDetectorModel::SFeatureModels::refreshMemoryUsage(TSizeVec ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    for (auto id : ids) {
+        this->refreshMemoryUsage(id);
+    }
+}
+
+void CAnomalyDetectorModel::SFeatureModels::auditMemoryUsage() {
+    std::size_t previous{s_TotalModelsMemoryUsage};
+    s_ModelsMemoryUsage.clear();
+    s_TotalModelsMemoryUsage = 0;
+    for (std::size_t id = 0; id < s_Models.size(); ++id) {
+        this->refreshMemoryUsage(id);
+    }
+    LOG_TRACE(<< model_t::print(s_Feature) << " memory usage drifted by "
+              << static_cast<double>(s_TotalModelsMemoryUsage) - static_cast<double>(previous));
 }
 
 bool CAnomalyDetectorModel::SFeatureModels::shouldPersist() const {
@@ -84,6 +84,7 @@ const double CAnomalyDetectorModelConfig::DEFAULT_MAXIMUM_UPDATES_PER_BUCKET(1.0
 const double CAnomalyDetectorModelConfig::DEFAULT_INFLUENCE_CUTOFF(0.4);
 const double CAnomalyDetectorModelConfig::DEFAULT_PRUNE_WINDOW_SCALE_MINIMUM(0.25);
 const double CAnomalyDetectorModelConfig::DEFAULT_PRUNE_WINDOW_SCALE_MAXIMUM(4.0);
+const std::size_t CAnomalyDetectorModelConfig::DEFAULT_COMPACT_MODELS_WINDOW(48);
 const double CAnomalyDetectorModelConfig::DEFAULT_CORRELATION_MODELS_OVERHEAD(3.0);
 const double CAnomalyDetectorModelConfig::DEFAULT_MINIMUM_SIGNIFICANT_CORRELATION(0.3);
 const double CAnomalyDetectorModelConfig::DEFAULT_AGGREGATION_STYLE_PARAMS[][model_t::NUMBER_AGGREGATION_PARAMS] =
@@ -202,6 +203,12 @@ void CAnomalyDetectorModelConfig::useMultibucketFeatures(bool enabled) {
     }
 }
 
+void CAnomalyDetectorModelConfig::compactModelsWindow(std::size_t window) {
+    for (auto& factory : m_Factories) {
+        factory.second->compactModelsWindow(window);
+    }
+}
+
 void CAnomalyDetectorModelConfig::multivariateByFields(bool enabled) {
     m_MultivariateByFields = enabled;
 }
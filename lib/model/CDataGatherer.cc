@@ -634,10 +634,8 @@ bool CDataGatherer::resetBucket(core_t::TTime bucketStart) {
     return m_BucketGatherer->resetBucket(bucketStart);
 }
 
-void CDataGatherer::releaseMemory(core_t::TTime samplingCutoffTime) {
-    if (this->isPopulation()) {
-        m_BucketGatherer->releaseMemory(samplingCutoffTime);
-    }
+bool CDataGatherer::releaseMemory(core_t::TTime samplingCutoffTime) {
+    return this->isPopulation() && m_BucketGatherer->releaseMemory(samplingCutoffTime);
 }
 
 const SModelParams& CDataGatherer::params() const {
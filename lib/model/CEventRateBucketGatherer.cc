@@ -1041,8 +1041,9 @@ bool CEventRateBucketGatherer::resetBucket(core_t::TTime bucketStart) {
     return this->CBucketGatherer::resetBucket(bucketStart);
 }
 
-void CEventRateBucketGatherer::releaseMemory(core_t::TTime /*samplingCutoffTime*/) {
+bool CEventRateBucketGatherer::releaseMemory(core_t::TTime /*samplingCutoffTime*/) {
     // Nothing to release
+    return false;
 }
 
 void CEventRateBucketGatherer::sample(core_t::TTime /*time*/) {
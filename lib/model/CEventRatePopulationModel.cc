@@ -527,6 +527,13 @@ void CEventRatePopulationModel::sample(core_t::TTime startTime,
                     gatherer.resetSampleCount(cid);
                 }
             }
+
+            TSizeVec attributes;
+            attributes.reserve(data.size());
+            for (const auto& data_ : data) {
+                attributes.push_back(CDataGatherer::extractAttributeId(data_));
+            }
+            this->refreshMemoryUsage(feature, std::move(attributes));
         }
 
         for (const auto& feature : m_FeatureCorrelatesModels) {
@@ -889,6 +896,12 @@ std::size_t CEventRatePopulationModel::memoryUsage() const {
     return estimate ? estimate.get() : this->computeMemoryUsage();
 }
 
+void CEventRatePopulationModel::auditMemoryUsage() {
+    for (auto& feature : m_FeatureModels) {
+        feature.auditMemoryUsage();
+    }
+}
+
 std::size_t CEventRatePopulationModel::computeMemoryUsage() const {
     std::size_t mem = this->CPopulationModel::memoryUsage();
     mem += core::CMemory::dynamicSize(m_CurrentBucketStats.s_PersonCounts);
@@ -964,6 +977,7 @@ void CEventRatePopulationModel::createNewModels(std::size_t n, std::size_t m) {
                         feature.s_Models.back()->modelCorrelations(*correlates.s_Models);
                     }
                 }
+                feature.refreshMemoryUsage(cid);
             }
         }
     }
@@ -981,6 +995,7 @@ void CEventRatePopulationModel::updateRecycledModels() {
                         feature.s_Models.back()->modelCorrelations(*correlates.s_Models);
                     }
                 }
+                feature.refreshMemoryUsage(cid);
             }
         }
     }
@@ -1009,6 +1024,7 @@ void CEventRatePopulationModel::clearPrunedResources(const TSizeVec& /*people*/,
         for (auto& feature : m_FeatureModels) {
             if (cid < feature.s_Models.size()) {
                 feature.s_Models[cid].reset(this->tinyModel());
+                feature.refreshMemoryUsage(cid);
             }
         }
     }
@@ -1024,10 +1040,21 @@ void CEventRatePopulationModel::doSkipSampling(core_t::TTime startTime, core_t::
         for (auto& model : feature.s_Models) {
             model->skipTime(gap);
         }
+        feature.auditMemoryUsage();
     }
     this->CPopulationModel::doSkipSampling(startTime, endTime);
 }
 
+void CEventRatePopulationModel::refreshMemoryUsage(model_t::EFeature feature, TSizeVec attributes) {
+    auto i = std::find_if(m_FeatureModels.begin(), m_FeatureModels.end(),
+                          [feature](const SFeatureModels& model) {
+                              return model.s_Feature == feature;
+                          });
+    if (i != m_FeatureModels.end()) {
+        i->refreshMemoryUsage(std::move(attributes));
+    }
+}
+
 const maths::common::CModel*
 CEventRatePopulationModel::model(model_t::EFeature feature, std::size_t cid) const {
     return const_cast<CEventRatePopulationModel*>(this)->model(feature, cid);
@@ -11,8 +11,11 @@
 
 #include <model/CForecastModelPersist.h>
 
+#include <core/CBinaryStatePersistInserter.h>
+#include <core/CBinaryStateRestoreTraverser.h>
 #include <core/CLogger.h>
 #include <core/CPersistUtils.h>
+#include <core/CompressUtils.h>
 #include <core/RestoreMacros.h>
 
 #include <maths/common/CRestoreParams.h>
@@ -22,6 +25,8 @@
 
 #include <model/CAnomalyDetectorModelConfig.h>
 
+#include <sstream>
+
 namespace ml {
 namespace model {
 
@@ -33,13 +38,14 @@ const std::string FIRST_DATA_TIME_TAG("first_data_time");
 const std::string LAST_DATA_TIME_TAG("last_data_time");
 const std::string MODEL_TAG("model");
 const std::string BY_FIELD_VALUE_TAG("by_field_value");
+
+using TRecordLength = std::uint64_t;
 }
 
 CForecastModelPersist::CPersist::CPersist(const std::string& temporaryPath)
     : m_FileName(temporaryPath), m_OutStream(), m_ModelCount(0) {
     m_FileName /= boost::filesystem::unique_path("forecast-persist-%%%%-%%%%-%%%%-%%%%");
-    m_OutStream.open(m_FileName.string());
-    m_OutStream << "[";
+    m_OutStream.open(m_FileName.string(), std::ios::binary);
 }
 
 void CForecastModelPersist::CPersist::addModel(const maths::common::CModel* model,
@@ -47,10 +53,6 @@ void CForecastModelPersist::CPersist::addModel(const maths::common::CModel* mode
                                                core_t::TTime lastDataTime,
                                                const model_t::EFeature feature,
                                                const std::string& byFieldValue) {
-    if (m_ModelCount++ > 0) {
-        m_OutStream << ",";
-    }
-
     auto persistOneModel = [&](core::CStatePersistInserter& inserter) {
         inserter.insertValue(FEATURE_TAG, feature);
         inserter.insertValue(DATA_TYPE_TAG, model->dataType());
@@ -62,12 +64,28 @@ void CForecastModelPersist::CPersist::addModel(const maths::common::CModel* mode
                                        std::cref(*model), std::placeholders::_1));
     };
 
-    core::CJsonStatePersistInserter inserter(m_OutStream);
-    inserter.insertLevel(FORECAST_MODEL_PERSIST_TAG, persistOneModel);
+    std::ostringstream state;
+    {
+        core::CBinaryStatePersistInserter inserter(state);
+        inserter.insertLevel(FORECAST_MODEL_PERSIST_TAG, persistOneModel);
+    }
+
+    core::CDeflator compressor(false);
+    TByteVec record;
+    if (compressor.addString(state.str()) == false ||
+        compressor.finishAndTakeData(record) == false) {
+        LOG_ERROR(<< "Failed to compress forecast model");
+        return;
+    }
+
+    TRecordLength length{record.size()};
+    m_OutStream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    m_OutStream.write(reinterpret_cast<const char*>(record.data()),
+                      static_cast<std::streamsize>(record.size()));
+    ++m_ModelCount;
 }
 
 std::string CForecastModelPersist::CPersist::finalizePersistAndGetFile() {
-    m_OutStream << "]";
     m_OutStream.close();
 
     return m_FileName.string();
@@ -78,7 +96,7 @@ CForecastModelPersist::CRestore::CRestore(const SModelParams& modelParams,
                                           const std::string& fileName)
     : m_ModelParams(modelParams),
       m_MinimumSeasonalVarianceScale(minimumSeasonalVarianceScale),
-      m_InStream(fileName), m_RestoreTraverser(m_InStream) {
+      m_InStream(fileName, std::ios::binary) {
 }
 
 bool CForecastModelPersist::CRestore::nextModel(TMathsModelPtr& model,
@@ -86,16 +104,59 @@ bool CForecastModelPersist::CRestore::nextModel(TMathsModelPtr& model,
                                                 core_t::TTime& lastDataTime,
                                                 model_t::EFeature& feature,
                                                 std::string& byFieldValue) {
-    if (m_RestoreTraverser.isEof() || m_RestoreTraverser.name().empty()) {
+    TByteVec record;
+    return this->nextRecord(record) &&
+           this->restoreModel(record, model, firstDataTime, lastDataTime,
+                              feature, byFieldValue);
+}
+
+bool CForecastModelPersist::CRestore::nextRecord(TByteVec& record) {
+    record.clear();
+
+    TRecordLength length{0};
+    if (m_InStream.read(reinterpret_cast<char*>(&length), sizeof(length)).gcount() == 0) {
         return false;
     }
+    if (m_InStream.fail()) {
+        LOG_ERROR(<< "Failed to restore forecast model, truncated length");
+        return false;
+    }
+
+    record.resize(static_cast<std::size_t>(length));
+    if (m_InStream.read(reinterpret_cast<char*>(record.data()),
+                        static_cast<std::streamsize>(length))
+            .fail()) {
+        LOG_ERROR(<< "Failed to restore forecast model, truncated record");
+        record.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool CForecastModelPersist::CRestore::restoreModel(const TByteVec& record,
+                                                   TMathsModelPtr& model,
+                                                   core_t::TTime& firstDataTime,
+                                                   core_t::TTime& lastDataTime,
+                                                   model_t::EFeature& feature,
+                                                   std::string& byFieldValue) const {
+    core::CInflator decompressor(false);
+    TByteVec state;
+    if (decompressor.addVector(record) == false ||
+        decompressor.finishAndTakeData(state) == false) {
+        LOG_ERROR(<< "Failed to restore forecast model, decompression failed");
+        return false;
+    }
+
+    std::istringstream input(std::string(state.begin(), state.end()));
+    core::CBinaryStateRestoreTraverser restoreTraverser(input);
 
-    if (m_RestoreTraverser.name() != FORECAST_MODEL_PERSIST_TAG) {
+    if (restoreTraverser.isEof() || restoreTraverser.name() != FORECAST_MODEL_PERSIST_TAG) {
         LOG_ERROR(<< "Failed to restore forecast model, unexpected tag");
         return false;
     }
 
-    if (!m_RestoreTraverser.hasSubLevel()) {
+    if (!restoreTraverser.hasSubLevel()) {
         LOG_ERROR(<< "Failed to restore forecast model, unexpected format");
         return false;
     }
@@ -160,14 +221,13 @@ bool CForecastModelPersist::CRestore::nextModel(TMathsModelPtr& model,
     };
 
     TMathsModelPtr originalModel;
-    if (m_RestoreTraverser.traverseSubLevel(std::bind<bool>(
+    if (restoreTraverser.traverseSubLevel(std::bind<bool>(
             restoreOneModel, std::placeholders::_1, std::ref(originalModel))) == false) {
         LOG_ERROR(<< "Failed to restore forecast model, internal error");
         return false;
     }
 
     model.reset(originalModel->cloneForForecast());
-    m_RestoreTraverser.nextObject();
 
     return true;
 }
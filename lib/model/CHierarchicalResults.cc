@@ -14,7 +14,9 @@
 #include <core/CContainerPrinter.h>
 #include <core/CFunctional.h>
 #include <core/CLogger.h>
+#include <core/CProgramCounters.h>
 #include <core/CStringUtils.h>
+#include <core/Concurrency.h>
 
 #include <maths/common/COrderings.h>
 
@@ -37,6 +39,9 @@ namespace {
 using TNodeCPtr = SNode::TNodeCPtr;
 
 const std::string COUNT("count");
+//! The smallest number of nodes for which it is worth visiting a level
+//! of the tree in parallel.
+const std::size_t MINIMUM_PARALLEL_LEVEL_SIZE{512};
 // This is intentionally NOT an empty string from the string store, but instead
 // a completely separate empty string, such that its pointer will be different
 // to other empty string pointers.  (In general, if you need a pointer to an
@@ -157,6 +162,17 @@ void aggregateLayer(ITR beginLayer,
     }
 }
 
+//! Apply \p visit to each value in [\p begin, \p end) in parallel if
+//! there are enough of them.
+template<typename ITR, typename FUNCTION>
+void visitLevel(ITR begin, ITR end, FUNCTION visit) {
+    if (static_cast<std::size_t>(std::distance(begin, end)) < MINIMUM_PARALLEL_LEVEL_SIZE) {
+        std::for_each(begin, end, visit);
+    } else {
+        core::parallel_for_each(begin, end, std::move(visit));
+    }
+}
+
 //! \brief Propagates influences to the appropriate point in the
 //! hierarchical results.
 //!
@@ -295,6 +311,22 @@ void SNode::swap(SNode& other) noexcept {
     std::swap(s_BucketLength, other.s_BucketLength);
 }
 
+void SNode::clear() {
+    s_Parent = nullptr;
+    s_Children.clear();
+    s_Spec = SResultSpec();
+    s_AnnotatedProbability.clear();
+    s_Detector = -3;
+    s_AggregationStyle = -1;
+    s_SmallestChildProbability = 1.0;
+    s_SmallestDescendantProbability = 1.0;
+    s_RawAnomalyScore = 0.0;
+    s_NormalizedAnomalyScore = 0.0;
+    s_Model = nullptr;
+    s_BucketStartTime = 0;
+    s_BucketLength = 0;
+}
+
 void swap(SNode& node1, SNode& node2) noexcept {
     node1.swap(node2);
 }
@@ -304,7 +336,7 @@ void swap(SNode& node1, SNode& node2) noexcept {
 using namespace hierarchical_results_detail;
 
 CHierarchicalResults::CHierarchicalResults()
-    : m_ResultType(model_t::CResultType::E_Final) {
+    : m_NumberNodes(0), m_ResultType(model_t::CResultType::E_Final) {
 }
 
 void CHierarchicalResults::addSimpleCountResult(SAnnotatedProbability& annotatedProbability,
@@ -371,19 +403,24 @@ void CHierarchicalResults::addInfluencer(const std::string& name) {
 void CHierarchicalResults::buildHierarchy() {
     using TNodePtrVec = std::vector<SNode*>;
 
-    m_Nodes.erase(std::remove_if(m_Nodes.begin(), m_Nodes.end(), isAggregate),
-                  m_Nodes.end());
+    auto end = m_Nodes.begin() + m_NumberNodes;
+    auto leavesEnd = std::remove_if(m_Nodes.begin(), end, isAggregate);
+    std::for_each(leavesEnd, end, [](TNode& node) { node.clear(); });
+    m_NumberNodes = static_cast<std::size_t>(leavesEnd - m_Nodes.begin());
+    end = leavesEnd;
+    m_LevelEnds.clear();
+    m_LevelEnds.push_back(m_NumberNodes);
 
     // To make life easier for downstream code, bring a simple count node
     // to the front of the deque (if there is one).
-    auto simpleCountItr = m_Nodes.end();
-    for (auto i = m_Nodes.begin(); i != m_Nodes.end(); ++i) {
+    auto simpleCountItr = end;
+    for (auto i = m_Nodes.begin(); i != end; ++i) {
         i->s_Parent = nullptr;
         if (i->s_Spec.s_IsSimpleCount) {
             simpleCountItr = i;
         }
     }
-    if (simpleCountItr != m_Nodes.end()) {
+    if (simpleCountItr != end) {
         while (simpleCountItr != m_Nodes.begin()) {
             auto next = simpleCountItr;
             std::iter_swap(--simpleCountItr, next);
@@ -395,8 +432,9 @@ void CHierarchicalResults::buildHierarchy() {
 
     LOG_TRACE(<< "Distinct values of the person field");
     {
-        aggregateLayer<SPersonValueLess>(m_Nodes.begin(), m_Nodes.end(), *this,
+        aggregateLayer<SPersonValueLess>(m_Nodes.begin(), end, *this,
                                          &CHierarchicalResults::newNode, layer);
+        m_LevelEnds.push_back(m_NumberNodes);
         LOG_TRACE(<< "layer = " << core::CContainerPrinter::print(layer));
     }
 
@@ -406,6 +444,7 @@ void CHierarchicalResults::buildHierarchy() {
         aggregateLayer<SPersonNameLess>(layer.begin(), layer.end(), *this,
                                         &CHierarchicalResults::newNode, newLayer);
         newLayer.swap(layer);
+        m_LevelEnds.push_back(m_NumberNodes);
         LOG_TRACE(<< "layer = " << core::CContainerPrinter::print(layer));
     }
 
@@ -415,6 +454,7 @@ void CHierarchicalResults::buildHierarchy() {
         aggregateLayer<SPartitionValueLess>(layer.begin(), layer.end(), *this,
                                             &CHierarchicalResults::newNode, newLayer);
         newLayer.swap(layer);
+        m_LevelEnds.push_back(m_NumberNodes);
         LOG_TRACE(<< "layer = " << core::CContainerPrinter::print(layer));
     }
 
@@ -424,6 +464,7 @@ void CHierarchicalResults::buildHierarchy() {
         aggregateLayer<SPartitionNameLess>(layer.begin(), layer.end(), *this,
                                            &CHierarchicalResults::newNode, newLayer);
         newLayer.swap(layer);
+        m_LevelEnds.push_back(m_NumberNodes);
         LOG_TRACE(<< "layer = " << core::CContainerPrinter::print(layer));
     }
 
@@ -436,6 +477,7 @@ void CHierarchicalResults::buildHierarchy() {
             population |= layer[i]->s_Spec.s_IsPopulation;
         }
         root.s_Spec.s_IsPopulation = population;
+        m_LevelEnds.push_back(m_NumberNodes);
         LOG_TRACE(<< "root = " << root.print());
     }
 
@@ -448,7 +490,8 @@ void CHierarchicalResults::buildHierarchy() {
 void CHierarchicalResults::createPivots() {
     LOG_TRACE(<< "Creating pivots");
 
-    for (const auto& node : m_Nodes) {
+    for (std::size_t i = 0; i < m_NumberNodes; ++i) {
+        const TNode& node = m_Nodes[i];
         const auto& parentInfluences = node.s_Parent->s_AnnotatedProbability.s_Influences;
         for (const auto& influence : node.s_AnnotatedProbability.s_Influences) {
             if (node.s_Parent &&
@@ -468,13 +511,13 @@ void CHierarchicalResults::createPivots() {
 }
 
 const CHierarchicalResults::TNode* CHierarchicalResults::root() const {
-    if (m_Nodes.empty()) {
+    if (m_NumberNodes == 0) {
         return nullptr;
     }
-    if (m_Nodes.size() == 1) {
+    if (m_NumberNodes == 1) {
         return &m_Nodes.front();
     }
-    const TNode& result = m_Nodes.back();
+    const TNode& result = m_Nodes[m_NumberNodes - 1];
     if (isLeaf(result)) {
         return nullptr;
     }
@@ -489,14 +532,36 @@ CHierarchicalResults::influencer(const TStoredStringPtr& influencerName,
 }
 
 void CHierarchicalResults::bottomUpBreadthFirst(CHierarchicalResultsVisitor& visitor) const {
-    for (const auto& node : m_Nodes) {
-        visitor.visit(*this, node, /*pivot =*/false);
+    if (visitor.canVisitLevelInParallel()) {
+        TSizeVec levels;
+        this->levels(levels);
+        for (std::size_t i = 1; i < levels.size(); ++i) {
+            visitLevel(m_Nodes.begin() + levels[i - 1], m_Nodes.begin() + levels[i],
+                       [&](const TNode& node) {
+                           visitor.visit(*this, node, /*pivot =*/false);
+                       });
+        }
+        return;
+    }
+    for (std::size_t i = 0; i < m_NumberNodes; ++i) {
+        visitor.visit(*this, m_Nodes[i], /*pivot =*/false);
     }
 }
 
 void CHierarchicalResults::topDownBreadthFirst(CHierarchicalResultsVisitor& visitor) const {
-    for (auto i = m_Nodes.rbegin(); i != m_Nodes.rend(); ++i) {
-        visitor.visit(*this, *i, /*pivot =*/false);
+    if (visitor.canVisitLevelInParallel()) {
+        TSizeVec levels;
+        this->levels(levels);
+        for (std::size_t i = levels.size() - 1; i > 0; --i) {
+            visitLevel(m_Nodes.begin() + levels[i - 1], m_Nodes.begin() + levels[i],
+                       [&](const TNode& node) {
+                           visitor.visit(*this, node, /*pivot =*/false);
+                       });
+        }
+        return;
+    }
+    for (std::size_t i = m_NumberNodes; i > 0; --i) {
+        visitor.visit(*this, m_Nodes[i - 1], /*pivot =*/false);
     }
 }
 
@@ -507,6 +572,15 @@ void CHierarchicalResults::postorderDepthFirst(CHierarchicalResultsVisitor& visi
 }
 
 void CHierarchicalResults::pivotsBottomUpBreadthFirst(CHierarchicalResultsVisitor& visitor) const {
+    if (visitor.canVisitLevelInParallel()) {
+        visitLevel(m_PivotNodes.begin(), m_PivotNodes.end(), [&](const auto& pivot) {
+            visitor.visit(*this, pivot.second, /*pivot =*/true);
+        });
+        visitLevel(m_PivotRootNodes.begin(), m_PivotRootNodes.end(), [&](const auto& root) {
+            visitor.visit(*this, root.second, /*pivot =*/true);
+        });
+        return;
+    }
     for (const auto& pivot : m_PivotNodes) {
         visitor.visit(*this, pivot.second, /*pivot =*/true);
     }
@@ -516,6 +590,15 @@ void CHierarchicalResults::pivotsBottomUpBreadthFirst(CHierarchicalResultsVisito
 }
 
 void CHierarchicalResults::pivotsTopDownBreadthFirst(CHierarchicalResultsVisitor& visitor) const {
+    if (visitor.canVisitLevelInParallel()) {
+        visitLevel(m_PivotRootNodes.begin(), m_PivotRootNodes.end(), [&](const auto& root) {
+            visitor.visit(*this, root.second, /*pivot =*/true);
+        });
+        visitLevel(m_PivotNodes.begin(), m_PivotNodes.end(), [&](const auto& pivot) {
+            visitor.visit(*this, pivot.second, /*pivot =*/true);
+        });
+        return;
+    }
     for (const auto& root : m_PivotRootNodes) {
         visitor.visit(*this, root.second, /*pivot =*/true);
     }
@@ -525,12 +608,13 @@ void CHierarchicalResults::pivotsTopDownBreadthFirst(CHierarchicalResultsVisitor
 }
 
 bool CHierarchicalResults::empty() const {
-    return m_Nodes.empty();
+    return m_NumberNodes == 0;
 }
 
 std::size_t CHierarchicalResults::resultCount() const {
     std::size_t result = 0;
-    for (const auto& node : m_Nodes) {
+    for (std::size_t i = 0; i < m_NumberNodes; ++i) {
+        const TNode& node = m_Nodes[i];
         if (isLeaf(node) && !node.s_Spec.s_IsSimpleCount) {
             ++result;
         }
@@ -542,28 +626,46 @@ void CHierarchicalResults::setInterim() {
     m_ResultType.set(model_t::CResultType::E_Interim);
 }
 
+void CHierarchicalResults::clear() {
+    for (std::size_t i = 0; i < m_NumberNodes; ++i) {
+        m_Nodes[i].clear();
+    }
+    m_NumberNodes = 0;
+    m_LevelEnds.clear();
+    m_PivotNodes.clear();
+    m_PivotRootNodes.clear();
+    m_ResultType = model_t::CResultType::E_Final;
+}
+
 model_t::CResultType CHierarchicalResults::resultType() const {
     return m_ResultType;
 }
 
 std::string CHierarchicalResults::print() const {
     std::ostringstream ss;
-    for (const auto& node : m_Nodes) {
-        ss << "\t" << node.print() << core_t::LINE_ENDING;
+    for (std::size_t i = 0; i < m_NumberNodes; ++i) {
+        ss << "\t" << m_Nodes[i].print() << core_t::LINE_ENDING;
     }
     return ss.str();
 }
 
 CHierarchicalResults::TNode& CHierarchicalResults::newNode() {
-    m_Nodes.push_back(TNode());
-    return m_Nodes.back();
+    if (m_NumberNodes == m_Nodes.size()) {
+        m_Nodes.emplace_back();
+        ++core::CProgramCounters::counter(counter_t::E_TSADNumberResultNodeAllocations);
+    }
+    return m_Nodes[m_NumberNodes++];
 }
 
 CHierarchicalResults::TNode&
 CHierarchicalResults::newLeaf(const TResultSpec& simpleSearch,
                               SAnnotatedProbability& annotatedProbability) {
-    m_Nodes.emplace_back(simpleSearch, annotatedProbability);
-    return m_Nodes.back();
+    TNode& result = this->newNode();
+    result.s_Spec = simpleSearch;
+    result.s_Detector = simpleSearch.s_Detector;
+    result.s_SmallestChildProbability = annotatedProbability.s_Probability;
+    result.s_AnnotatedProbability.swap(annotatedProbability);
+    return result;
 }
 
 CHierarchicalResults::TNode&
@@ -589,9 +691,29 @@ void CHierarchicalResults::postorderDepthFirst(const TNode* node,
     visitor.visit(*this, *node, /*pivot =*/false);
 }
 
+void CHierarchicalResults::levels(TSizeVec& result) const {
+    // Any nodes added since the hierarchy was built are leaves so are
+    // treated as an extra level.
+    result.clear();
+    result.push_back(0);
+    for (auto end : m_LevelEnds) {
+        end = std::min(end, m_NumberNodes);
+        if (end > result.back()) {
+            result.push_back(end);
+        }
+    }
+    if (m_NumberNodes > result.back()) {
+        result.push_back(m_NumberNodes);
+    }
+}
+
 CHierarchicalResultsVisitor::~CHierarchicalResultsVisitor() {
 }
 
+bool CHierarchicalResultsVisitor::canVisitLevelInParallel() const {
+    return false;
+}
+
 bool CHierarchicalResultsVisitor::isRoot(const TNode& node) {
     return !node.s_Parent;
 }
@@ -136,6 +136,10 @@ void CHierarchicalResultsNormalizer::visit(const CHierarchicalResults& /*results
     }
 }
 
+bool CHierarchicalResultsNormalizer::canVisitLevelInParallel() const {
+    return m_Job == E_NormalizeScores;
+}
+
 void CHierarchicalResultsNormalizer::propagateForwardByTime(double time) {
     if (time < 0.0) {
         LOG_ERROR(<< "Can't propagate normalizer backwards in time");
@@ -24,5 +24,9 @@ void CHierarchicalResultsProbabilityFinalizer::visit(const CHierarchicalResults&
             maths::common::CTools::inverseAnomalyScore(node.s_RawAnomalyScore);
     }
 }
+
+bool CHierarchicalResultsProbabilityFinalizer::canVisitLevelInParallel() const {
+    return true;
+}
 }
 }
@@ -23,6 +23,7 @@
 #include <maths/common/CMultivariatePrior.h>
 #include <maths/common/COrderings.h>
 #include <maths/common/CPrior.h>
+#include <maths/common/CRestoreParams.h>
 
 #include <maths/time_series/CTimeSeriesDecomposition.h>
 
@@ -113,6 +114,7 @@ CIndividualModel::CIndividualModel(bool isForPersistence, const CIndividualModel
     : CAnomalyDetectorModel(isForPersistence, other),
       m_FirstBucketTimes(other.m_FirstBucketTimes),
       m_LastBucketTimes(other.m_LastBucketTimes),
+      m_LastBucketTimeIndex(other.m_LastBucketTimeIndex),
       m_MemoryEstimator(other.m_MemoryEstimator) {
     if (!isForPersistence) {
         LOG_ABORT(<< "This constructor only creates clones for persistence");
@@ -198,8 +200,10 @@ void CIndividualModel::sample(core_t::TTime startTime,
                 m_FirstBucketTimes[pid] = time;
             }
             m_LastBucketTimes[pid] = time;
+            m_LastBucketTimeIndex.update(pid, time);
         }
         this->applyFilter(model_t::E_XF_By, true, this->personFilter(), personCounts);
+        this->compactInactiveModels(time);
     }
 }
 
@@ -213,18 +217,15 @@ void CIndividualModel::prune(std::size_t maximumAge) {
     CDataGatherer& gatherer = this->dataGatherer();
 
     TSizeVec peopleToRemove;
-    for (std::size_t pid = 0; pid < m_LastBucketTimes.size(); ++pid) {
-        if (gatherer.isPersonActive(pid) &&
-            !CAnomalyDetectorModel::isTimeUnset(m_LastBucketTimes[pid])) {
-            std::size_t bucketsSinceLastEvent = static_cast<std::size_t>(
-                (time - m_LastBucketTimes[pid]) / gatherer.bucketLength());
-            if (bucketsSinceLastEvent > maximumAge) {
-                LOG_TRACE(<< gatherer.personName(pid) << ", bucketsSinceLastEvent = " << bucketsSinceLastEvent
+    m_LastBucketTimeIndex.forEachOlderThan(
+        time, gatherer.bucketLength(), maximumAge, [&](std::size_t pid) {
+            if (gatherer.isPersonActive(pid)) {
+                LOG_TRACE(<< gatherer.personName(pid) << ", bucketsSinceLastEvent = "
+                          << (time - m_LastBucketTimes[pid]) / gatherer.bucketLength()
                           << ", maximumAge = " << maximumAge);
                 peopleToRemove.push_back(pid);
             }
-        }
-    }
+        });
 
     if (peopleToRemove.empty()) {
         return;
@@ -294,6 +295,7 @@ void CIndividualModel::debugMemoryUsage(const core::CMemoryUsage::TMemoryUsagePt
     this->CAnomalyDetectorModel::debugMemoryUsage(mem->addChild());
     core::CMemoryDebug::dynamicSize("m_FirstBucketTimes", m_FirstBucketTimes, mem);
     core::CMemoryDebug::dynamicSize("m_LastBucketTimes", m_LastBucketTimes, mem);
+    core::CMemoryDebug::dynamicSize("m_LastBucketTimeIndex", m_LastBucketTimeIndex, mem);
     core::CMemoryDebug::dynamicSize("m_FeatureModels", m_FeatureModels, mem);
     core::CMemoryDebug::dynamicSize("m_FeatureCorrelatesModels",
                                     m_FeatureCorrelatesModels, mem);
@@ -308,10 +310,17 @@ std::size_t CIndividualModel::memoryUsage() const {
     return estimate ? estimate.get() : this->computeMemoryUsage();
 }
 
+void CIndividualModel::auditMemoryUsage() {
+    for (auto& feature : m_FeatureModels) {
+        feature.auditMemoryUsage();
+    }
+}
+
 std::size_t CIndividualModel::computeMemoryUsage() const {
     std::size_t mem = this->CAnomalyDetectorModel::memoryUsage();
     mem += core::CMemory::dynamicSize(m_FirstBucketTimes);
     mem += core::CMemory::dynamicSize(m_LastBucketTimes);
+    mem += core::CMemory::dynamicSize(m_LastBucketTimeIndex);
     mem += core::CMemory::dynamicSize(m_FeatureModels);
     mem += core::CMemory::dynamicSize(m_FeatureCorrelatesModels);
     mem += core::CMemory::dynamicSize(m_MemoryEstimator);
@@ -422,6 +431,7 @@ bool CIndividualModel::doAcceptRestoreTraverser(core::CStateRestoreTraverser& tr
                     this->lastBucketTimes()[pid], TDouble2Vec(dimension, 0.0),
                     model_t::INDIVIDUAL_ANALYSIS_ATTRIBUTE_ID)};
                 feature.s_Models[pid]->addSamples(params, value);
+                feature.refreshMemoryUsage(pid);
             }
             for (const auto& correlates : m_FeatureCorrelatesModels) {
                 if (feature.s_Feature == correlates.s_Feature) {
@@ -433,6 +443,8 @@ bool CIndividualModel::doAcceptRestoreTraverser(core::CStateRestoreTraverser& tr
 
     VIOLATES_INVARIANT(m_FirstBucketTimes.size(), !=, m_LastBucketTimes.size());
 
+    this->rebuildLastBucketTimeIndex();
+
     return true;
 }
 
@@ -493,6 +505,7 @@ void CIndividualModel::createNewModels(std::size_t n, std::size_t m) {
                                           CAnomalyDetectorModel::TIME_UNSET);
         core::CAllocationStrategy::resize(m_LastBucketTimes, newN,
                                           CAnomalyDetectorModel::TIME_UNSET);
+        m_LastBucketTimeIndex.resize(newN);
         for (auto& feature : m_FeatureModels) {
             core::CAllocationStrategy::reserve(feature.s_Models, newN);
             for (std::size_t pid = feature.s_Models.size(); pid < newN; ++pid) {
@@ -502,6 +515,7 @@ void CIndividualModel::createNewModels(std::size_t n, std::size_t m) {
                         feature.s_Models.back()->modelCorrelations(*correlates.s_Models);
                     }
                 }
+                feature.refreshMemoryUsage(pid);
             }
         }
     }
@@ -513,6 +527,7 @@ void CIndividualModel::updateRecycledModels() {
         if (pid < m_FirstBucketTimes.size()) {
             m_FirstBucketTimes[pid] = CAnomalyDetectorModel::TIME_UNSET;
             m_LastBucketTimes[pid] = CAnomalyDetectorModel::TIME_UNSET;
+            m_LastBucketTimeIndex.remove(pid);
             for (auto& feature : m_FeatureModels) {
                 feature.s_Models[pid].reset(feature.s_NewModel->clone(pid));
                 for (const auto& correlates : m_FeatureCorrelatesModels) {
@@ -520,6 +535,7 @@ void CIndividualModel::updateRecycledModels() {
                         feature.s_Models.back()->modelCorrelations(*correlates.s_Models);
                     }
                 }
+                feature.refreshMemoryUsage(pid);
             }
         }
     }
@@ -548,6 +564,7 @@ void CIndividualModel::clearPrunedResources(const TSizeVec& people,
         for (auto& feature : m_FeatureModels) {
             if (pid < feature.s_Models.size()) {
                 feature.s_Models[pid].reset(this->tinyModel());
+                feature.refreshMemoryUsage(pid);
             }
         }
     }
@@ -584,6 +601,16 @@ maths::common::CModel* CIndividualModel::model(model_t::EFeature feature, std::s
                : nullptr;
 }
 
+void CIndividualModel::refreshMemoryUsage(model_t::EFeature feature, TSizeVec people) {
+    auto i = std::find_if(m_FeatureModels.begin(), m_FeatureModels.end(),
+                          [feature](const SFeatureModels& model) {
+                              return model.s_Feature == feature;
+                          });
+    if (i != m_FeatureModels.end()) {
+        i->refreshMemoryUsage(std::move(people));
+    }
+}
+
 void CIndividualModel::sampleCorrelateModels() {
     for (const auto& feature : m_FeatureCorrelatesModels) {
         feature.s_Models->processSamples();
@@ -639,6 +666,45 @@ double CIndividualModel::attributeFrequency(std::size_t /*cid*/) const {
     return 1.0;
 }
 
+void CIndividualModel::compactInactiveModels(core_t::TTime time) {
+    std::size_t window{this->params().s_CompactModelsWindow};
+    if (window == 0) {
+        return;
+    }
+
+    const CDataGatherer& gatherer = this->dataGatherer();
+    core_t::TTime cutoff{time - static_cast<core_t::TTime>(window) * gatherer.bucketLength()};
+
+    // We only try to compact each model once, when its person first crosses
+    // the inactivity window, since compacting isn't free and is skipped if
+    // it wouldn't save memory.
+    m_LastBucketTimeIndex.forEach(cutoff, [&](std::size_t pid) {
+        if (gatherer.isPersonActive(pid) == false) {
+            return;
+        }
+        for (auto& feature : m_FeatureModels) {
+            if (pid < feature.s_Models.size() && feature.s_Models[pid] != nullptr &&
+                feature.s_Models[pid]->isCompact() == false) {
+                auto& model = feature.s_Models[pid];
+                maths_t::EDataType dataType{model->dataType()};
+                model->compact(this->params().decompositionRestoreParams(dataType),
+                               this->params().distributionRestoreParams(dataType));
+                feature.refreshMemoryUsage(pid);
+            }
+        }
+    });
+}
+
+void CIndividualModel::rebuildLastBucketTimeIndex() {
+    m_LastBucketTimeIndex.clear();
+    m_LastBucketTimeIndex.resize(m_LastBucketTimes.size());
+    for (std::size_t pid = 0; pid < m_LastBucketTimes.size(); ++pid) {
+        if (!CAnomalyDetectorModel::isTimeUnset(m_LastBucketTimes[pid])) {
+            m_LastBucketTimeIndex.update(pid, m_LastBucketTimes[pid]);
+        }
+    }
+}
+
 void CIndividualModel::doSkipSampling(core_t::TTime startTime, core_t::TTime endTime) {
     core_t::TTime gap = endTime - startTime;
 
@@ -647,11 +713,13 @@ void CIndividualModel::doSkipSampling(core_t::TTime startTime, core_t::TTime end
             time = time + gap;
         }
     }
+    this->rebuildLastBucketTimeIndex();
 
     for (auto& feature : m_FeatureModels) {
         for (auto& model : feature.s_Models) {
             model->skipTime(gap);
         }
+        feature.auditMemoryUsage();
     }
 }
 }
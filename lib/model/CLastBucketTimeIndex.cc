@@ -0,0 +1,122 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+
+#include <model/CLastBucketTimeIndex.h>
+
+#include <core/CAllocationStrategy.h>
+#include <core/CLogger.h>
+#include <core/CMemory.h>
+
+#include <limits>
+
+namespace ml {
+namespace model {
+
+void CLastBucketTimeIndex::resize(std::size_t n) {
+    if (n > static_cast<std::size_t>(NONE)) {
+        LOG_ERROR(<< "Too many identifiers " << n);
+        return;
+    }
+    for (std::size_t id = n; id < m_Entries.size(); ++id) {
+        this->remove(id);
+    }
+    core::CAllocationStrategy::resize(m_Entries, n);
+}
+
+void CLastBucketTimeIndex::update(std::size_t id, core_t::TTime time) {
+    if (id >= m_Entries.size()) {
+        LOG_ERROR(<< "Bad identifier " << id);
+        return;
+    }
+
+    auto id_ = static_cast<std::uint32_t>(id);
+    SEntry& entry{m_Entries[id]};
+    if (entry.indexed()) {
+        if (entry.s_Time == time) {
+            return;
+        }
+        this->unlink(id_);
+    } else {
+        ++m_Size;
+    }
+
+    auto head = m_Heads.emplace(time, NONE).first;
+    entry.s_Time = time;
+    entry.s_Previous = NONE;
+    entry.s_Next = head->second;
+    if (head->second != NONE) {
+        m_Entries[head->second].s_Previous = id_;
+    }
+    head->second = id_;
+}
+
+void CLastBucketTimeIndex::remove(std::size_t id) {
+    if (id < m_Entries.size() && m_Entries[id].indexed()) {
+        this->unlink(static_cast<std::uint32_t>(id));
+        m_Entries[id] = SEntry{};
+        --m_Size;
+    }
+}
+
+void CLastBucketTimeIndex::clear() {
+    m_Entries.assign(m_Entries.size(), SEntry{});
+    m_Heads.clear();
+    m_Size = 0;
+}
+
+std::size_t CLastBucketTimeIndex::size() const {
+    return m_Size;
+}
+
+void CLastBucketTimeIndex::debugMemoryUsage(const core::CMemoryUsage::TMemoryUsagePtr& mem) const {
+    mem->setName("CLastBucketTimeIndex");
+    core::CMemoryDebug::dynamicSize("m_Entries", m_Entries, mem);
+    core::CMemoryDebug::dynamicSize("m_Heads", m_Heads, mem);
+}
+
+std::size_t CLastBucketTimeIndex::memoryUsage() const {
+    std::size_t mem = core::CMemory::dynamicSize(m_Entries);
+    mem += core::CMemory::dynamicSize(m_Heads);
+    return mem;
+}
+
+core_t::TTime CLastBucketTimeIndex::ageCutoff(core_t::TTime time,
+                                              core_t::TTime bucketLength,
+                                              std::size_t maximumAge) {
+    // The number of complete buckets since an identifier was last seen is
+    // greater than maximumAge if and only if it was last seen no later than
+    // time - (maximumAge + 1) * bucketLength.
+    core_t::TTime never{std::numeric_limits<core_t::TTime>::min()};
+    if (bucketLength <= 0 ||
+        maximumAge >= static_cast<std::size_t>(
+                          std::numeric_limits<core_t::TTime>::max() / bucketLength) -
+                          1) {
+        return never;
+    }
+    core_t::TTime age{(static_cast<core_t::TTime>(maximumAge) + 1) * bucketLength};
+    return time < never + age ? never : time - age + 1;
+}
+
+void CLastBucketTimeIndex::unlink(std::uint32_t id) {
+    const SEntry& entry{m_Entries[id]};
+    if (entry.s_Previous != NONE) {
+        m_Entries[entry.s_Previous].s_Next = entry.s_Next;
+    } else if (entry.s_Next != NONE) {
+        m_Heads[entry.s_Time] = entry.s_Next;
+    } else {
+        m_Heads.erase(entry.s_Time);
+    }
+    if (entry.s_Next != NONE) {
+        m_Entries[entry.s_Next].s_Previous = entry.s_Previous;
+    }
+}
+}
+}
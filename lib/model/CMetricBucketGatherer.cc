@@ -909,12 +909,14 @@ public:
     template<typename T>
     void operator()(const TCategorySizePr& /*category*/,
                     TSizeSizeTUMapUMap<T>& data,
-                    core_t::TTime samplingCutoffTime) const {
+                    core_t::TTime samplingCutoffTime,
+                    bool& released) const {
         for (auto& cidEntry : data) {
             auto& pidMap = cidEntry.second;
             for (auto i = pidMap.begin(); i != pidMap.end(); /**/) {
                 if (i->second.isRedundant(samplingCutoffTime)) {
                     i = pidMap.erase(i);
+                    released = true;
                 } else {
                     ++i;
                 }
@@ -1370,9 +1372,12 @@ bool CMetricBucketGatherer::resetBucket(core_t::TTime bucketStart) {
     return true;
 }
 
-void CMetricBucketGatherer::releaseMemory(core_t::TTime samplingCutoffTime) {
-    applyFunc(m_FeatureData, std::bind<void>(SReleaseMemory(), std::placeholders::_1,
-                                             std::placeholders::_2, samplingCutoffTime));
+bool CMetricBucketGatherer::releaseMemory(core_t::TTime samplingCutoffTime) {
+    bool released{false};
+    applyFunc(m_FeatureData,
+              std::bind<void>(SReleaseMemory(), std::placeholders::_1, std::placeholders::_2,
+                              samplingCutoffTime, std::ref(released)));
+    return released;
 }
 
 void CMetricBucketGatherer::sample(core_t::TTime time) {
@@ -1479,6 +1484,8 @@ void CMetricBucketGatherer::startNewBucket(core_t::TTime time, bool skipUpdates)
             }
             double alpha = std::exp(-m_DataGatherer.params().s_DecayRate);
 
+            TSizeVec ids;
+            ids.reserve(counts.size());
             for (auto& count : counts) {
                 std::sort(count.second.begin(), count.second.end());
                 std::size_t n = count.second.size() / 2;
@@ -1488,8 +1495,10 @@ void CMetricBucketGatherer::startNewBucket(core_t::TTime time, bool skipUpdates)
                         : static_cast<double>(count.second[n]);
                 m_DataGatherer.sampleCounts()->updateMeanNonZeroBucketCount(
                     count.first, median, alpha);
+                ids.push_back(count.first);
             }
-            m_DataGatherer.sampleCounts()->refresh(m_DataGatherer);
+            // Only the sample counts of the series which had values can change.
+            m_DataGatherer.sampleCounts()->refresh(m_DataGatherer, ids);
         }
     }
     applyFunc(m_FeatureData, std::bind<void>(SStartNewBucket(), std::placeholders::_1,
@@ -344,6 +344,13 @@ void CMetricModel::sample(core_t::TTime startTime,
                     gatherer.resetSampleCount(pid);
                 }
             }
+
+            TSizeVec people;
+            people.reserve(data.size());
+            for (const auto& data_ : data) {
+                people.push_back(data_.first);
+            }
+            this->refreshMemoryUsage(feature, std::move(people));
         }
 
         this->sampleCorrelateModels();
@@ -514,6 +514,13 @@ void CMetricPopulationModel::sample(core_t::TTime startTime,
                     gatherer.resetSampleCount(cid);
                 }
             }
+
+            TSizeVec attributes;
+            attributes.reserve(data.size());
+            for (const auto& data_ : data) {
+                attributes.push_back(CDataGatherer::extractAttributeId(data_));
+            }
+            this->refreshMemoryUsage(feature, std::move(attributes));
         }
 
         for (const auto& feature : m_FeatureCorrelatesModels) {
@@ -789,6 +796,12 @@ std::size_t CMetricPopulationModel::memoryUsage() const {
     return estimate ? estimate.get() : this->computeMemoryUsage();
 }
 
+void CMetricPopulationModel::auditMemoryUsage() {
+    for (auto& feature : m_FeatureModels) {
+        feature.auditMemoryUsage();
+    }
+}
+
 std::size_t CMetricPopulationModel::computeMemoryUsage() const {
     std::size_t mem = this->CPopulationModel::memoryUsage();
     mem += core::CMemory::dynamicSize(m_CurrentBucketStats.s_PersonCounts);
@@ -860,6 +873,7 @@ void CMetricPopulationModel::createNewModels(std::size_t n, std::size_t m) {
                         feature.s_Models.back()->modelCorrelations(*correlates.s_Models);
                     }
                 }
+                feature.refreshMemoryUsage(cid);
             }
         }
     }
@@ -877,6 +891,7 @@ void CMetricPopulationModel::updateRecycledModels() {
                         feature.s_Models.back()->modelCorrelations(*correlates.s_Models);
                     }
                 }
+                feature.refreshMemoryUsage(cid);
             }
         }
     }
@@ -911,6 +926,7 @@ void CMetricPopulationModel::clearPrunedResources(const TSizeVec& /*people*/,
                         feature.s_Models.back()->modelCorrelations(*correlates.s_Models);
                     }
                 }
+                feature.refreshMemoryUsage(cid);
             }
         }
     }
@@ -926,10 +942,21 @@ void CMetricPopulationModel::doSkipSampling(core_t::TTime startTime, core_t::TTi
         for (auto& model : feature.s_Models) {
             model->skipTime(gap);
         }
+        feature.auditMemoryUsage();
     }
     this->CPopulationModel::doSkipSampling(startTime, endTime);
 }
 
+void CMetricPopulationModel::refreshMemoryUsage(model_t::EFeature feature, TSizeVec attributes) {
+    auto i = std::find_if(m_FeatureModels.begin(), m_FeatureModels.end(),
+                          [feature](const SFeatureModels& model) {
+                              return model.s_Feature == feature;
+                          });
+    if (i != m_FeatureModels.end()) {
+        i->refreshMemoryUsage(std::move(attributes));
+    }
+}
+
 const maths::common::CModel*
 CMetricPopulationModel::model(model_t::EFeature feature, std::size_t cid) const {
     return const_cast<CMetricPopulationModel*>(this)->model(feature, cid);
@@ -260,6 +260,10 @@ void CModelFactory::multibucketFeaturesWindowLength(std::size_t length) {
     m_ModelParams.s_MultibucketFeaturesWindowLength = length;
 }
 
+void CModelFactory::compactModelsWindow(std::size_t window) {
+    m_ModelParams.s_CompactModelsWindow = window;
+}
+
 void CModelFactory::multivariateByFields(bool enabled) {
     m_ModelParams.s_MultivariateByFields = enabled;
 }
@@ -13,6 +13,10 @@
 namespace ml {
 namespace model {
 
+void CMonitoredResource::auditMemoryUsage() {
+    // NO-OP
+}
+
 bool CMonitoredResource::supportsPruning() const {
     return false;
 }
@@ -121,6 +121,8 @@ CPopulationModel::CPopulationModel(bool isForPersistence, const CPopulationModel
       m_PersonLastBucketTimes(other.m_PersonLastBucketTimes),
       m_AttributeFirstBucketTimes(other.m_AttributeFirstBucketTimes),
       m_AttributeLastBucketTimes(other.m_AttributeLastBucketTimes),
+      m_PersonLastBucketTimeIndex(other.m_PersonLastBucketTimeIndex),
+      m_AttributeLastBucketTimeIndex(other.m_AttributeLastBucketTimeIndex),
       m_NewDistinctPersonCounts(BJKST_HASHES, BJKST_MAX_SIZE),
       m_DistinctPersonCounts(other.m_DistinctPersonCounts),
       m_PersonAttributeBucketCounts(other.m_PersonAttributeBucketCounts) {
@@ -176,10 +178,12 @@ void CPopulationModel::sample(core_t::TTime startTime,
         std::size_t pid = CDataGatherer::extractPersonId(count);
         std::size_t cid = CDataGatherer::extractAttributeId(count);
         m_PersonLastBucketTimes[pid] = startTime;
+        m_PersonLastBucketTimeIndex.update(pid, startTime);
         if (CAnomalyDetectorModel::isTimeUnset(m_AttributeFirstBucketTimes[cid])) {
             m_AttributeFirstBucketTimes[cid] = startTime;
         }
         m_AttributeLastBucketTimes[cid] = startTime;
+        m_AttributeLastBucketTimeIndex.update(cid, startTime);
         m_DistinctPersonCounts[cid].add(static_cast<int32_t>(pid));
         if (cid < m_PersonAttributeBucketCounts.size()) {
             m_PersonAttributeBucketCounts[cid].add(static_cast<int32_t>(pid), 1.0);
@@ -215,6 +219,10 @@ void CPopulationModel::debugMemoryUsage(const core::CMemoryUsage::TMemoryUsagePt
                                     m_AttributeFirstBucketTimes, mem);
     core::CMemoryDebug::dynamicSize("m_AttributeLastBucketTimes",
                                     m_AttributeLastBucketTimes, mem);
+    core::CMemoryDebug::dynamicSize("m_PersonLastBucketTimeIndex",
+                                    m_PersonLastBucketTimeIndex, mem);
+    core::CMemoryDebug::dynamicSize("m_AttributeLastBucketTimeIndex",
+                                    m_AttributeLastBucketTimeIndex, mem);
     core::CMemoryDebug::dynamicSize("m_NewDistinctPersonCounts",
                                     m_NewDistinctPersonCounts, mem);
     core::CMemoryDebug::dynamicSize("m_DistinctPersonCounts", m_DistinctPersonCounts, mem);
@@ -228,6 +236,8 @@ std::size_t CPopulationModel::memoryUsage() const {
     mem += core::CMemory::dynamicSize(m_PersonLastBucketTimes);
     mem += core::CMemory::dynamicSize(m_AttributeFirstBucketTimes);
     mem += core::CMemory::dynamicSize(m_AttributeLastBucketTimes);
+    mem += core::CMemory::dynamicSize(m_PersonLastBucketTimeIndex);
+    mem += core::CMemory::dynamicSize(m_AttributeLastBucketTimeIndex);
     mem += core::CMemory::dynamicSize(m_NewDistinctPersonCounts);
     mem += core::CMemory::dynamicSize(m_DistinctPersonCounts);
     mem += core::CMemory::dynamicSize(m_NewPersonBucketCounts);
@@ -333,6 +343,8 @@ bool CPopulationModel::doAcceptRestoreTraverser(core::CStateRestoreTraverser& tr
     VIOLATES_INVARIANT(m_AttributeFirstBucketTimes.size(), !=,
                        m_AttributeLastBucketTimes.size());
 
+    this->rebuildLastBucketTimeIndices();
+
     return true;
 }
 
@@ -422,6 +434,7 @@ void CPopulationModel::createNewModels(std::size_t n, std::size_t m) {
         core::CAllocationStrategy::resize(m_PersonLastBucketTimes,
                                           n + m_PersonLastBucketTimes.size(),
                                           CAnomalyDetectorModel::TIME_UNSET);
+        m_PersonLastBucketTimeIndex.resize(m_PersonLastBucketTimes.size());
     }
 
     if (m > 0) {
@@ -430,6 +443,7 @@ void CPopulationModel::createNewModels(std::size_t n, std::size_t m) {
                                           CAnomalyDetectorModel::TIME_UNSET);
         core::CAllocationStrategy::resize(m_AttributeLastBucketTimes, newM,
                                           CAnomalyDetectorModel::TIME_UNSET);
+        m_AttributeLastBucketTimeIndex.resize(newM);
         core::CAllocationStrategy::resize(m_DistinctPersonCounts, newM, m_NewDistinctPersonCounts);
         if (m_NewPersonBucketCounts) {
             core::CAllocationStrategy::resize(m_PersonAttributeBucketCounts,
@@ -445,6 +459,7 @@ void CPopulationModel::updateRecycledModels() {
     for (auto pid : gatherer.recycledPersonIds()) {
         if (pid < m_PersonLastBucketTimes.size()) {
             m_PersonLastBucketTimes[pid] = 0;
+            m_PersonLastBucketTimeIndex.update(pid, 0);
         }
     }
 
@@ -453,6 +468,7 @@ void CPopulationModel::updateRecycledModels() {
         if (cid < m_AttributeFirstBucketTimes.size()) {
             m_AttributeFirstBucketTimes[cid] = CAnomalyDetectorModel::TIME_UNSET;
             m_AttributeLastBucketTimes[cid] = CAnomalyDetectorModel::TIME_UNSET;
+            m_AttributeLastBucketTimeIndex.remove(cid);
             m_DistinctPersonCounts[cid] = m_NewDistinctPersonCounts;
             if (m_NewPersonBucketCounts) {
                 m_PersonAttributeBucketCounts[cid] = *m_NewPersonBucketCounts;
@@ -509,33 +525,27 @@ void CPopulationModel::peopleAndAttributesToRemove(core_t::TTime time,
     }
 
     const CDataGatherer& gatherer = this->dataGatherer();
+    core_t::TTime bucketLength{gatherer.bucketLength()};
 
-    for (std::size_t pid = 0; pid < m_PersonLastBucketTimes.size(); ++pid) {
-        if ((gatherer.isPersonActive(pid)) &&
-            (!CAnomalyDetectorModel::isTimeUnset(m_PersonLastBucketTimes[pid]))) {
-            std::size_t bucketsSinceLastEvent = static_cast<std::size_t>(
-                (time - m_PersonLastBucketTimes[pid]) / gatherer.bucketLength());
-            if (bucketsSinceLastEvent > maximumAge) {
-                LOG_TRACE(<< gatherer.personName(pid) << ", bucketsSinceLastEvent = " << bucketsSinceLastEvent
+    m_PersonLastBucketTimeIndex.forEachOlderThan(
+        time, bucketLength, maximumAge, [&](std::size_t pid) {
+            if (gatherer.isPersonActive(pid)) {
+                LOG_TRACE(<< gatherer.personName(pid) << ", bucketsSinceLastEvent = "
+                          << (time - m_PersonLastBucketTimes[pid]) / bucketLength
                           << ", maximumAge = " << maximumAge);
                 peopleToRemove.push_back(pid);
             }
-        }
-    }
+        });
 
-    for (std::size_t cid = 0; cid < m_AttributeLastBucketTimes.size(); ++cid) {
-        if ((gatherer.isAttributeActive(cid)) &&
-            (!CAnomalyDetectorModel::isTimeUnset(m_AttributeLastBucketTimes[cid]))) {
-            std::size_t bucketsSinceLastEvent = static_cast<std::size_t>(
-                (time - m_AttributeLastBucketTimes[cid]) / gatherer.bucketLength());
-            if (bucketsSinceLastEvent > maximumAge) {
-                LOG_TRACE(<< gatherer.attributeName(cid)
-                          << ", bucketsSinceLastEvent = " << bucketsSinceLastEvent
+    m_AttributeLastBucketTimeIndex.forEachOlderThan(
+        time, bucketLength, maximumAge, [&](std::size_t cid) {
+            if (gatherer.isAttributeActive(cid)) {
+                LOG_TRACE(<< gatherer.attributeName(cid) << ", bucketsSinceLastEvent = "
+                          << (time - m_AttributeLastBucketTimes[cid]) / bucketLength
                           << ", maximumAge = " << maximumAge);
                 attributesToRemove.push_back(cid);
             }
-        }
-    }
+        });
 }
 
 void CPopulationModel::removePeople(const TSizeVec& peopleToRemove) {
@@ -567,6 +577,22 @@ void CPopulationModel::doSkipSampling(core_t::TTime startTime, core_t::TTime end
             m_AttributeLastBucketTimes[cid] = m_AttributeLastBucketTimes[cid] + gapDuration;
         }
     }
+
+    this->rebuildLastBucketTimeIndices();
+}
+
+void CPopulationModel::rebuildLastBucketTimeIndices() {
+    auto rebuild = [](const TTimeVec& times, CLastBucketTimeIndex& index) {
+        index.clear();
+        index.resize(times.size());
+        for (std::size_t id = 0; id < times.size(); ++id) {
+            if (!CAnomalyDetectorModel::isTimeUnset(times[id])) {
+                index.update(id, times[id]);
+            }
+        }
+    };
+    rebuild(m_PersonLastBucketTimes, m_PersonLastBucketTimeIndex);
+    rebuild(m_AttributeLastBucketTimes, m_AttributeLastBucketTimeIndex);
 }
 
 CPopulationModel::CCorrectionKey::CCorrectionKey(model_t::EFeature feature,
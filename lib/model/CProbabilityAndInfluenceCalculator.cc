@@ -56,6 +56,10 @@ using TProbabilityCalculation2Vec = core::CSmallVector<maths_t::EProbabilityCalc
 using TSizeDoublePr = std::pair<std::size_t, double>;
 using TSizeDoublePr1Vec = core::CSmallVector<TSizeDoublePr, 1>;
 
+//! The maximum relative error in the probabilities of influenced values
+//! we'll tolerate when interpolating cached probabilities.
+const double INFLUENCE_PROBABILITY_CACHE_MAXIMUM_ERROR{0.05};
+
 //! Get the canonical influence string pointer.
 core::CStoredStringPtr canonical(const std::string& influence) {
     return CStringStore::influencers().get(influence);
@@ -348,6 +352,40 @@ void doComputeIndicatorInfluences(const core::CStoredStringPtr& influencerName,
     }
 }
 
+//! Compute the probability of the influenced \p value.
+//!
+//! If \p cache is supplied the probabilities of univariate values are
+//! memoised, or interpolated where this is accurate enough, because many
+//! influencer field values result in the same or similar influenced values.
+//! This is only valid whilst \p params are the same for all values looked
+//! up in \p cache.
+bool influencedProbability(model_t::EFeature feature,
+                           const maths::common::CModel& model,
+                           const maths::common::CModelProbabilityParams& params,
+                           const TTime2Vec1Vec& time,
+                           const TDouble2Vec1Vec& value,
+                           CModelTools::CProbabilityCache* cache,
+                           maths::common::SModelProbabilityResult& result) {
+    if (cache == nullptr || model_t::isConstant(feature) || value.size() != 1 ||
+        value[0].size() != 1) {
+        return model.probability(params, time, value, result);
+    }
+
+    // The cache is keyed by the residual so it can check we don't interpolate
+    // across a mode of the residual distribution.
+    TDouble2Vec1Vec residual(value);
+    model.detrend(time, params.seasonalConfidenceInterval(), residual);
+    if (cache->lookup(feature, 0, residual, result)) {
+        return true;
+    }
+    if (model.probability(params, time, value, result) == false) {
+        return false;
+    }
+    cache->addModes(feature, 0, model);
+    cache->addProbability(feature, 0, residual, result);
+    return true;
+}
+
 //! The influence calculation for features using \p computeSample to
 //! get the statistics and \p computeInfluence to compute the influences
 //! from the corresponding probabilities.
@@ -368,6 +406,8 @@ void doComputeIndicatorInfluences(const core::CStoredStringPtr& influencerName,
 //! \param[in] cutoff The value at which there is no influence.
 //! \param[in] includeCutoff If true then add in values for influences
 //! less than the cutoff with estimated influence.
+//! \param[in] cache A cache of the probabilities of influenced values
+//! if there is one.
 //! \param[out] result Filled in with the influences of \p value.
 template<typename COMPUTE_INFLUENCED_VALUE, typename COMPUTE_INFLUENCE>
 void doComputeInfluences(model_t::EFeature feature,
@@ -383,6 +423,7 @@ void doComputeInfluences(model_t::EFeature feature,
                          const TStrCRefDouble1VecDoublePrPrVec& influencerValues,
                          double cutoff,
                          bool includeCutoff,
+                         CModelTools::CProbabilityCache* cache,
                          TStoredStringPtrStoredStringPtrPrDoublePrVec& result) {
     auto description = [&influencerName](const std::string& v) {
         return std::make_pair(influencerName, canonical(v));
@@ -403,8 +444,9 @@ void doComputeInfluences(model_t::EFeature feature,
     maths_t::TDouble2VecWeightsAry1Vec weights(computeProbabilityParams.weights());
     computeProbabilityParams.weights(weights).useMultibucketFeatures(false).useAnomalyModel(false);
     maths::common::SModelProbabilityResult overallResult;
-    model.probability(computeProbabilityParams, time,
-                      model_t::stripExtraStatistics(feature, {value}), overallResult);
+    influencedProbability(feature, model, computeProbabilityParams, time,
+                          model_t::stripExtraStatistics(feature, {value}),
+                          cache, overallResult);
     double overallProbability{probability(overallResult)};
 
     if (overallProbability == 1.0) {
@@ -435,8 +477,12 @@ void doComputeInfluences(model_t::EFeature feature,
             continue;
         }
 
-        if (model.probability(computeProbabilityParams, time, influencedValue,
-                              influenceResult) == false) {
+        // Some influenced values are computed by changing the weights in
+        // which case their probabilities can't be cached.
+        bool cacheable{computeProbabilityParams.weights() == weights};
+        if (influencedProbability(feature, model, computeProbabilityParams,
+                                  time, influencedValue, cacheable ? cache : nullptr,
+                                  influenceResult) == false) {
             LOG_ERROR(<< "Failed to compute P(" << influencedValue[0]
                       << " | influencer = " << core::CContainerPrinter::print(*i) << ")");
             continue;
@@ -564,7 +610,8 @@ CProbabilityAndInfluenceCalculator::CProbabilityAndInfluenceCalculator(double cu
            {CModelTools::CProbabilityAggregator::E_Min}},
           {maths::common::SModelProbabilityResult::E_MultiBucketProbability,
            {CModelTools::CProbabilityAggregator::E_Min}}},
-      m_ProbabilityCache(nullptr) {
+      m_ProbabilityCache(nullptr),
+      m_InfluenceProbabilityCache(INFLUENCE_PROBABILITY_CACHE_MAXIMUM_ERROR) {
 }
 
 bool CProbabilityAndInfluenceCalculator::empty() const {
@@ -576,6 +623,11 @@ double CProbabilityAndInfluenceCalculator::cutoff() const {
 }
 
 void CProbabilityAndInfluenceCalculator::plugin(const CInfluenceCalculator& influenceCalculator) {
+    // Different calculations compute probabilities of influenced values
+    // with different parameters.
+    if (m_InfluenceCalculator != &influenceCalculator) {
+        m_InfluenceProbabilityCache.clear();
+    }
     m_InfluenceCalculator = &influenceCalculator;
 }
 
@@ -702,6 +754,9 @@ bool CProbabilityAndInfluenceCalculator::addProbability(
         return false;
     }
 
+    // Any influences added next are for this value.
+    m_InfluenceProbabilityCache.clear();
+
     auto readResult = [&](const maths::common::SModelProbabilityResult& result) {
         for (const auto& fp : result.s_FeatureProbabilities) {
             auto itr = m_ExplainingProbabilities.find(fp.s_Label);
@@ -793,6 +848,7 @@ void CProbabilityAndInfluenceCalculator::addInfluences(const std::string& influe
     params.s_InfluencerValues = influencerValues;
     params.s_Cutoff = 0.5 / std::max(-logp, 1.0);
     params.s_IncludeCutoff = true;
+    params.s_ProbabilityCache = &m_InfluenceProbabilityCache;
 
     m_InfluenceCalculator->computeInfluences(params);
     m_Influences.swap(params.s_Influences);
@@ -949,7 +1005,7 @@ void CProbabilityAndInfluenceCalculator::commitInfluences(model_t::EFeature feat
 CProbabilityAndInfluenceCalculator::SParams::SParams(const CPartitioningFields& partitioningFields)
     : s_Feature(), s_Model(nullptr), s_ElapsedTime(0), s_Count(0.0),
       s_Probability(1.0), s_PartitioningFields(partitioningFields),
-      s_Cutoff(1.0), s_IncludeCutoff(false) {
+      s_Cutoff(1.0), s_IncludeCutoff(false), s_ProbabilityCache(nullptr) {
 }
 
 std::string CProbabilityAndInfluenceCalculator::SParams::describe() const {
@@ -1038,7 +1094,8 @@ void CLogProbabilityComplementInfluenceCalculator::computeInfluences(TParams& pa
                             *params.s_Model, params.s_ElapsedTime, computeProbabilityParams,
                             params.s_Time, params.s_Value[0], params.s_Count,
                             params.s_InfluencerName, params.s_InfluencerValues,
-                            params.s_Cutoff, params.s_IncludeCutoff, params.s_Influences);
+                            params.s_Cutoff, params.s_IncludeCutoff,
+                            params.s_ProbabilityCache, params.s_Influences);
     }
 }
 
@@ -1115,7 +1172,8 @@ void CLogProbabilityInfluenceCalculator::computeInfluences(TParams& params) cons
                             params.s_ElapsedTime, computeProbabilityParams,
                             params.s_Time, params.s_Value[0], params.s_Count,
                             params.s_InfluencerName, params.s_InfluencerValues,
-                            params.s_Cutoff, params.s_IncludeCutoff, params.s_Influences);
+                            params.s_Cutoff, params.s_IncludeCutoff,
+                            params.s_ProbabilityCache, params.s_Influences);
     }
 }
 
@@ -1171,7 +1229,8 @@ void CMeanInfluenceCalculator::computeInfluences(TParams& params) const {
                             *params.s_Model, params.s_ElapsedTime, computeProbabilityParams,
                             params.s_Time, params.s_Value[0], params.s_Count,
                             params.s_InfluencerName, params.s_InfluencerValues,
-                            params.s_Cutoff, params.s_IncludeCutoff, params.s_Influences);
+                            params.s_Cutoff, params.s_IncludeCutoff,
+                            params.s_ProbabilityCache, params.s_Influences);
     }
 }
 
@@ -1228,7 +1287,8 @@ void CVarianceInfluenceCalculator::computeInfluences(TParams& params) const {
                             *params.s_Model, params.s_ElapsedTime, computeProbabilityParams,
                             params.s_Time, params.s_Value[0], params.s_Count,
                             params.s_InfluencerName, params.s_InfluencerValues,
-                            params.s_Cutoff, params.s_IncludeCutoff, params.s_Influences);
+                            params.s_Cutoff, params.s_IncludeCutoff,
+                            params.s_ProbabilityCache, params.s_Influences);
     }
 }
 
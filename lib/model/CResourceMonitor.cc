@@ -117,14 +117,22 @@ void CResourceMonitor::categorizerAllocationFailures(std::size_t categorizerAllo
     m_CategorizerAllocationFailures = categorizerAllocationFailures;
 }
 
+std::size_t CResourceMonitor::lastMemoryUsage(const CMonitoredResource& resource) const {
+    auto itr = m_Resources.find(const_cast<CMonitoredResource*>(&resource));
+    return itr == m_Resources.end() ? 0 : itr->second;
+}
+
 void CResourceMonitor::refresh(CMonitoredResource& resource) {
     if (m_NoLimit) {
         return;
     }
-    this->forceRefresh(resource);
+    this->memUsage(&resource);
+
+    this->updateAllowAllocations();
 }
 
 void CResourceMonitor::forceRefresh(CMonitoredResource& resource) {
+    resource.auditMemoryUsage();
     this->memUsage(&resource);
 
     this->updateAllowAllocations();
@@ -132,6 +140,7 @@ void CResourceMonitor::forceRefresh(CMonitoredResource& resource) {
 
 void CResourceMonitor::forceRefreshAll() {
     for (auto& resource : m_Resources) {
+        resource.first->auditMemoryUsage();
         this->memUsage(resource.first);
     }
 
@@ -141,6 +150,11 @@ void CResourceMonitor::forceRefreshAll() {
 void CResourceMonitor::updateAllowAllocations() {
     std::size_t total{this->totalMemory()};
     core::CProgramCounters::counter(counter_t::E_TSADMemoryUsage) = total;
+    this->updateAllowAllocations(total);
+}
+
+void CResourceMonitor::updateAllowAllocations(std::size_t total) {
+    total += m_RetainedMemory;
     LOG_TRACE(<< "Checking allocations: currently at " << total);
     if (m_AllowAllocations) {
         if (total > this->highLimit()) {
@@ -247,7 +261,8 @@ bool CResourceMonitor::areAllocationsAllowed() const {
 }
 
 std::size_t CResourceMonitor::allocationLimit() const {
-    return this->highLimit() - std::min(this->highLimit(), this->totalMemory());
+    return this->highLimit() -
+           std::min(this->highLimit(), this->totalMemory() + m_RetainedMemory);
 }
 
 void CResourceMonitor::memUsage(CMonitoredResource* resource) {
@@ -461,6 +476,14 @@ void CResourceMonitor::clearExtraMemory() {
     }
 }
 
+void CResourceMonitor::retainedMemory(std::size_t memory) {
+    if (memory != m_RetainedMemory) {
+        m_RetainedMemory = memory;
+        // The reported memory usage is unchanged.
+        this->updateAllowAllocations(this->totalMemory());
+    }
+}
+
 void CResourceMonitor::decreaseMargin(core_t::TTime elapsedTime) {
     // We choose to increase the margin to close to 1 on the order
     // time it takes to detect diurnal periodic components. These
@@ -123,7 +123,7 @@ void CSampleCounts::resetSampleCount(const CDataGatherer& gatherer, std::size_t
     }
 }
 
-void CSampleCounts::refresh(const CDataGatherer& gatherer) {
+void CSampleCounts::refresh(const CDataGatherer& gatherer, const TSizeVec& ids) {
     if (m_SampleCountOverride > 0) {
         return;
     }
@@ -135,7 +135,11 @@ void CSampleCounts::refresh(const CDataGatherer& gatherer) {
             std::max(sampleCountThreshold, model_t::minimumSampleCount(feature));
     }
 
-    for (std::size_t id = 0; id < m_MeanNonZeroBucketCounts.size(); ++id) {
+    for (auto id : ids) {
+        if (id >= m_MeanNonZeroBucketCounts.size()) {
+            LOG_ERROR(<< "Bad identifier " << id);
+            continue;
+        }
         const TMeanAccumulator& count_ = m_MeanNonZeroBucketCounts[id];
         if (m_SampleCounts[id] > 0) {
             if (maths::common::CBasicStatistics::count(count_) >=
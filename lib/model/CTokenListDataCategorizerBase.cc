@@ -10,6 +10,7 @@
  */
 #include <model/CTokenListDataCategorizerBase.h>
 
+#include <core/CHashing.h>
 #include <core/CLogger.h>
 #include <core/CMemory.h>
 #include <core/CStatePersistInserter.h>
@@ -31,6 +32,8 @@ namespace model {
 
 // Initialise statics
 const std::string CTokenListDataCategorizerBase::PRETOKENISED_TOKEN_FIELD{"..."};
+const std::size_t CTokenListDataCategorizerBase::TOKENISATION_CACHE_SIZE{256};
+const std::size_t CTokenListDataCategorizerBase::MAX_CACHED_STRING_LENGTH{1024};
 
 // We use short field names to reduce the state size
 namespace {
@@ -74,7 +77,7 @@ CTokenListDataCategorizerBase::computeCategory(bool isDryRun,
             return CLocalCategoryId::softFailure();
         }
     } else {
-        this->tokeniseString(fields, str, m_WorkTokenIds, m_WorkTokenUniqueIds, workWeight);
+        workWeight = this->tokeniseStringUsingCache(fields, str);
     }
 
     // Determine the minimum and maximum token weight that could possibly
@@ -85,10 +88,14 @@ CTokenListDataCategorizerBase::computeCategory(bool isDryRun,
         workWeight, m_LowerThreshold)};
 
     // We search previous categories in descending order of the number of matches
-    // we've seen for them
+    // we've seen for them. Only categories which share a common unique token with
+    // the string, or have none, can match so we use the token index to skip the
+    // rest
+    this->candidateCategories(m_WorkTokenUniqueIds, m_WorkCandidatePositions);
     auto bestSoFarIter = m_CategoriesByCount.end();
     double bestSoFarSimilarity{m_LowerThreshold};
-    for (auto iter = m_CategoriesByCount.begin(); iter != m_CategoriesByCount.end(); ++iter) {
+    for (auto position : m_WorkCandidatePositions) {
+        auto iter = m_CategoriesByCount.begin() + static_cast<std::ptrdiff_t>(position);
         const CTokenListCategory& compCategory{m_Categories[iter->second]};
         const TSizeSizePrVec& baseTokenIds{compCategory.baseTokenIds()};
         std::size_t baseWeight{compCategory.baseWeight()};
@@ -120,18 +127,16 @@ CTokenListDataCategorizerBase::computeCategory(bool isDryRun,
             }
         }
 
-        double similarity{this->similarity(m_WorkTokenIds, workWeight, baseTokenIds, baseWeight)};
+        // A string that matches the search for a category is accepted whatever
+        // its similarity, so only compute the similarity if we need it
+        double similarity{matchesSearch ? 0.0
+                                        : this->similarity(m_WorkTokenIds, workWeight,
+                                                           baseTokenIds, baseWeight)};
 
-        LOG_TRACE(<< similarity << '-' << compCategory.baseString() << '|' << str);
+        LOG_TRACE(<< (matchesSearch ? "reverse search match" : std::to_string(similarity))
+                  << '-' << compCategory.baseString() << '|' << str);
 
         if (matchesSearch || similarity > m_UpperThreshold) {
-            if (similarity <= m_LowerThreshold) {
-                // Not an ideal situation, but log at trace level to avoid
-                // excessive log file spam
-                LOG_TRACE(<< "Reverse search match below threshold : " << similarity
-                          << '-' << compCategory.baseString() << '|' << str);
-            }
-
             // This is a strong match, so accept it immediately and stop
             // looking for better matches
             CLocalCategoryId categoryId{iter->second};
@@ -171,6 +176,7 @@ CTokenListDataCategorizerBase::computeCategory(bool isDryRun,
     }
 
     // If we get here we haven't matched, so create a new category
+    m_CategoryPositions.push_back(m_CategoriesByCount.size());
     m_CategoriesByCount.emplace_back(1, m_Categories.size());
     ++m_TotalCount;
     if (this->isCategoryCountRare(1)) {
@@ -178,6 +184,7 @@ CTokenListDataCategorizerBase::computeCategory(bool isDryRun,
     }
     m_Categories.emplace_back(isDryRun, str, rawStringLen, m_WorkTokenIds,
                               workWeight, m_WorkTokenUniqueIds);
+    this->indexCategory(m_Categories.size() - 1);
 
     // Increment the counts of categories that use a given token
     for (const auto& workTokenId : m_WorkTokenIds) {
@@ -323,9 +330,15 @@ bool CTokenListDataCategorizerBase::acceptRestoreTraverser(core::CStateRestoreTr
     m_CategoriesByCount.clear();
     m_TotalCount = 0;
     m_NumRareCategories = 0;
+    m_CategoryPositions.clear();
+    m_CategoriesByCommonToken.clear();
+    m_CategoriesWithoutCommonTokens.clear();
     m_TokenIdLookup.clear();
     m_WorkTokenIds.clear();
     m_WorkTokenUniqueIds.clear();
+    // Token IDs may be assigned differently by the restored state
+    m_TokenisationCache.clear();
+    m_TokenisationCacheHits = 0;
     m_MemoryCategorizationFailures = 0;
     m_LastCategorizerStats = SCategorizerStats{};
 
@@ -374,6 +387,14 @@ bool CTokenListDataCategorizerBase::acceptRestoreTraverser(core::CStateRestoreTr
     std::stable_sort(m_CategoriesByCount.begin(), m_CategoriesByCount.end(),
                      maths::common::COrderings::SFirstGreater{});
 
+    m_CategoryPositions.resize(m_Categories.size());
+    for (std::size_t position = 0; position < m_CategoriesByCount.size(); ++position) {
+        m_CategoryPositions[m_CategoriesByCount[position].second] = position;
+    }
+    for (std::size_t index = 0; index < m_Categories.size(); ++index) {
+        this->indexCategory(index);
+    }
+
     this->updateCategorizerStats(m_LastCategorizerStats);
 
     return true;
@@ -428,7 +449,12 @@ void CTokenListDataCategorizerBase::addCategoryMatch(bool isDryRun,
                                                      const TSizeSizePrVec& tokenIds,
                                                      const TSizeSizeMap& tokenUniqueIds,
                                                      TSizeSizePrVecItr iter) {
-    m_Categories[iter->second].addString(isDryRun, str, rawStringLen, tokenIds, tokenUniqueIds);
+    CTokenListCategory& category{m_Categories[iter->second]};
+    bool hadCommonTokens{category.commonUniqueTokenIds().empty() == false};
+    category.addString(isDryRun, str, rawStringLen, tokenIds, tokenUniqueIds);
+    if (hadCommonTokens && category.commonUniqueTokenIds().empty()) {
+        m_CategoriesWithoutCommonTokens.push_back(iter->second);
+    }
 
     std::size_t& count{iter->first};
     bool wasCountRare{this->isCategoryCountRare(count)};
@@ -460,7 +486,43 @@ void CTokenListDataCategorizerBase::addCategoryMatch(bool isDryRun,
     // deserves this
     if (swapIter != iter) {
         std::iter_swap(swapIter, iter);
+        m_CategoryPositions[swapIter->second] =
+            static_cast<std::size_t>(swapIter - m_CategoriesByCount.begin());
+        m_CategoryPositions[iter->second] =
+            static_cast<std::size_t>(iter - m_CategoriesByCount.begin());
+    }
+}
+
+void CTokenListDataCategorizerBase::indexCategory(std::size_t index) {
+    const TSizeSizePrVec& commonUniqueTokenIds{m_Categories[index].commonUniqueTokenIds()};
+    if (commonUniqueTokenIds.empty()) {
+        m_CategoriesWithoutCommonTokens.push_back(index);
+        return;
+    }
+    // Common unique token IDs are sorted so the last is the largest.
+    if (commonUniqueTokenIds.back().first >= m_CategoriesByCommonToken.size()) {
+        m_CategoriesByCommonToken.resize(commonUniqueTokenIds.back().first + 1);
+    }
+    for (const auto& tokenId : commonUniqueTokenIds) {
+        m_CategoriesByCommonToken[tokenId.first].push_back(index);
+    }
+}
+
+void CTokenListDataCategorizerBase::candidateCategories(const TSizeSizeMap& tokenUniqueIds,
+                                                        TSizeVec& positions) const {
+    positions.clear();
+    for (auto index : m_CategoriesWithoutCommonTokens) {
+        positions.push_back(m_CategoryPositions[index]);
+    }
+    for (const auto& tokenId : tokenUniqueIds) {
+        if (tokenId.first < m_CategoriesByCommonToken.size()) {
+            for (auto index : m_CategoriesByCommonToken[tokenId.first]) {
+                positions.push_back(m_CategoryPositions[index]);
+            }
+        }
     }
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
 }
 
 std::size_t CTokenListDataCategorizerBase::minMatchingWeight(std::size_t weight,
@@ -514,6 +576,51 @@ std::size_t CTokenListDataCategorizerBase::idForToken(const std::string& token)
     return nextIndex;
 }
 
+std::size_t CTokenListDataCategorizerBase::tokeniseStringUsingCache(const TStrStrUMap& fields,
+                                                                   const std::string& str) {
+    // Long messages are rarely repeated exactly and would dominate the memory
+    // used by the cache, so they're always tokenised afresh.  This bounds the
+    // size of the cache to roughly TOKENISATION_CACHE_SIZE times this length.
+    if (str.length() > MAX_CACHED_STRING_LENGTH) {
+        std::size_t weight{0};
+        this->tokeniseString(fields, str, m_WorkTokenIds, m_WorkTokenUniqueIds, weight);
+        return weight;
+    }
+
+    // Field names can affect tokenisation so they form part of the key.  The
+    // field map is unordered so combine their hashes commutatively.
+    core::CHashing::CMurmurHash2String hasher;
+    std::uint64_t fieldNamesHash{0};
+    for (const auto& field : fields) {
+        fieldNamesHash += hasher(field.first);
+    }
+
+    if (m_TokenisationCache.empty()) {
+        m_TokenisationCache.resize(TOKENISATION_CACHE_SIZE);
+    }
+    std::uint64_t hash{core::CHashing::hashCombine(
+        static_cast<std::uint64_t>(hasher(str)), fieldNamesHash)};
+    STokenisation& cached{m_TokenisationCache[hash % TOKENISATION_CACHE_SIZE]};
+
+    // Assignment reuses the existing capacity of the vectors and nodes of the
+    // maps so neither a hit nor a miss allocates once the slots are warm.
+    if (cached.s_FieldNamesHash == fieldNamesHash && cached.s_String == str) {
+        ++m_TokenisationCacheHits;
+        m_WorkTokenIds = cached.s_TokenIds;
+        m_WorkTokenUniqueIds = cached.s_TokenUniqueIds;
+        return cached.s_Weight;
+    }
+
+    std::size_t weight{0};
+    this->tokeniseString(fields, str, m_WorkTokenIds, m_WorkTokenUniqueIds, weight);
+    cached.s_FieldNamesHash = fieldNamesHash;
+    cached.s_String = str;
+    cached.s_TokenIds = m_WorkTokenIds;
+    cached.s_TokenUniqueIds = m_WorkTokenUniqueIds;
+    cached.s_Weight = weight;
+    return weight;
+}
+
 bool CTokenListDataCategorizerBase::addPretokenisedTokens(const std::string& tokensCsv,
                                                           TSizeSizePrVec& tokenIds,
                                                           TSizeSizeMap& tokenUniqueIds,
@@ -547,9 +654,15 @@ void CTokenListDataCategorizerBase::debugMemoryUsage(const core::CMemoryUsage::T
     core::CMemoryDebug::dynamicSize("m_ReverseSearchCreator", m_ReverseSearchCreator, mem);
     core::CMemoryDebug::dynamicSize("m_Categories", m_Categories, mem);
     core::CMemoryDebug::dynamicSize("m_CategoriesByCount", m_CategoriesByCount, mem);
+    core::CMemoryDebug::dynamicSize("m_CategoryPositions", m_CategoryPositions, mem);
+    core::CMemoryDebug::dynamicSize("m_CategoriesByCommonToken", m_CategoriesByCommonToken, mem);
+    core::CMemoryDebug::dynamicSize("m_CategoriesWithoutCommonTokens",
+                                    m_CategoriesWithoutCommonTokens, mem);
     core::CMemoryDebug::dynamicSize("m_TokenIdLookup", m_TokenIdLookup, mem);
     core::CMemoryDebug::dynamicSize("m_WorkTokenIds", m_WorkTokenIds, mem);
     core::CMemoryDebug::dynamicSize("m_WorkTokenUniqueIds", m_WorkTokenUniqueIds, mem);
+    core::CMemoryDebug::dynamicSize("m_WorkCandidatePositions", m_WorkCandidatePositions, mem);
+    core::CMemoryDebug::dynamicSize("m_TokenisationCache", m_TokenisationCache, mem);
     core::CMemoryDebug::dynamicSize("m_CsvLineParser", m_CsvLineParser, mem);
 }
 
@@ -558,9 +671,14 @@ std::size_t CTokenListDataCategorizerBase::memoryUsage() const {
     mem += core::CMemory::dynamicSize(m_ReverseSearchCreator);
     mem += core::CMemory::dynamicSize(m_Categories);
     mem += core::CMemory::dynamicSize(m_CategoriesByCount);
+    mem += core::CMemory::dynamicSize(m_CategoryPositions);
+    mem += core::CMemory::dynamicSize(m_CategoriesByCommonToken);
+    mem += core::CMemory::dynamicSize(m_CategoriesWithoutCommonTokens);
     mem += core::CMemory::dynamicSize(m_TokenIdLookup);
     mem += core::CMemory::dynamicSize(m_WorkTokenIds);
     mem += core::CMemory::dynamicSize(m_WorkTokenUniqueIds);
+    mem += core::CMemory::dynamicSize(m_WorkCandidatePositions);
+    mem += core::CMemory::dynamicSize(m_TokenisationCache);
     mem += core::CMemory::dynamicSize(m_CsvLineParser);
     return mem;
 }
@@ -571,6 +689,7 @@ void CTokenListDataCategorizerBase::updateCategorizerStats(SCategorizerStats& ca
 
     categorizerStats.s_CategorizedMessages += m_TotalCount;
     categorizerStats.s_MemoryCategorizationFailures += m_MemoryCategorizationFailures;
+    categorizerStats.s_TokenisationCacheHits += m_TokenisationCacheHits;
 
     std::size_t frequentCategoriesThisCategorizer{0};
     std::size_t deadCategoriesThisCategorizer{0};
@@ -813,6 +932,21 @@ std::size_t CTokenListDataCategorizerBase::CTokenInfoItem::memoryUsage() const {
     return core::CMemory::dynamicSize(m_Str);
 }
 
+void CTokenListDataCategorizerBase::STokenisation::debugMemoryUsage(
+    const core::CMemoryUsage::TMemoryUsagePtr& mem) const {
+    mem->setName("STokenisation");
+    core::CMemoryDebug::dynamicSize("s_String", s_String, mem);
+    core::CMemoryDebug::dynamicSize("s_TokenIds", s_TokenIds, mem);
+    core::CMemoryDebug::dynamicSize("s_TokenUniqueIds", s_TokenUniqueIds, mem);
+}
+
+std::size_t CTokenListDataCategorizerBase::STokenisation::memoryUsage() const {
+    std::size_t mem{core::CMemory::dynamicSize(s_String)};
+    mem += core::CMemory::dynamicSize(s_TokenIds);
+    mem += core::CMemory::dynamicSize(s_TokenUniqueIds);
+    return mem;
+}
+
 std::size_t CTokenListDataCategorizerBase::CTokenInfoItem::index() const {
     return m_Index;
 }
@@ -55,6 +55,7 @@ SModelParams::SModelParams(core_t::TTime bucketLength)
       s_SamplingAgeCutoff(SAMPLING_AGE_CUTOFF_DEFAULT),
       s_PruneWindowScaleMinimum(CAnomalyDetectorModelConfig::DEFAULT_PRUNE_WINDOW_SCALE_MINIMUM),
       s_PruneWindowScaleMaximum(CAnomalyDetectorModelConfig::DEFAULT_PRUNE_WINDOW_SCALE_MAXIMUM),
+      s_CompactModelsWindow(CAnomalyDetectorModelConfig::DEFAULT_COMPACT_MODELS_WINDOW),
       s_DetectionRules(EMPTY_RULES), s_ScheduledEvents(EMPTY_SCHEDULED_EVENTS),
       s_InfluenceCutoff(CAnomalyDetectorModelConfig::DEFAULT_INFLUENCE_CUTOFF),
       s_MinimumToFuzzyDeduplicate(10000), s_CacheProbabilities(true),
@@ -108,6 +109,7 @@ uint64_t SModelParams::checksum(uint64_t seed) const {
     seed = maths::common::CChecksum::calculate(seed, s_SampleQueueGrowthFactor);
     seed = maths::common::CChecksum::calculate(seed, s_PruneWindowScaleMinimum);
     seed = maths::common::CChecksum::calculate(seed, s_PruneWindowScaleMaximum);
+    seed = maths::common::CChecksum::calculate(seed, s_CompactModelsWindow);
     seed = maths::common::CChecksum::calculate(seed, s_CorrelationModelsOverhead);
     seed = maths::common::CChecksum::calculate(seed, s_MultivariateByFields);
     seed = maths::common::CChecksum::calculate(seed, s_MinimumSignificantCorrelation);
@@ -49,6 +49,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <map>
 #include <set>
 #include <string>
@@ -149,6 +150,49 @@ public:
         std::sort(messages.begin(), messages.end());
     }
 
+    //! Check that the people and attributes found to prune by the last
+    //! bucket time indices are exactly those found by scanning the last
+    //! bucket times.
+    //!
+    //! \return The number of people and attributes found.
+    std::size_t checkPeopleAndAttributesToRemove(core_t::TTime time, std::size_t maximumAge) {
+        const auto& model = static_cast<const CPopulationModel&>(*m_Model);
+        const CDataGatherer& gatherer = model.dataGatherer();
+        core_t::TTime bucketLength{gatherer.bucketLength()};
+
+        auto scan = [&](const CPopulationModel::TTimeVec& lastBucketTimes,
+                        const std::function<bool(std::size_t)>& isActive) {
+            TSizeVec result;
+            for (std::size_t id = 0; id < lastBucketTimes.size(); ++id) {
+                if (isActive(id) &&
+                    CAnomalyDetectorModel::isTimeUnset(lastBucketTimes[id]) == false &&
+                    static_cast<std::size_t>((time - lastBucketTimes[id]) / bucketLength) > maximumAge) {
+                    result.push_back(id);
+                }
+            }
+            return result;
+        };
+        TSizeVec expectedPeople{scan(model.m_PersonLastBucketTimes, [&](std::size_t pid) {
+            return gatherer.isPersonActive(pid);
+        })};
+        TSizeVec expectedAttributes{scan(model.m_AttributeLastBucketTimes, [&](std::size_t cid) {
+            return gatherer.isAttributeActive(cid);
+        })};
+
+        TSizeVec people;
+        TSizeVec attributes;
+        model.peopleAndAttributesToRemove(time, maximumAge, people, attributes);
+        std::sort(people.begin(), people.end());
+        std::sort(attributes.begin(), attributes.end());
+
+        BOOST_REQUIRE_EQUAL(core::CContainerPrinter::print(expectedPeople),
+                            core::CContainerPrinter::print(people));
+        BOOST_REQUIRE_EQUAL(core::CContainerPrinter::print(expectedAttributes),
+                            core::CContainerPrinter::print(attributes));
+
+        return people.size() + attributes.size();
+    }
+
     void makeModel(const SModelParams& params,
                    const model_t::TFeatureVec& features,
                    core_t::TTime startTime) {
@@ -617,6 +661,62 @@ BOOST_FIXTURE_TEST_CASE(testPrune, CTestFixture) {
                         clonedModelHolder->dataGatherer().numberActivePeople());
 }
 
+BOOST_FIXTURE_TEST_CASE(testPruneCandidatesMatchScan, CTestFixture) {
+    // Check that the people and attributes to prune found from the last
+    // bucket time indices match a scan of all the last bucket times as
+    // people and attributes come and go, are pruned and recycled, and
+    // after skipping time.
+
+    const core_t::TTime bucketLength{600};
+    core_t::TTime startTime{1367280000};
+    SModelParams params(bucketLength);
+    params.s_DecayRate = 0.01;
+    this->makeModel(params, {model_t::E_PopulationCountByBucketPersonAndAttribute}, startTime);
+
+    test::CRandomNumbers rng;
+
+    // Each person and attribute has its own probability of being seen in a
+    // bucket so their last seen times are spread out.
+    TDoubleVec personRates;
+    TDoubleVec attributeRates;
+    rng.generateUniformSamples(0.0, 0.5, 40, personRates);
+    rng.generateUniformSamples(0.0, 1.0, 8, attributeRates);
+
+    std::size_t numberFound{0};
+    core_t::TTime time{startTime};
+    TDoubleVec u01;
+    for (std::size_t bucket = 0; bucket < 300; ++bucket, time += bucketLength) {
+        for (std::size_t i = 0; i < personRates.size(); ++i) {
+            // Stop seeing some people half way through.
+            if (bucket > 150 && i % 4 == 0) {
+                continue;
+            }
+            for (std::size_t j = 0; j < attributeRates.size(); ++j) {
+                rng.generateUniformSamples(0.0, 1.0, 1, u01);
+                if (u01[0] < personRates[i] * attributeRates[j]) {
+                    this->addArrival(SMessage(time, "p" + std::to_string(i),
+                                              TOptionalStr("c" + std::to_string(j))),
+                                     m_Gatherer);
+                }
+            }
+        }
+        m_Model->sample(time, time + bucketLength, m_ResourceMonitor);
+
+        for (std::size_t maximumAge : {0, 1, 3, 10, 40}) {
+            numberFound += this->checkPeopleAndAttributesToRemove(time, maximumAge);
+        }
+        if (bucket % 50 == 49) {
+            m_Model->prune(20);
+        }
+        if (bucket == 200) {
+            m_Model->skipSampling(time + 10 * bucketLength);
+            time += 9 * bucketLength;
+        }
+    }
+    LOG_DEBUG(<< "found " << numberFound << " people and attributes to prune");
+    BOOST_TEST_REQUIRE(numberFound > 0);
+}
+
 BOOST_FIXTURE_TEST_CASE(testKey, CTestFixture) {
     function_t::TFunctionVec countFunctions{function_t::E_PopulationCount,
                                             function_t::E_PopulationDistinctCount,
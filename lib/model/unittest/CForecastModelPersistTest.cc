@@ -26,6 +26,9 @@
 #include <boost/test/unit_test.hpp>
 
 #include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(CForecastModelPersistTest)
 
@@ -166,6 +169,63 @@ BOOST_AUTO_TEST_CASE(testPersistAndRestore) {
     std::remove(persistedModels.c_str());
 }
 
+BOOST_AUTO_TEST_CASE(testRestoreRecordsOutOfOrder) {
+    // Test that records can be read and then restored independently.
+
+    core_t::TTime bucketLength{1800};
+    double minimumSeasonalVarianceScale = 0.2;
+    SModelParams params{bucketLength};
+    maths::time_series::CTimeSeriesDecomposition trend(params.s_DecayRate, bucketLength);
+    maths::common::CNormalMeanPrecConjugate prior{
+        maths::common::CNormalMeanPrecConjugate::nonInformativePrior(
+            maths_t::E_ContinuousData, params.s_DecayRate)};
+    maths::common::CModelParams timeSeriesModelParams{bucketLength,
+                                                      params.s_LearnRate,
+                                                      params.s_DecayRate,
+                                                      minimumSeasonalVarianceScale,
+                                                      params.s_MinimumTimeToDetectChange,
+                                                      params.s_MaximumTimeToTestForChange};
+
+    std::vector<std::unique_ptr<maths::time_series::CUnivariateTimeSeriesModel>> models;
+    CForecastModelPersist::CPersist persister(ml::test::CTestTmpDir::tmpDir());
+    for (std::size_t i = 0; i < 5; ++i) {
+        models.push_back(std::make_unique<maths::time_series::CUnivariateTimeSeriesModel>(
+            timeSeriesModelParams, i, trend, prior));
+        persister.addModel(models.back().get(), 10, 50,
+                           model_t::EFeature::E_IndividualCountByBucketAndPerson,
+                           "by" + std::to_string(i));
+    }
+    std::string persistedModels = persister.finalizePersistAndGetFile();
+
+    {
+        CForecastModelPersist::CRestore restorer(params, minimumSeasonalVarianceScale,
+                                                 persistedModels);
+        std::vector<CForecastModelPersist::TByteVec> records;
+        CForecastModelPersist::TByteVec record;
+        while (restorer.nextRecord(record)) {
+            records.push_back(std::move(record));
+        }
+        BOOST_REQUIRE_EQUAL(models.size(), records.size());
+
+        for (std::size_t i = records.size(); i > 0; --i) {
+            CForecastModelPersist::TMathsModelPtr restoredModel;
+            core_t::TTime firstDataTime;
+            core_t::TTime lastDataTime;
+            std::string restoredByFieldValue;
+            model_t::EFeature restoredFeature;
+            BOOST_TEST_REQUIRE(restorer.restoreModel(records[i - 1], restoredModel,
+                                                     firstDataTime, lastDataTime,
+                                                     restoredFeature, restoredByFieldValue));
+            BOOST_REQUIRE_EQUAL("by" + std::to_string(i - 1), restoredByFieldValue);
+            BOOST_REQUIRE_EQUAL(i - 1, restoredModel->identifier());
+            CForecastModelPersist::TMathsModelPtr modelForForecast{
+                models[i - 1]->cloneForForecast()};
+            BOOST_REQUIRE_EQUAL(modelForForecast->checksum(42), restoredModel->checksum(42));
+        }
+    }
+    std::remove(persistedModels.c_str());
+}
+
 BOOST_AUTO_TEST_CASE(testPersistAndRestoreEmpty) {
     core_t::TTime bucketLength{1800};
     double minimumSeasonalVarianceScale = 0.2;
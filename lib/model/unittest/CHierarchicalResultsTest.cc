@@ -11,9 +11,11 @@
 
 #include <core/CContainerPrinter.h>
 #include <core/CLogger.h>
+#include <core/CProgramCounters.h>
 #include <core/CRapidXmlParser.h>
 #include <core/CRapidXmlStatePersistInserter.h>
 #include <core/CRapidXmlStateRestoreTraverser.h>
+#include <core/Concurrency.h>
 
 #include <maths/common/CStatisticalTests.h>
 #include <maths/common/CTools.h>
@@ -61,6 +63,7 @@ using TStoredStringPtrStoredStringPtrPrDoublePr =
 using TStoredStringPtrStoredStringPtrPrDoublePrVec =
     model::CHierarchicalResults::TStoredStringPtrStoredStringPtrPrDoublePrVec;
 using TStrVec = std::vector<std::string>;
+using TStoredStringPtrVec = std::vector<core::CStoredStringPtr>;
 
 const std::string EMPTY_STRING;
 
@@ -241,6 +244,20 @@ public:
     }
 };
 
+//! \brief Gathers the node probabilities and normalized scores.
+class CScoreGatherer : public model::CHierarchicalResultsVisitor {
+public:
+    void visit(const model::CHierarchicalResults& /*results*/, const TNode& node, bool /*pivot*/) override {
+        m_Scores.push_back(node.probability());
+        m_Scores.push_back(node.s_NormalizedAnomalyScore);
+    }
+
+    const TDoubleVec& scores() const { return m_Scores; }
+
+private:
+    TDoubleVec m_Scores;
+};
+
 //! \brief Checks that if we write a result for a node, we also write one
 //! for its parent (if there is one) and one for at least one child (if
 //! there are any children).
@@ -1879,6 +1896,154 @@ BOOST_AUTO_TEST_CASE(testDetectorEqualizing) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(testParallelVisit) {
+    // Test that visiting the levels of the tree in parallel gives identical
+    // probabilities and normalized scores to visiting the nodes serially.
+
+    model::CAnomalyDetectorModelConfig modelConfig =
+        model::CAnomalyDetectorModelConfig::defaultConfig();
+    std::string FUNC("max");
+    static const ml::model::function_t::EFunction function(ml::model::function_t::E_IndividualMetricMax);
+
+    core::CStoredStringPtr I(model::CStringStore::influencers().get("I"));
+    TStoredStringPtrVec influencerValues;
+    for (std::size_t i = 0; i < 10; ++i) {
+        influencerValues.push_back(
+            model::CStringStore::influencers().get("i" + std::to_string(i)));
+    }
+
+    test::CRandomNumbers rng;
+    TDoubleVec probabilities;
+    rng.generateUniformSamples(0.0, 1.0, 3000, probabilities);
+    for (auto& probability : probabilities) {
+        probability = std::pow(probability, 4.0);
+    }
+
+    auto gatherScores = [&]() {
+        model::CHierarchicalResultsAggregator aggregator(modelConfig);
+        model::CHierarchicalResultsProbabilityFinalizer finalizer;
+        model::CHierarchicalResultsNormalizer normalizer(modelConfig);
+
+        // Two detectors for each partition and person so every level of
+        // the tree has nodes.
+        model::CHierarchicalResults results;
+        for (std::size_t i = 0; i < probabilities.size(); ++i) {
+            model::SAnnotatedProbability annotatedProbability(probabilities[i]);
+            annotatedProbability.s_Influences.push_back(TStoredStringPtrStoredStringPtrPrDoublePr(
+                TStoredStringPtrStoredStringPtrPr(I, influencerValues[i % 10]), 1.0));
+            results.addModelResult(
+                static_cast<int>(1 + i % 2), false, FUNC, function, PF1,
+                "p" + std::to_string(i / 2 % 3), PNF1, "pn" + std::to_string(i / 6),
+                EMPTY_STRING, annotatedProbability);
+        }
+        results.buildHierarchy();
+        results.bottomUpBreadthFirst(aggregator);
+        results.createPivots();
+        results.pivotsBottomUpBreadthFirst(aggregator);
+        results.bottomUpBreadthFirst(finalizer);
+        results.pivotsBottomUpBreadthFirst(finalizer);
+        for (auto job : {model::CHierarchicalResultsNormalizer::E_RefreshSettings,
+                         model::CHierarchicalResultsNormalizer::E_UpdateQuantiles,
+                         model::CHierarchicalResultsNormalizer::E_NormalizeScores}) {
+            normalizer.setJob(job);
+            results.bottomUpBreadthFirst(normalizer);
+            results.pivotsBottomUpBreadthFirst(normalizer);
+        }
+
+        CScoreGatherer gatherer;
+        results.bottomUpBreadthFirst(gatherer);
+        results.pivotsBottomUpBreadthFirst(gatherer);
+        return gatherer.scores();
+    };
+
+    TDoubleVec expectedScores{gatherScores()};
+
+    core::startDefaultAsyncExecutor(4);
+    TDoubleVec scores{gatherScores()};
+    core::stopDefaultAsyncExecutor();
+
+    BOOST_REQUIRE_EQUAL(expectedScores.size(), scores.size());
+    BOOST_REQUIRE_EQUAL(core::CContainerPrinter::print(expectedScores),
+                        core::CContainerPrinter::print(scores));
+}
+
+BOOST_AUTO_TEST_CASE(testClearReusesNodes) {
+    // Test that the results built after clearing are identical to those
+    // built from scratch and that no nodes are allocated to build them.
+
+    model::CAnomalyDetectorModelConfig modelConfig =
+        model::CAnomalyDetectorModelConfig::defaultConfig();
+    model::CHierarchicalResultsAggregator aggregator(modelConfig);
+    std::string FUNC("max");
+    static const ml::model::function_t::EFunction function(ml::model::function_t::E_IndividualMetricMax);
+
+    core::CStoredStringPtr i1(model::CStringStore::influencers().get("i1"));
+    core::CStoredStringPtr i2(model::CStringStore::influencers().get("i2"));
+    core::CStoredStringPtr I(model::CStringStore::influencers().get("I"));
+
+    auto addResults = [&](model::CHierarchicalResults& results) {
+        model::SAnnotatedProbability annotatedProbability;
+        annotatedProbability.s_Probability = 0.22;
+        annotatedProbability.s_Influences.push_back(TStoredStringPtrStoredStringPtrPrDoublePr(
+            TStoredStringPtrStoredStringPtrPr(I, i1), 0.6));
+        results.addModelResult(1, false, FUNC, function, PNF1, pn11, PF1, p11,
+                               EMPTY_STRING, annotatedProbability);
+        annotatedProbability.clear();
+        annotatedProbability.s_Probability = 0.003;
+        annotatedProbability.s_Influences.push_back(TStoredStringPtrStoredStringPtrPrDoublePr(
+            TStoredStringPtrStoredStringPtrPr(I, i1), 0.9));
+        annotatedProbability.s_Influences.push_back(TStoredStringPtrStoredStringPtrPrDoublePr(
+            TStoredStringPtrStoredStringPtrPr(I, i2), 1.0));
+        results.addModelResult(1, false, FUNC, function, PNF1, pn11, PF1, p12,
+                               EMPTY_STRING, annotatedProbability);
+        annotatedProbability.clear();
+        annotatedProbability.s_Probability = 0.01;
+        annotatedProbability.s_Influences.push_back(TStoredStringPtrStoredStringPtrPrDoublePr(
+            TStoredStringPtrStoredStringPtrPr(I, i2), 1.0));
+        results.addModelResult(2, false, FUNC, function, PNF2, pn21, PF1, p13,
+                               EMPTY_STRING, annotatedProbability);
+        return annotatedProbability.s_Influences.capacity();
+    };
+    auto print = [&](model::CHierarchicalResults& results) {
+        results.buildHierarchy();
+        results.bottomUpBreadthFirst(aggregator);
+        results.createPivots();
+        results.pivotsBottomUpBreadthFirst(aggregator);
+        CPrinter printer;
+        results.postorderDepthFirst(printer);
+        results.pivotsBottomUpBreadthFirst(printer);
+        return printer.result();
+    };
+
+    std::string expected;
+    {
+        model::CHierarchicalResults results;
+        addResults(results);
+        expected = print(results);
+        LOG_DEBUG(<< "\nexpected:\n" << expected);
+    }
+
+    model::CHierarchicalResults results;
+    addResults(results);
+    BOOST_REQUIRE_EQUAL(expected, print(results));
+    results.setInterim();
+
+    results.clear();
+    BOOST_TEST_REQUIRE(results.empty());
+    BOOST_REQUIRE_EQUAL(std::size_t(0), results.resultCount());
+    BOOST_TEST_REQUIRE(results.root() == nullptr);
+    BOOST_TEST_REQUIRE(results.resultType().isInterim() == false);
+
+    std::uint64_t allocations{core::CProgramCounters::counter(
+        counter_t::E_TSADNumberResultNodeAllocations)};
+
+    // The leaves hand back the memory of the cleared nodes' influences.
+    BOOST_TEST_REQUIRE(addResults(results) > 0);
+    BOOST_REQUIRE_EQUAL(expected, print(results));
+    BOOST_REQUIRE_EQUAL(allocations, static_cast<std::uint64_t>(core::CProgramCounters::counter(
+                                         counter_t::E_TSADNumberResultNodeAllocations)));
+}
+
 BOOST_AUTO_TEST_CASE(testShouldWritePartition) {
     static const std::string PART1("PART1");
     static const std::string PERS("PERS");
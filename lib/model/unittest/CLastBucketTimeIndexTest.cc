@@ -0,0 +1,185 @@
+/*
+ * Copyright Elasticsearch B.V. and/or licensed to Elasticsearch B.V. under one
+ * or more contributor license agreements. Licensed under the Elastic License
+ * 2.0 and the following additional limitation. Functionality enabled by the
+ * files subject to the Elastic License 2.0 may only be used in production when
+ * invoked by an Elasticsearch process with a license key installed that permits
+ * use of machine learning features. You may not use this file except in
+ * compliance with the Elastic License 2.0 and the foregoing additional
+ * limitation.
+ */
+
+#include <core/CContainerPrinter.h>
+#include <core/CLogger.h>
+#include <core/CoreTypes.h>
+
+#include <model/CLastBucketTimeIndex.h>
+
+#include <test/CRandomNumbers.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(CLastBucketTimeIndexTest)
+
+using namespace ml;
+using namespace model;
+
+namespace {
+using TSizeVec = std::vector<std::size_t>;
+using TTimeVec = std::vector<core_t::TTime>;
+
+const core_t::TTime UNSET{-1};
+
+TSizeVec idsAt(const CLastBucketTimeIndex& index, core_t::TTime time) {
+    TSizeVec result;
+    index.forEach(time, [&](std::size_t id) { result.push_back(id); });
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TSizeVec expectedIdsAt(const TTimeVec& times, core_t::TTime time) {
+    TSizeVec result;
+    for (std::size_t id = 0; id < times.size(); ++id) {
+        if (times[id] == time) {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
+}
+
+BOOST_AUTO_TEST_CASE(testBasic) {
+    CLastBucketTimeIndex index;
+    index.resize(5);
+    BOOST_REQUIRE_EQUAL(0, index.size());
+    BOOST_TEST_REQUIRE(idsAt(index, 0).empty());
+
+    index.update(0, 100);
+    index.update(1, 100);
+    index.update(3, 200);
+    BOOST_REQUIRE_EQUAL(3, index.size());
+    BOOST_REQUIRE_EQUAL("[0, 1]", core::CContainerPrinter::print(idsAt(index, 100)));
+    BOOST_REQUIRE_EQUAL("[3]", core::CContainerPrinter::print(idsAt(index, 200)));
+
+    // Moving an identifier removes it from its old time.
+    index.update(1, 200);
+    index.update(1, 200);
+    BOOST_REQUIRE_EQUAL(3, index.size());
+    BOOST_REQUIRE_EQUAL("[0]", core::CContainerPrinter::print(idsAt(index, 100)));
+    BOOST_REQUIRE_EQUAL("[1, 3]", core::CContainerPrinter::print(idsAt(index, 200)));
+
+    index.remove(0);
+    index.remove(0);
+    index.remove(4);
+    BOOST_REQUIRE_EQUAL(2, index.size());
+    BOOST_TEST_REQUIRE(idsAt(index, 100).empty());
+
+    // Shrinking removes the identifiers which no longer exist.
+    index.resize(2);
+    BOOST_REQUIRE_EQUAL(1, index.size());
+    BOOST_REQUIRE_EQUAL("[1]", core::CContainerPrinter::print(idsAt(index, 200)));
+
+    // Updates to bad identifiers are ignored.
+    index.update(2, 200);
+    BOOST_REQUIRE_EQUAL("[1]", core::CContainerPrinter::print(idsAt(index, 200)));
+
+    index.clear();
+    BOOST_REQUIRE_EQUAL(0, index.size());
+    BOOST_TEST_REQUIRE(idsAt(index, 200).empty());
+    index.update(1, 300);
+    BOOST_REQUIRE_EQUAL("[1]", core::CContainerPrinter::print(idsAt(index, 300)));
+}
+
+BOOST_AUTO_TEST_CASE(testRandomUpdates) {
+    // Check the index always agrees with a brute force scan of the times.
+
+    test::CRandomNumbers rng;
+
+    std::size_t numberIds{200};
+    core_t::TTime bucketLength{600};
+
+    CLastBucketTimeIndex index;
+    index.resize(numberIds);
+    TTimeVec times(numberIds, UNSET);
+
+    TSizeVec active;
+    TSizeVec removed;
+    for (core_t::TTime time = 0; time < 100 * bucketLength; time += bucketLength) {
+        rng.generateUniformSamples(0, numberIds, 20, active);
+        for (auto id : active) {
+            index.update(id, time);
+            times[id] = time;
+        }
+        rng.generateUniformSamples(0, numberIds, 2, removed);
+        for (auto id : removed) {
+            index.remove(id);
+            times[id] = UNSET;
+        }
+
+        std::size_t expectedSize = static_cast<std::size_t>(std::count_if(
+            times.begin(), times.end(), [](core_t::TTime t) { return t != UNSET; }));
+        BOOST_REQUIRE_EQUAL(expectedSize, index.size());
+        for (core_t::TTime t = 0; t <= time; t += bucketLength) {
+            BOOST_REQUIRE_EQUAL(core::CContainerPrinter::print(expectedIdsAt(times, t)),
+                                core::CContainerPrinter::print(idsAt(index, t)));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testOlderThan) {
+    // Check we find exactly the identifiers the models used to prune when
+    // scanning all their last bucket times.
+
+    test::CRandomNumbers rng;
+
+    std::size_t numberIds{500};
+    core_t::TTime bucketLength{300};
+    core_t::TTime startTime{1700000000};
+
+    CLastBucketTimeIndex index;
+    index.resize(numberIds);
+    TTimeVec times(numberIds, UNSET);
+
+    TSizeVec active;
+    for (core_t::TTime time = startTime; time < startTime + 200 * bucketLength;
+         time += bucketLength) {
+        rng.generateUniformSamples(0, numberIds, 10, active);
+        for (auto id : active) {
+            index.update(id, time);
+            times[id] = time;
+        }
+    }
+    core_t::TTime time{startTime + 200 * bucketLength};
+
+    for (std::size_t maximumAge :
+         {std::size_t{0}, std::size_t{1}, std::size_t{10}, std::size_t{150},
+          std::size_t{199}, std::size_t{200}, std::numeric_limits<std::size_t>::max()}) {
+        TSizeVec expected;
+        for (std::size_t id = 0; id < times.size(); ++id) {
+            if (times[id] != UNSET &&
+                static_cast<std::size_t>((time - times[id]) / bucketLength) > maximumAge) {
+                expected.push_back(id);
+            }
+        }
+
+        TSizeVec actual;
+        core_t::TTime last{std::numeric_limits<core_t::TTime>::min()};
+        index.forEachOlderThan(time, bucketLength, maximumAge, [&](std::size_t id) {
+            // We should visit the oldest first.
+            BOOST_TEST_REQUIRE(times[id] >= last);
+            last = times[id];
+            actual.push_back(id);
+        });
+        std::sort(actual.begin(), actual.end());
+
+        LOG_DEBUG(<< "maximum age = " << maximumAge << ", # older = " << expected.size());
+        BOOST_REQUIRE_EQUAL(core::CContainerPrinter::print(expected),
+                            core::CContainerPrinter::print(actual));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
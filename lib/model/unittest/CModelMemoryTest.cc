@@ -9,6 +9,7 @@
  * limitation.
  */
 
+#include <core/CLogger.h>
 #include <core/CMemory.h>
 
 #include <maths/common/CBasicStatistics.h>
@@ -26,7 +27,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <cmath>
 #include <memory>
+#include <string>
 
 BOOST_AUTO_TEST_SUITE(CModelMemoryTest)
 
@@ -176,4 +179,128 @@ BOOST_AUTO_TEST_CASE(testOnlineMetricModel) {
     BOOST_REQUIRE_EQUAL(model.computeMemoryUsage(), memoryUsage->usage());
 }
 
+BOOST_AUTO_TEST_CASE(testIncrementalMemoryUsage) {
+
+    // Tests that the memory usage of the feature models, which is maintained
+    // as they're updated, stays close to a full computation while people come
+    // and go and that the audit makes them agree exactly. The full computation
+    // comes from an identical model which we audit every bucket.
+
+    core_t::TTime startTime(0);
+    core_t::TTime bucketLength(600);
+    SModelParams params(bucketLength);
+    auto interimBucketCorrector = std::make_shared<CInterimBucketCorrector>(bucketLength);
+    CMetricModelFactory factory(params, interimBucketCorrector);
+
+    CDataGatherer::TFeatureVec features;
+    features.push_back(model_t::E_IndividualMeanByPerson);
+    features.push_back(model_t::E_IndividualMaxByPerson);
+    factory.features(features);
+    CModelFactory::TDataGathererPtr gatherers[]{
+        CModelFactory::TDataGathererPtr(factory.makeDataGatherer(startTime)),
+        CModelFactory::TDataGathererPtr(factory.makeDataGatherer(startTime))};
+    CModelFactory::TModelPtr modelPtrs[]{CModelFactory::TModelPtr(factory.makeModel(gatherers[0])),
+                                         CModelFactory::TModelPtr(factory.makeModel(gatherers[1]))};
+    BOOST_TEST_REQUIRE(modelPtrs[0]);
+    BOOST_TEST_REQUIRE(modelPtrs[1]);
+    CMetricModel& model = static_cast<CMetricModel&>(*modelPtrs[0].get());
+    CMetricModel& reference = static_cast<CMetricModel&>(*modelPtrs[1].get());
+    CResourceMonitor resourceMonitor;
+
+    test::CRandomNumbers rng;
+
+    double maxError{0.0};
+    core_t::TTime time{startTime};
+    TSizeVec people;
+    TDoubleVec values;
+    for (std::size_t i = 0; i < 200; ++i, time += bucketLength) {
+        rng.generateUniformSamples(0, i < 100 ? 20 : 10, 5, people);
+        for (auto person : people) {
+            rng.generateNormalSamples(10.0, 4.0, 3, values);
+            for (std::size_t j = 0; j < values.size(); ++j) {
+                for (auto& gatherer : gatherers) {
+                    addArrival(*gatherer, time + static_cast<core_t::TTime>(j),
+                               "p" + std::to_string(person), values[j]);
+                }
+            }
+        }
+        model.sample(time, time + bucketLength, resourceMonitor);
+        reference.sample(time, time + bucketLength, resourceMonitor);
+        if (i == 150) {
+            model.prune(10);
+            reference.prune(10);
+        }
+        reference.auditMemoryUsage();
+
+        double expected{static_cast<double>(reference.computeMemoryUsage())};
+        double actual{static_cast<double>(model.computeMemoryUsage())};
+        maxError = std::max(maxError, std::fabs(actual - expected) / expected);
+    }
+    LOG_DEBUG(<< "maximum relative error = " << maxError);
+    BOOST_TEST_REQUIRE(maxError < 0.05);
+
+    model.auditMemoryUsage();
+    BOOST_REQUIRE_EQUAL(reference.computeMemoryUsage(), model.computeMemoryUsage());
+}
+
+BOOST_AUTO_TEST_CASE(testAuditMemoryUsage) {
+
+    // Tests that the incrementally maintained memory usage drifts from the
+    // full recomputation done by auditMemoryUsage by a bounded amount if we
+    // audit every 10 buckets, as the detector does.
+
+    core_t::TTime startTime(0);
+    core_t::TTime bucketLength(600);
+    SModelParams params(bucketLength);
+    auto interimBucketCorrector = std::make_shared<CInterimBucketCorrector>(bucketLength);
+    CMetricModelFactory factory(params, interimBucketCorrector);
+
+    CDataGatherer::TFeatureVec features;
+    features.push_back(model_t::E_IndividualMeanByPerson);
+    features.push_back(model_t::E_IndividualMaxByPerson);
+    factory.features(features);
+    CModelFactory::TDataGathererPtr gatherer(factory.makeDataGatherer(startTime));
+    CModelFactory::TModelPtr modelPtr(factory.makeModel(gatherer));
+    BOOST_TEST_REQUIRE(modelPtr);
+    CMetricModel& model = static_cast<CMetricModel&>(*modelPtr.get());
+    CResourceMonitor resourceMonitor;
+
+    test::CRandomNumbers rng;
+
+    double maxDrift{0.0};
+    core_t::TTime time{startTime};
+    TSizeVec people;
+    TDoubleVec values;
+    for (std::size_t i = 0; i < 300; ++i, time += bucketLength) {
+        rng.generateUniformSamples(0, i < 150 ? 30 : 15, 8, people);
+        for (auto person : people) {
+            rng.generateNormalSamples(10.0, 4.0, 3, values);
+            for (std::size_t j = 0; j < values.size(); ++j) {
+                addArrival(*gatherer, time + static_cast<core_t::TTime>(j),
+                           "p" + std::to_string(person), values[j]);
+            }
+        }
+        model.sample(time, time + bucketLength, resourceMonitor);
+        if (i % 50 == 49) {
+            model.prune(20);
+        }
+
+        if (i % 10 == 9) {
+            double cached{static_cast<double>(model.computeMemoryUsage())};
+            model.auditMemoryUsage();
+            std::size_t audited{model.computeMemoryUsage()};
+            double drift{std::fabs(cached - static_cast<double>(audited)) /
+                         static_cast<double>(audited)};
+            LOG_TRACE(<< "bucket " << i << " drift = " << drift);
+            maxDrift = std::max(maxDrift, drift);
+
+            // Auditing again must change nothing.
+            model.auditMemoryUsage();
+            BOOST_REQUIRE_EQUAL(audited, model.computeMemoryUsage());
+        }
+    }
+    LOG_DEBUG(<< "maximum relative drift = " << maxDrift);
+    BOOST_TEST_REQUIRE(maxDrift < 0.01);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1415,6 +1415,84 @@ BOOST_AUTO_TEST_CASE(testIndicatorInfluenceCalculator) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(testInfluenceProbabilityCache) {
+    // Test that caching the probabilities of influenced values gives the
+    // same influences as computing every probability.
+
+    test::CRandomNumbers rng;
+
+    model::CLogProbabilityComplementInfluenceCalculator calculator;
+
+    core_t::TTime bucketLength{600};
+
+    maths::time_series::CTimeSeriesDecomposition trend{0.0, bucketLength};
+    maths::common::CNormalMeanPrecConjugate prior =
+        maths::common::CNormalMeanPrecConjugate::nonInformativePrior(maths_t::E_ContinuousData);
+    maths::time_series::CUnivariateTimeSeriesModel model(params(bucketLength), 0, trend, prior);
+
+    TDoubleVec samples;
+    rng.generateNormalSamples(100.0, 25.0, 100, samples);
+    core_t::TTime now{addSamples(bucketLength, samples, model)};
+
+    // Many influencer field values with the same or similar values.
+    std::vector<std::string> influencerNames;
+    TDoubleVec influencerValues_;
+    for (std::size_t i = 0; i < 20; ++i) {
+        influencerNames.push_back("big" + std::to_string(i));
+        influencerValues_.push_back(10.0 + static_cast<double>(i % 4));
+    }
+    for (std::size_t i = 0; i < 100; ++i) {
+        influencerNames.push_back("small" + std::to_string(i));
+        influencerValues_.push_back(1.0 + 0.01 * static_cast<double>(i % 10));
+    }
+    double value{0.0};
+    TStrCRefDouble1VecDoublePrPrVec influencerValues;
+    for (std::size_t i = 0; i < influencerNames.size(); ++i) {
+        value += influencerValues_[i];
+        influencerValues.emplace_back(TStrCRef(influencerNames[i]),
+                                      make_pair(influencerValues_[i], 1.0));
+    }
+
+    double p;
+    TTail2Vec tail;
+    computeProbability(now, maths_t::E_TwoSided, TDouble1Vec{value}, model, p, tail);
+
+    auto computeInfluences = [&](model::CModelTools::CProbabilityCache* cache) {
+        model::CPartitioningFields partitioningFields(EMPTY_STRING, EMPTY_STRING);
+        model::CProbabilityAndInfluenceCalculator::SParams params(partitioningFields);
+        params.s_Feature = model_t::E_IndividualCountByBucketAndPerson;
+        params.s_Model = &model;
+        params.s_Time = TTime2Vec1Vec{TTimeVec{now}};
+        params.s_Value = TDouble2Vec1Vec{TDoubleVec{value}};
+        params.s_Count = static_cast<double>(influencerValues.size());
+        params.s_ComputeProbabilityParams.addWeights(
+            maths_t::CUnitWeights::unit<TDouble2Vec>(1));
+        params.s_Probability = p;
+        params.s_Tail = tail;
+        params.s_InfluencerName = model::CStringStore::influencers().get(I);
+        params.s_InfluencerValues = influencerValues;
+        params.s_Cutoff = 0.1;
+        params.s_IncludeCutoff = true;
+        params.s_ProbabilityCache = cache;
+        calculator.computeInfluences(params);
+        return std::move(params.s_Influences);
+    };
+
+    TStoredStringPtrStoredStringPtrPrDoublePrVec expectedInfluences{computeInfluences(nullptr)};
+    model::CModelTools::CProbabilityCache cache{0.05};
+    TStoredStringPtrStoredStringPtrPrDoublePrVec influences{computeInfluences(&cache)};
+    LOG_DEBUG(<< "expected influences = " << core::CContainerPrinter::print(expectedInfluences));
+    LOG_DEBUG(<< "influences          = " << core::CContainerPrinter::print(influences));
+
+    BOOST_REQUIRE_EQUAL(expectedInfluences.size(), influences.size());
+    for (std::size_t i = 0; i < influences.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(*expectedInfluences[i].first.second,
+                            *influences[i].first.second);
+        BOOST_REQUIRE_CLOSE_ABSOLUTE(expectedInfluences[i].second,
+                                     influences[i].second, 0.01);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(testProbabilityAndInfluenceCalculator) {
     test::CRandomNumbers rng;
 
@@ -431,6 +431,9 @@ BOOST_FIXTURE_TEST_CASE(testPruning, CTestFixture) {
 
     CAnomalyDetectorModelConfig modelConfig =
         CAnomalyDetectorModelConfig::defaultConfig(BUCKET_LENGTH);
+    // Compacting the models of the people who stop sending data would keep
+    // memory below the limit and we want to test pruning.
+    modelConfig.compactModelsWindow(0);
     CLimits limits(false, 1.0);
 
     CSearchKey key(1, // detectorIndex
@@ -548,6 +551,51 @@ BOOST_FIXTURE_TEST_CASE(testExtraMemory, CTestFixture) {
     BOOST_REQUIRE_EQUAL(allocationLimit, monitor.allocationLimit());
 }
 
+BOOST_FIXTURE_TEST_CASE(testRetainedMemory, CTestFixture) {
+    static const std::string EMPTY_STRING;
+    static const core_t::TTime FIRST_TIME{358556400};
+    static const core_t::TTime BUCKET_LENGTH{3600};
+
+    CAnomalyDetectorModelConfig modelConfig =
+        CAnomalyDetectorModelConfig::defaultConfig(BUCKET_LENGTH);
+    CLimits limits;
+
+    CSearchKey key(1, // detectorIndex
+                   function_t::E_IndividualMetric, false, model_t::E_XF_None,
+                   "value", "colour");
+
+    CResourceMonitor& monitor = limits.resourceMonitor();
+    // set the limit to 1 MB
+    monitor.memoryLimit(1);
+
+    CAnomalyDetector detector(limits, modelConfig, EMPTY_STRING, FIRST_TIME,
+                              modelConfig.factory(key));
+
+    monitor.forceRefresh(detector);
+    BOOST_TEST_REQUIRE(monitor.lastMemoryUsage(detector) > 0);
+    std::size_t allocationLimit = monitor.allocationLimit();
+    std::size_t totalMemory = monitor.totalMemory();
+
+    // Retained memory counts towards the limit but not the usage.
+    monitor.retainedMemory(200);
+    BOOST_TEST_REQUIRE(monitor.areAllocationsAllowed());
+    BOOST_REQUIRE_EQUAL(allocationLimit - 200, monitor.allocationLimit());
+    BOOST_REQUIRE_EQUAL(totalMemory, monitor.totalMemory());
+    BOOST_REQUIRE_EQUAL(totalMemory, monitor.createMemoryUsageReport(FIRST_TIME).s_Usage);
+
+    // Retained memory isn't cleared with the extra memory.
+    monitor.clearExtraMemory();
+    BOOST_REQUIRE_EQUAL(allocationLimit - 200, monitor.allocationLimit());
+
+    monitor.retainedMemory(core::constants::BYTES_IN_MEGABYTES);
+    BOOST_TEST_REQUIRE(monitor.areAllocationsAllowed() == false);
+    BOOST_REQUIRE_EQUAL(0, monitor.allocationLimit());
+
+    monitor.retainedMemory(0);
+    BOOST_TEST_REQUIRE(monitor.areAllocationsAllowed());
+    BOOST_REQUIRE_EQUAL(allocationLimit, monitor.allocationLimit());
+}
+
 BOOST_FIXTURE_TEST_CASE(testPeakUsage, CTestFixture) {
     // Clear the counter so that other test cases do not interfere.
     core::CProgramCounters::counter(counter_t::E_TSADPeakMemoryUsage) = 0;
@@ -524,6 +524,114 @@ BOOST_FIXTURE_TEST_CASE(testPersist, CTestFixture) {
     checkMemoryUsageInstrumentation(restoredCategorizer);
 }
 
+BOOST_FIXTURE_TEST_CASE(testCandidateCategoriesAfterRestore, CTestFixture) {
+    // Check that the categories found via the index of common tokens are the
+    // same for a categorizer which is restored part way through the messages.
+
+    TTokenListDataCategorizerKeepsFields origCategorizer{
+        m_Limits, NO_REVERSE_SEARCH_CREATOR, 0.7, "whatever"};
+
+    using TStrVec = std::vector<std::string>;
+    TStrVec prefixes{20};
+    std::generate(prefixes.begin(), prefixes.end(),
+                  [this]() { return makeUniqueMessage(4); });
+    TStrVec messages;
+    for (std::size_t i = 0; i < 400; ++i) {
+        messages.push_back(prefixes[(i * 7) % prefixes.size()] + ' ' +
+                           makeUniqueMessage(1 + i % 3));
+    }
+
+    for (std::size_t i = 0; i < 200; ++i) {
+        origCategorizer.computeCategory(false, messages[i], messages[i].length());
+    }
+
+    std::string origXml;
+    {
+        ml::core::CRapidXmlStatePersistInserter inserter{"root"};
+        origCategorizer.acceptPersistInserter(inserter);
+        inserter.toXml(origXml);
+    }
+    TTokenListDataCategorizerKeepsFields restoredCategorizer{
+        m_Limits, NO_REVERSE_SEARCH_CREATOR, 0.7, "whatever"};
+    {
+        ml::core::CRapidXmlParser parser;
+        BOOST_TEST_REQUIRE(parser.parseStringIgnoreCdata(origXml));
+        ml::core::CRapidXmlStateRestoreTraverser traverser{parser};
+        BOOST_TEST_REQUIRE(traverser.traverseSubLevel(
+            std::bind(&TTokenListDataCategorizerKeepsFields::acceptRestoreTraverser,
+                      &restoredCategorizer, std::placeholders::_1)));
+    }
+
+    for (std::size_t i = 200; i < messages.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(
+            origCategorizer.computeCategory(false, messages[i], messages[i].length()),
+            restoredCategorizer.computeCategory(false, messages[i],
+                                                messages[i].length()));
+    }
+
+    checkMemoryUsageInstrumentation(origCategorizer);
+    checkMemoryUsageInstrumentation(restoredCategorizer);
+}
+
+BOOST_FIXTURE_TEST_CASE(testTokenisationCache, CTestFixture) {
+    TTokenListDataCategorizerKeepsFields categorizer{
+        m_Limits, NO_REVERSE_SEARCH_CREATOR, 0.7, "whatever"};
+    TTokenListDataCategorizerKeepsFields::TStrStrUMap noFields;
+
+    using TStrVec = std::vector<std::string>;
+    using TLocalCategoryIdVec = std::vector<ml::model::CLocalCategoryId>;
+    TStrVec messages{20};
+    std::generate(messages.begin(), messages.end(),
+                  [this]() { return makeUniqueMessage(5); });
+
+    TLocalCategoryIdVec categories;
+    for (const auto& message : messages) {
+        categories.push_back(categorizer.computeCategory(false, noFields, message,
+                                                         message.length()));
+    }
+
+    ml::model::SCategorizerStats categorizerStats;
+    categorizer.updateCategorizerStats(categorizerStats);
+    BOOST_REQUIRE_EQUAL(0, categorizerStats.s_TokenisationCacheHits);
+
+    // Repeating the messages should hit the cache and give the same categories.
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(categories[i],
+                            categorizer.computeCategory(false, noFields, messages[i],
+                                                        messages[i].length()));
+    }
+
+    categorizerStats = ml::model::SCategorizerStats{};
+    categorizer.updateCategorizerStats(categorizerStats);
+    BOOST_REQUIRE_EQUAL(40, categorizerStats.s_CategorizedMessages);
+    BOOST_REQUIRE_EQUAL(messages.size(), categorizerStats.s_TokenisationCacheHits);
+
+    // The field names are part of the key.
+    TTokenListDataCategorizerKeepsFields::TStrStrUMap fields{{"message", messages[0]}};
+    BOOST_REQUIRE_EQUAL(categories[0], categorizer.computeCategory(false, fields, messages[0],
+                                                                   messages[0].length()));
+    categorizerStats = ml::model::SCategorizerStats{};
+    categorizer.updateCategorizerStats(categorizerStats);
+    BOOST_REQUIRE_EQUAL(messages.size(), categorizerStats.s_TokenisationCacheHits);
+
+    // Long messages aren't cached.
+    std::string longMessage{makeUniqueMessage(5)};
+    while (longMessage.length() <=
+           TTokenListDataCategorizerKeepsFields::MAX_CACHED_STRING_LENGTH) {
+        longMessage += " " + makeUniqueMessage(5);
+    }
+    auto longCategory = categorizer.computeCategory(false, noFields, longMessage,
+                                                    longMessage.length());
+    BOOST_REQUIRE_EQUAL(longCategory,
+                        categorizer.computeCategory(false, noFields, longMessage,
+                                                    longMessage.length()));
+    categorizerStats = ml::model::SCategorizerStats{};
+    categorizer.updateCategorizerStats(categorizerStats);
+    BOOST_REQUIRE_EQUAL(messages.size(), categorizerStats.s_TokenisationCacheHits);
+
+    checkMemoryUsageInstrumentation(categorizer);
+}
+
 BOOST_FIXTURE_TEST_CASE(testLongReverseSearch, CTestFixture) {
     TTokenListDataCategorizerKeepsFields::TTokenListReverseSearchCreatorCPtr reverseSearchCreator{
         new ml::model::CTokenListReverseSearchCreator{"_raw"}};
@@ -655,6 +763,16 @@ BOOST_FIXTURE_TEST_CASE(testPreTokenisedPerformance, CTestFixture) {
     static const std::size_t TEST_SIZE{100000};
     ml::core::CStopWatch stopWatch;
 
+    // Each message ends with a distinct number so that inline tokenisation
+    // can't simply reuse a cached tokenisation.  Tokens with a leading digit
+    // are ignored so all the messages have the same tokens.
+    std::vector<std::string> messages;
+    messages.reserve(TEST_SIZE);
+    for (std::size_t count = 0; count < TEST_SIZE; ++count) {
+        messages.push_back("Vpxa: [49EC0B90 verbose 'VpxaHalCnxHostagent' opID=WFU-ddeadb59] [WaitForUpdatesDone] Received callback " +
+                           std::to_string(count));
+    }
+
     std::uint64_t inlineTokenisationTime{0};
     {
         TTokenListDataCategorizerKeepsFields categorizer{
@@ -665,8 +783,7 @@ BOOST_FIXTURE_TEST_CASE(testPreTokenisedPerformance, CTestFixture) {
         stopWatch.start();
         for (std::size_t count = 0; count < TEST_SIZE; ++count) {
             BOOST_REQUIRE_EQUAL(ml::model::CLocalCategoryId{1},
-                                categorizer.computeCategory(false, "Vpxa: [49EC0B90 verbose 'VpxaHalCnxHostagent' opID=WFU-ddeadb59] [WaitForUpdatesDone] Received callback",
-                                                            103));
+                                categorizer.computeCategory(false, messages[count], 103));
         }
         inlineTokenisationTime = stopWatch.stop();
 